@@ -0,0 +1,78 @@
+// SERVER-12015: aggregations which only depend on indexed fields may be answered from the index
+// alone, but a covered plan must not be chosen over a more selective plan that fetches.
+
+load("jstests/libs/analyze_plan.js");
+
+var t = db.jstests_aggregation_server12015;
+t.drop();
+
+for (var i = 0; i < 1000; i++) {
+    assert.writeOK(t.insert({a: i % 100, b: i, c: i % 7}));
+}
+assert.commandWorked(t.ensureIndex({a: 1}));
+assert.commandWorked(t.ensureIndex({b: 1, a: 1}));
+
+function winningPlan(pipeline) {
+    var explained = t.runCommand("aggregate", {pipeline: pipeline, explain: true});
+    assert.commandWorked(explained);
+    assert("$cursor" in explained.stages[0], tojson(explained));
+    return explained.stages[0].$cursor.queryPlanner.winningPlan;
+}
+
+function ixscanKeyPattern(root) {
+    if (root.stage === "IXSCAN") {
+        return root.keyPattern;
+    }
+    if ("inputStage" in root) {
+        return ixscanKeyPattern(root.inputStage);
+    }
+    return null;
+}
+
+function sortedValues(results, field) {
+    return results.map(function(doc) { return doc[field]; }).sort(function(x, y) {
+        return x - y;
+    });
+}
+
+// Only {b: 1, a: 1} holds both fields, but it can't bound 'a'. The selective {a: 1} plan has to
+// fetch, and it should still win.
+var pipeline = [{$match: {a: 5}}, {$project: {_id: 0, a: 1, b: 1}}];
+var plan = winningPlan(pipeline);
+assert(isIxscan(plan), tojson(plan));
+assert.eq({a: 1}, ixscanKeyPattern(plan), tojson(plan));
+var results = t.aggregate(pipeline).toArray();
+assert.eq(10, results.length);
+assert.eq([5, 105, 205, 305, 405, 505, 605, 705, 805, 905], sortedValues(results, "b"));
+
+// When the bounds are as selective, the plan that never fetches is used.
+pipeline = [{$match: {a: {$gte: 90}}}, {$group: {_id: "$a", n: {$sum: 1}}}];
+plan = winningPlan(pipeline);
+assert(isIndexOnly(plan), tojson(plan));
+assert.eq({a: 1}, ixscanKeyPattern(plan), tojson(plan));
+results = t.aggregate(pipeline).toArray();
+assert.eq(10, results.length);
+results.forEach(function(doc) { assert.eq(10, doc.n, tojson(doc)); });
+
+// A covered plan may also provide the sort.
+pipeline = [{$match: {b: {$lt: 5}}}, {$sort: {b: 1}}, {$project: {_id: 0, a: 1, b: 1}}];
+plan = winningPlan(pipeline);
+assert(isIndexOnly(plan), tojson(plan));
+results = t.aggregate(pipeline).toArray();
+assert.eq([0, 1, 2, 3, 4], results.map(function(doc) { return doc.b; }));
+assert.eq([0, 1, 2, 3, 4], results.map(function(doc) { return doc.a; }));
+
+// No index holds 'c', so documents are fetched and the results are unaffected.
+pipeline = [{$match: {a: 5}}, {$project: {_id: 0, c: 1}}];
+plan = winningPlan(pipeline);
+assert(planHasStage(plan, "FETCH"), tojson(plan));
+assert.eq(10, t.aggregate(pipeline).itcount());
+
+// A multikey index can't cover the fields it holds.
+assert.writeOK(t.insert({a: [1, 2], b: -1}));
+pipeline = [{$match: {a: 1}}, {$project: {_id: 0, a: 1}}];
+plan = winningPlan(pipeline);
+assert(planHasStage(plan, "FETCH"), tojson(plan));
+results = t.aggregate(pipeline).toArray();
+assert.eq(11, results.length);
+assert(results.some(function(doc) { return friendlyEqual([1, 2], doc.a); }), tojson(results));
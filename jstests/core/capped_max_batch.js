@@ -0,0 +1,20 @@
+// Multi-document inserts into a capped collection must respect its max, and every document left
+// in it must still be indexed.
+
+var t = db.capped_max_batch;
+t.drop();
+
+var max = 5;
+assert.commandWorked(db.createCollection(t.getName(), {capped: true, size: 64 * 1024, max: max}));
+assert.commandWorked(t.ensureIndex({x: 1}));
+
+var docs = [];
+for (var i = 0; i < max * 4; i++) {
+    docs.push({x: i});
+}
+assert.writeOK(t.insert(docs));
+
+assert.eq(max, t.count());
+assert.eq(max, t.find().hint({x: 1}).itcount());
+assert.eq(max * 3, t.find().sort({$natural: 1}).next().x);
+assert(t.validate(true).valid);
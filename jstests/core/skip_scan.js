@@ -0,0 +1,53 @@
+// Tests that queries and distincts over the second field of a compound index skip scan it when
+// its first field holds few distinct values, and fall back to other plans when it doesn't.
+
+load("jstests/libs/analyze_plan.js");
+
+var t = db.jstests_skip_scan;
+t.drop();
+
+for (var a = 0; a < 3; a++) {
+    for (var b = 0; b < 100; b++) {
+        assert.writeOK(t.insert({a: a, b: b}));
+    }
+}
+assert.commandWorked(t.ensureIndex({a: 1, b: 1}));
+
+// The prefix holds three values, so {b: 5} is answered by seeking to b = 5 under each of them.
+var explain = t.find({b: 5}).explain("executionStats");
+assert.eq(3, explain.executionStats.nReturned);
+assert(isIxscan(explain.queryPlanner.winningPlan), tojson(explain));
+assert.lt(explain.executionStats.totalKeysExamined, 30, tojson(explain));
+
+// Running the query again may use the cached plan, which must return the same results.
+assert.eq(3, t.find({b: 5}).itcount());
+assert.eq(3, t.find({b: 5}).itcount());
+
+// Distinct over b skips through the index instead of reading documents.
+var res = t.runCommand("distinct", {key: "b"});
+assert.commandWorked(res);
+assert.eq(100, res.values.length);
+assert.eq(0, res.stats.nscannedObjects, tojson(res));
+assert(/DISTINCT_SCAN/.test(res.stats.planSummary), tojson(res));
+
+// With more distinct prefixes than internalQueryPlannerSkipScanMaxPrefixes the index isn't
+// skip scanned, and both the query and the distinct read the collection.
+for (var a = 3; a < 100; a++) {
+    assert.writeOK(t.insert({a: a, b: 5}));
+}
+explain = t.find({b: 5}).explain("executionStats");
+assert.eq(100, explain.executionStats.nReturned);
+assert(isCollscan(explain.queryPlanner.winningPlan), tojson(explain));
+
+res = t.runCommand("distinct", {key: "b"});
+assert.commandWorked(res);
+assert.eq(100, res.values.length);
+assert(!/DISTINCT_SCAN/.test(res.stats.planSummary), tojson(res));
+
+// Fields of a multikey index which share a path prefix are not bounded together: the keys of
+// this document are (1, 1, 5) and (1, 9, 2), yet it matches.
+t.drop();
+assert.commandWorked(t.ensureIndex({a: 1, "x.b": 1, "x.c": 1}));
+assert.writeOK(t.insert({a: 1, x: [{b: 1, c: 5}, {b: 9, c: 2}]}));
+assert.writeOK(t.insert({a: 2, x: [{b: 1, c: 3}, {b: 9, c: 4}]}));
+assert.eq(1, t.find({"x.b": 1, "x.c": 2}).itcount());
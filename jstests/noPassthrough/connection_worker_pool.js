@@ -0,0 +1,55 @@
+/**
+ * Tests mongod with connectionWorkerThreads set. Connections outnumbering the worker threads are
+ * all serviced, each keeps its own Client while moving between the workers, and the server shuts
+ * down cleanly while connections are parked and requests are in flight.
+ */
+(function() {
+    "use strict";
+
+    var conn = MongoRunner.runMongod({setParameter: "connectionWorkerThreads=2"});
+    assert.neq(null, conn, "mongod failed to start with connectionWorkerThreads set");
+
+    var numConns = 20;
+    var numRounds = 5;
+    var conns = [];
+    for (var i = 0; i < numConns; i++) {
+        conns.push(new Mongo(conn.host));
+    }
+
+    // Each round sends one request per connection, and the connections go back to the pollers
+    // in between, so the same few workers service every connection in turn.
+    var connectionIds = [];
+    for (var round = 0; round < numRounds; round++) {
+        conns.forEach(function(c, i) {
+            var testDB = c.getDB("test");
+            assert.writeOK(testDB.connection_worker_pool.insert({_id: round * numConns + i}));
+
+            // The connection id belongs to the Client, so it must not change as the connection
+            // moves between workers, and no two connections may share one.
+            var gle = testDB.runCommand({getLastError: 1});
+            assert.commandWorked(gle);
+            if (round === 0) {
+                assert.eq(-1, connectionIds.indexOf(gle.connectionId), tojson(connectionIds));
+                connectionIds.push(gle.connectionId);
+            }
+            else {
+                assert.eq(connectionIds[i], gle.connectionId, "connection " + i);
+            }
+        });
+    }
+    assert.eq(numConns * numRounds, conn.getDB("test").connection_worker_pool.count());
+
+    // A cursor opened on one worker can be continued on another.
+    var cursor = conns[0].getDB("test").connection_worker_pool.find().batchSize(10);
+    assert.eq(numConns * numRounds, cursor.itcount());
+
+    // Shut down with the connections parked and another client busy writing.
+    var awaitWriter = startParallelShell(
+        "while (true) { db.connection_worker_pool_writer.insert({}); }", conn.port);
+    assert.soon(function() {
+        return conn.getDB("test").connection_worker_pool_writer.count() > 100;
+    });
+
+    assert.eq(0, MongoRunner.stopMongod(conn));
+    awaitWriter();
+})();
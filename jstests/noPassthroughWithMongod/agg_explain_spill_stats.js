@@ -0,0 +1,48 @@
+// Aggregate explain with executionStats runs the pipeline, and $group and $sort report how much
+// they spilled to disk.
+var t = db.agg_explain_spill_stats;
+t.drop();
+
+// Strings over 1MB, to go past the 100MB a $group or $sort may use before spilling.
+var bigStr = Array(210000).join("asdf ");
+for (var i = 0; i < 110; i++) {
+    assert.writeOK(t.insert({_id: i, n: i % 7, text: bigStr}));
+}
+
+function explainStages(pipeline, explain) {
+    var res = t.runCommand("aggregate", {pipeline: pipeline, explain: explain,
+                                         allowDiskUse: true});
+    assert.commandWorked(res);
+    return res.stages;
+}
+
+function checkSpillStats(stats) {
+    assert(stats, "no spillStats");
+    assert.gt(stats.spilledRuns, 0, tojson(stats));
+    assert.gt(stats.spilledBytes, 0, tojson(stats));
+    assert.gte(stats.mergePasses, 0, tojson(stats));
+}
+
+// $sort on a field without an index stays in the pipeline.
+var sortPipeline = [{$sort: {n: 1}}];
+var stages = explainStages(sortPipeline, "executionStats");
+assert.eq(110, stages[0].$cursor.executionStats.nReturned, tojson(stages[0]));
+checkSpillStats(stages[1].$sort.spillStats);
+
+// Without executionStats nothing runs, so there is nothing to report.
+stages = explainStages(sortPipeline, true);
+assert(!("executionStats" in stages[0].$cursor), tojson(stages[0]));
+assert(!("spillStats" in stages[1].$sort), tojson(stages[1]));
+
+var groupPipeline = [{$group: {_id: "$_id", text: {$first: "$text"}}}];
+stages = explainStages(groupPipeline, "executionStats");
+checkSpillStats(stages[1].spillStats);
+
+// The explained pipeline gave the same results as it does when run.
+assert.eq(110, t.aggregate(groupPipeline, {allowDiskUse: true}).itcount());
+
+assert.commandFailedWithCode(t.runCommand("aggregate", {pipeline: sortPipeline,
+                                                        explain: "allPlansExecution"}),
+                             28707);
+
+t.drop();
@@ -0,0 +1,78 @@
+// Secondaries keep several oplog getMores in flight to their sync source. Check that the batches
+// are applied in order when the in-flight bytes limit is small, and that a secondary which
+// changes sync source with replies still in flight drops the old connection and catches up.
+(function() {
+    "use strict";
+    var name = "oplog_fetcher_pipelined_getmores";
+    var replTest = new ReplSetTest({name: name, nodes: 3, oplogSize: 20});
+    var nodes = replTest.startSet();
+
+    // A limit of a few documents' worth of bytes, so that the number of requests in flight
+    // follows the size of the batches.
+    nodes.forEach(function(node) {
+        assert.commandWorked(node.adminCommand({setParameter: 1,
+                                                replOplogFetcherMaxInFlightBatches: 4,
+                                                replOplogFetcherMaxInFlightBytes: 8 * 1024}));
+    });
+
+    var hosts = replTest.nodeList();
+    replTest.initiate({"_id": name,
+                       "members": [
+                           {"_id": 0, "host": hosts[0], priority: 3},
+                           {"_id": 1, "host": hosts[1], priority: 0},
+                           {"_id": 2, "host": hosts[2], priority: 0}]});
+
+    var master = replTest.getMaster();
+    var slaves = replTest.liveNodes.slaves;
+    var coll = master.getDB("test").pipelined;
+    var pad = new Array(1024).join("x");
+
+    // Each update depends on the one before it, so any op applied out of order or twice shows up
+    // in the final value of 'n'.
+    function writeOps(first, count) {
+        for (var i = first; i < first + count; i++) {
+            assert.writeOK(coll.insert({_id: i, pad: pad}));
+            assert.writeOK(coll.update({_id: "counter"}, {$inc: {n: 1}, $set: {last: i}},
+                                       {upsert: true}));
+        }
+    }
+
+    function checkSecondaries(numDocs) {
+        replTest.awaitReplication();
+        var expected = coll.findOne({_id: "counter"});
+        assert.eq(numDocs, expected.n, tojson(expected));
+        slaves.forEach(function(slave) {
+            slave.setSlaveOk();
+            var slaveColl = slave.getDB("test").pipelined;
+            assert.eq(numDocs + 1, slaveColl.count(), slave.host);
+            assert.eq(expected, slaveColl.findOne({_id: "counter"}), slave.host);
+        });
+    }
+
+    jsTestLog("Replicating with getMores in flight");
+    writeOps(0, 500);
+    checkSecondaries(500);
+
+    jsTestLog("Changing sync source while the primary is writing");
+    var awaitWriter = startParallelShell(
+        "var pad = new Array(1024).join('x');" +
+        "for (var i = 500; i < 2500; i++) {" +
+        "    assert.writeOK(db.pipelined.insert({_id: i, pad: pad}));" +
+        "    assert.writeOK(db.pipelined.update({_id: 'counter'}," +
+        "                                       {$inc: {n: 1}, $set: {last: i}}));" +
+        "}",
+        master.port);
+
+    assert.soon(function() {
+        return coll.count() > 1000;
+    }, "primary didn't take writes");
+    assert.commandWorked(slaves[1].adminCommand({replSetSyncFrom: slaves[0].name}));
+    assert.soon(function() {
+        return replTest.status().members[2].syncingTo === slaves[0].name;
+    }, "sync source not changed to the other secondary");
+
+    awaitWriter();
+    checkSecondaries(2500);
+
+    replTest.stopSet();
+}());
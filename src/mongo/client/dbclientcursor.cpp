@@ -207,9 +207,72 @@ namespace {
         return ok;
     }
 
+    void DBClientCursor::enablePrefetch(int maxOutstanding, int maxInFlightBytes) {
+        massert(28701, "DBClientCursor::enablePrefetch called on an unsupported cursor",
+                _client && _client->lazySupported() && !haveLimit
+                && !(opts & QueryOption_Exhaust) && maxOutstanding > 0);
+        _prefetch = true;
+        _prefetchMaxOutstanding = maxOutstanding;
+        _prefetchMaxBytes = maxInFlightBytes;
+        prefetchMore();
+    }
+
+    void DBClientCursor::prefetchMore() {
+        if ( !_prefetch || cursorId == 0 )
+            return;
+
+        int wanted = _prefetchMaxOutstanding;
+        const int lastBatchBytes = batch.m ? batch.m->size() : 0;
+        if ( _prefetchMaxBytes > 0 && lastBatchBytes > 0 ) {
+            wanted = std::min( wanted, _prefetchMaxBytes / lastBatchBytes );
+        }
+        wanted = std::max( wanted, 1 );
+
+        while ( _prefetchOutstanding < wanted ) {
+            BufBuilder b;
+            b.appendNum(opts);
+            b.appendStr(ns);
+            b.appendNum(nextBatchSize());
+            b.appendNum(cursorId);
+
+            Message toSend;
+            toSend.setData(dbGetMore, b.buf(), b.len());
+            _client->say( toSend );
+            _prefetchOutstanding++;
+        }
+    }
+
+    void DBClientCursor::drainPrefetched() {
+        while ( _prefetchOutstanding > 0 ) {
+            Message response;
+            if (!_client->recv(response)) {
+                uasserted(28703, "recv failed while draining prefetched batches");
+            }
+            _prefetchOutstanding--;
+        }
+    }
+
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        if ( _prefetchOutstanding > 0 ) {
+            // The getMore was sent when an earlier batch arrived, just collect the reply.
+            _prefetchOutstanding--;
+            unique_ptr<Message> response(new Message());
+            if (!_client->recv(*response)) {
+                uasserted(28702, "recv failed while reading prefetched batch");
+            }
+            batch.m = std::move(response);
+            dataReceived();
+            if ( cursorId == 0 ) {
+                drainPrefetched();
+            }
+            else {
+                prefetchMore();
+            }
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
@@ -149,7 +149,11 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _prefetch( false ),
+            _prefetchOutstanding( 0 ),
+            _prefetchMaxOutstanding( 0 ),
+            _prefetchMaxBytes( 0 ) {
             _finishConsInit();
         }
 
@@ -165,7 +169,11 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _prefetch(false),
+            _prefetchOutstanding(0),
+            _prefetchMaxOutstanding(0),
+            _prefetchMaxBytes(0) {
             _finishConsInit();
         }
 
@@ -204,6 +212,30 @@ namespace mongo {
         void initLazy( bool isRetry = false );
         bool initLazyFinish( bool& retry );
 
+        /**
+         * Keeps getMore requests in flight ahead of the consumer. Whenever a batch arrives,
+         * requests for the following ones are sent right away, and their replies are only read
+         * once the current batch has been consumed. Callers reading from many cursors at once can
+         * use this to overlap the round trips to each server, and callers reading one cursor over
+         * a slow link can keep several requests in flight to hide the latency.
+         *
+         * At most 'maxOutstanding' requests are in flight. If 'maxInFlightBytes' is positive, the
+         * number is also limited so that that many bytes of replies, estimated from the size of
+         * the last batch, are outstanding; at least one request is always kept in flight.
+         *
+         * Must be called after the first batch has been received. Only supported for cursors
+         * without a limit that aren't exhaust, and whose connection supports lazy requests. The
+         * connection must not be reused while requests are outstanding, see
+         * prefetchOutstanding(). When a tailable cursor dies, the replies to the requests sent
+         * after it are read and dropped.
+         */
+        void enablePrefetch(int maxOutstanding = 1, int maxInFlightBytes = 0);
+
+        /**
+         * The number of getMore requests sent ahead whose replies haven't been read.
+         */
+        int prefetchOutstanding() const { return _prefetchOutstanding; }
+
         class Batch {
             MONGO_DISALLOW_COPYING(Batch);
             friend class DBClientCursor;
@@ -240,6 +272,10 @@ namespace mongo {
         std::string _scopedHost;
         std::string _lazyHost;
         bool wasError;
+        bool _prefetch;
+        int _prefetchOutstanding;
+        int _prefetchMaxOutstanding;
+        int _prefetchMaxBytes;
 
         void dataReceived() { bool retry; std::string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, std::string& lazyHost );
@@ -254,6 +290,13 @@ namespace mongo {
         void requestMore();
         void exhaustReceiveMore(); // for exhaust
 
+        // Sends getMores for the next batches without waiting for the replies, see
+        // enablePrefetch().
+        void prefetchMore();
+
+        // Reads and drops the replies to requests still outstanding once the cursor is dead.
+        void drainPrefetched();
+
         // Don't call from a virtual function
         void _assertIfNull() const { uassert(13348, "connection died", this); }
 
@@ -0,0 +1,267 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * Tests for the getMores DBClientCursor keeps in flight once enablePrefetch() is called. The
+ * connection is faked, so only the client side of the pipeline is covered.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::BufBuilder;
+    using mongo::DBClientConnection;
+    using mongo::DBClientCursor;
+    using mongo::Message;
+    using std::string;
+    using std::vector;
+
+    namespace QueryResult = mongo::QueryResult;
+
+    const char* const kNs = "test.prefetch";
+    const long long kCursorId = 7;
+
+    /**
+     * A connection which answers each request, in the order the requests were sent, with the next
+     * of the batches it was given. Once the batches run out, it replies that the cursor is gone,
+     * as a server does to getMores on a cursor it has closed.
+     */
+    class PipelinedConnection : public DBClientConnection {
+    public:
+        PipelinedConnection() : getMoresSent(0), repliesRead(0), killCursorsSent(0) { }
+
+        /**
+         * Adds a batch of 'n' documents, with _ids counting up from 'firstId' and each padded
+         * with 'padBytes' bytes.
+         */
+        void addBatch(long long cursorId, int firstId, int n, int padBytes = 0) {
+            Batch batch;
+            batch.cursorId = cursorId;
+            for (int i = 0; i < n; ++i) {
+                batch.docs.push_back(BSON("_id" << firstId + i << "pad" << string(padBytes, 'x')));
+            }
+            _batches.push_back(batch);
+        }
+
+        int unreadReplies() const { return getMoresSent - repliesRead; }
+
+        virtual bool call(Message& toSend, Message& response, bool assertOk = true,
+                          string* actualServer = 0) {
+            // Only the initial query is sent this way.
+            ASSERT_EQUALS(mongo::dbQuery, toSend.operation());
+            _reply(&response);
+            return true;
+        }
+
+        virtual void say(Message& toSend, bool isRetry = false, string* actualServer = 0) {
+            _sent(toSend);
+        }
+
+        virtual void sayPiggyBack(Message& toSend) {
+            _sent(toSend);
+        }
+
+        virtual bool recv(Message& m) {
+            ASSERT_GREATER_THAN(unreadReplies(), 0);
+            repliesRead++;
+            _reply(&m);
+            return true;
+        }
+
+        int getMoresSent;
+        int repliesRead;
+        int killCursorsSent;
+
+    private:
+        struct Batch {
+            long long cursorId;
+            vector<BSONObj> docs;
+        };
+
+        void _sent(Message& toSend) {
+            if (toSend.operation() == mongo::dbGetMore) {
+                getMoresSent++;
+            }
+            else {
+                ASSERT_EQUALS(mongo::dbKillCursors, toSend.operation());
+                killCursorsSent++;
+            }
+        }
+
+        void _reply(Message* response) {
+            Batch batch;
+            int flags = 0;
+            if (_batches.empty()) {
+                batch.cursorId = 0;
+                flags = mongo::ResultFlag_CursorNotFound;
+            }
+            else {
+                batch = _batches.front();
+                _batches.pop_front();
+            }
+
+            BufBuilder b;
+            b.skip(sizeof(QueryResult::Value));
+            for (size_t i = 0; i < batch.docs.size(); ++i) {
+                b.appendBuf(batch.docs[i].objdata(), batch.docs[i].objsize());
+            }
+            QueryResult::View qr = b.buf();
+            qr.setResultFlags(flags);
+            qr.msgdata().setLen(b.len());
+            qr.msgdata().setOperation(mongo::opReply);
+            qr.setCursorId(batch.cursorId);
+            qr.setStartingFrom(0);
+            qr.setNReturned(static_cast<int>(batch.docs.size()));
+            b.decouple();
+            response->setData(qr.view2ptr(), true);
+        }
+
+        std::deque<Batch> _batches;
+    };
+
+    DBClientCursor* openCursor(PipelinedConnection* conn, int options = 0) {
+        DBClientCursor* cursor = new DBClientCursor(conn, kNs, BSONObj(), 0, 0, NULL, options, 2);
+        ASSERT(cursor->init());
+        return cursor;
+    }
+
+    TEST(DBClientCursorPrefetch, OutstandingRepliesArriveInOrder) {
+        PipelinedConnection conn;
+        conn.addBatch(kCursorId, 0, 2);
+        conn.addBatch(kCursorId, 2, 2);
+        conn.addBatch(kCursorId, 4, 2);
+        conn.addBatch(kCursorId, 6, 2);
+        conn.addBatch(0, 8, 2);
+
+        std::unique_ptr<DBClientCursor> cursor(openCursor(&conn));
+        cursor->enablePrefetch(3);
+        ASSERT_EQUALS(3, conn.getMoresSent);
+        ASSERT_EQUALS(3, cursor->prefetchOutstanding());
+
+        for (int i = 0; i < 10; ++i) {
+            ASSERT(cursor->more());
+            ASSERT_EQUALS(i, cursor->next()["_id"].numberInt());
+            // Reading a reply sends the next getMore, until the cursor is exhausted.
+            ASSERT_EQUALS(conn.unreadReplies(), cursor->prefetchOutstanding());
+        }
+        ASSERT_FALSE(cursor->more());
+
+        // The getMores sent past the end of the cursor were answered and dropped.
+        ASSERT_EQUALS(0, cursor->prefetchOutstanding());
+        ASSERT_EQUALS(0, conn.unreadReplies());
+        ASSERT_EQUALS(6, conn.getMoresSent);
+    }
+
+    TEST(DBClientCursorPrefetch, InFlightBytesLimitRequests) {
+        PipelinedConnection conn;
+        for (int i = 0; i < 8; ++i) {
+            conn.addBatch(kCursorId, 2 * i, 2, 1000);
+        }
+
+        std::unique_ptr<DBClientCursor> cursor(openCursor(&conn));
+        const int batchBytes = cursor->getMessage()->size();
+
+        // Room for two and a half batches lets two requests out, however many are allowed.
+        cursor->enablePrefetch(8, 2 * batchBytes + batchBytes / 2);
+        ASSERT_EQUALS(2, conn.getMoresSent);
+        ASSERT_EQUALS(2, cursor->prefetchOutstanding());
+
+        // Consuming a batch only sends the request which takes its place.
+        for (int i = 0; i < 4; ++i) {
+            ASSERT(cursor->more());
+            cursor->next();
+        }
+        ASSERT_EQUALS(3, conn.getMoresSent);
+        ASSERT_EQUALS(2, cursor->prefetchOutstanding());
+    }
+
+    TEST(DBClientCursorPrefetch, InFlightBytesLimitKeepsOneRequest) {
+        PipelinedConnection conn;
+        conn.addBatch(kCursorId, 0, 2, 1000);
+        conn.addBatch(0, 2, 2, 1000);
+
+        std::unique_ptr<DBClientCursor> cursor(openCursor(&conn));
+        cursor->enablePrefetch(8, 10);
+        ASSERT_EQUALS(1, conn.getMoresSent);
+        ASSERT_EQUALS(1, cursor->prefetchOutstanding());
+    }
+
+    TEST(DBClientCursorPrefetch, DeadTailableCursorDropsRepliesInFlight) {
+        PipelinedConnection conn;
+        conn.addBatch(kCursorId, 0, 2);
+        conn.addBatch(kCursorId, 2, 2);
+
+        std::unique_ptr<DBClientCursor> cursor(openCursor(&conn,
+                                                          mongo::QueryOption_CursorTailable));
+        cursor->enablePrefetch(4);
+
+        for (int i = 0; i < 4; ++i) {
+            ASSERT(cursor->more());
+            ASSERT_EQUALS(i, cursor->next()["_id"].numberInt());
+        }
+
+        // The next reply says the cursor is gone, and the ones queued behind it are read too.
+        ASSERT_FALSE(cursor->more());
+        ASSERT(cursor->isDead());
+        ASSERT_EQUALS(0, cursor->prefetchOutstanding());
+        ASSERT_EQUALS(0, conn.unreadReplies());
+    }
+
+    TEST(DBClientCursorPrefetch, AbandonedCursorLeavesRepliesInFlight) {
+        PipelinedConnection conn;
+        for (int i = 0; i < 8; ++i) {
+            conn.addBatch(kCursorId, 2 * i, 2);
+        }
+
+        std::unique_ptr<DBClientCursor> cursor(openCursor(&conn));
+        cursor->enablePrefetch(3);
+        ASSERT(cursor->more());
+        cursor->next();
+
+        // The replies to the requests sent ahead are still on the connection, which is why
+        // OplogReader::resetCursor() drops the connection along with such a cursor.
+        ASSERT_EQUALS(3, cursor->prefetchOutstanding());
+        cursor.reset();
+        ASSERT_EQUALS(1, conn.killCursorsSent);
+        ASSERT_EQUALS(3, conn.unreadReplies());
+    }
+
+}  // namespace
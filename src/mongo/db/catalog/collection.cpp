@@ -164,6 +164,12 @@ namespace {
         _indexCatalog.init(txn);
         if ( isCapped() )
             _recordStore->setCappedDeleteCallback( this );
+
+        const std::string rangeSummaryField =
+            _details->getCollectionOptions(txn).rangeSummaryField;
+        if (!rangeSummaryField.empty())
+            _recordStore->enableRangeSummary(rangeSummaryField);
+
         _infoCache.reset(txn);
     }
 
@@ -332,6 +338,48 @@ namespace {
         return res;
     }
 
+    Status Collection::insertDocuments(OperationContext* txn,
+                                       std::vector<BSONObj>::const_iterator begin,
+                                       std::vector<BSONObj>::const_iterator end,
+                                       bool enforceQuota,
+                                       bool fromMigrate) {
+        invariant( !isCapped() );
+
+        const bool hasIdIndex = _indexCatalog.findIdIndex( txn );
+
+        for ( auto it = begin; it != end; ++it ) {
+            auto status = checkValidation(txn, *it);
+            if (!status.isOK())
+                return status;
+
+            if ( hasIdIndex && (*it)["_id"].eoo() ) {
+                return Status( ErrorCodes::InternalError,
+                               str::stream() << "Collection::insertDocuments got "
+                               "document without _id for ns:" << _ns.ns() );
+            }
+        }
+
+        const SnapshotId sid = txn->recoveryUnit()->getSnapshotId();
+
+        Status status = _insertDocuments( txn, begin, end, enforceQuota );
+        if ( !status.isOK() )
+            return status;
+        invariant( sid == txn->recoveryUnit()->getSnapshotId() );
+
+        for ( auto it = begin; it != end; ++it ) {
+            getGlobalServiceContext()->getOpObserver()->onInsert(txn, ns(), *it, fromMigrate);
+        }
+
+        // If there is a notifier object and another thread is waiting on it, then we notify
+        // waiters of these document inserts. Waiters keep a shared_ptr to '_cappedNotifier', so
+        // there are waiters if this Collection's shared_ptr is not unique.
+        if (_cappedNotifier && !_cappedNotifier.unique()) {
+            _cappedNotifier->notifyOfInsert();
+        }
+
+        return Status::OK();
+    }
+
     StatusWith<RecordId> Collection::insertDocument(OperationContext* txn,
                                                     const BSONObj& doc,
                                                     MultiIndexBlock* indexBlock,
@@ -396,6 +444,40 @@ namespace {
         return loc;
     }
 
+    Status Collection::_insertDocuments( OperationContext* txn,
+                                         std::vector<BSONObj>::const_iterator begin,
+                                         std::vector<BSONObj>::const_iterator end,
+                                         bool enforceQuota ) {
+        dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
+
+        std::vector<Record> records;
+        records.reserve( end - begin );
+        for ( auto it = begin; it != end; ++it ) {
+            records.push_back( Record{ RecordId(), RecordData( it->objdata(), it->objsize() ) } );
+        }
+
+        Status status = _recordStore->insertRecords( txn,
+                                                     &records,
+                                                     _enforceQuota( enforceQuota ) );
+        if ( !status.isOK() )
+            return status;
+
+        std::vector<BsonRecord> bsonRecords;
+        bsonRecords.reserve( records.size() );
+        size_t i = 0;
+        for ( auto it = begin; it != end; ++it, ++i ) {
+            const RecordId& loc = records[i].id;
+            invariant( RecordId::min() < loc );
+            invariant( loc < RecordId::max() );
+
+            bsonRecords.push_back( BsonRecord{ loc, &(*it) } );
+        }
+
+        _infoCache.notifyOfWriteOp();
+
+        return _indexCatalog.indexRecords( txn, bsonRecords );
+    }
+
     Status Collection::aboutToDeleteCapped( OperationContext* txn,
                                             const RecordId& loc,
                                             RecordData data ) {
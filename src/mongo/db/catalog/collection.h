@@ -209,6 +209,22 @@ namespace mongo {
                                             bool enforceQuota,
                                             bool fromMigrate = false);
 
+        /**
+         * Inserts all documents in the range [begin, end) with a single batched call into the
+         * RecordStore and into each index.  Has the same semantics as calling insertDocument()
+         * for each document, except that on failure some documents may already have been
+         * written: the caller must abandon the enclosing WriteUnitOfWork, and may then retry the
+         * documents one at a time to find out which of them failed.
+         *
+         * Must not be called on capped collections, whose RecordStores may delete documents of
+         * the batch before they are indexed.
+         */
+        Status insertDocuments( OperationContext* txn,
+                                std::vector<BSONObj>::const_iterator begin,
+                                std::vector<BSONObj>::const_iterator end,
+                                bool enforceQuota,
+                                bool fromMigrate = false );
+
         /**
          * Callers must ensure no document validation is performed for this collection when calling
          * this method.
@@ -360,6 +376,11 @@ namespace mongo {
                                              const BSONObj& doc,
                                              bool enforceQuota );
 
+        Status _insertDocuments( OperationContext* txn,
+                                 std::vector<BSONObj>::const_iterator begin,
+                                 std::vector<BSONObj>::const_iterator end,
+                                 bool enforceQuota );
+
         bool _enforceQuota( bool userEnforeQuota ) const;
 
         int _magic;
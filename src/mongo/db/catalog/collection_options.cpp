@@ -64,6 +64,7 @@ namespace mongo {
         temp = false;
         storageEngine = BSONObj();
         validator = BSONObj();
+        rangeSummaryField.clear();
     }
 
     bool CollectionOptions::isValid() const {
@@ -171,6 +172,19 @@ namespace mongo {
 
                 validator = e.Obj().getOwned();
             }
+            else if (fieldName == "rangeSummaryField") {
+                if (e.type() != mongo::String) {
+                    return Status(ErrorCodes::BadValue, "'rangeSummaryField' has to be a string.");
+                }
+
+                rangeSummaryField = e.String();
+                if (rangeSummaryField.empty()
+                    || rangeSummaryField[0] == '$'
+                    || rangeSummaryField.find('.') != std::string::npos) {
+                    return Status(ErrorCodes::BadValue,
+                                  "'rangeSummaryField' has to name a top-level field.");
+                }
+            }
         }
 
         return Status::OK();
@@ -208,6 +222,10 @@ namespace mongo {
             b.append("validator", validator);
         }
 
+        if (!rangeSummaryField.empty()) {
+            b.append("rangeSummaryField", rangeSummaryField);
+        }
+
         return b.obj();
     }
 
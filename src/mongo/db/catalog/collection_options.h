@@ -98,6 +98,10 @@ namespace mongo {
 
         // Always owned or empty.
         BSONObj validator;
+
+        // Top-level field whose values the record store summarizes over ranges of records, so
+        // that collection scans can step over ranges which can't match.  Empty if none.
+        std::string rangeSummaryField;
     };
 
 }
@@ -87,6 +87,23 @@ namespace mongo {
         ASSERT(!options.toBSON()["validator"]);
     }
 
+    TEST(CollectionOptions, RangeSummaryField) {
+        CollectionOptions options;
+
+        ASSERT_NOT_OK(options.parse(fromjson("{rangeSummaryField: 1}")));
+        ASSERT_NOT_OK(options.parse(fromjson("{rangeSummaryField: ''}")));
+        ASSERT_NOT_OK(options.parse(fromjson("{rangeSummaryField: 'a.b'}")));
+        ASSERT_NOT_OK(options.parse(fromjson("{rangeSummaryField: '$a'}")));
+
+        ASSERT_OK(options.parse(fromjson("{capped: true, size: 4096, rangeSummaryField: 'ts'}")));
+        ASSERT_EQ(options.rangeSummaryField, "ts");
+        ASSERT_EQ(options.toBSON()["rangeSummaryField"].String(), "ts");
+
+        options.reset();
+        ASSERT(options.rangeSummaryField.empty());
+        ASSERT(!options.toBSON()["rangeSummaryField"]);
+    }
+
     TEST( CollectionOptions, ErrorBadSize ) {
         ASSERT_NOT_OK( CollectionOptions().parse( fromjson( "{capped: true, size: -1}" ) ) );
         ASSERT_NOT_OK( CollectionOptions().parse( fromjson( "{capped: false, size: -1}" ) ) );
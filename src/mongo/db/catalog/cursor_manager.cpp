@@ -43,6 +43,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/platform/random.h"
+#include "mongo/util/concurrency/striped_counter.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/startup_test.h"
 
@@ -317,10 +318,11 @@ namespace mongo {
 
 
     CursorManager::CursorManager( StringData ns )
-        : _nss( ns ),
-          _mutex( "CursorManager" ) {
+        : _nss( ns ) {
         _collectionCacheRuntimeId = globalCursorIdCache->created( _nss.ns() );
-        _random.reset( new PseudoRandom( globalCursorIdCache->nextSeed() ) );
+        for ( size_t i = 0; i < kNumPartitions; i++ ) {
+            _partitions[i].random.reset( new PseudoRandom( globalCursorIdCache->nextSeed() ) );
+        }
     }
 
     CursorManager::~CursorManager() {
@@ -328,73 +330,93 @@ namespace mongo {
         globalCursorIdCache->destroyed( _collectionCacheRuntimeId, _nss.ns() );
     }
 
-    void CursorManager::invalidateAll(bool collectionGoingAway,
-                                      const std::string& reason) {
-        SimpleMutex::scoped_lock lk( _mutex );
-
-        for ( ExecSet::iterator it = _nonCachedExecutors.begin();
-              it != _nonCachedExecutors.end();
-              ++it ) {
+    CursorManager::Partition& CursorManager::_partitionFor( CursorId id ) {
+        // The low half of an id is random, so its low bits spread cursors evenly.
+        return _partitions[static_cast<uint64_t>( id ) % kNumPartitions];
+    }
 
-            // we kill the executor, but it deletes itself
-            PlanExecutor* exec = *it;
-            exec->kill(reason);
-            invariant( exec->collection() == NULL );
-        }
-        _nonCachedExecutors.clear();
+    CursorManager::Partition& CursorManager::_partitionFor( PlanExecutor* exec ) {
+        // Drop the bits which are the same for all heap allocations of this size.
+        const uintptr_t address = reinterpret_cast<uintptr_t>( exec );
+        return _partitions[( address >> 6 ) % kNumPartitions];
+    }
 
-        if ( collectionGoingAway ) {
-            // we're going to wipe out the world
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
+    void CursorManager::invalidateAll(bool collectionGoingAway,
+                                      const std::string& reason) {
+        for ( size_t p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+
+            for ( Partition::ExecSet::iterator it = partition.nonCachedExecutors.begin();
+                  it != partition.nonCachedExecutors.end();
+                  ++it ) {
+
+                // we kill the executor, but it deletes itself
+                PlanExecutor* exec = *it;
+                exec->kill(reason);
+                invariant( exec->collection() == NULL );
+            }
+            partition.nonCachedExecutors.clear();
 
-                cc->kill();
+            if ( collectionGoingAway ) {
+                // we're going to wipe out the world
+                for ( Partition::CursorMap::const_iterator i = partition.cursors.begin();
+                      i != partition.cursors.end();
+                      ++i ) {
+                    ClientCursor* cc = i->second;
 
-                invariant( cc->getExecutor() == NULL || cc->getExecutor()->collection() == NULL );
+                    cc->kill();
 
-                // If the CC is pinned, somebody is actively using it and we do not delete it.
-                // Instead we notify the holder that we killed it.  The holder will then delete the
-                // CC.
-                //
-                // If the CC is not pinned, there is nobody actively holding it.  We can safely
-                // delete it.
-                if (!cc->isPinned()) {
-                    delete cc;
+                    invariant( cc->getExecutor() == NULL ||
+                               cc->getExecutor()->collection() == NULL );
+
+                    // If the CC is pinned, somebody is actively using it and we do not delete it.
+                    // Instead we notify the holder that we killed it.  The holder will then
+                    // delete the CC.
+                    //
+                    // If the CC is not pinned, there is nobody actively holding it.  We can
+                    // safely delete it.
+                    if (!cc->isPinned()) {
+                        delete cc;
+                    }
                 }
             }
-        }
-        else {
-            CursorMap newMap;
-
-            // collection will still be around, just all PlanExecutors are invalid
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
+            else {
+                Partition::CursorMap newMap;
+
+                // collection will still be around, just all PlanExecutors are invalid
+                for ( Partition::CursorMap::const_iterator i = partition.cursors.begin();
+                      i != partition.cursors.end();
+                      ++i ) {
+                    ClientCursor* cc = i->second;
+
+                    // Note that a valid ClientCursor state is "no cursor no executor."  This is
+                    // because the set of active cursor IDs in ClientCursor is used as
+                    // representation of query state.  See sharding_block.h.  TODO(greg,hk): Move
+                    // this out.
+                    if (NULL == cc->getExecutor() ) {
+                        newMap.insert( *i );
+                        continue;
+                    }
+
+                    if (cc->isPinned() || cc->isAggCursor()) {
+                        // Pinned cursors need to stay alive, so we leave them around.
+                        // Aggregation cursors also can stay alive (since they don't have their
+                        // lifetime bound to the underlying collection).  However, if they have an
+                        // associated executor, we need to kill it, because it's now invalid.
+                        if ( cc->getExecutor() )
+                            cc->getExecutor()->kill(reason);
+                        newMap.insert( *i );
+                    }
+                    else {
+                        cc->kill();
+                        delete cc;
+                    }
 
-                // Note that a valid ClientCursor state is "no cursor no executor."  This is because
-                // the set of active cursor IDs in ClientCursor is used as representation of query
-                // state.  See sharding_block.h.  TODO(greg,hk): Move this out.
-                if (NULL == cc->getExecutor() ) {
-                    newMap.insert( *i );
-                    continue;
-                }
-
-                if (cc->isPinned() || cc->isAggCursor()) {
-                    // Pinned cursors need to stay alive, so we leave them around.  Aggregation
-                    // cursors also can stay alive (since they don't have their lifetime bound to
-                    // the underlying collection).  However, if they have an associated executor, we
-                    // need to kill it, because it's now invalid.
-                    if ( cc->getExecutor() )
-                        cc->getExecutor()->kill(reason);
-                    newMap.insert( *i );
-                }
-                else {
-                    cc->kill();
-                    delete cc;
                 }
 
+                partition.cursors = newMap;
             }
-
-            _cursors = newMap;
         }
     }
 
@@ -407,61 +429,79 @@ namespace mongo {
             return;
         }
 
-        SimpleMutex::scoped_lock lk( _mutex );
+        for ( size_t p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( ExecSet::iterator it = _nonCachedExecutors.begin();
-              it != _nonCachedExecutors.end();
-              ++it ) {
+            for ( Partition::ExecSet::iterator it = partition.nonCachedExecutors.begin();
+                  it != partition.nonCachedExecutors.end();
+                  ++it ) {
 
-            PlanExecutor* exec = *it;
-            exec->invalidate(txn, dl, type);
-        }
-
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            PlanExecutor* exec = i->second->getExecutor();
-            if ( exec ) {
+                PlanExecutor* exec = *it;
                 exec->invalidate(txn, dl, type);
             }
+
+            for ( Partition::CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                PlanExecutor* exec = i->second->getExecutor();
+                if ( exec ) {
+                    exec->invalidate(txn, dl, type);
+                }
+            }
         }
     }
 
     std::size_t CursorManager::timeoutCursors( int millisSinceLastCall ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        size_t numTimedOut = 0;
 
-        vector<ClientCursor*> toDelete;
+        for ( size_t p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            if ( cc->shouldTimeout( millisSinceLastCall ) )
-                toDelete.push_back( cc );
-        }
+            vector<ClientCursor*> toDelete;
+
+            for ( Partition::CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                ClientCursor* cc = i->second;
+                if ( cc->shouldTimeout( millisSinceLastCall ) )
+                    toDelete.push_back( cc );
+            }
+
+            for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
+                    i != toDelete.end(); ++i ) {
+                ClientCursor* cc = *i;
+                _deregisterCursor_inlock( &partition, cc );
+                cc->kill();
+                delete cc;
+            }
 
-        for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
-                i != toDelete.end(); ++i ) {
-            ClientCursor* cc = *i;
-            _deregisterCursor_inlock( cc );
-            cc->kill();
-            delete cc;
+            numTimedOut += toDelete.size();
         }
 
-        return toDelete.size();
+        return numTimedOut;
     }
 
     void CursorManager::registerExecutor( PlanExecutor* exec ) {
-        SimpleMutex::scoped_lock lk(_mutex);
-        const std::pair<ExecSet::iterator, bool> result = _nonCachedExecutors.insert(exec);
+        Partition& partition = _partitionFor( exec );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        const std::pair<Partition::ExecSet::iterator, bool> result =
+            partition.nonCachedExecutors.insert(exec);
         invariant(result.second); // make sure this was inserted
     }
 
     void CursorManager::deregisterExecutor( PlanExecutor* exec ) {
-        SimpleMutex::scoped_lock lk(_mutex);
-        _nonCachedExecutors.erase(exec);
+        Partition& partition = _partitionFor( exec );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        partition.nonCachedExecutors.erase(exec);
     }
 
     ClientCursor* CursorManager::find( CursorId id, bool pin ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorMap::const_iterator it = _cursors.find( id );
-        if ( it == _cursors.end() )
+        Partition& partition = _partitionFor( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        Partition::CursorMap::const_iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() )
             return NULL;
 
         ClientCursor* cursor = it->second;
@@ -476,7 +516,8 @@ namespace mongo {
     }
 
     void CursorManager::unpin( ClientCursor* cursor ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        Partition& partition = _partitionFor( cursor->cursorid() );
+        SimpleMutex::scoped_lock lk( partition.mutex );
 
         invariant( cursor->isPinned() );
         cursor->unsetPinned();
@@ -487,47 +528,64 @@ namespace mongo {
     }
 
     void CursorManager::getCursorIds( std::set<CursorId>* openCursors ) const {
-        SimpleMutex::scoped_lock lk( _mutex );
+        for ( size_t p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            openCursors->insert( cc->cursorid() );
+            for ( Partition::CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                ClientCursor* cc = i->second;
+                openCursors->insert( cc->cursorid() );
+            }
         }
     }
 
     size_t CursorManager::numCursors() const {
-        SimpleMutex::scoped_lock lk( _mutex );
-        return _cursors.size();
+        size_t num = 0;
+        for ( size_t p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            num += partition.cursors.size();
+        }
+        return num;
     }
 
-    CursorId CursorManager::_allocateCursorId_inlock() {
-        for ( int i = 0; i < 10000; i++ ) {
-            unsigned mypart = static_cast<unsigned>( _random->nextInt32() );
-            CursorId id = cursorIdFromParts( _collectionCacheRuntimeId, mypart );
-            if ( _cursors.count( id ) == 0 )
-                return id;
-        }
-        fassertFailed( 17360 );
+    CursorId CursorManager::_allocateCursorId() {
+        // Draw from the generator of the partition this thread would use, so that threads
+        // creating cursors at the same time don't wait on each other.
+        Partition& source = _partitions[threadStripe() % kNumPartitions];
+        SimpleMutex::scoped_lock lk( source.mutex );
+        unsigned mypart = static_cast<unsigned>( source.random->nextInt32() );
+        return cursorIdFromParts( _collectionCacheRuntimeId, mypart );
     }
 
     CursorId CursorManager::registerCursor( ClientCursor* cc ) {
         invariant( cc );
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorId id = _allocateCursorId_inlock();
-        _cursors[id] = cc;
-        return id;
+        for ( int i = 0; i < 10000; i++ ) {
+            CursorId id = _allocateCursorId();
+            Partition& partition = _partitionFor( id );
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            if ( partition.cursors.count( id ) == 0 ) {
+                partition.cursors[id] = cc;
+                return id;
+            }
+        }
+        fassertFailed( 17360 );
     }
 
     void CursorManager::deregisterCursor( ClientCursor* cc ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        _deregisterCursor_inlock( cc );
+        Partition& partition = _partitionFor( cc->cursorid() );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        _deregisterCursor_inlock( &partition, cc );
     }
 
     bool CursorManager::eraseCursor(OperationContext* txn, CursorId id, bool checkAuth) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        Partition& partition = _partitionFor( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
 
-        CursorMap::iterator it = _cursors.find( id );
-        if ( it == _cursors.end() ) {
+        Partition::CursorMap::iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() ) {
             if ( checkAuth )
                 audit::logKillCursorsAuthzCheck( txn->getClient(),
                                                  _nss,
@@ -549,15 +607,15 @@ namespace mongo {
                  !cursor->isPinned() );
 
         cursor->kill();
-        _deregisterCursor_inlock( cursor );
+        _deregisterCursor_inlock( &partition, cursor );
         delete cursor;
         return true;
     }
 
-    void CursorManager::_deregisterCursor_inlock( ClientCursor* cc ) {
+    void CursorManager::_deregisterCursor_inlock( Partition* partition, ClientCursor* cc ) {
         invariant( cc );
         CursorId id = cc->cursorid();
-        _cursors.erase( id );
+        partition->cursors.erase( id );
     }
 
 }
@@ -35,13 +35,13 @@
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/record_id.h"
+#include "mongo/platform/random.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
     class OperationContext;
-    class PseudoRandom;
     class PlanExecutor;
 
     class CursorManager {
@@ -138,20 +138,39 @@ namespace mongo {
         static std::size_t timeoutCursorsGlobal(OperationContext* txn, int millisSinceLastCall);
 
     private:
-        CursorId _allocateCursorId_inlock();
-        void _deregisterCursor_inlock( ClientCursor* cc );
+        /**
+         * A slice of the registered executors and cursors with its own lock.  Cursors are spread
+         * across the partitions by id and executors by address, so that getMores on different
+         * cursors and concurrent queries registering their executors don't contend on one mutex.
+         * Operations on the whole manager lock one partition at a time.
+         */
+        struct Partition {
+            Partition() : mutex( "CursorManager" ) { }
 
-        NamespaceString _nss;
-        unsigned _collectionCacheRuntimeId;
-        std::unique_ptr<PseudoRandom> _random;
+            typedef unordered_set<PlanExecutor*> ExecSet;
+            typedef std::map<CursorId,ClientCursor*> CursorMap;
+
+            SimpleMutex mutex;
+            ExecSet nonCachedExecutors;
+            CursorMap cursors;
 
-        mutable SimpleMutex _mutex;
+            // Generates the random part of the ids of cursors registered by threads which
+            // picked this partition; not related to the partition the cursor ends up in.
+            std::unique_ptr<PseudoRandom> random;
+        };
 
-        typedef unordered_set<PlanExecutor*> ExecSet;
-        ExecSet _nonCachedExecutors;
+        static const size_t kNumPartitions = 16;
+
+        Partition& _partitionFor( CursorId id );
+        Partition& _partitionFor( PlanExecutor* exec );
+
+        CursorId _allocateCursorId();
+        void _deregisterCursor_inlock( Partition* partition, ClientCursor* cc );
+
+        NamespaceString _nss;
+        unsigned _collectionCacheRuntimeId;
 
-        typedef std::map<CursorId,ClientCursor*> CursorMap;
-        CursorMap _cursors;
+        mutable Partition _partitions[kNumPartitions];
     };
 
 }
@@ -57,6 +57,7 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/latency_stats.h"
 #include "mongo/db/stats/top.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/storage/storage_engine.h"
@@ -387,6 +388,7 @@ namespace mongo {
         LOG(1) << "\t dropIndexes done" << endl;
 
         Top::get(txn->getClient()->getServiceContext()).collectionDropped(fullns);
+        LatencyStats::get(txn->getClient()->getServiceContext()).collectionDropped(fullns);
 
         s = _dbEntry->dropCollection( txn, fullns );
 
@@ -467,6 +469,7 @@ namespace mongo {
             _clearCollectionCache(txn, toNS, clearCacheReason);
 
             Top::get(txn->getClient()->getServiceContext()).collectionDropped(fromNS.toString());
+            LatencyStats::get(txn->getClient()->getServiceContext()).collectionDropped(fromNS);
         }
 
         txn->recoveryUnit()->registerChange( new AddCollectionChange(this, toNS) );
@@ -1157,6 +1157,29 @@ namespace {
         return index->accessMethod()->insert(txn, obj, loc, options, &inserted);
     }
 
+    Status IndexCatalog::_indexRecords(OperationContext* txn,
+                                       IndexCatalogEntry* index,
+                                       const std::vector<BsonRecord>& bsonRecords) {
+        const MatchExpression* filter = index->getFilterExpression();
+        std::vector<BsonRecord> filteredRecords;
+        if ( filter ) {
+            for ( const auto& record : bsonRecords ) {
+                if ( filter->matchesBSON( *record.docPtr ) )
+                    filteredRecords.push_back( record );
+            }
+        }
+
+        InsertDeleteOptions options;
+        options.logIfError = false;
+        options.dupsAllowed = isDupsAllowed( index->descriptor() );
+
+        int64_t inserted;
+        return index->accessMethod()->insertMany(txn,
+                                                 filter ? filteredRecords : bsonRecords,
+                                                 options,
+                                                 &inserted);
+    }
+
     Status IndexCatalog::_unindexRecord(OperationContext* txn,
                                         IndexCatalogEntry* index,
                                         const BSONObj& obj,
@@ -1199,6 +1222,20 @@ namespace {
         return Status::OK();
     }
 
+    Status IndexCatalog::indexRecords(OperationContext* txn,
+                                      const std::vector<BsonRecord>& bsonRecords) {
+
+        for ( IndexCatalogEntryContainer::const_iterator i = _entries.begin();
+              i != _entries.end();
+              ++i ) {
+            Status s = _indexRecords(txn, *i, bsonRecords);
+            if (!s.isOK())
+                return s;
+        }
+
+        return Status::OK();
+    }
+
     void IndexCatalog::unindexRecord(OperationContext* txn,
                                      const BSONObj& obj,
                                      const RecordId& loc,
@@ -45,6 +45,7 @@ namespace mongo {
 
     class IndexDescriptor;
     class IndexAccessMethod;
+    struct BsonRecord;
 
     /**
      * how many: 1 per Collection
@@ -269,6 +270,12 @@ namespace mongo {
         // this throws for now
         Status indexRecord(OperationContext* txn, const BSONObj& obj, const RecordId &loc);
 
+        /**
+         * Indexes a batch of documents, handing each index all of the batch's keys at once.
+         * On failure the caller must abandon the enclosing WriteUnitOfWork.
+         */
+        Status indexRecords(OperationContext* txn, const std::vector<BsonRecord>& bsonRecords);
+
         void unindexRecord(OperationContext* txn,
                            const BSONObj& obj,
                            const RecordId& loc,
@@ -306,6 +313,10 @@ namespace mongo {
                             const BSONObj& obj,
                             const RecordId &loc );
 
+        Status _indexRecords(OperationContext* txn,
+                             IndexCatalogEntry* index,
+                             const std::vector<BsonRecord>& bsonRecords);
+
         Status _unindexRecord(OperationContext* txn,
                               IndexCatalogEntry* index,
                               const BSONObj& obj,
@@ -44,10 +44,14 @@
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/sorter/sorter_spill.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/old_thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
@@ -88,6 +92,178 @@ namespace mongo {
         MultiIndexBlock* const _indexer;
     };
 
+namespace {
+    // Number of threads generating and sorting index keys during a foreground index build. 0
+    // means one per core, and 1 generates all keys on the thread running the build.
+    MONGO_EXPORT_SERVER_PARAMETER(indexBuildKeyGenerationThreads, int, 0);
+
+    // Collections smaller than this are not worth starting threads for.
+    const long long kMinRecordsForParallelKeyGeneration = 10 * 1000;
+
+    // Each key generation thread gets an equal share of an index's bulk build memory, and
+    // fewer threads are used than would leave a share smaller than this. Small shares spill
+    // many small runs, which then have to be merged again.
+    const size_t kMinBulkMemoryPerPartition = 16 * 1024 * 1024;
+
+    // Documents are handed to the key generation threads in batches of up to this size.
+    const size_t kMaxKeyGenerationBatchDocs = 1000;
+    const int kMaxKeyGenerationBatchBytes = 1024 * 1024;
+}  // namespace
+
+    /**
+     * Generates and sorts the keys of a foreground index build on several threads.
+     *
+     * Each thread has a partition with a BulkBuilder of its own for every index, so no Sorter is
+     * ever shared. Documents are processed in rounds: a round gives every partition a batch of
+     * documents and runs all of them on the thread pool, while the next round is read from the
+     * collection. finish() merges the keys of all partitions into the indexes' own BulkBuilders,
+     * which are then committed as usual.
+     *
+     * The partitions of an index split its bulk build memory and its sorterMaxOpenSpillFiles
+     * between them, so that together they hold no more memory or spill files than a single
+     * BulkBuilder would, including when their runs are all merged at commit time.
+     */
+    class MultiIndexBlock::ParallelBulkInserter {
+        MONGO_DISALLOW_COPYING(ParallelBulkInserter);
+    public:
+        ParallelBulkInserter(std::vector<IndexToBuild>* indexes, int numPartitions)
+            : _indexes(indexes),
+              _partitions(numPartitions),
+              _pool(numPartitions, "index build key generator ") {
+
+            const size_t memoryPerPartition =
+                IndexAccessMethod::kDefaultMaxBulkMemoryUsageBytes / numPartitions;
+            const size_t spillFilesPerPartition = sorter::maxOpenSpillFiles() / numPartitions;
+            invariant(spillFilesPerPartition >= 2);
+            for (auto&& partition : _partitions) {
+                for (auto&& index : *_indexes) {
+                    partition.bulks.push_back(index.real->initiateBulk(memoryPerPartition,
+                                                                       spillFilesPerPartition));
+                }
+            }
+        }
+
+        /**
+         * Queues 'doc' to have its keys inserted. 'doc' must be owned. Returns an error if the
+         * key generation for an earlier document failed.
+         */
+        Status add(const BSONObj& doc, const RecordId& loc) {
+            Partition& partition = _partitions[_fillingPartition];
+            partition.docs.push_back(std::make_pair(doc, loc));
+            partition.docsBytes += doc.objsize();
+
+            if (partition.docs.size() < kMaxKeyGenerationBatchDocs
+                    && partition.docsBytes < kMaxKeyGenerationBatchBytes) {
+                return Status::OK();
+            }
+
+            if (++_fillingPartition < _partitions.size()) {
+                return Status::OK();
+            }
+
+            return _startRound();
+        }
+
+        /**
+         * Waits for all queued documents to be processed, and hands their keys over to the
+         * BulkBuilders of the indexes being built.
+         */
+        Status finish() {
+            Status status = _startRound();
+            if (!status.isOK()) {
+                return status;
+            }
+
+            status = _waitForRound();
+            if (!status.isOK()) {
+                return status;
+            }
+
+            for (auto&& partition : _partitions) {
+                for (size_t i = 0; i < _indexes->size(); i++) {
+                    (*_indexes)[i].bulk->merge(std::move(partition.bulks[i]));
+                }
+            }
+            return Status::OK();
+        }
+
+    private:
+        typedef std::vector<std::pair<BSONObj, RecordId>> Batch;
+
+        struct Partition {
+            Batch docs; // filled by the build thread
+            int docsBytes = 0;
+            Batch inProgress; // processed by a key generation thread
+            std::vector<std::unique_ptr<IndexAccessMethod::BulkBuilder>> bulks;
+            Status status = Status::OK();
+        };
+
+        Status _waitForRound() {
+            _pool.join();
+            for (auto&& partition : _partitions) {
+                if (!partition.status.isOK()) {
+                    return partition.status;
+                }
+            }
+            return Status::OK();
+        }
+
+        Status _startRound() {
+            Status status = _waitForRound();
+            if (!status.isOK()) {
+                return status;
+            }
+
+            for (auto&& partition : _partitions) {
+                partition.inProgress.clear();
+                partition.inProgress.swap(partition.docs);
+                partition.docsBytes = 0;
+                if (!partition.inProgress.empty()) {
+                    _pool.schedule(&ParallelBulkInserter::_processBatch, this, &partition);
+                }
+            }
+            _fillingPartition = 0;
+            return Status::OK();
+        }
+
+        void _processBatch(Partition* partition) {
+            try {
+                for (auto&& doc : partition->inProgress) {
+                    for (size_t i = 0; i < _indexes->size(); i++) {
+                        const IndexToBuild& index = (*_indexes)[i];
+                        if (index.filterExpression
+                                && !index.filterExpression->matchesBSON(doc.first)) {
+                            continue;
+                        }
+
+                        // Bulk inserts only generate keys, which does not need an
+                        // OperationContext.
+                        int64_t unused;
+                        Status status = partition->bulks[i]->insert(NULL,
+                                                                    doc.first,
+                                                                    doc.second,
+                                                                    index.options,
+                                                                    &unused);
+                        if (!status.isOK()) {
+                            partition->status = status;
+                            return;
+                        }
+                    }
+                }
+            }
+            catch (const DBException& ex) {
+                partition->status = ex.toStatus();
+            }
+        }
+
+        std::vector<IndexToBuild>* const _indexes;
+        std::vector<Partition> _partitions;
+        size_t _fillingPartition = 0;
+
+        // Must be destroyed first, since its destructor waits for the batches in progress.
+        OldThreadPool _pool;
+    };
+
     MultiIndexBlock::MultiIndexBlock(OperationContext* txn, Collection* collection)
         : _collection(collection),
           _txn(txn),
@@ -246,6 +422,13 @@ namespace mongo {
             exec->setYieldPolicy(PlanExecutor::WRITE_CONFLICT_RETRY_ONLY);
         }
 
+        std::unique_ptr<ParallelBulkInserter> parallelInserter;
+        const int numThreads = _numKeyGenerationThreads(numRecords);
+        if (numThreads > 1) {
+            log() << "generating index keys on " << numThreads << " threads";
+            parallelInserter.reset(new ParallelBulkInserter(&_indexes, numThreads));
+        }
+
         Snapshotted<BSONObj> objToIndex;
         RecordId loc;
         PlanExecutor::ExecState state;
@@ -268,6 +451,19 @@ namespace mongo {
                 // Done before insert so we can retry document if it WCEs.
                 progress->setTotalWhileRunning( _collection->numRecords(_txn) );
 
+                if (parallelInserter) {
+                    // Bulk inserts never write to the index, so there is nothing to roll back
+                    // and no duplicate key to report until the keys are committed.
+                    Status ret = parallelInserter->add(objToIndex.value().getOwned(), loc);
+                    if (!ret.isOK()) {
+                        return ret;
+                    }
+                    progress->hit();
+                    n++;
+                    retries = 0;
+                    continue;
+                }
+
                 WriteUnitOfWork wunit(_txn);
                 Status ret = insert(objToIndex.value(), loc);
                 if (ret.isOK()) {
@@ -312,6 +508,13 @@ namespace mongo {
                       "Unable to complete index build as the collection is no longer readable");
         }
 
+        if (parallelInserter) {
+            Status ret = parallelInserter->finish();
+            if (!ret.isOK())
+                return ret;
+            parallelInserter.reset();
+        }
+
         progress->finished();
 
         Status ret = doneInserting(dupsOut);
@@ -324,6 +527,35 @@ namespace mongo {
         return Status::OK();
     }
 
+    int MultiIndexBlock::_numKeyGenerationThreads(long long numRecords) const {
+        if (_buildInBackground || numRecords < kMinRecordsForParallelKeyGeneration) {
+            return 1;
+        }
+
+        for (size_t i = 0; i < _indexes.size(); i++) {
+            // Only btree key generation is known to be safe to run on several threads at once.
+            if (!_indexes[i].bulk
+                    || _indexes[i].block->getEntry()->descriptor()->getAccessMethodName()
+                           != IndexNames::BTREE) {
+                return 1;
+            }
+        }
+
+        int numThreads = indexBuildKeyGenerationThreads;
+        if (numThreads <= 0) {
+            ProcessInfo p;
+            numThreads = p.getNumCores();
+        }
+
+        // Every thread needs a worthwhile share of the bulk build memory, and room for at least
+        // two spilled runs so that its sorter can merge them.
+        const int maxThreadsForMemory = static_cast<int>(
+            IndexAccessMethod::kDefaultMaxBulkMemoryUsageBytes / kMinBulkMemoryPerPartition);
+        const int maxThreadsForSpillFiles = static_cast<int>(sorter::maxOpenSpillFiles() / 2);
+        numThreads = std::min(numThreads, std::min(maxThreadsForMemory, maxThreadsForSpillFiles));
+        return std::max(numThreads, 1);
+    }
+
     Status MultiIndexBlock::insert(const BSONObj& doc, const RecordId& loc) {
         for ( size_t i = 0; i < _indexes.size(); i++ ) {
 
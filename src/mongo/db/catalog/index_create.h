@@ -181,6 +181,13 @@ namespace mongo {
     private:
         class SetNeedToCleanupOnRollback;
         class CleanupIndexesVectorOnRollback;
+        class ParallelBulkInserter;
+
+        /**
+         * Returns the number of threads to generate keys on in insertAllDocumentsInCollection, or
+         * 1 if this build must generate them on the calling thread.
+         */
+        int _numKeyGenerationThreads(long long numRecords) const;
 
         struct IndexToBuild {
 #if defined(_MSC_VER) && _MSC_VER < 1900 // MVSC++ <= 2013 can't generate default move operations
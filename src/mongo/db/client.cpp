@@ -42,6 +42,7 @@
 #include "mongo/base/status.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/service_context.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/exit.h"
@@ -89,6 +90,23 @@ namespace mongo {
         *currentClient.get() = service->makeClient(fullDesc, mp);
     }
 
+    ServiceContext::UniqueClient Client::releaseCurrent() {
+        invariant(currentClient.getMake()->get());
+        return std::move(*currentClient.get());
+    }
+
+    void Client::setCurrent(ServiceContext::UniqueClient client) {
+        invariant(client);
+        invariant(currentClient.getMake()->get() == nullptr);
+
+        setThreadName(client->desc().c_str());
+        {
+            stdx::lock_guard<Client> lk(*client);
+            client->_threadId = stdx::this_thread::get_id();
+        }
+        *currentClient.get() = std::move(client);
+    }
+
     Client::Client(std::string desc,
                    ServiceContext* serviceContext,
                    AbstractMessagingPort *p)
@@ -74,6 +74,19 @@ namespace mongo {
          */
         static void initThreadIfNotAlready();
 
+        /**
+         * Detaches the Client from the current thread and returns ownership of it, leaving the
+         * thread without a Client. Used to move a connection's Client between the threads of a
+         * worker pool.
+         */
+        static ServiceContext::UniqueClient releaseCurrent();
+
+        /**
+         * Attaches 'client' to the current thread, which must not already have a Client, and
+         * names the thread after it.
+         */
+        static void setCurrent(ServiceContext::UniqueClient client);
+
         std::string clientAddress(bool includePort = false) const;
         const std::string& desc() const { return _desc; }
 
@@ -132,7 +145,7 @@ namespace mongo {
         const std::string _desc;
 
         // OS id of the thread, which owns this client
-        const stdx::thread::id _threadId;
+        stdx::thread::id _threadId;
 
         // > 0 for things "conn", 0 otherwise
         const ConnectionId _connectionId;
@@ -0,0 +1,103 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/base/init.h"
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/client.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/stats/latency_stats.h"
+#include "mongo/db/commands.h"
+
+namespace {
+
+    using namespace mongo;
+
+    /**
+     * Like top, but reports latency histograms per collection rather than totals.  Collections
+     * are only tracked while the trackLatencyHistogramsByNamespace server parameter is set.
+     */
+    class LatencyTopCommand : public Command {
+    public:
+        LatencyTopCommand() : Command("latencyTop", true) {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual void help(std::stringstream& help) const {
+            help << "latency histograms by collection and operation type, in micros; "
+                 << "set the trackLatencyHistogramsByNamespace parameter to collect them";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::top);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+        virtual bool run(OperationContext* txn,
+                         const std::string& db,
+                         BSONObj& cmdObj,
+                         int options,
+                         std::string& errmsg,
+                         BSONObjBuilder& result) {
+            LatencyStats& stats = LatencyStats::get(txn->getClient()->getServiceContext());
+            {
+                BSONObjBuilder b(result.subobjStart("totals"));
+                b.append("note", "all times in microseconds");
+                stats.appendByOpType(b);
+                b.done();
+            }
+            {
+                BSONObjBuilder b(result.subobjStart("namespaces"));
+                stats.appendByNamespace(b);
+                b.done();
+            }
+            return true;
+        }
+
+    };
+
+    //
+    // Command instance.
+    // Registers command with the command system and make command
+    // available to the client.
+    //
+
+    MONGO_INITIALIZER(RegisterLatencyTopCommand)(InitializerContext* context) {
+
+        new LatencyTopCommand();
+
+        return Status::OK();
+    }
+} // namespace
@@ -168,7 +168,7 @@ namespace mongo {
         virtual bool slaveOverrideOk() const { return true; }
         virtual void help(stringstream &help) const {
             help << "{ pipeline: [ { $operator: {...}}, ... ]"
-                 << ", explain: <bool>"
+                 << ", explain: <bool or \"executionStats\">"
                  << ", allowDiskUse: <bool>"
                  << ", cursor: {batchSize: <number>}"
                  << " }"
@@ -299,6 +299,13 @@ namespace mongo {
 
                 // If both explain and cursor are specified, explain wins.
                 if (pPipeline->isExplain()) {
+                    if (pCtx->explainExecStats) {
+                        // Stages such as $group and $sort only know what they did, for instance
+                        // whether they spilled, once the pipeline has run.
+                        DocumentSource* finalSource = pPipeline->output();
+                        while (finalSource->getNext()) {
+                        }
+                    }
                     result << "stages" << Value(pPipeline->writeExplainOps());
                 }
                 else if (isCursorCommand) {
@@ -267,6 +267,14 @@ namespace mongo {
         }
         arrayBuilder.doneFast();
 
+        const PlanCacheStats stats = planCache.getStats();
+        BSONObjBuilder statsBuilder(bob->subobjStart("stats"));
+        statsBuilder.append("hits", stats.hits);
+        statsBuilder.append("misses", stats.misses);
+        statsBuilder.append("evictions", stats.evictions);
+        statsBuilder.append("regressionEvictions", stats.regressionEvictions);
+        statsBuilder.doneFast();
+
         return Status::OK();
     }
 
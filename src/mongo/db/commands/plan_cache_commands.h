@@ -121,7 +121,8 @@ namespace mongo {
 
         /**
          * Looks up cache keys for collection's plan cache.
-         * Inserts keys for query into BSON builder.
+         * Inserts keys for query into BSON builder, followed by the cache's lookup and eviction
+         * counts.
          */
         static Status list(const PlanCache& planCache, BSONObjBuilder* bob);
     };
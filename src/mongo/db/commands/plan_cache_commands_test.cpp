@@ -145,6 +145,29 @@ namespace {
         ASSERT_EQUALS(shapes[0].getObjectField("projection"), cq->getParsed().getProj());
     }
 
+    TEST(PlanCacheCommandsTest, planCacheListQueryShapesStats) {
+        CanonicalQuery* cqRaw;
+        ASSERT_OK(CanonicalQuery::canonicalize(ns, fromjson("{a: 1}"), &cqRaw));
+        unique_ptr<CanonicalQuery> cq(cqRaw);
+
+        PlanCache planCache;
+        CachedSolution* rawCachedSolution;
+        ASSERT_NOT_OK(planCache.get(*cq, &rawCachedSolution));
+
+        QuerySolution qs;
+        qs.cacheData.reset(createSolutionCacheData());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+        planCache.add(*cq, solns, createDecision(1U));
+        ASSERT_OK(planCache.get(*cq, &rawCachedSolution));
+        delete rawCachedSolution;
+
+        BSONObjBuilder bob;
+        ASSERT_OK(PlanCacheListQueryShapes::list(planCache, &bob));
+        ASSERT_EQUALS(bob.obj().getObjectField("stats"),
+                      BSON("hits" << 1LL << "misses" << 1LL << "evictions" << 0LL));
+    }
+
     /**
      * Tests for planCacheClear
      */
@@ -110,6 +110,11 @@ namespace mongo {
             std::unique_ptr<WriteErrorDetail> _error;
         };
 
+        // Limits on the number of documents, and their total size, which execInserts will hand
+        // to the storage engine in a single group.
+        const size_t kMaxInsertGroupDocs = 64;
+        const size_t kMaxInsertGroupBytes = 256 * 1024;
+
     }  // namespace
 
     // TODO: Determine queueing behavior we want here
@@ -867,6 +872,12 @@ namespace mongo {
                 elapsedTracker.resetLastTime();
             }
 
+            if (execInsertGroup(&state, errors)) {
+                if (request.getOrdered() && !errors->empty())
+                    return;
+                continue;
+            }
+
             WriteErrorDetail* error = NULL;
             execOneInsert(&state, &error);
             if (error) {
@@ -1134,6 +1145,135 @@ namespace mongo {
         }
     }
 
+    bool WriteBatchExecutor::execInsertGroup(ExecInsertsState* state,
+                                             std::vector<WriteErrorDetail*>* errors) {
+        const BatchedCommandRequest& request = *state->request;
+        if (request.isInsertIndexRequest()) {
+            return false;
+        }
+
+        std::vector<BSONObj> docs;
+        size_t groupBytes = 0;
+        for (size_t i = state->currIndex;
+             i < state->normalizedInserts.size()
+                 && docs.size() < kMaxInsertGroupDocs
+                 && groupBytes < kMaxInsertGroupBytes;
+             ++i) {
+
+            const StatusWith<BSONObj>& normalizedInsert = state->normalizedInserts[i];
+            if (!normalizedInsert.isOK()) {
+                break;
+            }
+
+            docs.push_back(normalizedInsert.getValue().isEmpty() ?
+                               request.getInsertRequest()->getDocumentsAt(i) :
+                               normalizedInsert.getValue());
+            groupBytes += docs.back().objsize();
+        }
+
+        // A lone document takes the regular path.
+        if (docs.size() < 2) {
+            return false;
+        }
+
+        const size_t groupBegin = state->currIndex;
+        const size_t groupEnd = groupBegin + docs.size();
+        if (groupEnd == request.sizeWriteOps()) {
+            setupSynchronousCommit(_txn);
+        }
+
+        BatchItemRef firstInsertItem(&request, groupBegin);
+        CurOp currentOp(_txn);
+        beginCurrentOp(_txn, firstInsertItem);
+
+        WriteOpResult result;
+        bool insertOneAtATime = false;
+        try {
+            if (state->lockAndCheck(&result)) {
+                Collection* collection = state->getCollection();
+                invariant(_txn->lockState()->isCollectionLockedForMode(collection->ns().ns(),
+                                                                       MODE_IX));
+
+                // Capped collections may delete documents of the group while inserting it, so
+                // they are written one document at a time.
+                if (collection->isCapped()) {
+                    insertOneAtATime = true;
+                }
+                else {
+                    WriteUnitOfWork wunit(_txn);
+                    Status status = collection->insertDocuments(_txn,
+                                                                docs.begin(),
+                                                                docs.end(),
+                                                                true);
+                    if (status.isOK()) {
+                        wunit.commit();
+                        result.getStats().n = docs.size();
+                    }
+                    else {
+                        insertOneAtATime = true;
+                    }
+                }
+            }
+            else {
+                insertOneAtATime = true;
+            }
+        }
+        catch (const DBException& ex) {
+            // Write conflicts, stale shard versions and the like are all handled by the one
+            // document at a time path, which is where the group falls back to.
+            Status status(ex.toStatus());
+            if (ErrorCodes::isInterruption(status.code()))
+                throw;
+            insertOneAtATime = true;
+        }
+
+        if (!insertOneAtATime) {
+            for (size_t i = groupBegin; i < groupEnd; ++i) {
+                incOpStats(BatchItemRef(&request, i));
+            }
+            incWriteStats(firstInsertItem, result.getStats(), NULL, &currentOp);
+            finishCurrentOp(_txn, NULL);
+
+            state->currIndex = groupEnd - 1;
+            return true;
+        }
+
+        // Nothing of the group was written. Insert its documents one at a time, so that any
+        // error is reported against the right document, and report the group's op once they
+        // are all done.
+        _txn->recoveryUnit()->abandonSnapshot();
+        state->unlock();
+
+        WriteErrorDetail* lastError = NULL;
+        for (state->currIndex = groupBegin; state->currIndex < groupEnd; ++state->currIndex) {
+            BatchItemRef currInsertItem(&request, state->currIndex);
+            incOpStats(currInsertItem);
+
+            WriteOpResult docResult;
+            insertOne(state, &docResult);
+
+            incWriteStats(currInsertItem,
+                          docResult.getStats(),
+                          docResult.getError(),
+                          &currentOp);
+
+            if (docResult.getError()) {
+                lastError = docResult.releaseError();
+                lastError->setIndex(state->currIndex);
+                errors->push_back(lastError);
+                if (request.getOrdered())
+                    break;
+            }
+        }
+
+        if (state->currIndex == groupEnd) {
+            --state->currIndex;
+        }
+        finishCurrentOp(_txn, lastError);
+
+        return true;
+    }
+
     /**
      * Perform a single insert into a collection.  Requires the insert be preprocessed and the
      * collection already has been created.
@@ -100,6 +100,18 @@ namespace mongo {
          */
         void execOneInsert( ExecInsertsState* state, WriteErrorDetail** error );
 
+        /**
+         * Inserts the run of valid documents starting at the current insert of "state" as one
+         * op, with a single call to Collection::insertDocuments.  If that fails, or the
+         * collection is capped, the documents are inserted one at a time instead, so that any
+         * error is reported against the right document.  Errors are appended to "errors", and
+         * an ordered batch stops at the first one.
+         *
+         * Returns false, having done nothing, if no group of at least two documents could be
+         * formed.  Otherwise leaves the current insert of "state" at the last document handled.
+         */
+        bool execInsertGroup( ExecInsertsState* state, std::vector<WriteErrorDetail*>* errors );
+
         /**
          * Executes an update item (which may update many documents or upsert), and returns the
          * upserted _id on upsert or error on failure.
@@ -27,9 +27,12 @@
  */
 
 #include "mongo/base/counter.h"
+#include "mongo/db/client.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/latency_stats.h"
 
 namespace mongo {
 namespace {
@@ -60,10 +63,15 @@ namespace {
     ServerStatusMetricField<Counter64> displayWriteConflicts("operation.writeConflicts",
                                                                      &writeConflictsCounter);
 
+    // Per namespace latency histograms cost a few kilobytes per collection, so they are off
+    // unless asked for.
+    MONGO_EXPORT_SERVER_PARAMETER(trackLatencyHistogramsByNamespace, bool, false);
+
 }  // namespace
 
     void recordCurOpMetrics(OperationContext* opCtx) {
-        const OpDebug& debug = CurOp::get(opCtx)->debug();
+        CurOp* curOp = CurOp::get(opCtx);
+        const OpDebug& debug = curOp->debug();
         if (debug.nreturned > 0)
             returnedCounter.increment(debug.nreturned);
         if (debug.ninserted > 0)
@@ -85,6 +93,17 @@ namespace {
             fastmodCounter.increment();
         if (debug.writeConflicts)
             writeConflictsCounter.increment(debug.writeConflicts);
+
+        LatencyStats::OpType opType;
+        if (LatencyStats::opTypeFor(curOp->getOp(), curOp->isCommand(), &opType)) {
+            LatencyStats& latencyStats =
+                LatencyStats::get(opCtx->getClient()->getServiceContext());
+            const long long micros = curOp->totalTimeMicros();
+            latencyStats.record(opType, micros);
+            if (trackLatencyHistogramsByNamespace) {
+                latencyStats.recordForNamespace(curOp->getNS(), opType, micros);
+            }
+        }
     }
 
 }  // namespace mongo
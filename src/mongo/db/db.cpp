@@ -156,6 +156,19 @@ namespace mongo {
             Client::initThread("conn", p);
         }
 
+        // All per-connection state of mongod hangs off its Client, so a connection can be
+        // serviced by any thread as long as the Client moves along with it.
+        virtual bool canShareThreads() const { return true; }
+
+        virtual std::unique_ptr<ThreadState> releaseThreadState( AbstractMessagingPort* p ) {
+            return stdx::make_unique<ClientState>(Client::releaseCurrent());
+        }
+
+        virtual void restoreThreadState( AbstractMessagingPort* p,
+                                         std::unique_ptr<ThreadState> state ) {
+            Client::setCurrent(std::move(static_cast<ClientState*>(state.get())->client));
+        }
+
         virtual void process(Message& m , AbstractMessagingPort* port) {
             while ( true ) {
                 if ( inShutdown() ) {
@@ -200,6 +213,12 @@ namespace mongo {
                 break;
             }
         }
+
+    private:
+        struct ClientState : public ThreadState {
+            explicit ClientState(ServiceContext::UniqueClient c) : client(std::move(c)) {}
+            ServiceContext::UniqueClient client;
+        };
     };
 
     static void logStartup() {
@@ -26,6 +26,8 @@
  *    it in the license file.
  */
 
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
 #include "mongo/db/exec/and_hash.h"
 
 #include "mongo/db/exec/and_common-inl.h"
@@ -33,12 +35,18 @@
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/bufreader.h"
+#include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace {
 
     // Upper limit for buffered data.
-    // Stage execution will fail once size of all buffered data exceeds this threshold.
+    // Stage execution will fail once size of all buffered data exceeds this threshold, unless it
+    // can spill.
     const size_t kDefaultMaxMemUsageBytes = 32 * 1024 * 1024;
 
 } // namespace
@@ -48,6 +56,77 @@ namespace mongo {
     using std::unique_ptr;
     using std::vector;
 
+    namespace {
+
+        typedef std::pair<AndHashStage::SpillKey, SpilledWorkingSetMember> SpillData;
+
+        class SpillKeyComparator {
+        public:
+            int operator()(const SpillData& lhs, const SpillData& rhs) const {
+                int result = lhs.first.loc.compare(rhs.first.loc);
+                if (0 != result) {
+                    return result;
+                }
+                if (lhs.first.seq == rhs.first.seq) {
+                    return 0;
+                }
+                return lhs.first.seq < rhs.first.seq ? -1 : 1;
+            }
+        };
+
+        /**
+         * Reads spilled results one ahead, so that two sorted streams can be merged.
+         */
+        class SpillReader {
+        public:
+            typedef SortIteratorInterface<AndHashStage::SpillKey, SpilledWorkingSetMember> Iterator;
+
+            explicit SpillReader(Iterator* it) : _it(it) { advance(); }
+
+            bool more() const { return _hasNext; }
+            const AndHashStage::SpillKey& key() const { return _next.first; }
+            const SpilledWorkingSetMember& member() const { return _next.second; }
+
+            void advance() {
+                _hasNext = _it->more();
+                if (_hasNext) {
+                    _next = _it->next();
+                    _next.second = _next.second.getOwned();
+                }
+            }
+
+            /**
+             * Skips the results for the current RecordId.
+             */
+            void skipLoc() {
+                const RecordId loc = _next.first.loc;
+                do {
+                    advance();
+                } while (_hasNext && _next.first.loc == loc);
+            }
+
+        private:
+            Iterator* _it;
+            bool _hasNext;
+            SpillData _next;
+        };
+
+    }  // namespace
+
+    void AndHashStage::SpillKey::serializeForSorter(BufBuilder& buf) const {
+        loc.serializeForSorter(buf);
+        buf.appendNum(seq);
+    }
+
+    // static
+    AndHashStage::SpillKey AndHashStage::SpillKey::deserializeForSorter(
+            BufReader& buf, const SorterDeserializeSettings&) {
+        const RecordId loc = RecordId::deserializeForSorter(buf,
+                                                            RecordId::SorterDeserializeSettings());
+        const long long seq = buf.read<long long>();
+        return SpillKey(loc, seq);
+    }
+
     const size_t AndHashStage::kLookAheadWorks = 10;
 
     // static
@@ -63,7 +142,9 @@ namespace mongo {
           _currentChild(0),
           _commonStats(kStageType),
           _memUsage(0),
-          _maxMemUsage(kDefaultMaxMemUsageBytes) {}
+          _maxMemUsage(kDefaultMaxMemUsageBytes),
+          _spilled(false),
+          _spillSeq(0) {}
 
     AndHashStage::AndHashStage(WorkingSet* ws, 
                                const MatchExpression* filter,
@@ -76,7 +157,9 @@ namespace mongo {
           _currentChild(0),
           _commonStats(kStageType),
           _memUsage(0),
-          _maxMemUsage(maxMemUsage) {}
+          _maxMemUsage(maxMemUsage),
+          _spilled(false),
+          _spillSeq(0) {}
 
     AndHashStage::~AndHashStage() {
         for (size_t i = 0; i < _children.size(); ++i) { delete _children[i]; }
@@ -97,6 +180,13 @@ namespace mongo {
 
         // Or we're streaming in results from the last child.
 
+        if (_spilled) {
+            // We're reading the last child while there's an intersection to probe, and then
+            // returning the results.
+            if (_intersection) { return false; }
+            return !_spilledResults || !_spilledResults->more();
+        }
+
         // If there's nothing to probe against, we're EOF.
         if (_dataMap.empty()) { return true; }
 
@@ -181,7 +271,12 @@ namespace mongo {
         // We read the first child into our hash table.
         if (_hashingChildren) {
             // Check memory usage of previously hashed results.
-            if (_memUsage > _maxMemUsage) {
+            if (_memUsage > _maxMemUsage
+                && internalQueryExecBlockingStageSpill
+                && supportsDocLocking()) {
+                spill();
+            }
+            else if (_memUsage > _maxMemUsage) {
                 mongoutils::str::stream ss;
                 ss << "hashed AND stage buffered data usage of " << _memUsage
                    << " bytes exceeds internal limit of " << kDefaultMaxMemUsageBytes << " bytes";
@@ -204,6 +299,10 @@ namespace mongo {
             }
         }
 
+        if (_spilled) {
+            return workSpilled(out);
+        }
+
         // Returning results.  We read from the last child and return the results that are in our
         // hash map.
 
@@ -288,6 +387,12 @@ namespace mongo {
                 return PlanStage::NEED_TIME;
             }
 
+            if (_spilled) {
+                addToChildSorter(id);
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
             if (!_dataMap.insert(std::make_pair(member->loc, id)).second) {
                 // Didn't insert because we already had this loc inside the map. This should only
                 // happen if we're seeing a newer copy of the same doc in a more recent snapshot.
@@ -307,6 +412,16 @@ namespace mongo {
             // Done reading child 0.
             _currentChild = 1;
 
+            if (_spilled) {
+                // Duplicates are dropped when the output is merged with the next child.
+                _specificStats.mapAfterChild.push_back(_spillSeq);
+                _intersection.reset(_childSorter->done());
+                _childSorter.reset(makeSpillSorter());
+                _spillSeq = 0;
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
             // If our first child was empty, don't scan any others, no possible results.
             if (_dataMap.empty()) {
                 _hashingChildren = false;
@@ -361,6 +476,12 @@ namespace mongo {
             }
 
             verify(member->hasLoc());
+            if (_spilled) {
+                addToChildSorter(id);
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
             if (_dataMap.end() == _dataMap.find(member->loc)) {
                 // Ignore.  It's not in any previous child.
             }
@@ -383,6 +504,21 @@ namespace mongo {
             // Finished with a child.
             ++_currentChild;
 
+            if (_spilled) {
+                const size_t intersectionSize = mergeSpilledChild();
+                _specificStats.mapAfterChild.push_back(intersectionSize);
+                _seenMap.clear();
+
+                if (0 == intersectionSize) {
+                    _intersection.reset();
+                    _hashingChildren = false;
+                    return PlanStage::IS_EOF;
+                }
+
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
             // Keep elements of _dataMap that are in _seenMap.
             DataMap::iterator it = _dataMap.begin();
             while (it != _dataMap.end()) {
@@ -447,6 +583,156 @@ namespace mongo {
         }
     }
 
+    AndHashStage::SpillSorter* AndHashStage::makeSpillSorter() {
+        SortOptions opts = SortOptions().MaxMemoryUsageBytes(_maxMemUsage)
+                                        .ExtSortAllowed()
+                                        .TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                        .SpillStats(&_spillStats);
+        return SpillSorter::make(opts, SpillKeyComparator());
+    }
+
+    void AndHashStage::spill() {
+        LOG(1) << "hashed AND stage using more than " << _maxMemUsage
+               << " bytes, spilling to disk while reading child " << _currentChild;
+
+        unique_ptr<SpillSorter> sorter(makeSpillSorter());
+        for (DataMap::const_iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
+            sorter->add(SpillKey(it->first, 0),
+                        SpilledWorkingSetMember(*_ws->get(it->second), false, &_spilledIndexes));
+            _ws->free(it->second);
+        }
+        _dataMap.clear();
+        _memUsage = 0;
+        _spilled = true;
+
+        if (0 == _currentChild) {
+            // The hash table holds part of the first child's output.  The rest goes with it.
+            _childSorter.reset(sorter.release());
+        }
+        else {
+            // The hash table holds the intersection of the children before this one.  Which of
+            // its entries this child returned so far is still in _seenMap.
+            _intersection.reset(sorter->done());
+            _childSorter.reset(makeSpillSorter());
+        }
+    }
+
+    void AndHashStage::addToChildSorter(WorkingSetID id) {
+        WorkingSetMember* member = _ws->get(id);
+        _childSorter->add(SpillKey(member->loc, ++_spillSeq),
+                          SpilledWorkingSetMember(*member, false, &_spilledIndexes));
+        _ws->free(id);
+    }
+
+    size_t AndHashStage::mergeSpilledChild() {
+        unique_ptr<SpillIterator> childOutput(_childSorter->done());
+        unique_ptr<SpillSorter> merged(makeSpillSorter());
+        size_t intersectionSize = 0;
+
+        SpillReader older(_intersection.get());
+        SpillReader newer(childOutput.get());
+        while (older.more()) {
+            const RecordId loc = older.key().loc;
+            while (newer.more() && newer.key().loc < loc) {
+                newer.advance();
+            }
+
+            const bool inNewer = newer.more() && newer.key().loc == loc;
+            if (inNewer || _seenMap.end() != _seenMap.find(loc)) {
+                WorkingSetID olderID = older.member().restore(_ws, _spilledIndexes);
+                WorkingSetMember* olderMember = _ws->get(olderID);
+                for (; newer.more() && newer.key().loc == loc; newer.advance()) {
+                    WorkingSetID newerID = newer.member().restore(_ws, _spilledIndexes);
+                    AndCommon::mergeFrom(olderMember, *_ws->get(newerID));
+                    _ws->free(newerID);
+                }
+
+                merged->add(SpillKey(loc, 0),
+                            SpilledWorkingSetMember(*olderMember, false, &_spilledIndexes));
+                _ws->free(olderID);
+                ++intersectionSize;
+            }
+
+            // Only the first child's output can hold a RecordId more than once.  As when hashing,
+            // the first copy is kept.
+            older.skipLoc();
+        }
+
+        _intersection.reset(merged->done());
+        _childSorter.reset(makeSpillSorter());
+        _spillSeq = 0;
+        return intersectionSize;
+    }
+
+    void AndHashStage::mergeLastSpilledChild() {
+        unique_ptr<SpillIterator> childOutput(_childSorter->done());
+        _childSorter.reset();
+        unique_ptr<SpillSorter> results(makeSpillSorter());
+
+        SpillReader older(_intersection.get());
+        SpillReader newer(childOutput.get());
+        while (older.more() && newer.more()) {
+            const RecordId loc = older.key().loc;
+            if (newer.key().loc < loc) {
+                newer.advance();
+                continue;
+            }
+            if (loc < newer.key().loc) {
+                older.skipLoc();
+                continue;
+            }
+
+            // As when probing, the first copy the last child returned is the one kept.
+            WorkingSetID olderID = older.member().restore(_ws, _spilledIndexes);
+            WorkingSetID newerID = newer.member().restore(_ws, _spilledIndexes);
+            WorkingSetMember* olderMember = _ws->get(olderID);
+            AndCommon::mergeFrom(olderMember, *_ws->get(newerID));
+            _ws->free(newerID);
+
+            if (Filter::passes(olderMember, _filter)) {
+                results->add(SpillKey(RecordId(), newer.key().seq),
+                             SpilledWorkingSetMember(*olderMember, false, &_spilledIndexes));
+            }
+            _ws->free(olderID);
+
+            older.skipLoc();
+            newer.skipLoc();
+        }
+
+        _intersection.reset();
+        _spilledResults.reset(results->done());
+    }
+
+    PlanStage::StageState AndHashStage::workSpilled(WorkingSetID* out) {
+        if (_spilledResults) {
+            const SpillSorter::Data next = _spilledResults->next();
+            *out = next.second.restore(_ws, _spilledIndexes);
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        StageState childStatus = workChild(_children.size() - 1, out);
+        if (PlanStage::IS_EOF == childStatus) {
+            mergeLastSpilledChild();
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        if (PlanStage::ADVANCED != childStatus) {
+            return childStatus;
+        }
+
+        // Maybe the child had an invalidation.  We intersect RecordId(s) so we can't do anything
+        // with this WSM.
+        if (!_ws->get(*out)->hasLoc()) {
+            _ws->flagForReview(*out);
+            return PlanStage::NEED_TIME;
+        }
+
+        addToChildSorter(*out);
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
     void AndHashStage::saveState() {
         ++_commonStats.yields;
 
@@ -527,6 +813,9 @@ namespace mongo {
 
         _specificStats.memLimit = _maxMemUsage;
         _specificStats.memUsage = _memUsage;
+        _specificStats.spilledBytes = _spillStats.spilledBytes;
+        _specificStats.spilledRuns = _spillStats.spilledRuns;
+        _specificStats.mergePasses = _spillStats.mergePasses;
 
         // Add a BSON representation of the filter to the stats tree, if there is one.
         if (NULL != _filter) {
@@ -553,3 +842,8 @@ namespace mongo {
     }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::AndHashStage::SpillKey,
+                    mongo::SpilledWorkingSetMember,
+                    mongo::SpillKeyComparator);
@@ -32,8 +32,10 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set_spill.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_set.h"
 
 namespace mongo {
@@ -48,9 +50,36 @@ namespace mongo {
      * is fetched and added to the WorkingSet as "flagged for further review."  Because this stage
      * operates with RecordIds, we are unable to evaluate the AND for the invalidated RecordId, and it
      * must be fully matched later.
+     *
+     * If the hash table grows past the memory limit and internalQueryExecBlockingStageSpill is
+     * set, the stage switches to a sort-merge intersection: each child's output is sorted by
+     * RecordId with an external Sorter, which spills to disk, and merged with the intersection of
+     * the children before it.  The last child's output is sorted back into the order the child
+     * returned it, so results come out in the same order as without spilling.  This is only done
+     * on storage engines with document-level locking, as spilled RecordIds can't be invalidated.
      */
     class AndHashStage : public PlanStage {
     public:
+        /**
+         * Sort key of spilled results: the RecordId, then the order in which the child returned
+         * it.  Results of the last child are finally sorted on the order alone, with a null
+         * RecordId.
+         */
+        struct SpillKey {
+            struct SorterDeserializeSettings {};
+
+            SpillKey() : seq(0) { }
+            SpillKey(const RecordId& l, long long s) : loc(l), seq(s) { }
+
+            void serializeForSorter(BufBuilder& buf) const;
+            static SpillKey deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&);
+            int memUsageForSorter() const { return sizeof(SpillKey); }
+            SpillKey getOwned() const { return *this; }
+
+            RecordId loc;
+            long long seq;
+        };
+
         AndHashStage(WorkingSet* ws,
                      const MatchExpression* filter,
                      const Collection* collection);
@@ -99,6 +128,43 @@ namespace mongo {
         StageState hashOtherChildren(WorkingSetID* out);
         StageState workChild(size_t childNo, WorkingSetID* out);
 
+        //
+        // Spilling.
+        //
+
+        typedef Sorter<SpillKey, SpilledWorkingSetMember> SpillSorter;
+        typedef SpillSorter::Iterator SpillIterator;
+
+        SpillSorter* makeSpillSorter();
+
+        /**
+         * Moves the hash table to disk.  Results of the child being read are added to _childSorter
+         * from then on.
+         */
+        void spill();
+
+        /**
+         * Adds the result 'id' of the child being read to _childSorter and frees it.
+         */
+        void addToChildSorter(WorkingSetID id);
+
+        /**
+         * Intersects the sorted output of the child just read with _intersection, which becomes
+         * the result.  Returns the size of the new intersection.
+         */
+        size_t mergeSpilledChild();
+
+        /**
+         * Intersects the sorted output of the last child with _intersection and puts the results
+         * which pass the filter in _spilledResults, in the order the last child returned them.
+         */
+        void mergeLastSpilledChild();
+
+        /**
+         * Reads the last child to the end, then returns the results in _spilledResults.
+         */
+        StageState workSpilled(WorkingSetID* out);
+
         // Not owned by us.
         const Collection* _collection;
 
@@ -144,6 +210,28 @@ namespace mongo {
         // Upper limit for buffered data memory usage.
         // Defaults to 32 MB (See kMaxBytes in and_hash.cpp).
         size_t _maxMemUsage;
+
+        // True once we've spilled.  _dataMap is then empty, and _seenMap is only used for the
+        // child being read when we spilled.
+        bool _spilled;
+
+        // Output of the child being read, once spilled.
+        std::unique_ptr<SpillSorter> _childSorter;
+
+        // Intersection of the children read so far, sorted by RecordId, once spilled.  May hold
+        // more than one result for a RecordId if only the first child has been read.
+        std::unique_ptr<SpillIterator> _intersection;
+
+        // The results, once spilled and all children were read.
+        std::unique_ptr<SpillIterator> _spilledResults;
+
+        // Numbers the results of the child being read.
+        long long _spillSeq;
+
+        // Indexes referred to by the key data of spilled results.
+        SpilledWorkingSetMember::IndexList _spilledIndexes;
+
+        SorterSpillStats _spillStats;
     };
 
 }  // namespace mongo
@@ -38,6 +38,7 @@
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/plan_yield_policy.h"
@@ -66,6 +67,7 @@ namespace mongo {
           _plannerParams(params),
           _decisionWorks(decisionWorks),
           _root(root),
+          _shouldRecordRun(true),
           _commonStats(kStageType) {
         invariant(_collection);
     }
@@ -211,9 +213,15 @@ namespace mongo {
         // We're going to start over with a new plan. No need for only old buffered results.
         _results.clear();
 
+        // Runs of the replacement plan say nothing about the cached one.
+        _shouldRecordRun = false;
+
         // Clear out the working set. We'll start with a fresh working set.
         _ws->clear();
 
+        // The cached plan was picked without probing indices for skip scans, so probe them now.
+        fillOutSkipScanParams(_txn, _collection, *_canonicalQuery, &_plannerParams);
+
         // Use the query planning module to plan the whole query.
         std::vector<QuerySolution*> rawSolutions;
         Status status = QueryPlanner::plan(*_canonicalQuery, _plannerParams, &rawSolutions);
@@ -283,7 +291,10 @@ namespace mongo {
         // Adds the amount of time taken by work() to executionTimeMillis.
         ScopedTimer timer(&_commonStats.executionTimeMillis);
 
-        if (isEOF()) { return PlanStage::IS_EOF; }
+        if (isEOF()) {
+            recordRun();
+            return PlanStage::IS_EOF;
+        }
 
         // First exhaust any results buffered during the trial period.
         if (!_results.empty()) {
@@ -305,6 +316,9 @@ namespace mongo {
         else if (PlanStage::NEED_TIME == childStatus) {
             _commonStats.needTime++;
         }
+        else if (PlanStage::IS_EOF == childStatus) {
+            recordRun();
+        }
 
         return childStatus;
     }
@@ -366,6 +380,21 @@ namespace mongo {
         return &_specificStats;
     }
 
+    void CachedPlanStage::recordRun() {
+        if (!_shouldRecordRun) {
+            return;
+        }
+        _shouldRecordRun = false;
+
+        std::unique_ptr<PlanStageStats> stats(_root->getStats());
+        PlanCache* cache = _collection->infoCache()->getPlanCache();
+        if (cache->recordExecution(*_canonicalQuery, *stats)) {
+            LOG(1) << "Cached plan kept examining far more than it was ranked with, evicted it"
+                   << " from the plan cache. query: " << _canonicalQuery->toStringShort()
+                   << " planSummary: " << Explain::getPlanSummary(_root.get());
+        }
+    }
+
     void CachedPlanStage::updatePlanCache() {
         std::unique_ptr<PlanCacheEntryFeedback> feedback(new PlanCacheEntryFeedback());
         feedback->stats.reset(getStats());
@@ -91,6 +91,15 @@ namespace mongo {
          */
         Status pickBestPlan(PlanYieldPolicy* yieldPolicy);
 
+        /**
+         * Tells the plan cache how the cached plan did, so that the cache can evict entries whose
+         * plans no longer suit the data. Called once the plan reaches EOF, and by the
+         * PlanExecutor when it is destroyed, so that runs which stop early are reported too.
+         * Does nothing if we replanned, or if this run was already reported. The collection must
+         * still exist.
+         */
+        void recordRun();
+
     private:
         /**
          * Passes stats from the trial period run of the cached plan to the plan cache.
@@ -142,6 +151,10 @@ namespace mongo {
 
         std::unique_ptr<PlanStage> _root;
 
+        // True while _root is the cached plan and its completed run has not been reported to the
+        // plan cache yet.
+        bool _shouldRecordRun;
+
         // Any results produced during trial period execution are kept here.
         std::list<WorkingSetID> _results;
 
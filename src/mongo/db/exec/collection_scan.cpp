@@ -30,14 +30,18 @@
 
 #include "mongo/db/exec/collection_scan.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/parallel_batch.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -52,6 +56,81 @@ namespace mongo {
     // static
     const char* CollectionScan::kStageType = "COLLSCAN";
 
+namespace {
+    // The most records a call to workBatch() examines, so that the caller gets a chance to yield
+    // while scanning for rare matches.
+    const size_t kMaxRecordsPerBatch = 1024;
+
+    // Batches which could hold fewer results than this are filtered on the query's thread.
+    // PlanExecutor asks for kParallelBatchResults at a time when parallel batches are enabled.
+    const size_t kMinResultsForParallelFilter = 256;
+
+    /**
+     * Tightens 'low' or 'high' with the comparisons against 'field' which every document matching
+     * 'expr' has to satisfy.  Bounds are single element objects, like the ones in a
+     * RecordRangeSummary::Range.
+     */
+    void addSummaryBounds(const MatchExpression* expr,
+                          StringData field,
+                          BSONObj* low,
+                          bool* lowInclusive,
+                          BSONObj* high,
+                          bool* highInclusive) {
+        if (MatchExpression::AND == expr->matchType()) {
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                addSummaryBounds(expr->getChild(i), field, low, lowInclusive, high, highInclusive);
+            }
+            return;
+        }
+
+        const MatchExpression::MatchType type = expr->matchType();
+        if (MatchExpression::EQ != type && MatchExpression::LT != type
+                && MatchExpression::LTE != type && MatchExpression::GT != type
+                && MatchExpression::GTE != type) {
+            return;
+        }
+
+        const ComparisonMatchExpression* cmp = static_cast<const ComparisonMatchExpression*>(expr);
+        if (cmp->path() != field) {
+            return;
+        }
+
+        // Null also matches a missing field, and the summary doesn't keep undefined apart from
+        // null, so those comparisons don't bound anything.
+        const BSONElement rhs = cmp->getData();
+        switch (rhs.type()) {
+        case jstNULL:
+        case Undefined:
+        case MinKey:
+        case MaxKey:
+            return;
+        default:
+            break;
+        }
+
+        BSONObjBuilder bob;
+        bob.appendAs(rhs, "");
+        const BSONObj bound = bob.obj();
+
+        if (MatchExpression::LT != type && MatchExpression::LTE != type) {
+            const bool inclusive = MatchExpression::GT != type;
+            const int c = low->isEmpty() ? 1 : bound.woCompare(*low, BSONObj(), false);
+            if (c > 0 || (c == 0 && !inclusive)) {
+                *low = bound;
+                *lowInclusive = inclusive;
+            }
+        }
+        if (MatchExpression::GT != type && MatchExpression::GTE != type) {
+            const bool inclusive = MatchExpression::LT != type;
+            const int c = high->isEmpty() ? -1 : bound.woCompare(*high, BSONObj(), false);
+            if (c < 0 || (c == 0 && !inclusive)) {
+                *high = bound;
+                *highInclusive = inclusive;
+            }
+        }
+    }
+}
+
     CollectionScan::CollectionScan(OperationContext* txn,
                                    const CollectionScanParams& params,
                                    WorkingSet* workingSet,
@@ -59,13 +138,29 @@ namespace mongo {
         : _txn(txn),
           _workingSet(workingSet),
           _filter(filter),
+          _compiledFilter(CompiledMatcher::compile(filter)),
+          _filterInParallel(canMatchInParallel(filter)),
           _params(params),
           _isDead(false),
+          _rangeSummary(NULL),
           _wsidForFetch(_workingSet->allocate()),
           _commonStats(kStageType) {
         // Explain reports the direction of the collection scan.
         _specificStats.direction = params.direction;
 
+        const RecordRangeSummary* summary = _params.collection->getRecordStore()->rangeSummary();
+        if (summary && _filter) {
+            addSummaryBounds(_filter,
+                             summary->fieldName(),
+                             &_summaryBounds.low,
+                             &_summaryBounds.lowInclusive,
+                             &_summaryBounds.high,
+                             &_summaryBounds.highInclusive);
+            if (!_summaryBounds.low.isEmpty() || !_summaryBounds.high.isEmpty()) {
+                _rangeSummary = summary;
+            }
+        }
+
         // We pre-allocate a WSM and use it to pass up fetch requests. This should never be used
         // for anything other than passing up NEED_YIELD. We use the loc and owned obj state, but
         // the loc isn't really pointing at any obj. The obj field of the WSM should never be used.
@@ -134,7 +229,7 @@ namespace mongo {
                     return PlanStage::NEED_YIELD;
                 }
 
-                record = _cursor->next();
+                record = nextRecord();
             }
         }
         catch (const WriteConflictException& wce) {
@@ -145,6 +240,12 @@ namespace mongo {
             return PlanStage::NEED_YIELD;
         }
 
+        if (_isDead) {
+            Status status(ErrorCodes::InternalError, "CollectionScan died: Unexpected RecordId");
+            *out = WorkingSetCommon::allocateStatusMember(_workingSet, status);
+            return PlanStage::DEAD;
+        }
+
         if (!record) {
             // We just hit EOF. If we are tailable and have already returned data, leave us in a
             // state to pick up where we left off on the next call to work(). Otherwise EOF is
@@ -170,12 +271,155 @@ namespace mongo {
         return returnIfMatches(member, id, out);
     }
 
+    PlanStage::StageState CollectionScan::workBatch(size_t maxResults,
+                                                    std::vector<WorkingSetID>* out) {
+        invariant(out->empty());
+
+        // Creating the cursor, seeking to the start record and reporting errors are left to
+        // work(), which is only called once per batch anyway.
+        if (!_cursor || _isDead || _commonStats.isEOF
+            || (_lastSeenId.isNull() && !_params.start.isNull())) {
+            return PlanStage::workBatch(maxResults, out);
+        }
+
+        // Adds the amount of time taken by workBatch() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        // With enough room for results, the records are read first and then filtered on several
+        // threads. Reading stops at 'maxResults' records so that every one of them may match.
+        const bool filterInParallel = _filterInParallel
+                                   && maxResults >= kMinResultsForParallelFilter
+                                   && parallelBatchThreads() > 1;
+        const size_t maxRecords = filterInParallel ? std::min(maxResults, kMaxRecordsPerBatch)
+                                                   : kMaxRecordsPerBatch;
+        vector<WorkingSetID> unfiltered;
+
+        bool hitEnd = false;
+        bool needWork = false;
+        for (size_t examined = 0; examined < maxRecords; ++examined) {
+            if ((0 != _params.maxScan)
+                    && (_specificStats.docsTested + unfiltered.size() >= _params.maxScan)) {
+                _commonStats.isEOF = true;
+                hitEnd = true;
+                break;
+            }
+
+            // A record which isn't in memory, or a write conflict, ends the batch. The next call
+            // goes through work() which passes the fetch request or the conflict up.
+            boost::optional<Record> record;
+            try {
+                if (_cursor->fetcherForNext()) {
+                    needWork = true;
+                    break;
+                }
+                record = nextRecord();
+            }
+            catch (const WriteConflictException& wce) {
+                needWork = true;
+                break;
+            }
+
+            if (_isDead) {
+                needWork = true;
+                break;
+            }
+
+            if (!record) {
+                // Same as in work(): stay ready to resume a tailable scan.
+                if (_params.tailable && !_lastSeenId.isNull()) {
+                    _cursor.reset();
+                }
+                else {
+                    _commonStats.isEOF = true;
+                }
+                hitEnd = true;
+                break;
+            }
+
+            // Each record examined would have taken a call to work().
+            ++_commonStats.works;
+            _lastSeenId = record->id;
+
+            WorkingSetID id = _workingSet->allocate();
+            WorkingSetMember* member = _workingSet->get(id);
+            member->loc = record->id;
+            member->obj = {_txn->recoveryUnit()->getSnapshotId(), record->data.releaseToBson()};
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+
+            if (filterInParallel) {
+                unfiltered.push_back(id);
+                continue;
+            }
+
+            ++_specificStats.docsTested;
+            if (Filter::passes(member, _filter, _compiledFilter.get())) {
+                out->push_back(id);
+                if (out->size() == maxResults) {
+                    break;
+                }
+            }
+            else {
+                _workingSet->free(id);
+                ++_commonStats.needTime;
+            }
+        }
+
+        if (!unfiltered.empty()) {
+            std::vector<char> passed(unfiltered.size());
+            Status status = runBatchInParallel(unfiltered.size(),
+                                               [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    passed[i] = Filter::passes(_workingSet->get(unfiltered[i]),
+                                               _filter,
+                                               _compiledFilter.get());
+                }
+                return Status::OK();
+            });
+            if (!status.isOK()) {
+                for (size_t i = 0; i < unfiltered.size(); ++i) {
+                    _workingSet->free(unfiltered[i]);
+                }
+                out->assign(1, WorkingSetCommon::allocateStatusMember(_workingSet, status));
+                return PlanStage::FAILURE;
+            }
+
+            // Results keep the order the records were read in.
+            for (size_t i = 0; i < unfiltered.size(); ++i) {
+                ++_specificStats.docsTested;
+                if (passed[i]) {
+                    out->push_back(unfiltered[i]);
+                }
+                else {
+                    _workingSet->free(unfiltered[i]);
+                    ++_commonStats.needTime;
+                }
+            }
+        }
+
+        if (!out->empty()) {
+            _commonStats.advanced += out->size();
+            return PlanStage::ADVANCED;
+        }
+
+        if (needWork) {
+            return PlanStage::workBatch(maxResults, out);
+        }
+
+        out->push_back(WorkingSet::INVALID_ID);
+        if (hitEnd) {
+            // Reported now rather than by the next call, so this is a call to work() as well.
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+        return PlanStage::NEED_TIME;
+    }
+
     PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
                                                           WorkingSetID memberID,
                                                           WorkingSetID* out) {
         ++_specificStats.docsTested;
 
-        if (Filter::passes(member, _filter)) {
+        if (Filter::passes(member, _filter, _compiledFilter.get())) {
             *out = memberID;
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
@@ -187,6 +431,64 @@ namespace mongo {
         }
     }
 
+    boost::optional<Record> CollectionScan::nextRecord() {
+        if (!_rangeStart.isNull()) {
+            // Seeking to the end of a range failed, or threw.  Go back to where the range starts
+            // and examine the rest of its records one by one.
+            if (!_cursor->seekExact(_rangeStart)) {
+                _isDead = true;
+                return boost::none;
+            }
+            _rangeStart = RecordId();
+            return _cursor->next();
+        }
+
+        boost::optional<Record> record = _cursor->next();
+        if (!_rangeSummary) {
+            return record;
+        }
+
+        const bool forward = _params.direction == CollectionScanParams::FORWARD;
+        RecordRangeSummary::Range range;
+        while (record && _rangeSummary->findRange(record->id, forward, &range) && canSkip(range)) {
+            // The record at the far end of the range is stepped over too.
+            _rangeStart = record->id;
+            const RecordId& end = forward ? range.last : range.first;
+            if (!_cursor->seekExact(end)) {
+                return nextRecord();
+            }
+            _rangeStart = RecordId();
+            _lastSeenId = end;
+
+            ++_specificStats.rangesSkipped;
+            _specificStats.docsSkipped += range.records;
+
+            record = _cursor->next();
+        }
+        return record;
+    }
+
+    bool CollectionScan::canSkip(const RecordRangeSummary::Range& range) const {
+        // Arrays match comparisons through their elements, which aren't summarized.
+        if (range.hasArray) {
+            return false;
+        }
+
+        if (!_summaryBounds.low.isEmpty()) {
+            const int c = range.max.woCompare(_summaryBounds.low, BSONObj(), false);
+            if (c < 0 || (c == 0 && !_summaryBounds.lowInclusive)) {
+                return true;
+            }
+        }
+        if (!_summaryBounds.high.isEmpty()) {
+            const int c = range.min.woCompare(_summaryBounds.high, BSONObj(), false);
+            if (c > 0 || (c == 0 && !_summaryBounds.highInclusive)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool CollectionScan::isEOF() {
         return _commonStats.isEOF || _isDead;
     }
@@ -28,12 +28,16 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/compiled_matcher.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/storage/record_range_summary.h"
+#include "mongo/db/storage/record_store.h"
 
 namespace mongo {
 
@@ -45,6 +49,9 @@ namespace mongo {
      * Scans over a collection, starting at the RecordId provided in params and continuing until
      * there are no more records in the collection.
      *
+     * If the record store keeps a RecordRangeSummary and the filter bounds the summarized field,
+     * ranges of records whose values are all out of bounds are stepped over.
+     *
      * Preconditions: Valid RecordId.
      */
     class CollectionScan : public PlanStage {
@@ -55,6 +62,7 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxResults, std::vector<WorkingSetID>* out);
         virtual bool isEOF();
 
         virtual void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
@@ -82,6 +90,28 @@ namespace mongo {
                                    WorkingSetID memberID,
                                    WorkingSetID* out);
 
+        /**
+         * Returns the next record from _cursor to examine, stepping over the ranges of records
+         * which can't match.  Sets _isDead if the scan can't go on.
+         */
+        boost::optional<Record> nextRecord();
+
+        /**
+         * Returns true if no record in 'range' can match the filter.
+         */
+        bool canSkip(const RecordRangeSummary::Range& range) const;
+
+        // Values of the summarized field which a document must hold to match the filter.  An
+        // empty bound is open.
+        struct SummaryBounds {
+            SummaryBounds() : lowInclusive(false), highInclusive(false) { }
+
+            BSONObj low;
+            bool lowInclusive;
+            BSONObj high;
+            bool highInclusive;
+        };
+
         // transactional context for read locks. Not owned by us
         OperationContext* _txn;
 
@@ -91,6 +121,12 @@ namespace mongo {
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // _filter flattened for faster evaluation, or NULL if that wouldn't help.
+        const std::unique_ptr<CompiledMatcher> _compiledFilter;
+
+        // True if workBatch() may evaluate _filter on several threads.
+        const bool _filterInParallel;
+
         std::unique_ptr<RecordCursor> _cursor;
 
         CollectionScanParams _params;
@@ -99,6 +135,14 @@ namespace mongo {
 
         RecordId _lastSeenId; // Null if nothing has been returned from _cursor yet.
 
+        // NULL unless the filter bounds the field which the record store summarizes.
+        const RecordRangeSummary* _rangeSummary;
+        SummaryBounds _summaryBounds;
+
+        // Set while stepping over a range, which starts at this record.  If seeking to the other
+        // end of the range fails, the scan goes back here.
+        RecordId _rangeStart;
+
         // We allocate a working set member with this id on construction of the stage. It gets
         // used for all fetch requests, changing the RecordId as appropriate.
         const WorkingSetID _wsidForFetch;
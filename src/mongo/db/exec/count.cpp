@@ -30,6 +30,8 @@
 
 #include "mongo/db/exec/count.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -42,6 +44,13 @@ namespace mongo {
     // static
     const char* CountStage::kStageType = "COUNT";
 
+namespace {
+    // The most results asked of the child at once. Counting keeps none of them, so this can be
+    // larger than what a PlanExecutor buffers, which gives a COLLSCAN child big enough batches to
+    // filter on several threads.
+    const size_t kMaxResultsPerBatch = 1024;
+}
+
     CountStage::CountStage(OperationContext* txn,
                            Collection* collection,
                            const CountRequest& request,
@@ -118,8 +127,18 @@ namespace mongo {
         // For non-trivial counts, we should always have a child stage from which we can retrieve
         // results.
         invariant(_child.get());
-        WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState state = _child->work(&id);
+
+        // Never ask for more results than the skip and limit still let us count.
+        size_t maxResults = kMaxResultsPerBatch;
+        if (_request.getLimit() > 0) {
+            const long long wanted =
+                _leftToSkip + _request.getLimit() - _specificStats.nCounted;
+            maxResults = std::min(maxResults, static_cast<size_t>(wanted));
+        }
+
+        vector<WorkingSetID> ids;
+        PlanStage::StageState state = _child->workBatch(maxResults, &ids);
+        WorkingSetID id = ids.front();
 
         if (PlanStage::IS_EOF == state) {
             _commonStats.isEOF = true;
@@ -140,21 +159,27 @@ namespace mongo {
             return state;
         }
         else if (PlanStage::ADVANCED == state) {
-            // We got a result. If we're still skipping, then decrement the number left to skip.
-            // Otherwise increment the count until we hit the limit.
-            if (_leftToSkip > 0) {
-                _leftToSkip--;
-                _specificStats.nSkipped++;
-            }
-            else {
-                _specificStats.nCounted++;
+            for (size_t i = 0; i < ids.size(); ++i) {
+                // We got a result. If we're still skipping, then decrement the number left to
+                // skip. Otherwise increment the count until we hit the limit.
+                if (_leftToSkip > 0) {
+                    _leftToSkip--;
+                    _specificStats.nSkipped++;
+                }
+                else {
+                    _specificStats.nCounted++;
+                }
+
+                // Count doesn't need the actual results, so we just discard any valid working
+                // set members that got returned from the child.
+                if (WorkingSet::INVALID_ID != ids[i]) {
+                    _ws->free(ids[i]);
+                }
             }
 
-            // Count doesn't need the actual results, so we just discard any valid working
-            // set members that got returned from the child.
-            if (WorkingSet::INVALID_ID != id) {
-                _ws->free(id);
-            }
+            // Every result after the first would have taken a call to work() of its own.
+            _commonStats.works += ids.size() - 1;
+            _commonStats.needTime += ids.size() - 1;
         }
         else if (PlanStage::NEED_YIELD == state) {
             *out = id;
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/limit.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/util/mongoutils/str.h"
@@ -96,6 +98,48 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState LimitStage::workBatch(size_t maxResults,
+                                                std::vector<WorkingSetID>* out) {
+        if (0 == _numToReturn) {
+            return PlanStage::workBatch(maxResults, out);
+        }
+
+        // Adds the amount of time taken by workBatch() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        // Each call to our child's work() would have been a call to ours.
+        const CommonStats* childStats = _child->getCommonStats();
+        const size_t childWorks = childStats->works;
+        const size_t childNeedTime = childStats->needTime;
+
+        // Never ask for more than we can return.
+        StageState status = _child->workBatch(std::min(maxResults, size_t(_numToReturn)), out);
+
+        _commonStats.works += childStats->works - childWorks;
+        _commonStats.needTime += childStats->needTime - childNeedTime;
+
+        if (PlanStage::ADVANCED == status) {
+            _numToReturn -= out->size();
+            _commonStats.advanced += out->size();
+        }
+        else if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case the id is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == out->front()) {
+                mongoutils::str::stream ss;
+                ss << "limit stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                out->front() = WorkingSetCommon::allocateStatusMember( _ws, status);
+            }
+        }
+        else if (PlanStage::NEED_YIELD == status) {
+            ++_commonStats.needYield;
+        }
+
+        return status;
+    }
+
     void LimitStage::saveState() {
         ++_commonStats.yields;
         _child->saveState();
@@ -49,6 +49,7 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxResults, std::vector<WorkingSetID>* out);
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -0,0 +1,248 @@
+// parallel_batch.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_batch.h"
+
+#include <algorithm>
+
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/old_thread_pool.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+namespace {
+    // Ranges smaller than this are not worth handing to another thread.
+    const size_t kMinItemsPerThread = 128;
+
+    stdx::mutex poolMutex;
+
+    // Created on first use and never destroyed, since queries may still be using it at shutdown.
+    OldThreadPool* pool = NULL;
+
+    // Threads, counting the caller, that the pool was sized for. 0 until it has been.
+    AtomicUInt32 poolThreads;
+
+    // Threads of the pool which aren't running or about to run a range. Ranges are only
+    // scheduled on threads reserved from here, so the pool's queue never grows beyond its size.
+    AtomicUInt32 idleWorkers;
+
+    /**
+     * Returns the shared pool, which has one thread fewer than the number it was sized for, as
+     * the caller takes a range itself. The size is fixed by the first call.
+     */
+    OldThreadPool* getPool(size_t* threadsOut) {
+        size_t numThreads = poolThreads.load();
+        if (numThreads == 0) {
+            stdx::lock_guard<stdx::mutex> lk(poolMutex);
+            numThreads = poolThreads.load();
+            if (numThreads == 0) {
+                int configured = internalQueryExecParallelBatchThreads;
+                if (configured <= 0) {
+                    ProcessInfo p;
+                    configured = p.getNumCores();
+                }
+                numThreads = std::max(configured, 1);
+                if (numThreads > 1) {
+                    pool = new OldThreadPool(numThreads - 1, "query batch worker ");
+                    idleWorkers.store(static_cast<unsigned>(numThreads - 1));
+                }
+                poolThreads.store(static_cast<unsigned>(numThreads));
+            }
+        }
+        *threadsOut = numThreads;
+        return pool;
+    }
+
+    /**
+     * Takes up to 'wanted' idle threads of the pool for the caller and returns how many it got.
+     * Each must be given back with releaseWorker() once its range is done.
+     */
+    size_t reserveWorkers(size_t wanted) {
+        unsigned idle = idleWorkers.load();
+        while (idle > 0) {
+            const unsigned taken = std::min(idle, static_cast<unsigned>(wanted));
+            const unsigned seen = idleWorkers.compareAndSwap(idle, idle - taken);
+            if (seen == idle) {
+                return taken;
+            }
+            idle = seen;
+        }
+        return 0;
+    }
+
+    void releaseWorker() {
+        idleWorkers.fetchAndAdd(1);
+    }
+
+    Status runRange(const stdx::function<Status(size_t, size_t)>& fn, size_t begin, size_t end) {
+        try {
+            return fn(begin, end);
+        }
+        catch (const DBException& ex) {
+            return ex.toStatus();
+        }
+        catch (const std::exception& ex) {
+            return Status(ErrorCodes::UnknownError, ex.what());
+        }
+        catch (...) {
+            return Status(ErrorCodes::UnknownError,
+                          "unknown exception while processing a batch of results");
+        }
+    }
+
+    /**
+     * Tracks the ranges of one batch which were handed to the pool.
+     */
+    class PendingRanges {
+    public:
+        explicit PendingRanges(size_t count) : _remaining(count), _status(Status::OK()) {}
+
+        void done(const Status& status) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (_status.isOK()) {
+                _status = status;
+            }
+            if (--_remaining == 0) {
+                _allDone.notify_one();
+            }
+        }
+
+        Status wait() {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            while (_remaining > 0) {
+                _allDone.wait(lk);
+            }
+            return _status;
+        }
+
+    private:
+        stdx::mutex _mutex;
+        stdx::condition_variable _allDone;
+        size_t _remaining;
+        Status _status;
+    };
+
+    /**
+     * Returns true if matching 'expr' reads nothing but the document and the expression's own
+     * immutable state. Geo expressions build their S2 indexes lazily from const methods and
+     * $where runs in a JavaScript scope belonging to the query's thread, so anything not listed
+     * here is evaluated serially.
+     */
+    bool isStateless(const MatchExpression* expr) {
+        switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT:
+        case MatchExpression::ELEM_MATCH_OBJECT:
+        case MatchExpression::ELEM_MATCH_VALUE:
+        case MatchExpression::SIZE:
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::EXISTS:
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::TYPE_OPERATOR:
+        case MatchExpression::ATOMIC:
+        case MatchExpression::ALWAYS_FALSE:
+            break;
+        default:
+            return false;
+        }
+        for (size_t i = 0; i < expr->numChildren(); ++i) {
+            if (!isStateless(expr->getChild(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace
+
+    size_t parallelBatchThreads() {
+        if (1 == internalQueryExecParallelBatchThreads) {
+            return 1;
+        }
+        size_t numThreads;
+        getPool(&numThreads);
+        const int maxPerQuery = std::max(internalQueryExecParallelBatchMaxThreadsPerQuery, 1);
+        return std::min(numThreads, static_cast<size_t>(maxPerQuery));
+    }
+
+    Status runBatchInParallel(size_t n, const stdx::function<Status(size_t, size_t)>& fn) {
+        const size_t numThreads = parallelBatchThreads();
+        const size_t wantedRanges = std::min(numThreads, n / kMinItemsPerThread);
+        if (wantedRanges <= 1) {
+            return runRange(fn, 0, n);
+        }
+
+        // Whatever the pool can't take right now is left to the calling thread.
+        const size_t numWorkers = reserveWorkers(wantedRanges - 1);
+        if (numWorkers == 0) {
+            return runRange(fn, 0, n);
+        }
+        const size_t numRanges = numWorkers + 1;
+
+        // Workers can only be reserved once the pool exists.
+        OldThreadPool* workers = pool;
+
+        PendingRanges pending(numWorkers);
+        for (size_t i = 1; i < numRanges; ++i) {
+            const size_t begin = n * i / numRanges;
+            const size_t end = n * (i + 1) / numRanges;
+            workers->schedule([&pending, &fn, begin, end]() {
+                const Status status = runRange(fn, begin, end);
+                releaseWorker();
+                pending.done(status);
+            });
+        }
+
+        const Status status = runRange(fn, 0, n / numRanges);
+        const Status poolStatus = pending.wait();
+        return status.isOK() ? poolStatus : status;
+    }
+
+    bool canMatchInParallel(const MatchExpression* filter) {
+        return filter && isStateless(filter);
+    }
+
+}  // namespace mongo
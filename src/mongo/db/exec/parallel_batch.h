@@ -0,0 +1,78 @@
+// parallel_batch.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/status.h"
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+    class MatchExpression;
+
+    /**
+     * Helpers for stages which process a batch of working set members and want to spread the
+     * CPU work over several threads. Only the work on members that are already in the WorkingSet
+     * is split up; cursors, the OperationContext and the WorkingSet itself are still only used by
+     * the thread running the query.
+     */
+
+    /**
+     * How many results callers of workBatch() should ask for when parallelBatchThreads() is
+     * above 1, so that there is enough work in a batch to split between threads.
+     */
+    const size_t kParallelBatchResults = 1024;
+
+    /**
+     * Returns the number of threads, including the caller, that a batch may be split between.
+     * 1 means batches are processed serially.
+     */
+    size_t parallelBatchThreads();
+
+    /**
+     * Splits [0, n) into contiguous ranges and calls 'fn' once for each of them. One range is
+     * processed on the calling thread and the others on a process-wide pool of threads. Batches
+     * too small to be worth splitting are processed entirely on the calling thread, and so are
+     * batches that arrive while every thread of the pool is busy.
+     *
+     * Returns once every call has finished, with the first error any of them returned or threw.
+     * 'fn' must be safe to run concurrently on disjoint ranges.
+     */
+    Status runBatchInParallel(size_t n, const stdx::function<Status(size_t, size_t)>& fn);
+
+    /**
+     * Returns true if 'filter' may be evaluated on several threads at once. Only filters built
+     * entirely from expression types known to keep no mutable state qualify; $where, geo and
+     * text expressions don't.
+     */
+    bool canMatchInParallel(const MatchExpression* filter);
+
+}  // namespace mongo
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/invalidation_type.h"
@@ -184,6 +186,24 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Batched form of work(), letting a stage produce several results in one call.  'out' must
+         * be empty.
+         *
+         * Returns StageState::ADVANCED if at least one and at most 'maxResults' results were
+         * appended to 'out'.  Otherwise returns what work() would have returned, and 'out' holds
+         * the single WorkingSetID that work() would have set (possibly WorkingSet::INVALID_ID).
+         *
+         * Statistics are kept as if the results had been produced by separate calls to work().
+         * Stages which can't do better than one result at a time need not override this.
+         */
+        virtual StageState workBatch(size_t maxResults, std::vector<WorkingSetID>* out) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            const StageState state = work(&id);
+            out->push_back(id);
+            return state;
+        }
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
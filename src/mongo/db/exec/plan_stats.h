@@ -146,7 +146,10 @@ namespace mongo {
         AndHashStats() : flaggedButPassed(0),
                          flaggedInProgress(0),
                          memUsage(0),
-                         memLimit(0) { }
+                         memLimit(0),
+                         spilledBytes(0),
+                         spilledRuns(0),
+                         mergePasses(0) { }
 
         virtual ~AndHashStats() { }
 
@@ -175,6 +178,11 @@ namespace mongo {
 
         // What's our memory limit?
         size_t memLimit;
+
+        // Disk usage once the hash table no longer fits within memLimit.  See SorterSpillStats.
+        long long spilledBytes;
+        long long spilledRuns;
+        long long mergePasses;
     };
 
     struct AndSortedStats : public SpecificStats {
@@ -203,7 +211,7 @@ namespace mongo {
     };
 
     struct CollectionScanStats : public SpecificStats {
-        CollectionScanStats() : docsTested(0), direction(1) { }
+        CollectionScanStats() : docsTested(0), direction(1), rangesSkipped(0), docsSkipped(0) { }
 
         virtual SpecificStats* clone() const {
             CollectionScanStats* specific = new CollectionScanStats(*this);
@@ -216,6 +224,11 @@ namespace mongo {
         // >0 if we're traversing the collection forwards. <0 if we're traversing it
         // backwards.
         int direction;
+
+        // Ranges of records which the record store's RecordRangeSummary showed couldn't match,
+        // and how many documents they held.
+        size_t rangesSkipped;
+        size_t docsSkipped;
     };
 
     struct CountStats : public SpecificStats {
@@ -474,7 +487,12 @@ namespace mongo {
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0), memUsage(0), memLimit(0) { }
+        SortStats() : forcedFetches(0),
+                      memUsage(0),
+                      memLimit(0),
+                      spilledBytes(0),
+                      spilledRuns(0),
+                      mergePasses(0) { }
 
         virtual ~SortStats() { }
 
@@ -497,6 +515,11 @@ namespace mongo {
 
         // The pattern according to which we are sorting.
         BSONObj sortPattern;
+
+        // Disk usage once results no longer fit within memLimit.  See SorterSpillStats.
+        long long spilledBytes;
+        long long spilledRuns;
+        long long mergePasses;
     };
 
     struct MergeSortStats : public SpecificStats {
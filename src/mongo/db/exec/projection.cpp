@@ -250,6 +250,59 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState ProjectionStage::workBatch(size_t maxResults,
+                                                     std::vector<WorkingSetID>* out) {
+        // Adds the amount of time taken by workBatch() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        // Each call to our child's work() would have been a call to ours.
+        const CommonStats* childStats = _child->getCommonStats();
+        const size_t childWorks = childStats->works;
+        const size_t childNeedTime = childStats->needTime;
+
+        StageState status = _child->workBatch(maxResults, out);
+
+        _commonStats.works += childStats->works - childWorks;
+        _commonStats.needTime += childStats->needTime - childNeedTime;
+
+        if (PlanStage::ADVANCED == status) {
+            // Punt to our specific projection impl. The fast paths cost too little per document
+            // to be worth handing to other threads, and the general path isn't safe to share.
+            Status projStatus = Status::OK();
+            for (size_t i = 0; i < out->size() && projStatus.isOK(); ++i) {
+                projStatus = transform(_ws->get((*out)[i]));
+            }
+
+            if (!projStatus.isOK()) {
+                warning() << "Couldn't execute projection, status = "
+                          << projStatus.toString() << endl;
+                for (size_t j = 0; j < out->size(); ++j) {
+                    _ws->free((*out)[j]);
+                }
+                out->assign(1, WorkingSetCommon::allocateStatusMember(_ws, projStatus));
+                return PlanStage::FAILURE;
+            }
+
+            _commonStats.advanced += out->size();
+        }
+        else if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case the id is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == out->front()) {
+                mongoutils::str::stream ss;
+                ss << "projection stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                out->front() = WorkingSetCommon::allocateStatusMember( _ws, status);
+            }
+        }
+        else if (PlanStage::NEED_YIELD == status) {
+            _commonStats.needYield++;
+        }
+
+        return status;
+    }
+
     void ProjectionStage::saveState() {
         ++_commonStats.yields;
         _child->saveState();
@@ -41,6 +41,7 @@
 #include "mongo/db/query/lite_parsed_query.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/storage_options.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -49,6 +50,30 @@ namespace mongo {
     using std::endl;
     using std::vector;
 
+    namespace {
+
+        /**
+         * Orders spilled results the way WorkingSetComparator orders buffered ones.
+         */
+        class SpillComparator {
+        public:
+            explicit SpillComparator(const BSONObj& pattern) : _pattern(pattern) { }
+
+            int operator()(const std::pair<BSONObj, SpilledWorkingSetMember>& lhs,
+                           const std::pair<BSONObj, SpilledWorkingSetMember>& rhs) const {
+                int result = lhs.first.woCompare(rhs.first, _pattern, false);
+                if (0 != result) {
+                    return result;
+                }
+                return lhs.second.loc().compare(rhs.second.loc());
+            }
+
+        private:
+            BSONObj _pattern;
+        };
+
+    }  // namespace
+
     // static
     const char* SortStage::kStageType = "SORT";
 
@@ -305,7 +330,13 @@ namespace mongo {
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
-        return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
+        if (!_child->isEOF() || !_sorted) {
+            return false;
+        }
+        if (_spillIterator) {
+            return !_spillIterator->more();
+        }
+        return _data.end() == _resultIterator;
     }
 
     PlanStage::StageState SortStage::work(WorkingSetID* out) {
@@ -328,7 +359,10 @@ namespace mongo {
         }
 
         const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
-        if (_memUsage > maxBytes) {
+        if (_memUsage > maxBytes && internalQueryExecBlockingStageSpill) {
+            spillBuffer();
+        }
+        else if (_memUsage > maxBytes) {
             mongoutils::str::stream ss;
             ss << "Sort operation used more than the maximum " << maxBytes
                << " bytes of RAM. Add an index, or specify a smaller limit.";
@@ -371,7 +405,12 @@ namespace mongo {
                     item.loc = member->loc;
                 }
 
-                addToBuffer(item);
+                if (_sorter) {
+                    addToSorter(item);
+                }
+                else {
+                    addToBuffer(item);
+                }
 
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -379,8 +418,14 @@ namespace mongo {
             else if (PlanStage::IS_EOF == code) {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                sortBuffer();
-                _resultIterator = _data.begin();
+                if (_sorter) {
+                    _spillIterator.reset(_sorter->done());
+                    _sorter.reset();
+                }
+                else {
+                    sortBuffer();
+                    _resultIterator = _data.begin();
+                }
                 _sorted = true;
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -410,8 +455,20 @@ namespace mongo {
         }
 
         // Returning results.
-        verify(_resultIterator != _data.end());
         verify(_sorted);
+
+        if (_spillIterator) {
+            const SpillSorter::Data next = _spillIterator->next();
+            const SpilledWorkingSetMember& spilled = next.second;
+            const bool invalidated = spilled.hasLoc()
+                && _invalidatedWhileSpilled.end() != _invalidatedWhileSpilled.find(spilled.loc());
+            *out = spilled.restore(_ws, _spilledIndexes, !invalidated);
+
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        verify(_resultIterator != _data.end());
         *out = _resultIterator->wsid;
         _resultIterator++;
 
@@ -461,6 +518,11 @@ namespace mongo {
             _wsidByDiskLoc.erase(it);
             ++_specificStats.forcedFetches;
         }
+        else if (_sorter || _spillIterator) {
+            // The result may have been spilled, where we can't fetch it.  Remember to drop its
+            // RecordId when it comes back.
+            _invalidatedWhileSpilled.insert(dl);
+        }
     }
 
     vector<PlanStage*> SortStage::getChildren() const {
@@ -476,6 +538,9 @@ namespace mongo {
         _specificStats.memUsage = _memUsage;
         _specificStats.limit = _limit;
         _specificStats.sortPattern = _pattern.getOwned();
+        _specificStats.spilledBytes = _spillStats.spilledBytes;
+        _specificStats.spilledRuns = _spillStats.spilledRuns;
+        _specificStats.mergePasses = _spillStats.mergePasses;
 
         unique_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_SORT));
         ret->specific.reset(new SortStats(_specificStats));
@@ -574,6 +639,49 @@ namespace mongo {
         }
     }
 
+    void SortStage::spillBuffer() {
+        if (!_sorter) {
+            const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
+            SortOptions opts = SortOptions().Limit(_limit)
+                                            .MaxMemoryUsageBytes(maxBytes)
+                                            .ExtSortAllowed()
+                                            .TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                            .SpillStats(&_spillStats);
+            _sorter.reset(SpillSorter::make(opts,
+                                            SpillComparator(_sortKeyGen->getSortComparator())));
+            LOG(1) << "Sort using more than " << maxBytes << " bytes, spilling to disk."
+                   << " sortPattern: " << _pattern;
+        }
+
+        for (size_t i = 0; i < _data.size(); ++i) {
+            addToSorter(_data[i]);
+        }
+        _data.clear();
+        _resultIterator = _data.end();
+
+        if (_dataSet) {
+            for (SortableDataItemSet::const_iterator it = _dataSet->begin();
+                 it != _dataSet->end(); ++it) {
+                addToSorter(*it);
+            }
+            _dataSet->clear();
+        }
+
+        _memUsage = 0;
+    }
+
+    void SortStage::addToSorter(const SortableDataItem& item) {
+        WorkingSetMember* member = _ws->get(item.wsid);
+        _sorter->add(item.sortKey,
+                     SpilledWorkingSetMember(*member, _ws->isFlagged(item.wsid),
+                                             &_spilledIndexes));
+
+        if (member->hasLoc()) {
+            _wsidByDiskLoc.erase(member->loc);
+        }
+        _ws->free(item.wsid);
+    }
+
     void SortStage::sortBuffer() {
         if (_limit == 0) {
             const WorkingSetComparator& cmp = *_sortKeyComparator;
@@ -594,3 +702,6 @@ namespace mongo {
     }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj, mongo::SpilledWorkingSetMember, mongo::SpillComparator);
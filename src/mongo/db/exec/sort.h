@@ -33,10 +33,13 @@
 
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_spill.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/platform/unordered_set.h"
 
 
 namespace mongo {
@@ -136,6 +139,11 @@ namespace mongo {
     /**
      * Sorts the input received from the child according to the sort pattern provided.
      *
+     * Buffered results are kept in the WorkingSet until they use more than
+     * internalQueryExecMaxBlockingSortBytes.  Past that, if internalQueryExecBlockingStageSpill is
+     * set, they are handed to an external Sorter, which spills sorted runs to disk, and results
+     * come back from the Sorter once the child is EOF.  Otherwise the stage fails.
+     *
      * Preconditions: For each field in 'pattern', all inputs in the child must handle a
      * getFieldDotted for that field.
      */
@@ -231,6 +239,17 @@ namespace mongo {
          */
         void addToBuffer(const SortableDataItem& item);
 
+        /**
+         * Moves everything in the data buffer to _sorter, creating it if needed.  Later results
+         * go straight to _sorter.
+         */
+        void spillBuffer();
+
+        /**
+         * Adds one item to _sorter and frees its working set member.
+         */
+        void addToSorter(const SortableDataItem& item);
+
         /**
          * Sorts data buffer.
          * Assumes no more items will be added to buffer.
@@ -261,6 +280,28 @@ namespace mongo {
         typedef unordered_map<RecordId, WorkingSetID, RecordId::Hasher> DataMap;
         DataMap _wsidByDiskLoc;
 
+        //
+        // Spilling
+        //
+
+        typedef Sorter<BSONObj, SpilledWorkingSetMember> SpillSorter;
+
+        // Takes results once the buffer went over the memory limit.  Reset when the child is EOF.
+        std::unique_ptr<SpillSorter> _sorter;
+
+        // Returns the sorted results once anything was spilled.
+        std::unique_ptr<SpillSorter::Iterator> _spillIterator;
+
+        // Indexes referred to by the key data of spilled results.
+        SpilledWorkingSetMember::IndexList _spilledIndexes;
+
+        // RecordIds invalidated while their results may be spilled.  Those results are returned
+        // without their RecordId, like invalidated results held in the WorkingSet.
+        typedef unordered_set<RecordId, RecordId::Hasher> LocSet;
+        LocSet _invalidatedWhileSpilled;
+
+        SorterSpillStats _spillStats;
+
         //
         // Stats
         //
@@ -70,6 +70,11 @@ namespace mongo {
         verify(i < _data.size()); // ID has been allocated.
         verify(holder.nextFreeOrSelf == i); // ID currently in use.
 
+        // A freed WSM can't be reviewed, and its ID may be handed out again.
+        if (!_flagged.empty()) {
+            _flagged.erase(i);
+        }
+
         // Free resources and push this WSM to the head of the freelist.
         holder.member->clear();
         holder.nextFreeOrSelf = _freeList;
@@ -79,7 +79,7 @@ namespace mongo {
         }
 
         /**
-         * Deallocate the i-th query result and release its resources.
+         * Deallocate the i-th query result and release its resources.  It is no longer flagged.
          */
         void free(const WorkingSetID& i);
 
@@ -0,0 +1,278 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/working_set_spill.h"
+
+#include <algorithm>
+
+#include "mongo/db/exec/working_set_computed_data.h"
+#include "mongo/util/bufreader.h"
+
+namespace mongo {
+
+    namespace {
+
+        BSONObj readObj(BufReader& buf) {
+            return BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings());
+        }
+
+    }  // namespace
+
+    SpilledWorkingSetMember::SpilledWorkingSetMember()
+        : _state(WorkingSetMember::INVALID),
+          _flagged(false),
+          _hasLoc(false),
+          _hasObj(false),
+          _snapshotId(0),
+          _computed(0),
+          _textScore(0),
+          _geoDistance(0) { }
+
+    SpilledWorkingSetMember::SpilledWorkingSetMember(const WorkingSetMember& member,
+                                                     bool flagged,
+                                                     IndexList* indexes)
+        : _state(member.state),
+          _flagged(flagged),
+          _hasLoc(member.hasLoc()),
+          _hasObj(member.hasObj()),
+          _snapshotId(0),
+          _computed(0),
+          _textScore(0),
+          _geoDistance(0) {
+        if (_hasLoc) {
+            _loc = member.loc;
+        }
+
+        if (_hasObj) {
+            _snapshotId = member.obj.snapshotId().toNumber();
+            _obj = member.obj.value().getOwned();
+        }
+
+        for (size_t i = 0; i < member.keyData.size(); ++i) {
+            const IndexKeyDatum& datum = member.keyData[i];
+            IndexList::const_iterator it = std::find(indexes->begin(), indexes->end(),
+                                                     datum.index);
+            if (indexes->end() == it) {
+                it = indexes->insert(indexes->end(), datum.index);
+            }
+
+            KeyDatum spilled;
+            spilled.index = it - indexes->begin();
+            spilled.indexKeyPattern = datum.indexKeyPattern.getOwned();
+            spilled.keyData = datum.keyData.getOwned();
+            _keyData.push_back(spilled);
+        }
+
+        if (member.hasComputed(WSM_COMPUTED_TEXT_SCORE)) {
+            _computed |= kTextScore;
+            _textScore = static_cast<const TextScoreComputedData*>(
+                member.getComputed(WSM_COMPUTED_TEXT_SCORE))->getScore();
+        }
+        if (member.hasComputed(WSM_COMPUTED_GEO_DISTANCE)) {
+            _computed |= kGeoDistance;
+            _geoDistance = static_cast<const GeoDistanceComputedData*>(
+                member.getComputed(WSM_COMPUTED_GEO_DISTANCE))->getDist();
+        }
+        if (member.hasComputed(WSM_INDEX_KEY)) {
+            _computed |= kIndexKey;
+            _indexKey = static_cast<const IndexKeyComputedData*>(
+                member.getComputed(WSM_INDEX_KEY))->getKey();
+        }
+        if (member.hasComputed(WSM_GEO_NEAR_POINT)) {
+            _computed |= kGeoNearPoint;
+            _geoNearPoint = static_cast<const GeoNearPointComputedData*>(
+                member.getComputed(WSM_GEO_NEAR_POINT))->getPoint();
+        }
+    }
+
+    WorkingSetID SpilledWorkingSetMember::restore(WorkingSet* ws,
+                                                  const IndexList& indexes,
+                                                  bool keepLoc) const {
+        // Index key data is meaningless without its RecordId.
+        invariant(keepLoc || _hasObj || !_hasLoc);
+
+        WorkingSetID id = ws->allocate();
+        WorkingSetMember* member = ws->get(id);
+
+        member->state = _state;
+        if (_hasLoc && keepLoc) {
+            member->loc = _loc;
+        }
+
+        if (_hasObj) {
+            const SnapshotId snapshotId = 0 == _snapshotId ? SnapshotId()
+                                                           : SnapshotId(_snapshotId);
+            member->obj = Snapshotted<BSONObj>(snapshotId, _obj.getOwned());
+
+            // Our copy of the object is owned, and may be older than what is at the RecordId.
+            if (!member->loc.isNull()) {
+                member->state = WorkingSetMember::LOC_AND_OWNED_OBJ;
+            }
+            else {
+                member->state = WorkingSetMember::OWNED_OBJ;
+            }
+        }
+
+        for (size_t i = 0; i < _keyData.size(); ++i) {
+            const KeyDatum& datum = _keyData[i];
+            invariant(static_cast<size_t>(datum.index) < indexes.size());
+            member->keyData.push_back(IndexKeyDatum(datum.indexKeyPattern.getOwned(),
+                                                    datum.keyData.getOwned(),
+                                                    indexes[datum.index]));
+        }
+        if (WorkingSetMember::LOC_AND_IDX == member->state) {
+            member->isSuspicious = true;
+        }
+
+        if (_computed & kTextScore) {
+            member->addComputed(new TextScoreComputedData(_textScore));
+        }
+        if (_computed & kGeoDistance) {
+            member->addComputed(new GeoDistanceComputedData(_geoDistance));
+        }
+        if (_computed & kIndexKey) {
+            member->addComputed(new IndexKeyComputedData(_indexKey));
+        }
+        if (_computed & kGeoNearPoint) {
+            member->addComputed(new GeoNearPointComputedData(_geoNearPoint));
+        }
+
+        if (_flagged) {
+            ws->flagForReview(id);
+        }
+
+        return id;
+    }
+
+    void SpilledWorkingSetMember::serializeForSorter(BufBuilder& buf) const {
+        buf.appendNum(static_cast<char>(_state));
+        buf.appendNum(static_cast<char>(_flagged));
+
+        buf.appendNum(static_cast<char>(_hasLoc));
+        if (_hasLoc) {
+            _loc.serializeForSorter(buf);
+        }
+
+        buf.appendNum(static_cast<char>(_hasObj));
+        if (_hasObj) {
+            buf.appendNum(_snapshotId);
+            _obj.serializeForSorter(buf);
+        }
+
+        buf.appendNum(static_cast<int>(_keyData.size()));
+        for (size_t i = 0; i < _keyData.size(); ++i) {
+            buf.appendNum(_keyData[i].index);
+            _keyData[i].indexKeyPattern.serializeForSorter(buf);
+            _keyData[i].keyData.serializeForSorter(buf);
+        }
+
+        buf.appendNum(static_cast<char>(_computed));
+        if (_computed & kTextScore) {
+            buf.appendNum(_textScore);
+        }
+        if (_computed & kGeoDistance) {
+            buf.appendNum(_geoDistance);
+        }
+        if (_computed & kIndexKey) {
+            _indexKey.serializeForSorter(buf);
+        }
+        if (_computed & kGeoNearPoint) {
+            _geoNearPoint.serializeForSorter(buf);
+        }
+    }
+
+    // static
+    SpilledWorkingSetMember SpilledWorkingSetMember::deserializeForSorter(
+            BufReader& buf, const SorterDeserializeSettings&) {
+        SpilledWorkingSetMember out;
+
+        out._state = static_cast<WorkingSetMember::MemberState>(buf.read<char>());
+        out._flagged = buf.read<char>();
+
+        out._hasLoc = buf.read<char>();
+        if (out._hasLoc) {
+            out._loc = RecordId::deserializeForSorter(buf, RecordId::SorterDeserializeSettings());
+        }
+
+        out._hasObj = buf.read<char>();
+        if (out._hasObj) {
+            out._snapshotId = buf.read<unsigned long long>();
+            out._obj = readObj(buf);
+        }
+
+        const int numKeys = buf.read<int>();
+        for (int i = 0; i < numKeys; ++i) {
+            KeyDatum datum;
+            datum.index = buf.read<int>();
+            datum.indexKeyPattern = readObj(buf);
+            datum.keyData = readObj(buf);
+            out._keyData.push_back(datum);
+        }
+
+        out._computed = buf.read<char>();
+        if (out._computed & kTextScore) {
+            out._textScore = buf.read<double>();
+        }
+        if (out._computed & kGeoDistance) {
+            out._geoDistance = buf.read<double>();
+        }
+        if (out._computed & kIndexKey) {
+            out._indexKey = readObj(buf);
+        }
+        if (out._computed & kGeoNearPoint) {
+            out._geoNearPoint = readObj(buf);
+        }
+
+        return out;
+    }
+
+    int SpilledWorkingSetMember::memUsageForSorter() const {
+        int memUsage = sizeof(*this) + _obj.objsize() + _indexKey.objsize()
+            + _geoNearPoint.objsize();
+        for (size_t i = 0; i < _keyData.size(); ++i) {
+            memUsage += sizeof(KeyDatum) + _keyData[i].indexKeyPattern.objsize()
+                + _keyData[i].keyData.objsize();
+        }
+        return memUsage;
+    }
+
+    SpilledWorkingSetMember SpilledWorkingSetMember::getOwned() const {
+        SpilledWorkingSetMember out(*this);
+        out._obj = _obj.getOwned();
+        for (size_t i = 0; i < out._keyData.size(); ++i) {
+            out._keyData[i].indexKeyPattern = _keyData[i].indexKeyPattern.getOwned();
+            out._keyData[i].keyData = _keyData[i].keyData.getOwned();
+        }
+        out._indexKey = _indexKey.getOwned();
+        out._geoNearPoint = _geoNearPoint.getOwned();
+        return out;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+    class BufReader;
+    class IndexAccessMethod;
+
+    /**
+     * A copy of a WorkingSetMember that can be handed to the Sorter, which may write it to disk.
+     * Blocking stages use this to spill buffered results instead of failing once they are over
+     * their memory limit.
+     *
+     * Index key data refers to its IndexAccessMethod by position in an IndexList kept by the
+     * spilling stage, as pointers can't be written out.
+     */
+    class SpilledWorkingSetMember {
+    public:
+        typedef std::vector<const IndexAccessMethod*> IndexList;
+
+        struct SorterDeserializeSettings {};
+
+        SpilledWorkingSetMember();
+
+        /**
+         * Copies 'member'.  'flagged' records whether the member was flagged for review.  Index
+         * access methods not in 'indexes' yet are added to it.
+         */
+        SpilledWorkingSetMember(const WorkingSetMember& member,
+                                bool flagged,
+                                IndexList* indexes);
+
+        const RecordId& loc() const { return _loc; }
+        bool hasLoc() const { return _hasLoc; }
+
+        /**
+         * Allocates a member of 'ws' holding the spilled data and returns its id.  'indexes' must
+         * be the list the member was spilled with.
+         *
+         * A member which had a RecordId and an object comes back in the LOC_AND_OWNED_OBJ state,
+         * as it would after a yield.  If 'keepLoc' is false it comes back in the OWNED_OBJ state
+         * instead, as if its RecordId had been invalidated.  Members with index key data are
+         * marked suspicious, since they were not in the WorkingSet over the yields that happened
+         * while they were spilled.
+         */
+        WorkingSetID restore(WorkingSet* ws, const IndexList& indexes, bool keepLoc = true) const;
+
+        //
+        // Sorter interface.
+        //
+
+        void serializeForSorter(BufBuilder& buf) const;
+
+        static SpilledWorkingSetMember deserializeForSorter(BufReader& buf,
+                                                            const SorterDeserializeSettings&);
+
+        int memUsageForSorter() const;
+
+        SpilledWorkingSetMember getOwned() const;
+
+    private:
+        struct KeyDatum {
+            int index;
+            BSONObj indexKeyPattern;
+            BSONObj keyData;
+        };
+
+        enum ComputedMask {
+            kTextScore = 1 << 0,
+            kGeoDistance = 1 << 1,
+            kIndexKey = 1 << 2,
+            kGeoNearPoint = 1 << 3,
+        };
+
+        WorkingSetMember::MemberState _state;
+        bool _flagged;
+
+        bool _hasLoc;
+        RecordId _loc;
+
+        bool _hasObj;
+        unsigned long long _snapshotId;
+        BSONObj _obj;
+
+        std::vector<KeyDatum> _keyData;
+
+        int _computed;
+        double _textScore;
+        double _geoDistance;
+        BSONObj _indexKey;
+        BSONObj _geoNearPoint;
+    };
+
+}  // namespace mongo
@@ -122,19 +122,10 @@ namespace mongo {
 
             // Error cases.
 
-            if (status.code() == ErrorCodes::KeyTooLong && ignoreKeyTooLong(txn)) {
+            if (isTolerableInsertError(txn, status, *i)) {
                 continue;
             }
 
-            if (status.code() == ErrorCodes::DuplicateKeyValue) {
-                // A document might be indexed multiple times during a background index build
-                // if it moves ahead of the collection scan cursor (e.g. via an update).
-                if (!_btreeState->isReady(txn)) {
-                    LOG(3) << "key " << *i << " already in index during background indexing (ok)";
-                    continue;
-                }
-            }
-
             // Clean up after ourselves.
             for (BSONObjSet::const_iterator j = keys.begin(); j != i; ++j) {
                 removeOneKey(txn, *j, loc, options.dupsAllowed);
@@ -151,6 +142,83 @@ namespace mongo {
         return ret;
     }
 
+    Status IndexAccessMethod::insertMany(OperationContext* txn,
+                                         const std::vector<BsonRecord>& records,
+                                         const InsertDeleteOptions& options,
+                                         int64_t* numInserted) {
+        *numInserted = 0;
+
+        // Generate the keys for the whole batch up front, remembering which record each key
+        // came from so that multikey-ness can still be decided per document.
+        std::vector<IndexKeyEntry> entries;
+        std::vector<size_t> entryToRecord;
+        for (size_t i = 0; i < records.size(); ++i) {
+            BSONObjSet keys;
+            getKeys(*records[i].docPtr, &keys);
+            for (BSONObjSet::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+                entries.push_back(IndexKeyEntry(*it, records[i].id));
+                entryToRecord.push_back(i);
+            }
+        }
+
+        std::vector<int64_t> keysInsertedPerRecord(records.size(), 0);
+        auto pos = entries.cbegin();
+        while (pos != entries.cend()) {
+            size_t numBatchInserted = 0;
+            Status status = _newInterface->insertKeys(txn,
+                                                      pos,
+                                                      entries.cend(),
+                                                      options.dupsAllowed,
+                                                      &numBatchInserted);
+
+            for (size_t i = 0; i < numBatchInserted; ++i) {
+                ++keysInsertedPerRecord[entryToRecord[(pos - entries.cbegin()) + i]];
+            }
+            *numInserted += numBatchInserted;
+            pos += numBatchInserted;
+
+            if (status.isOK()) {
+                invariant(pos == entries.cend());
+                break;
+            }
+
+            if (!isTolerableInsertError(txn, status, pos->key)) {
+                return status;
+            }
+
+            // Skip over the key which could not be inserted and carry on with the rest.
+            ++pos;
+        }
+
+        for (size_t i = 0; i < keysInsertedPerRecord.size(); ++i) {
+            if (keysInsertedPerRecord[i] > 1) {
+                _btreeState->setMultikey( txn );
+                break;
+            }
+        }
+
+        return Status::OK();
+    }
+
+    bool IndexAccessMethod::isTolerableInsertError(OperationContext* txn,
+                                                   const Status& status,
+                                                   const BSONObj& key) {
+        if (status.code() == ErrorCodes::KeyTooLong && ignoreKeyTooLong(txn)) {
+            return true;
+        }
+
+        if (status.code() == ErrorCodes::DuplicateKeyValue) {
+            // A document might be indexed multiple times during a background index build
+            // if it moves ahead of the collection scan cursor (e.g. via an update).
+            if (!_btreeState->isReady(txn)) {
+                LOG(3) << "key " << key << " already in index during background indexing (ok)";
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     void IndexAccessMethod::removeOneKey(OperationContext* txn,
                                          const BSONObj& key,
                                          const RecordId& loc,
@@ -328,16 +396,24 @@ namespace mongo {
         return Status::OK();
     }
 
-    std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk() {
+    std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk(
+            size_t maxMemoryUsageBytes,
+            size_t maxOpenSpillFiles) {
 
-        return std::unique_ptr<BulkBuilder>(new BulkBuilder(this, _descriptor));
+        return std::unique_ptr<BulkBuilder>(new BulkBuilder(this,
+                                                            _descriptor,
+                                                            maxMemoryUsageBytes,
+                                                            maxOpenSpillFiles));
     }
 
     IndexAccessMethod::BulkBuilder::BulkBuilder(const IndexAccessMethod* index,
-                                                const IndexDescriptor* descriptor)
+                                                const IndexDescriptor* descriptor,
+                                                size_t maxMemoryUsageBytes,
+                                                size_t maxOpenSpillFiles)
             : _sorter(Sorter::make(SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
                                                 .ExtSortAllowed()
-                                                .MaxMemoryUsageBytes(100*1024*1024),
+                                                .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+                                                .MaxOpenSpillFiles(maxOpenSpillFiles),
                                    BtreeExternalSortComparison(descriptor->keyPattern(),
                                                                descriptor->version())))
             , _real(index) {
@@ -365,6 +441,37 @@ namespace mongo {
         return Status::OK();
     }
 
+    void IndexAccessMethod::BulkBuilder::merge(std::unique_ptr<BulkBuilder> other) {
+        invariant(other->_real == _real);
+
+        _keysInserted += other->_keysInserted;
+        _isMultiKey = _isMultiKey || other->_isMultiKey;
+
+        _mergedSorters.push_back(std::move(other->_sorter));
+        for (auto&& sorter : other->_mergedSorters) {
+            _mergedSorters.push_back(std::move(sorter));
+        }
+    }
+
+    IndexAccessMethod::BulkBuilder::Sorter::Iterator* IndexAccessMethod::BulkBuilder::done() {
+        if (_mergedSorters.empty()) {
+            return _sorter->done();
+        }
+
+        // Each sorter keeps its own spilled runs within its spill file limit, so this merge holds
+        // open no more files than those limits add up to.
+        std::vector<std::shared_ptr<Sorter::Iterator>> iters;
+        iters.push_back(std::shared_ptr<Sorter::Iterator>(_sorter->done()));
+        for (auto&& sorter : _mergedSorters) {
+            iters.push_back(std::shared_ptr<Sorter::Iterator>(sorter->done()));
+        }
+
+        const IndexDescriptor* descriptor = _real->_descriptor;
+        return Sorter::Iterator::merge(iters,
+                                       SortOptions(),
+                                       BtreeExternalSortComparison(descriptor->keyPattern(),
+                                                                   descriptor->version()));
+    }
 
     Status IndexAccessMethod::commitBulk(OperationContext* txn,
                                          std::unique_ptr<BulkBuilder> bulk,
@@ -374,7 +481,7 @@ namespace mongo {
 
         Timer timer;
 
-        std::unique_ptr<BulkBuilder::Sorter::Iterator> i(bulk->_sorter->done());
+        std::unique_ptr<BulkBuilder::Sorter::Iterator> i(bulk->done());
 
         stdx::unique_lock<Client> lk(*txn->getClient());
         ProgressMeterHolder pm(*txn->setMessage_inlock("Index Bulk Build: (2/3) btree bottom up",
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/index/index_descriptor.h"
@@ -45,6 +46,15 @@ namespace mongo {
     class UpdateTicket;
     struct InsertDeleteOptions;
 
+    /**
+     * A document together with the RecordId it was stored at. Used to hand batches of freshly
+     * inserted documents to the indexes.
+     */
+    struct BsonRecord {
+        RecordId id;
+        const BSONObj* docPtr;
+    };
+
     /**
      * An IndexAccessMethod is the interface through which all the mutation, lookup, and
      * traversal of index entries is done. The class is designed so that the underlying index
@@ -80,6 +90,17 @@ namespace mongo {
                       const InsertDeleteOptions& options,
                       int64_t* numInserted);
 
+        /**
+         * Generates the keys for every record in 'records' and inserts them all through a single
+         * batched call into the underlying index.  Otherwise equivalent to calling insert() for
+         * each record, except that keys already inserted are not removed on failure: the caller
+         * must abandon the enclosing WriteUnitOfWork.
+         */
+        Status insertMany(OperationContext* txn,
+                          const std::vector<BsonRecord>& records,
+                          const InsertDeleteOptions& options,
+                          int64_t* numInserted);
+
         /**
          * Analogous to above, but remove the records instead of inserting them.  If not NULL,
          * numDeleted will be set to the number of keys removed from the index for the document.
@@ -182,6 +203,8 @@ namespace mongo {
         // Bulk operations support
         //
 
+        static const size_t kDefaultMaxBulkMemoryUsageBytes = 100 * 1024 * 1024;
+
         class BulkBuilder {
         public:
             /**
@@ -193,14 +216,33 @@ namespace mongo {
                           const InsertDeleteOptions& options,
                           int64_t* numInserted);
 
+            /**
+             * Takes over the keys inserted into 'other', which must have been started on the same
+             * index. This lets several threads each fill a BulkBuilder of their own, and then
+             * commit all of them with a single call to commitBulk.
+             */
+            void merge(std::unique_ptr<BulkBuilder> other);
+
         private:
             friend class IndexAccessMethod;
 
             using Sorter = mongo::Sorter<BSONObj, RecordId>;
 
-            BulkBuilder(const IndexAccessMethod* index, const IndexDescriptor* descriptor);
+            BulkBuilder(const IndexAccessMethod* index,
+                        const IndexDescriptor* descriptor,
+                        size_t maxMemoryUsageBytes,
+                        size_t maxOpenSpillFiles);
+
+            /**
+             * Returns an iterator over all keys inserted, including those of merged BulkBuilders,
+             * in index order. Can only be called once. The merged BulkBuilders' spilled runs all
+             * stay open until the iterator is destroyed, so their spill file limits should add up
+             * to no more than the server's.
+             */
+            Sorter::Iterator* done();
 
             std::unique_ptr<Sorter> _sorter;
+            std::vector<std::unique_ptr<Sorter>> _mergedSorters;
             const IndexAccessMethod* _real;
             int64_t _keysInserted = 0;
             bool _isMultiKey = false;
@@ -212,8 +254,14 @@ namespace mongo {
          * This can return NULL, meaning bulk mode is not available.
          *
          * It is only legal to initiate bulk when the index is new and empty.
+         *
+         * Keys beyond 'maxMemoryUsageBytes' are spilled to disk, and at most 'maxOpenSpillFiles'
+         * spilled runs are kept before they are merged. 0 uses the sorterMaxOpenSpillFiles server
+         * parameter.
          */
-        std::unique_ptr<BulkBuilder> initiateBulk();
+        std::unique_ptr<BulkBuilder> initiateBulk(
+            size_t maxMemoryUsageBytes = kDefaultMaxBulkMemoryUsageBytes,
+            size_t maxOpenSpillFiles = 0);
 
         /**
          * Call this when you are ready to finish your bulk work.
@@ -243,6 +291,14 @@ namespace mongo {
         const IndexDescriptor* _descriptor;
 
     private:
+        /**
+         * Returns true if the failure to insert 'key' described by 'status' should be skipped
+         * over rather than failing the whole insert.
+         */
+        bool isTolerableInsertError(OperationContext* txn,
+                                    const Status& status,
+                                    const BSONObj& key);
+
         void removeOneKey(OperationContext* txn,
                           const BSONObj& key,
                           const RecordId& loc,
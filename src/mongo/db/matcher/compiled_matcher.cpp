@@ -0,0 +1,256 @@
+// compiled_matcher.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_matcher.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "mongo/base/compare_numbers.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/field_ref.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+
+namespace {
+
+    bool isCompiledComparison(MatchExpression::MatchType type) {
+        switch (type) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool applyComparison(MatchExpression::MatchType op, int cmp) {
+        switch (op) {
+        case MatchExpression::EQ: return cmp == 0;
+        case MatchExpression::LT: return cmp < 0;
+        case MatchExpression::LTE: return cmp <= 0;
+        case MatchExpression::GT: return cmp > 0;
+        case MatchExpression::GTE: return cmp >= 0;
+        default: invariant(false);
+        }
+    }
+
+    // Same ordering as compareElementValues() for two numbers.
+    int compareNumberElements(const BSONElement& lhs, const BSONElement& rhs) {
+        if (lhs.type() == NumberDouble && rhs.type() == NumberDouble)
+            return compareDoubles(lhs._numberDouble(), rhs._numberDouble());
+        if (lhs.type() == NumberInt && rhs.type() == NumberInt)
+            return compareInts(lhs._numberInt(), rhs._numberInt());
+        return compareElementValues(lhs, rhs);
+    }
+
+    // Same ordering as compareElementValues() for two strings or symbols.
+    int compareStringElements(const BSONElement& lhs, const BSONElement& rhs) {
+        const int lhsSize = lhs.valuestrsize();
+        const int rhsSize = rhs.valuestrsize();
+        const int res = memcmp(lhs.valuestr(), rhs.valuestr(), std::min(lhsSize, rhsSize));
+        if (res)
+            return res;
+        return lhsSize - rhsSize;
+    }
+
+}  // namespace
+
+    std::unique_ptr<CompiledMatcher> CompiledMatcher::compile(const MatchExpression* expr) {
+        if (!expr)
+            return {};
+
+        std::unique_ptr<CompiledMatcher> compiled(new CompiledMatcher());
+        if (!compiled->add(expr))
+            return {};
+
+        for (size_t i = 0; i < compiled->_predicates.size(); i++) {
+            if (compiled->_predicates[i].kernel != kWholeDocument)
+                return compiled;
+        }
+
+        // Nothing would be faster than the tree itself.
+        return {};
+    }
+
+    bool CompiledMatcher::add(const MatchExpression* expr) {
+        if (expr->matchType() == MatchExpression::AND) {
+            for (size_t i = 0; i < expr->numChildren(); i++) {
+                if (!add(expr->getChild(i)))
+                    return false;
+            }
+            return true;
+        }
+
+        Predicate pred;
+        pred.kernel = kWholeDocument;
+        pred.path = -1;
+        pred.expr = expr;
+        pred.op = expr->matchType();
+
+        const bool compiledLeaf = isCompiledComparison(expr->matchType())
+                               || expr->matchType() == MatchExpression::MATCH_IN;
+        if (compiledLeaf && !expr->path().empty()) {
+            pred.path = addPath(expr->path());
+            if (pred.path < 0)
+                return false;
+
+            pred.kernel = kSingleElement;
+            if (isCompiledComparison(expr->matchType())) {
+                pred.rhs = static_cast<const ComparisonMatchExpression*>(expr)->getData();
+                if (pred.rhs.isNumber() && !std::isnan(pred.rhs.numberDouble())) {
+                    pred.kernel = kCompareNumber;
+                }
+                else if (pred.rhs.type() == String || pred.rhs.type() == Symbol) {
+                    pred.kernel = kCompareString;
+                }
+            }
+        }
+
+        _predicates.push_back(pred);
+        return true;
+    }
+
+    int CompiledMatcher::addPath(StringData dottedPath) {
+        FieldRef fieldRef(dottedPath);
+
+        int parent = -1;
+        for (size_t part = 0; part < fieldRef.numParts(); part++) {
+            const StringData field = fieldRef.getPart(part);
+
+            int found = -1;
+            for (size_t i = 0; i < _paths.size(); i++) {
+                if (_paths[i].parent == parent && _paths[i].field == field) {
+                    found = i;
+                    break;
+                }
+            }
+
+            if (found < 0) {
+                if (_paths.size() == kMaxPaths)
+                    return -1;
+                Path path;
+                path.parent = parent;
+                path.field = field.toString();
+                _paths.push_back(path);
+                found = _paths.size() - 1;
+            }
+
+            parent = found;
+        }
+
+        return parent;
+    }
+
+    bool CompiledMatcher::matches(const BSONObj& doc) const {
+        ResolvedPath resolved[kMaxPaths];
+        for (size_t i = 0; i < _paths.size(); i++) {
+            resolved[i].state = kUnresolved;
+        }
+
+        for (size_t i = 0; i < _predicates.size(); i++) {
+            const Predicate& pred = _predicates[i];
+
+            bool passed;
+            if (pred.kernel == kWholeDocument) {
+                passed = pred.expr->matchesBSON(doc, NULL);
+            }
+            else {
+                const ResolvedPath& path = resolve(doc, pred.path, resolved);
+                passed = path.state == kArray ? pred.expr->matchesBSON(doc, NULL)
+                                              : evaluate(pred, path.elem);
+            }
+
+            if (!passed)
+                return false;
+        }
+
+        return true;
+    }
+
+    const CompiledMatcher::ResolvedPath& CompiledMatcher::resolve(const BSONObj& doc,
+                                                                  int pathIdx,
+                                                                  ResolvedPath* resolved) const {
+        ResolvedPath& out = resolved[pathIdx];
+        if (out.state != kUnresolved)
+            return out;
+
+        const Path& path = _paths[pathIdx];
+        BSONElement elem;
+        if (path.parent < 0) {
+            elem = doc.getField(path.field);
+        }
+        else {
+            const ResolvedPath& parent = resolve(doc, path.parent, resolved);
+            if (parent.state == kArray) {
+                out.state = kArray;
+                return out;
+            }
+
+            // A scalar or a missing field has no subfields, so 'elem' stays EOO.
+            if (parent.elem.type() == Object)
+                elem = parent.elem.embeddedObject().getField(path.field);
+        }
+
+        out.state = elem.type() == Array ? kArray : kValue;
+        out.elem = elem;
+        return out;
+    }
+
+    bool CompiledMatcher::evaluate(const Predicate& pred, const BSONElement& elem) {
+        switch (pred.kernel) {
+        case kCompareNumber:
+            // A number only compares to other numbers, and NaN only matches NaN.
+            if (!elem.isNumber() || std::isnan(elem.numberDouble()))
+                return false;
+            return applyComparison(pred.op, compareNumberElements(elem, pred.rhs));
+
+        case kCompareString:
+            if (elem.type() != String && elem.type() != Symbol)
+                return false;
+            return applyComparison(pred.op, compareStringElements(elem, pred.rhs));
+
+        case kSingleElement:
+            return static_cast<const LeafMatchExpression*>(pred.expr)->matchesSingleElement(elem);
+
+        case kWholeDocument:
+            break;
+        }
+        invariant(false);
+    }
+
+}  // namespace mongo
@@ -0,0 +1,136 @@
+// compiled_matcher.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+    class BSONObj;
+
+    /**
+     * A flattened form of a MatchExpression tree, built once per plan stage, that evaluates
+     * documents faster than walking the tree:
+     *
+     *   - Nested $and nodes become one list of predicates, evaluated in their original order.
+     *   - Each distinct dotted path and each of its prefixes is looked up at most once per
+     *     document. Prefixes are shared, so {"a.b": 1, "a.c": 2} looks up "a" once.
+     *   - $eq, $lt, $lte, $gt and $gte against a number or a string use a comparison kernel for
+     *     that type. $in uses the hashed membership test of its ArrayFilterEntries.
+     *
+     * Only paths that resolve without going through an array are handled this way. If an array
+     * turns up on a predicate's path, that predicate falls back to its own matchesBSON(), which
+     * implements the array semantics. Nodes other than $and and the leaves above are always
+     * evaluated through matchesBSON(). The result is therefore always the same as
+     * expr->matchesBSON(doc).
+     *
+     * The CompiledMatcher keeps pointers into 'expr', which must outlive it.
+     */
+    class CompiledMatcher {
+        MONGO_DISALLOW_COPYING(CompiledMatcher);
+    public:
+        /**
+         * Returns NULL if 'expr' is NULL or has no predicate that compiling would speed up.
+         */
+        static std::unique_ptr<CompiledMatcher> compile(const MatchExpression* expr);
+
+        /**
+         * Returns the same result as matchesBSON(doc) on the compiled expression.
+         */
+        bool matches(const BSONObj& doc) const;
+
+    private:
+        // Limits the per-document state, which lives on the stack.
+        static const size_t kMaxPaths = 32;
+
+        enum Kernel {
+            // Calls matchesBSON() on the whole document.
+            kWholeDocument,
+
+            // Comparison against a number that is not NaN.
+            kCompareNumber,
+
+            // Comparison against a string or a symbol.
+            kCompareString,
+
+            // Calls matchesSingleElement() on the resolved element.
+            kSingleElement,
+        };
+
+        struct Path {
+            int parent; // index into _paths, or -1 for a top-level field
+            std::string field;
+        };
+
+        struct Predicate {
+            Kernel kernel;
+            int path; // index into _paths, unused for kWholeDocument
+            const MatchExpression* expr;
+            MatchExpression::MatchType op;
+            BSONElement rhs;
+        };
+
+        enum ResolvedState {
+            kUnresolved = 0,
+            kValue, // the element, which is EOO if the path is missing
+            kArray, // an array is on the path, so the generic matcher must decide
+        };
+
+        struct ResolvedPath {
+            ResolvedState state;
+            BSONElement elem;
+        };
+
+        CompiledMatcher() = default;
+
+        /**
+         * Returns false if the tree has more distinct paths than kMaxPaths.
+         */
+        bool add(const MatchExpression* expr);
+        int addPath(StringData dottedPath);
+
+        const ResolvedPath& resolve(const BSONObj& doc,
+                                    int pathIdx,
+                                    ResolvedPath* resolved) const;
+
+        static bool evaluate(const Predicate& pred, const BSONElement& elem);
+
+        std::vector<Path> _paths;
+        std::vector<Predicate> _predicates;
+    };
+
+}  // namespace mongo
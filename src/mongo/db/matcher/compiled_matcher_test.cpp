@@ -0,0 +1,150 @@
+// compiled_matcher_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <limits>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/compiled_matcher.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    std::unique_ptr<MatchExpression> parse(const BSONObj& query) {
+        StatusWithMatchExpression swme = MatchExpressionParser::parse(query);
+        ASSERT_OK(swme.getStatus());
+        return std::unique_ptr<MatchExpression>(swme.getValue());
+    }
+
+    std::vector<BSONObj> testDocuments() {
+        std::vector<BSONObj> docs;
+        docs.push_back(BSONObj());
+        docs.push_back(fromjson("{a: 1}"));
+        docs.push_back(fromjson("{a: 1.0, b: 'x'}"));
+        docs.push_back(BSON("a" << 1LL << "b" << "y"));
+        docs.push_back(BSON("a" << 2.5 << "b" << BSONSymbol("x")));
+        docs.push_back(BSON("a" << std::numeric_limits<double>::quiet_NaN()));
+        docs.push_back(fromjson("{a: null, b: null}"));
+        docs.push_back(fromjson("{a: 'str', b: 5}"));
+        docs.push_back(fromjson("{a: {b: 1, c: 'x'}}"));
+        docs.push_back(fromjson("{a: {b: {c: 3}}, b: 2}"));
+        docs.push_back(fromjson("{a: {b: [1, 2]}, b: 'x'}"));
+        docs.push_back(fromjson("{a: [1, 2, 3]}"));
+        docs.push_back(fromjson("{a: [{b: 1}, {b: 5}]}"));
+        docs.push_back(fromjson("{a: [[1], 2], b: 'xy'}"));
+        docs.push_back(fromjson("{a: 5, b: {c: 'x'}}"));
+        docs.push_back(fromjson("{a: {b: null}}"));
+        docs.push_back(fromjson("{a: {}}"));
+        docs.push_back(fromjson("{a: {b: 1}, 'a.b': 2}"));
+        docs.push_back(fromjson("{a: {'0': 1}}"));
+        docs.push_back(fromjson("{a: [], b: []}"));
+        docs.push_back(fromjson("{a: {$minKey: 1}, b: {$maxKey: 1}}"));
+        return docs;
+    }
+
+    std::vector<BSONObj> testQueries() {
+        std::vector<BSONObj> queries;
+        queries.push_back(fromjson("{a: 1}"));
+        queries.push_back(fromjson("{a: {$lt: 2}}"));
+        queries.push_back(fromjson("{a: {$lte: 1}, b: 'x'}"));
+        queries.push_back(fromjson("{a: {$gt: 1}, b: {$gte: 'x'}}"));
+        queries.push_back(fromjson("{a: {$gte: 1, $lt: 3}}"));
+        queries.push_back(fromjson("{a: null}"));
+        queries.push_back(fromjson("{b: {$lte: null}}"));
+        queries.push_back(fromjson("{a: 'str'}"));
+        queries.push_back(fromjson("{b: {$lt: 'xz'}}"));
+        queries.push_back(fromjson("{'a.b': 1}"));
+        queries.push_back(fromjson("{'a.b': {$gt: 0}, 'a.c': 'x'}"));
+        queries.push_back(fromjson("{'a.b.c': 3, b: 2}"));
+        queries.push_back(fromjson("{'a.b': null}"));
+        queries.push_back(fromjson("{'a.0': 1}"));
+        queries.push_back(fromjson("{a: {$in: [1, 'str', null]}}"));
+        queries.push_back(fromjson("{'a.b': {$in: [5, 2]}}"));
+        queries.push_back(fromjson("{a: {$in: [/^s/, 2.5]}}"));
+        queries.push_back(fromjson("{a: {b: 1, c: 'x'}}"));
+        queries.push_back(fromjson("{a: [1, 2, 3]}"));
+        queries.push_back(fromjson("{a: {$gt: {$minKey: 1}}}"));
+        queries.push_back(fromjson("{b: {$lt: {$maxKey: 1}}}"));
+        queries.push_back(fromjson("{$and: [{a: {$gte: 1}}, {$and: [{b: 'x'}, {a: {$lt: 2}}]}]}"));
+        queries.push_back(fromjson("{a: 1, $or: [{b: 'x'}, {b: 'y'}]}"));
+        queries.push_back(fromjson("{a: {$ne: 1}, b: {$exists: true}}"));
+        queries.push_back(fromjson("{a: {$elemMatch: {b: 5}}, 'a.b': 1}"));
+        queries.push_back(fromjson("{a: {$type: 2}, b: {$nin: [5]}}"));
+        queries.push_back(BSON("a" << std::numeric_limits<double>::quiet_NaN()));
+        queries.push_back(BSON("a" << BSON("$lte" << std::numeric_limits<double>::quiet_NaN())));
+        queries.push_back(BSON("b" << BSONSymbol("x")));
+        return queries;
+    }
+
+    // Every query must give the same answer compiled or not, on every document.
+    TEST(CompiledMatcherTest, MatchesLikeMatchExpression) {
+        const std::vector<BSONObj> docs = testDocuments();
+        const std::vector<BSONObj> queries = testQueries();
+
+        for (size_t q = 0; q < queries.size(); q++) {
+            const std::unique_ptr<MatchExpression> expr = parse(queries[q]);
+            const std::unique_ptr<CompiledMatcher> compiled = CompiledMatcher::compile(expr.get());
+            if (!compiled)
+                continue;
+
+            for (size_t d = 0; d < docs.size(); d++) {
+                const bool expected = expr->matchesBSON(docs[d], NULL);
+                if (compiled->matches(docs[d]) != expected) {
+                    FAIL(str::stream() << "query " << queries[q] << " on document " << docs[d]
+                                       << " should have returned " << expected);
+                }
+            }
+        }
+    }
+
+    TEST(CompiledMatcherTest, OnlyCompilesWhenUseful) {
+        ASSERT(!CompiledMatcher::compile(NULL));
+        ASSERT(!CompiledMatcher::compile(parse(fromjson("{$or: [{a: 1}, {b: 1}]}")).get()));
+        ASSERT(!CompiledMatcher::compile(parse(fromjson("{a: {$exists: true}}")).get()));
+
+        ASSERT(CompiledMatcher::compile(parse(fromjson("{a: 1}")).get()));
+        ASSERT(CompiledMatcher::compile(parse(fromjson("{a: {$exists: true}, b: 1}")).get()));
+        ASSERT(CompiledMatcher::compile(parse(fromjson("{'a.b': {$in: [1, 2]}}")).get()));
+    }
+
+    TEST(CompiledMatcherTest, TooManyPathsIsNotCompiled) {
+        BSONObjBuilder query;
+        for (int i = 0; i < 40; i++) {
+            query.append(std::string(str::stream() << "f" << i), i);
+        }
+        ASSERT(!CompiledMatcher::compile(parse(query.obj()).get()));
+    }
+
+}  // namespace
+}  // namespace mongo
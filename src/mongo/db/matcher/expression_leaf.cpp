@@ -30,7 +30,10 @@
 
 #include "mongo/db/matcher/expression_leaf.h"
 
+#include <boost/functional/hash.hpp>
+#include <climits>
 #include <cmath>
+#include <limits>
 #include <pcrecpp.h>
 
 #include "mongo/bson/bsonobj.h"
@@ -467,9 +470,62 @@ namespace mongo {
             _hasEmptyArray = true;
 
         _equalities.insert( e );
+        if ( isHashable( e ) )
+            _hashedEqualities.insert( e );
         return Status::OK();
     }
 
+    bool ArrayFilterEntries::contains( const BSONElement& elem ) const {
+        // Only a number, string or symbol can equal one of those, so the hash set is complete for
+        // them.
+        if ( isHashable( elem ) )
+            return _hashedEqualities.count( elem ) > 0;
+        return _equalities.count( elem ) > 0;
+    }
+
+    bool ArrayFilterEntries::isHashable( const BSONElement& elem ) {
+        return elem.isNumber() || elem.type() == String || elem.type() == Symbol;
+    }
+
+    size_t ArrayFilterEntries::HashableElementHasher::operator()( const BSONElement& elem ) const {
+        size_t hash = 0;
+        boost::hash_combine( hash, elem.canonicalType() );
+
+        switch ( elem.type() ) {
+        case NumberInt:
+            boost::hash_combine( hash, static_cast<long long>( elem.numberInt() ) );
+            break;
+        case NumberLong:
+            boost::hash_combine( hash, elem.numberLong() );
+            break;
+        case NumberDouble: {
+            // A double equals a long only if it is integral and in the range of long long, so
+            // hash those as the long they equal. All NaNs compare equal, and -0.0 == 0.0.
+            static const double kBoundOfLongRange = -static_cast<double>( LLONG_MIN );
+            const double d = elem.numberDouble();
+            if ( std::isnan( d ) ) {
+                boost::hash_combine( hash, std::numeric_limits<double>::quiet_NaN() );
+            }
+            else if ( d >= -kBoundOfLongRange && d < kBoundOfLongRange && d == std::floor( d ) ) {
+                boost::hash_combine( hash, static_cast<long long>( d ) );
+            }
+            else {
+                boost::hash_combine( hash, d );
+            }
+            break;
+        }
+        case String:
+        case Symbol:
+            boost::hash_combine( hash, StringData::Hasher()(
+                StringData( elem.valuestr(), elem.valuestrsize() - 1 ) ) );
+            break;
+        default:
+            invariant( false );
+        }
+
+        return hash;
+    }
+
     Status ArrayFilterEntries::addRegex( RegexMatchExpression* expr ) {
         _regexes.push_back( expr );
         return Status::OK();
@@ -492,6 +548,7 @@ namespace mongo {
         toFillIn._hasNull = _hasNull;
         toFillIn._hasEmptyArray = _hasEmptyArray;
         toFillIn._equalities = _equalities;
+        toFillIn._hashedEqualities = _hashedEqualities;
         for ( unsigned i = 0; i < _regexes.size(); i++ )
             toFillIn._regexes.push_back( static_cast<RegexMatchExpression*>(_regexes[i]->shallowClone()) );
     }
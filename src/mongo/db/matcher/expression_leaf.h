@@ -34,6 +34,7 @@
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/platform/unordered_set.h"
 
 namespace pcrecpp {
     class RE;
@@ -294,7 +295,7 @@ namespace mongo {
         Status addRegex( RegexMatchExpression* expr );
 
         const BSONElementSet& equalities() const { return _equalities; }
-        bool contains( const BSONElement& elem ) const { return _equalities.count(elem) > 0; }
+        bool contains( const BSONElement& elem ) const;
 
         size_t numRegexes() const { return _regexes.size(); }
         RegexMatchExpression* regex( int idx ) const { return _regexes[idx]; }
@@ -313,9 +314,28 @@ namespace mongo {
         void toBSON(BSONArrayBuilder* out) const;
 
     private:
+        /**
+         * Numbers, strings and symbols are also kept in a hash set so that large $in lists can be
+         * probed in constant time. Hashing and equality follow BSONElement::woCompare, so 1, 1.0
+         * and NumberLong(1) are the same entry, as are a string and a symbol with equal contents.
+         */
+        struct HashableElementHasher {
+            size_t operator()( const BSONElement& elem ) const;
+        };
+        struct HashableElementEq {
+            bool operator()( const BSONElement& lhs, const BSONElement& rhs ) const {
+                return lhs.woCompare( rhs, false ) == 0;
+            }
+        };
+        typedef unordered_set<BSONElement, HashableElementHasher, HashableElementEq>
+            HashedEqualitySet;
+
+        static bool isHashable( const BSONElement& elem );
+
         bool _hasNull; // if _equalities has a jstNULL element in it
         bool _hasEmptyArray;
         BSONElementSet _equalities;
+        HashedEqualitySet _hashedEqualities; // the isHashable() subset of _equalities
         std::vector<RegexMatchExpression*> _regexes;
     };
 
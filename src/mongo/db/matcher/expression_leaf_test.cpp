@@ -1479,6 +1479,55 @@ namespace mongo {
     }
 
 
+    TEST( InMatchExpression, MatchesNumericAndStringEquivalents ) {
+        BSONArrayBuilder operandBuilder;
+        for ( int i = 0; i < 1000; i++ ) {
+            operandBuilder.append( i * 2 );
+        }
+        operandBuilder.append( 2.5 );
+        operandBuilder.append( 1LL << 60 );
+        operandBuilder.append( "s" );
+        BSONObj operand = operandBuilder.arr();
+        BSONObjBuilder symbolBuilder;
+        symbolBuilder.appendSymbol( "", "t" );
+        BSONObj symbolOperand = symbolBuilder.obj();
+
+        InMatchExpression in;
+        BSONObjIterator it( operand );
+        while ( it.more() ) {
+            ASSERT_OK( in.getArrayFilterEntries()->addEquality( it.next() ) );
+        }
+        ASSERT_OK( in.getArrayFilterEntries()->addEquality( symbolOperand.firstElement() ) );
+
+        BSONObjBuilder docBuilder;
+        docBuilder.append( "int", 10 );
+        docBuilder.append( "double", 10.0 );
+        docBuilder.append( "long", 10LL );
+        docBuilder.append( "fraction", 2.5 );
+        docBuilder.append( "bigDouble", static_cast<double>( 1LL << 60 ) );
+        docBuilder.appendSymbol( "symbol", "s" );
+        docBuilder.append( "string", "t" );
+        docBuilder.append( "odd", 11 );
+        docBuilder.append( "oddDouble", 10.5 );
+        docBuilder.append( "bigLong", ( 1LL << 60 ) + 1 );
+        docBuilder.append( "prefix", "ss" );
+        docBuilder.append( "negativeZero", -0.0 );
+        BSONObj doc = docBuilder.obj();
+
+        ASSERT( in.matchesSingleElement( doc[ "int" ] ) );
+        ASSERT( in.matchesSingleElement( doc[ "double" ] ) );
+        ASSERT( in.matchesSingleElement( doc[ "long" ] ) );
+        ASSERT( in.matchesSingleElement( doc[ "fraction" ] ) );
+        ASSERT( in.matchesSingleElement( doc[ "bigDouble" ] ) );
+        ASSERT( in.matchesSingleElement( doc[ "symbol" ] ) );
+        ASSERT( in.matchesSingleElement( doc[ "string" ] ) );
+        ASSERT( in.matchesSingleElement( doc[ "negativeZero" ] ) );
+        ASSERT( !in.matchesSingleElement( doc[ "odd" ] ) );
+        ASSERT( !in.matchesSingleElement( doc[ "oddDouble" ] ) );
+        ASSERT( !in.matchesSingleElement( doc[ "bigLong" ] ) );
+        ASSERT( !in.matchesSingleElement( doc[ "prefix" ] ) );
+    }
+
     TEST( InMatchExpression, MatchesScalar ) {
         BSONObj operand = BSON_ARRAY( 5 );
         InMatchExpression in;
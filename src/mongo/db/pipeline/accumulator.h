@@ -49,6 +49,13 @@ namespace mongo {
             processInternal(input, merging);
         }
 
+        /** Process 'count' inputs in order, with the same result as calling process() on each.
+         *  Used by $group to hand over all of a group's inputs from a batch of documents at once.
+         */
+        void process(const Value* inputs, size_t count, bool merging) {
+            processBatchInternal(inputs, count, merging);
+        }
+
         /** Marks the end of the evaluate() phase and return accumulated result.
          *  toBeMerged should be true when the outputs will be merged by process().
          */
@@ -69,6 +76,26 @@ namespace mongo {
         /// Update subclass's internal state based on input
         virtual void processInternal(const Value& input, bool merging) = 0;
 
+        /// Subclasses which can do better than one input at a time should override this.
+        virtual void processBatchInternal(const Value* inputs, size_t count, bool merging) {
+            for (size_t i = 0; i < count; i++) {
+                processInternal(inputs[i], merging);
+            }
+        }
+
+        /// Returns the type of 'inputs' if they are all of the same numeric type, otherwise EOO.
+        static BSONType commonNumericType(const Value* inputs, size_t count) {
+            if (count == 0 || !inputs[0].numeric())
+                return EOO;
+
+            const BSONType type = inputs[0].getType();
+            for (size_t i = 1; i < count; i++) {
+                if (inputs[i].getType() != type)
+                    return EOO;
+            }
+            return type;
+        }
+
         /// subclasses are expected to update this as necessary
         int _memUsageBytes = 0;
     };
@@ -129,6 +156,7 @@ namespace mongo {
         AccumulatorSum();
 
         void processInternal(const Value& input, bool merging) final;
+        void processBatchInternal(const Value* inputs, size_t count, bool merging) final;
         Value getValue(bool toBeMerged) const final;
         const char* getOpName() const final;
         void reset() final;
@@ -186,6 +214,7 @@ namespace mongo {
         AccumulatorAvg();
 
         void processInternal(const Value& input, bool merging) final;
+        void processBatchInternal(const Value* inputs, size_t count, bool merging) final;
         Value getValue(bool toBeMerged) const final;
         const char* getOpName() const final;
         void reset() final;
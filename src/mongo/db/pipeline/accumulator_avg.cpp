@@ -60,6 +60,26 @@ namespace {
         }
     }
 
+    void AccumulatorAvg::processBatchInternal(const Value* inputs, size_t count, bool merging) {
+        if (merging || commonNumericType(inputs, count) == EOO) {
+            Accumulator::processBatchInternal(inputs, count, merging);
+            return;
+        }
+
+        std::vector<double> column(count);
+        for (size_t i = 0; i < count; i++) {
+            column[i] = inputs[i].getDouble();
+        }
+
+        // added in input order so the total matches processing one Value at a time
+        double total = _total;
+        for (size_t i = 0; i < count; i++) {
+            total += column[i];
+        }
+        _total = total;
+        _count += count;
+    }
+
     intrusive_ptr<Accumulator> AccumulatorAvg::create() {
         return new AccumulatorAvg();
     }
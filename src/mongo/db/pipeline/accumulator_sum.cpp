@@ -58,6 +58,50 @@ namespace mongo {
         }
     }
 
+    void AccumulatorSum::processBatchInternal(const Value* inputs, size_t count, bool merging) {
+        const BSONType type = commonNumericType(inputs, count);
+        if (type == EOO) {
+            // mixed or non numeric types need the checks in processInternal()
+            Accumulator::processBatchInternal(inputs, count, merging);
+            return;
+        }
+
+        totalType = Value::getWidestNumeric(totalType, type);
+
+        // The doubles are added in input order so the total is the same as when processing one
+        // Value at a time, rounding included.
+        if (totalType == NumberDouble) {
+            std::vector<double> column(count);
+            for (size_t i = 0; i < count; i++) {
+                column[i] = inputs[i].getDouble();
+            }
+
+            double total = doubleTotal;
+            for (size_t i = 0; i < count; i++) {
+                total += column[i];
+            }
+            doubleTotal = total;
+        }
+        else {
+            std::vector<long long> column(count);
+            for (size_t i = 0; i < count; i++) {
+                column[i] = inputs[i].getLong();
+            }
+
+            long long longSum = 0;
+            for (size_t i = 0; i < count; i++) {
+                longSum += column[i];
+            }
+            longTotal += longSum;
+
+            double total = doubleTotal;
+            for (size_t i = 0; i < count; i++) {
+                total += column[i];
+            }
+            doubleTotal = total;
+        }
+    }
+
     intrusive_ptr<Accumulator> AccumulatorSum::create() {
         return new AccumulatorSum();
     }
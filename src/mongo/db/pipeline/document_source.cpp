@@ -66,6 +66,15 @@ namespace mongo {
         }
     }
 
+    Value DocumentSource::serializeSpillStats(const SorterSpillStats& stats) {
+        if (!stats.spilled())
+            return Value();
+
+        return Value(DOC("spilledBytes" << stats.spilledBytes
+                      << "spilledRuns" << stats.spilledRuns
+                      << "mergePasses" << stats.mergePasses));
+    }
+
     void DocumentSource::serializeToArray(vector<Value>& array, bool explain) const {
         Value entry = serialize(explain);
         if (!entry.missing()) {
@@ -164,6 +164,11 @@ namespace mongo {
          */
         DocumentSource(const boost::intrusive_ptr<ExpressionContext> &pExpCtx);
 
+        /**
+         * For explain output of stages which sort. Returns a missing Value if nothing spilled.
+         */
+        static Value serializeSpillStats(const SorterSpillStats& stats);
+
         /*
           Most DocumentSources have an underlying source they get their data
           from.  This is a convenience for them.
@@ -492,6 +497,9 @@ namespace mongo {
         /// Spill groups map to disk and returns an iterator to the file.
         std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+        /// Options for the files written by spill() and by merges of those files.
+        SortOptions spillOptions();
+
         // Only used by spill. Would be function-local if that were legal in C++03.
         class SpillSTLComparator;
 
@@ -504,6 +512,16 @@ namespace mongo {
         void populate();
         bool populated;
 
+        /**
+         * Adds a batch of input documents to their groups. 'ids' holds the group key of each
+         * document and (*arguments)[i] the input of the i-th accumulator for each document. The
+         * inputs are moved out of 'arguments'. Returns true if any document was not the first of
+         * its group.
+         */
+        bool accumulateBatch(const std::vector<Value>& ids,
+                             std::vector<std::vector<Value> >* arguments,
+                             int* memoryUsageBytes);
+
         /**
          * Parses the raw id expression into _idExpressions and possibly _idFieldNames.
          */
@@ -546,6 +564,7 @@ namespace mongo {
 
         bool _doingMerge;
         bool _spilled;
+        SorterSpillStats _spillStats;
         const bool _extSortAllowed;
         const int _maxMemoryUsageBytes;
         std::unique_ptr<Variables> _variables;
@@ -902,6 +921,7 @@ namespace mongo {
 
         bool _done;
         bool _mergingPresorted;
+        SorterSpillStats _spillStats;
         std::unique_ptr<MySorter::Iterator> _output;
     };
 
@@ -118,8 +118,14 @@ namespace mongo {
         }
 
         // If we got here, there won't be any more documents, so destroy the executor. Can't use
-        // dispose since we want to keep the _currentBatch.
-        _exec.reset();
+        // dispose since we want to keep the _currentBatch. An executor that is still to be
+        // explained with its execution stats is kept until the explain is done.
+        if (pExpCtx->explainExecStats && state == PlanExecutor::IS_EOF) {
+            _exec->saveState();
+        }
+        else {
+            _exec.reset();
+        }
 
         uassert(16028, str::stream() << "collection or index disappeared when cursor yielded: "
                                      << WorkingSetCommon::toStatusString(obj),
@@ -172,7 +178,10 @@ namespace mongo {
             massert(17392, "No _exec. Were we disposed before explained?", _exec);
 
             _exec->restoreState(pExpCtx->opCtx);
-            Explain::explainStages(_exec.get(), ExplainCommon::QUERY_PLANNER, &explainBuilder);
+            Explain::explainStages(_exec.get(),
+                                   pExpCtx->explainExecStats ? ExplainCommon::EXEC_STATS
+                                                             : ExplainCommon::QUERY_PLANNER,
+                                   &explainBuilder);
             _exec->saveState();
         }
 
@@ -192,6 +201,9 @@ namespace mongo {
         BSONObj explainObj = explainBuilder.obj();
         invariant(explainObj.hasField("queryPlanner"));
         out["queryPlanner"] = Value(explainObj["queryPlanner"]);
+        if (pExpCtx->explainExecStats) {
+            out["executionStats"] = Value(explainObj["executionStats"]);
+        }
 
         return Value(DOC(getSourceName() << out.freezeToValue()));
     }
@@ -46,6 +46,11 @@ namespace mongo {
 
     const char DocumentSourceGroup::groupName[] = "$group";
 
+    namespace {
+        // Number of input documents to read before adding them to their groups.
+        const size_t kBatchSize = 1024;
+    }
+
     const char *DocumentSourceGroup::getSourceName() const {
         return groupName;
     }
@@ -175,7 +180,8 @@ namespace mongo {
             insides["$doingMerge"] = Value(true);
         }
 
-        return Value(DOC(getSourceName() << insides.freeze()));
+        return Value(DOC(getSourceName() << insides.freeze()
+                      << "spillStats" << (explain ? serializeSpillStats(_spillStats) : Value())));
     }
 
     DocumentSource::GetDepsReturn DocumentSourceGroup::getDependencies(DepsTracker* deps) const {
@@ -363,63 +369,64 @@ namespace mongo {
 
         // pushed to on spill()
         vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
+        vector<unsigned> sortedFileLevels;
         int memoryUsageBytes = 0;
 
-        // This loop consumes all input from pSource and buckets it based on pIdExpression.
-        while (boost::optional<Document> input = pSource->getNext()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
-                uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
-                               " Pass allowDiskUse:true to opt in.",
-                        _extSortAllowed);
-                sortedFiles.push_back(spill());
-                memoryUsageBytes = 0;
+        // This loop consumes all input from pSource and buckets it based on pIdExpression. The
+        // input is read in batches, computing the group key and the accumulator inputs of each
+        // document before any of them is added to a group.
+        vector<Value> ids;
+        vector<vector<Value> > arguments(numAccumulators); // one column per accumulator
+        bool eof = false;
+        while (!eof) {
+            ids.clear();
+            for (size_t i = 0; i < numAccumulators; i++) {
+                arguments[i].clear();
             }
 
-            _variables->setRoot(*input);
-
-            /* get the _id value */
-            Value id = computeId(_variables.get());
+            while (ids.size() < kBatchSize) {
+                boost::optional<Document> input = pSource->getNext();
+                if (!input) {
+                    eof = true;
+                    break;
+                }
 
-            /* treat missing values the same as NULL SERVER-4674 */
-            if (id.missing())
-                id = Value(BSONNULL);
+                _variables->setRoot(*input);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
+                /* get the _id value */
+                Value id = computeId(_variables.get());
 
-            if (inserted) {
-                memoryUsageBytes += id.getApproximateSize();
+                /* treat missing values the same as NULL SERVER-4674 */
+                if (id.missing())
+                    id = Value(BSONNULL);
 
-                // Add the accumulators
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
-                }
-            } else {
+                ids.push_back(id);
                 for (size_t i = 0; i < numAccumulators; i++) {
-                    // subtract old mem usage. New usage added back after processing.
-                    memoryUsageBytes -= group[i]->memUsageForSorter();
+                    arguments[i].push_back(vpExpression[i]->evaluate(_variables.get()));
                 }
+
+                // We are done with the ROOT document so release it.
+                _variables->clearRoot();
             }
 
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
-            for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
-                memoryUsageBytes += group[i]->memUsageForSorter();
+            if (ids.empty())
+                break;
+
+            if (memoryUsageBytes > _maxMemoryUsageBytes) {
+                uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
+                               " Pass allowDiskUse:true to opt in.",
+                        _extSortAllowed);
+                sortedFiles.push_back(spill());
+                mergeSpilledRunsIfNeeded(&sortedFiles, &sortedFileLevels, spillOptions(),
+                                         SorterComparator());
+                memoryUsageBytes = 0;
             }
 
-            // We are done with the ROOT document so release it.
-            _variables->clearRoot();
+            const bool sawDuplicate = accumulateBatch(ids, &arguments, &memoryUsageBytes);
 
             DEV {
                 // In debug mode, spill every time we have a duplicate id to stress merge logic.
-                if (!inserted // is a dup
+                if (sawDuplicate
                         && !pExpCtx->inRouter // can't spill to disk in router
                         && !_extSortAllowed // don't change behavior when testing external sort
                         && sortedFiles.size() < 20 // don't open too many FDs
@@ -434,6 +441,8 @@ namespace mongo {
             _spilled = true;
             if (!groups.empty()) {
                 sortedFiles.push_back(spill());
+                mergeSpilledRunsIfNeeded(&sortedFiles, &sortedFileLevels, spillOptions(),
+                                         SorterComparator());
             }
 
             // We won't be using groups again so free its memory.
@@ -459,6 +468,81 @@ namespace mongo {
         populated = true;
     }
 
+    bool DocumentSourceGroup::accumulateBatch(const vector<Value>& ids,
+                                              vector<vector<Value> >* arguments,
+                                              int* memoryUsageBytes) {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        const size_t numDocs = ids.size();
+        bool sawDuplicate = false;
+
+        // Find the group of each document, numbering the groups in order of first appearance in
+        // this batch. Groups which existed before the batch have their accumulators' memory usage
+        // subtracted here and added back once they have processed their inputs.
+        vector<GroupsMap::value_type*> batchGroups;
+        vector<size_t> groupSizes;
+        vector<size_t> docGroups(numDocs);
+        boost::unordered_map<const GroupsMap::value_type*, size_t> groupNumbers;
+        for (size_t doc = 0; doc < numDocs; doc++) {
+            GroupsMap::iterator it = groups.find(ids[doc]);
+            const bool inserted = it == groups.end();
+            if (inserted) {
+                it = groups.insert(std::make_pair(ids[doc], Accumulators())).first;
+                *memoryUsageBytes += ids[doc].getApproximateSize();
+
+                // Add the accumulators
+                Accumulators& group = it->second;
+                group.reserve(numAccumulators);
+                for (size_t i = 0; i < numAccumulators; i++) {
+                    group.push_back(vpAccumulatorFactory[i]());
+                }
+            }
+            else {
+                sawDuplicate = true;
+            }
+
+            const pair<boost::unordered_map<const GroupsMap::value_type*, size_t>::iterator, bool>
+                number = groupNumbers.insert(std::make_pair(&*it, batchGroups.size()));
+            if (number.second) {
+                batchGroups.push_back(&*it);
+                groupSizes.push_back(0);
+                if (!inserted) {
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        *memoryUsageBytes -= it->second[i]->memUsageForSorter();
+                    }
+                }
+            }
+
+            docGroups[doc] = number.first->second;
+            groupSizes[docGroups[doc]]++;
+        }
+
+        // Reorder each column of inputs so that the inputs of each group are contiguous, keeping
+        // the documents' order within a group.
+        vector<size_t> groupStarts(batchGroups.size());
+        for (size_t g = 1; g < batchGroups.size(); g++) {
+            groupStarts[g] = groupStarts[g - 1] + groupSizes[g - 1];
+        }
+
+        vector<Value> column(numDocs);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            vector<Value>& inputs = (*arguments)[i];
+            vector<size_t> positions(groupStarts);
+            for (size_t doc = 0; doc < numDocs; doc++) {
+                column[positions[docGroups[doc]]++] = std::move(inputs[doc]);
+            }
+            column.swap(inputs);
+
+            /* tickle the accumulators of each group with all of its inputs at once */
+            for (size_t g = 0; g < batchGroups.size(); g++) {
+                const intrusive_ptr<Accumulator>& accumulator = batchGroups[g]->second[i];
+                accumulator->process(&inputs[groupStarts[g]], groupSizes[g], _doingMerge);
+                *memoryUsageBytes += accumulator->memUsageForSorter();
+            }
+        }
+
+        return sawDuplicate;
+    }
+
     class DocumentSourceGroup::SpillSTLComparator {
     public:
         bool operator() (const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
@@ -466,6 +550,10 @@ namespace mongo {
         }
     };
 
+    SortOptions DocumentSourceGroup::spillOptions() {
+        return SortOptions().TempDir(pExpCtx->tempDir).SpillStats(&_spillStats);
+    }
+
     shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
         vector<const GroupsMap::value_type*> ptrs; // using pointers to speed sorting
         ptrs.reserve(groups.size());
@@ -475,7 +563,7 @@ namespace mongo {
 
         stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
 
-        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
+        SortedFileWriter<Value, Value> writer(spillOptions());
         switch (vpAccumulatorFactory.size()) { // same as ptrs[i]->second.size() for all i.
         case 0: // no values, essentially a distinct
             for (size_t i=0; i < ptrs.size(); i++) {
@@ -134,6 +134,12 @@ namespace mongo {
             verify(!retry);
         }
 
+        // Keep the next batch from every shard in flight while we consume the current ones, so
+        // that the merge never waits on one shard's round trip while the others sit idle.
+        for (Cursors::const_iterator it = _cursors.begin(); it !=_cursors.end(); ++it) {
+            (*it)->cursor.enablePrefetch();
+        }
+
         _currentCursor = _cursors.begin();
     }
 
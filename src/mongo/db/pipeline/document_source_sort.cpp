@@ -68,7 +68,8 @@ namespace mongo {
             array.push_back(Value(DOC(getSourceName() <<
                 DOC("sortKey" << serializeSortKey(explain)
                  << "mergePresorted" << (_mergingPresorted ? Value(true) : Value())
-                 << "limit" << (limitSrc ? Value(limitSrc->getLimit()) : Value())))));
+                 << "limit" << (limitSrc ? Value(limitSrc->getLimit()) : Value())
+                 << "spillStats" << serializeSpillStats(_spillStats)))));
         }
         else { // one Value for $sort and maybe a Value for $limit
             MutableDocument inner (serializeSortKey(explain));
@@ -237,7 +238,8 @@ namespace mongo {
                 msgasserted(17196, "can only mergePresorted from MergeCursors and CommandShards");
             }
         } else {
-            unique_ptr<MySorter> sorter (MySorter::make(makeSortOptions(), Comparator(*this)));
+            unique_ptr<MySorter> sorter (MySorter::make(makeSortOptions().SpillStats(&_spillStats),
+                                                        Comparator(*this)));
             while (boost::optional<Document> next = pSource->getNext()) {
                 sorter->add(extractKey(*next), *next);
             }
@@ -58,6 +58,7 @@ namespace mongo {
         bool inRouter = false;
         bool extSortAllowed = false;
         bool bypassDocumentValidation = false;
+        bool explainExecStats = false; // Explain runs the pipeline and reports what it did.
 
         NamespaceString ns;
         std::string tempDir; // Defaults to empty to prevent external sorting in mongos.
@@ -144,7 +144,18 @@ namespace mongo {
 
             /* check for explain option */
             if (!strcmp(pFieldName, explainName)) {
-                pPipeline->explain = cmdElement.Bool();
+                if (cmdElement.type() == String) {
+                    // Only mongod runs the pipeline for this. Shards are sent explain: true.
+                    uassert(28707,
+                            str::stream() << "explain must be a bool or \"executionStats\", not \""
+                                          << cmdElement.valueStringData() << "\"",
+                            cmdElement.valueStringData() == "executionStats");
+                    pPipeline->explain = true;
+                    pCtx->explainExecStats = true;
+                }
+                else {
+                    pPipeline->explain = cmdElement.Bool();
+                }
                 continue;
             }
 
@@ -35,8 +35,10 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/document_validation.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_executor.h"
@@ -88,6 +90,80 @@ namespace {
         intrusive_ptr<ExpressionContext> _ctx;
         DBDirectClient _client;
     };
+
+    /**
+     * Canonicalizes the query described by 'queryObj', 'sortObj' and 'projectionObj' and tries to
+     * build a PlanExecutor for it with the given planner options.
+     */
+    Status attemptToGetExecutor(OperationContext* txn,
+                                Collection* collection,
+                                const intrusive_ptr<ExpressionContext>& pExpCtx,
+                                const BSONObj& queryObj,
+                                const BSONObj& projectionObj,
+                                const BSONObj& sortObj,
+                                size_t plannerOpts,
+                                PlanExecutor** execOut) {
+        const WhereCallbackReal whereCallback(pExpCtx->opCtx, pExpCtx->ns.db());
+
+        CanonicalQuery* cq;
+        Status status = CanonicalQuery::canonicalize(pExpCtx->ns,
+                                                     queryObj,
+                                                     sortObj,
+                                                     projectionObj,
+                                                     &cq,
+                                                     whereCallback);
+        if (!status.isOK()) {
+            return status;
+        }
+
+        // Takes ownership of 'cq'.
+        return getExecutor(txn,
+                           collection,
+                           cq,
+                           PlanExecutor::YIELD_AUTO,
+                           execOut,
+                           plannerOpts);
+    }
+
+    /**
+     * Returns true if some index of 'collection' holds every field included by 'projection', so
+     * that the planner could answer that projection from index keys alone.
+     */
+    bool anyIndexCouldCover(OperationContext* txn,
+                            Collection* collection,
+                            const BSONObj& projection) {
+        if (!collection) {
+            return false;
+        }
+
+        IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(txn,
+                                                                                         false);
+        while (ii.more()) {
+            const IndexDescriptor* desc = ii.next();
+            if (desc->isMultikey(txn)) {
+                // Keys of a multikey index hold single array elements, not the whole field.
+                continue;
+            }
+
+            const BSONObj keyPattern = desc->keyPattern();
+            bool coversAll = true;
+            BSONObjIterator projIt(projection);
+            while (coversAll && projIt.more()) {
+                const BSONElement elt = projIt.next();
+                if (!elt.trueValue()) {
+                    // Exclusions such as {_id: 0} need nothing from the index.
+                    continue;
+                }
+                coversAll = keyPattern.hasField(elt.fieldName());
+            }
+
+            if (coversAll) {
+                return true;
+            }
+        }
+
+        return false;
+    }
 }
 
     shared_ptr<PlanExecutor> PipelineD::prepareCursorSource(
@@ -136,9 +212,20 @@ namespace {
         const DepsTracker deps = pPipeline->getDependencies(queryObj);
 
         // Passing query an empty projection since it is faster to use ParsedDeps::extractFields().
-        // This will need to change to support covering indexes (SERVER-12015). There is an
-        // exception for textScore since that can only be retrieved by a query projection.
-        const BSONObj projectionForQuery = deps.needTextScore ? deps.toProjection() : BSONObj();
+        // There is an exception for textScore since that can only be retrieved by a query
+        // projection.
+        //
+        // If the pipeline only depends on a few named fields which some index holds, we hand the
+        // dependency projection to the query system instead (SERVER-12015). Covered plans then
+        // race the plans that fetch documents, and the most productive one wins whether or not
+        // it is covered.
+        BSONObj projectionForQuery = deps.needTextScore ? deps.toProjection() : BSONObj();
+        if (!deps.needWholeDocument && !deps.needTextScore && !deps.fields.empty()) {
+            const BSONObj depsProjection = deps.toProjection();
+            if (anyIndexCouldCover(txn, collection, depsProjection)) {
+                projectionForQuery = depsProjection;
+            }
+        }
 
         /*
           Look for an initial sort; we'll try to add this to the
@@ -182,25 +269,13 @@ namespace {
         std::shared_ptr<PlanExecutor> exec;
         bool sortInRunner = false;
 
-        const WhereCallbackReal whereCallback(pExpCtx->opCtx, pExpCtx->ns.db());
-
         if (sortStage) {
-            CanonicalQuery* cq;
-            Status status =
-                CanonicalQuery::canonicalize(pExpCtx->ns,
-                                             queryObj,
-                                             sortObj,
-                                             projectionForQuery,
-                                             &cq,
-                                             whereCallback);
-
             PlanExecutor* rawExec;
-            if (status.isOK() && getExecutor(txn,
-                                             collection,
-                                             cq,
-                                             PlanExecutor::YIELD_AUTO,
-                                             &rawExec,
-                                             runnerOptions).isOK()) {
+            Status status = attemptToGetExecutor(txn, collection, pExpCtx, queryObj,
+                                                 projectionForQuery, sortObj,
+                                                 runnerOptions, &rawExec);
+
+            if (status.isOK()) {
                 // success: The PlanExecutor will handle sorting for us using an index.
                 exec.reset(rawExec);
                 sortInRunner = true;
@@ -215,22 +290,10 @@ namespace {
 
         if (!exec.get()) {
             const BSONObj noSort;
-            CanonicalQuery* cq;
-            uassertStatusOK(
-                CanonicalQuery::canonicalize(pExpCtx->ns,
-                                             queryObj,
-                                             noSort,
-                                             projectionForQuery,
-                                             &cq,
-                                             whereCallback));
-
             PlanExecutor* rawExec;
-            uassertStatusOK(getExecutor(txn,
-                                        collection,
-                                        cq,
-                                        PlanExecutor::YIELD_AUTO,
-                                        &rawExec,
-                                        runnerOptions));
+            uassertStatusOK(attemptToGetExecutor(txn, collection, pExpCtx, queryObj,
+                                                 projectionForQuery, noSort,
+                                                 runnerOptions, &rawExec));
             exec.reset(rawExec);
         }
 
@@ -244,6 +244,11 @@ namespace mongo {
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("memUsage", spec->memUsage);
                 bob->appendNumber("memLimit", spec->memLimit);
+                if (spec->spilledRuns > 0) {
+                    bob->appendNumber("spilledBytes", spec->spilledBytes);
+                    bob->appendNumber("spilledRuns", spec->spilledRuns);
+                    bob->appendNumber("mergePasses", spec->mergePasses);
+                }
 
                 bob->appendNumber("flaggedButPassed", spec->flaggedButPassed);
                 bob->appendNumber("flaggedInProgress", spec->flaggedInProgress);
@@ -269,6 +274,10 @@ namespace mongo {
             bob->append("direction", spec->direction > 0 ? "forward" : "backward");
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("docsExamined", spec->docsTested);
+                if (spec->rangesSkipped > 0) {
+                    bob->appendNumber("rangesSkipped", spec->rangesSkipped);
+                    bob->appendNumber("docsSkipped", spec->docsSkipped);
+                }
             }
         }
         else if (STAGE_COUNT == stats.stageType) {
@@ -402,6 +411,11 @@ namespace mongo {
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("memUsage", spec->memUsage);
                 bob->appendNumber("memLimit", spec->memLimit);
+                if (spec->spilledRuns > 0) {
+                    bob->appendNumber("spilledBytes", spec->spilledBytes);
+                    bob->appendNumber("spilledRuns", spec->spilledRuns);
+                    bob->appendNumber("mergePasses", spec->mergePasses);
+                }
             }
 
             if (spec->limit > 0) {
@@ -41,9 +41,11 @@
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/count.h"
 #include "mongo/db/exec/delete.h"
+#include "mongo/db/exec/distinct_scan.h"
 #include "mongo/db/exec/eof.h"
 #include "mongo/db/exec/group.h"
 #include "mongo/db/exec/idhack.h"
+#include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/oplogstart.h"
 #include "mongo/db/exec/projection.h"
@@ -62,6 +64,8 @@
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/planner_analysis.h"
+#include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/planner_prune.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_common.h"
@@ -75,6 +79,7 @@
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/s/d_state.h"
 #include "mongo/scripting/engine.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 
@@ -129,6 +134,87 @@ namespace mongo {
 
             return !expression::isSubsetOf(queryPredicates, filter);
         }
+
+        /**
+         * Returns true if the first 'prefixLen' fields of the index 'desc' hold at most 'limit'
+         * distinct key prefixes, counting them by skipping from one to the next.
+         */
+        bool hasFewKeyPrefixes(OperationContext* txn,
+                               const IndexDescriptor* desc,
+                               size_t prefixLen,
+                               long long limit) {
+            DistinctParams params;
+            params.descriptor = desc;
+            params.direction = 1;
+            IndexBoundsBuilder::allValuesBounds(desc->keyPattern(), &params.bounds);
+            params.fieldNo = prefixLen - 1;
+
+            WorkingSet ws;
+            DistinctScan scan(txn, params, &ws);
+
+            long long prefixes = 0;
+            while (prefixes <= limit) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan.work(&id);
+                if (PlanStage::IS_EOF == state) {
+                    return true;
+                }
+                else if (PlanStage::ADVANCED == state) {
+                    ws.free(id);
+                    ++prefixes;
+                }
+                else if (PlanStage::NEED_TIME != state) {
+                    // We don't yield or retry for an estimate.
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Returns the position in 'keyPattern' of the first field that is in 'fields', or 0 if
+         * the first field of 'keyPattern' is, or none is.
+         */
+        size_t firstFieldAfterPrefix(const BSONObj& keyPattern,
+                                     const unordered_set<string>& fields) {
+            size_t pos = 0;
+            BSONObjIterator it(keyPattern);
+            while (it.more()) {
+                if (fields.end() != fields.find(it.next().fieldName())) {
+                    return pos;
+                }
+                ++pos;
+            }
+            return 0;
+        }
+
+        /**
+         * Sets IndexEntry::skipScanPrefixLen for the btree indices in 'indices' which don't lead
+         * with a field in 'fields', but hold few distinct prefixes up to the first one that is.
+         */
+        void markSkipScanIndices(OperationContext* txn,
+                                 Collection* collection,
+                                 const unordered_set<string>& fields,
+                                 vector<IndexEntry>* indices) {
+            for (size_t i = 0; i < indices->size(); ++i) {
+                IndexEntry& entry = (*indices)[i];
+                if (INDEX_BTREE != entry.type || entry.sparse || entry.filterExpr) {
+                    continue;
+                }
+
+                const size_t prefixLen = firstFieldAfterPrefix(entry.keyPattern, fields);
+                if (0 == prefixLen) {
+                    continue;
+                }
+
+                const IndexDescriptor* desc =
+                    collection->getIndexCatalog()->findIndexByName(txn, entry.name);
+                if (desc && hasFewKeyPrefixes(txn, desc, prefixLen,
+                                              internalQueryPlannerSkipScanMaxPrefixes)) {
+                    entry.skipScanPrefixLen = prefixLen;
+                }
+            }
+        }
     }  // namespace
 
 
@@ -219,8 +305,63 @@ namespace mongo {
         }
     }
 
+    void fillOutSkipScanParams(OperationContext* txn,
+                               Collection* collection,
+                               const CanonicalQuery& canonicalQuery,
+                               QueryPlannerParams* plannerParams) {
+        // Hinted queries don't consider skip scans, so don't pay for looking at the indices.
+        if (internalQueryPlannerSkipScanMaxPrefixes <= 0
+            || !canonicalQuery.getParsed().getHint().isEmpty()) {
+            return;
+        }
+
+        unordered_set<string> fields;
+        QueryPlannerIXSelect::getFields(canonicalQuery.root(), "", &fields);
+        markSkipScanIndices(txn, collection, fields, &plannerParams->indices);
+    }
+
     namespace {
 
+        /**
+         * Counts the keys within the bounds of the index scan 'node' by running the scan, giving
+         * up once more than 'limit' keys were examined.  See QueryPlannerPrune::KeyCounter.
+         */
+        long long countIndexKeys(OperationContext* opCtx,
+                                 Collection* collection,
+                                 const IndexScanNode& node,
+                                 long long limit) {
+            IndexScanParams params;
+            params.descriptor =
+                collection->getIndexCatalog()->findIndexByKeyPattern(opCtx, node.indexKeyPattern);
+            if (NULL == params.descriptor) {
+                return limit + 1;
+            }
+            params.bounds = node.bounds;
+            params.direction = node.direction;
+            params.doNotDedup = true;
+
+            WorkingSet ws;
+            IndexScan scan(opCtx, params, &ws, NULL);
+            const IndexScanStats* stats =
+                static_cast<const IndexScanStats*>(scan.getSpecificStats());
+
+            while (static_cast<long long>(stats->keysExamined) <= limit) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan.work(&id);
+                if (PlanStage::IS_EOF == state) {
+                    break;
+                }
+                else if (PlanStage::ADVANCED == state) {
+                    ws.free(id);
+                }
+                else if (PlanStage::NEED_TIME != state) {
+                    // We don't yield or retry for an estimate.
+                    return limit + 1;
+                }
+            }
+            return stats->keysExamined;
+        }
+
         /**
          * Build an execution tree for the query described in 'canonicalQuery'.  Does not take
          * ownership of arguments.
@@ -351,6 +492,9 @@ namespace mongo {
                 }
             }
 
+            // Only queries which are about to be planned from scratch pay for probing indices.
+            fillOutSkipScanParams(opCtx, collection, *canonicalQuery, &plannerParams);
+
             if (internalQueryPlanOrChildrenIndependently
                 && SubplanStage::canUseSubplanning(*canonicalQuery)) {
 
@@ -401,6 +545,19 @@ namespace mongo {
                 }
             }
 
+            // Don't pay for trial runs of intersection plans which are sure to lose.
+            if (solutions.size() > 1) {
+                const size_t pruned = QueryPlannerPrune::pruneIntersections(
+                    &solutions,
+                    internalQueryPlannerIntersectionProbeKeys,
+                    stdx::bind(countIndexKeys, opCtx, collection,
+                               stdx::placeholders::_1, stdx::placeholders::_2));
+                if (pruned > 0) {
+                    LOG(2) << "Dropped " << pruned << " index intersection plan(s) which examine"
+                           << " more keys than another plan: " << canonicalQuery->toStringShort();
+                }
+            }
+
             if (1 == solutions.size()) {
                 // Only one possible plan.  Run it.  Build the stages from the solution.
                 verify(StageBuilder::build(opCtx, collection, *solutions[0], ws, rootOut));
@@ -1396,6 +1553,37 @@ namespace {
             }
         }
 
+        // Without such an index, one with few distinct prefixes before the field can be skip
+        // scanned instead.
+        if (plannerParams.indices.empty() && internalQueryPlannerSkipScanMaxPrefixes > 0) {
+            unordered_set<string> fields;
+            fields.insert(field);
+
+            IndexCatalog::IndexIterator all =
+                collection->getIndexCatalog()->getIndexIterator(txn, false);
+            while (all.more()) {
+                const IndexDescriptor* desc = all.next();
+                plannerParams.indices.push_back(IndexEntry(desc->keyPattern(),
+                                                           desc->getAccessMethodName(),
+                                                           desc->isMultikey(txn),
+                                                           desc->isSparse(),
+                                                           desc->unique(),
+                                                           desc->indexName(),
+                                                           NULL,
+                                                           desc->infoObj()));
+            }
+
+            markSkipScanIndices(txn, collection, fields, &plannerParams.indices);
+
+            vector<IndexEntry> skipScanIndices;
+            for (size_t i = 0; i < plannerParams.indices.size(); ++i) {
+                if (plannerParams.indices[i].skipScanPrefixLen > 0) {
+                    skipScanIndices.push_back(plannerParams.indices[i]);
+                }
+            }
+            plannerParams.indices.swap(skipScanIndices);
+        }
+
         const WhereCallbackReal whereCallback(txn, collection->ns().db());
 
         // If there are no suitable indices for the distinct hack bail out now into regular planning
@@ -1445,7 +1633,8 @@ namespace {
             dn->indexKeyPattern = plannerParams.indices[distinctNodeIndex].keyPattern;
             dn->direction = 1;
             IndexBoundsBuilder::allValuesBounds(dn->indexKeyPattern, &dn->bounds);
-            dn->fieldNo = 0;
+            // Zero unless the index has to be skip scanned to reach the field.
+            dn->fieldNo = plannerParams.indices[distinctNodeIndex].skipScanPrefixLen;
 
             QueryPlannerParams params;
 
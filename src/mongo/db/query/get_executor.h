@@ -62,6 +62,16 @@ namespace mongo {
                               CanonicalQuery* canonicalQuery,
                               QueryPlannerParams* plannerParams);
 
+    /**
+     * Marks the indices in 'plannerParams' which may be skip scanned to answer 'canonicalQuery'.
+     * This probes the indices themselves, so it should only be called when the planner is about
+     * to enumerate plans, not when a cached or idhack plan will be used.
+     */
+    void fillOutSkipScanParams(OperationContext* txn,
+                               Collection* collection,
+                               const CanonicalQuery& canonicalQuery,
+                               QueryPlannerParams* plannerParams);
+
     /**
      * Get a plan executor for a query. Takes ownership of 'rawCanonicalQuery'.
      *
@@ -60,6 +60,10 @@ namespace mongo {
             sb << " io: " << infoObj;
         }
 
+        if (skipScanPrefixLen) {
+            sb << " skipScanPrefixLen: " << skipScanPrefixLen;
+        }
+
         return sb.str();
     }
 
@@ -59,7 +59,8 @@ namespace mongo {
               unique(unq),
               name(n),
               filterExpr(fe),
-              infoObj(io) {
+              infoObj(io),
+              skipScanPrefixLen(0) {
 
             type = IndexNames::nameToType(accessMethod);
         }
@@ -80,7 +81,8 @@ namespace mongo {
               unique(unq),
               name(n),
               filterExpr(fe),
-              infoObj(io) {
+              infoObj(io),
+              skipScanPrefixLen(0) {
 
             type = IndexNames::nameToType(IndexNames::findPluginName(keyPattern));
         }
@@ -95,7 +97,8 @@ namespace mongo {
               unique(false),
               name("test_foo"),
               filterExpr(nullptr),
-              infoObj(BSONObj()) {
+              infoObj(BSONObj()),
+              skipScanPrefixLen(0) {
 
             type = IndexNames::nameToType(IndexNames::findPluginName(keyPattern));
         }
@@ -119,6 +122,11 @@ namespace mongo {
         // by the keyPattern?)
         IndexType type;
 
+        // If non-zero, the first this many fields of the index hold few distinct values, so a
+        // scan of the index may skip from one key prefix to the next to answer predicates over the
+        // fields after them.  Set by the caller of the planner, which can look at the data.
+        size_t skipScanPrefixLen;
+
         std::string toString() const;
     };
 
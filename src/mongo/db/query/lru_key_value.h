@@ -33,23 +33,32 @@
 #include <memory>
 
 #include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
 
     /**
-     * A key-value store structure with a least recently used (LRU) replacement
-     * policy. The number of entries allowed in the kv-store is set as a constant
-     * upon construction.
+     * A key-value store structure with an approximate least recently used (LRU)
+     * replacement policy. The number of entries allowed in the kv-store is set as a
+     * constant upon construction.
      *
      * Caveat:
      * This kv-store is NOT thread safe! The client to this utility is responsible
      * for protecting concurrent access to the LRU store if used in a threaded
-     * context.
+     * context. get(), peek(), hasKey(), size() and iteration never change the
+     * structure of the store, so they may be called concurrently with each other
+     * under a shared lock. Everything else needs exclusive access.
      *
      * Implemented as a doubly-linked list (std::list) with a hash map
      * (boost::unordered_map) for quickly locating the kv-store entries. The
-     * add(), get(), and remove() operations are all O(1).
+     * add(), get(), and remove() operations are all O(1), add() amortized.
+     *
+     * Rather than moving an entry to the front of the list on every get(), which
+     * would need exclusive access, get() only marks the entry as referenced. When
+     * add() has to evict, referenced entries at the back of the list are given a
+     * second chance: they are unmarked and moved to the front, and the first
+     * unmarked entry found is evicted (the "clock" algorithm).
      *
      * The keys of generic type K map to values of type V*. The V*
      * pointers are owned by the kv-store.
@@ -72,7 +81,28 @@ namespace mongo {
         typedef typename KVList::iterator KVListIt;
         typedef typename KVList::const_iterator KVListConstIt;
 
-        typedef boost::unordered_map<K, KVListIt> KVMap;
+        /**
+         * Where an entry is in the list, and whether it was used since it was last
+         * passed over for eviction.
+         */
+        struct KVMapEntry {
+            explicit KVMapEntry(KVListIt listIt) : listIt(listIt) { }
+
+            KVMapEntry(const KVMapEntry& other)
+                : listIt(other.listIt), referenced(other.referenced.load()) { }
+
+            KVMapEntry& operator=(const KVMapEntry& other) {
+                listIt = other.listIt;
+                referenced.store(other.referenced.load());
+                return *this;
+            }
+
+            KVListIt listIt;
+            mutable AtomicUInt32 referenced;
+        };
+
+        typedef boost::unordered_map<K, KVMapEntry> KVMap;
+        typedef typename KVMap::iterator KVMapIt;
         typedef typename KVMap::const_iterator KVMapConstIt;
 
         /**
@@ -84,17 +114,19 @@ namespace mongo {
          * If 'key' already exists in the kv-store, 'entry' will
          * simply replace what is already there.
          *
-         * The least recently used entry is evicted if the
-         * kv-store is full prior to the add() operation.
+         * An entry not used since it was last passed over is
+         * evicted if the kv-store is full prior to the add()
+         * operation. The new entry is only evicted if the
+         * kv-store can't hold any entries.
          *
          * If an entry is evicted, it will be returned in
          * an unique_ptr for the caller to use before disposing.
          */
         std::unique_ptr<V> add(const K& key, V* entry) {
             // If the key already exists, delete it first.
-            KVMapConstIt i = _kvMap.find(key);
+            KVMapIt i = _kvMap.find(key);
             if (i != _kvMap.end()) {
-                KVListIt found = i->second;
+                KVListIt found = i->second.listIt;
                 delete found->second;
                 _kvMap.erase(i);
                 _kvList.erase(found);
@@ -102,16 +134,24 @@ namespace mongo {
             }
 
             _kvList.push_front(std::make_pair(key, entry));
-            _kvMap[key] = _kvList.begin();
+            _kvMap.insert(std::make_pair(key, KVMapEntry(_kvList.begin())));
             _currentSize++;
 
-            // If the store has grown beyond its allowed size,
-            // evict the least recently used entry.
+            // If the store has grown beyond its allowed size, evict the first entry
+            // at the back of the list which hasn't been used since it was last
+            // passed over. Each entry is passed over at most once, as that unmarks it.
             if (_currentSize > _maxSize) {
+                KVMapIt victim = _kvMap.find(_kvList.back().first);
+                while (_currentSize > 1 && (victim->second.referenced.swap(0)
+                                            || _kvList.back().first == key)) {
+                    _kvList.splice(_kvList.begin(), _kvList, victim->second.listIt);
+                    victim = _kvMap.find(_kvList.back().first);
+                }
+
                 V* evictedEntry = _kvList.back().second;
                 invariant(evictedEntry);
 
-                _kvMap.erase(_kvList.back().first);
+                _kvMap.erase(victim);
                 _kvList.pop_back();
                 _currentSize--;
                 invariant(_currentSize == _maxSize);
@@ -132,25 +172,35 @@ namespace mongo {
          * The kv-store retains ownership of 'entryOut', so
          * it should not be deleted by the caller.
          *
-         * As a side effect, the retrieved entry is promoted
-         * to the most recently used.
+         * As a side effect, the retrieved entry is marked as
+         * used, so the next eviction will pass over it.
          */
         Status get(const K& key, V** entryOut) const {
             KVMapConstIt i = _kvMap.find(key);
             if (i == _kvMap.end()) {
                 return Status(ErrorCodes::NoSuchKey, "no such key in LRU key-value store");
             }
-            KVListIt found = i->second;
-            V* foundEntry = found->second;
 
-            // Promote the kv-store entry to the front of the list.
-            // It is now the most recently used.
-            _kvMap.erase(i);
-            _kvList.erase(found);
-            _kvList.push_front(std::make_pair(key, foundEntry));
-            _kvMap[key] = _kvList.begin();
+            // Only write the flag when it changes, so that hits on a hot entry from
+            // several threads don't all dirty its cache line.
+            if (!i->second.referenced.loadRelaxed()) {
+                i->second.referenced.store(1);
+            }
 
-            *entryOut = foundEntry;
+            *entryOut = i->second.listIt->second;
+            return Status::OK();
+        }
+
+        /**
+         * Like get(), but doesn't mark the entry as used. For callers that
+         * only update an entry's bookkeeping and shouldn't keep it from being evicted.
+         */
+        Status peek(const K& key, V** entryOut) const {
+            KVMapConstIt i = _kvMap.find(key);
+            if (i == _kvMap.end()) {
+                return Status(ErrorCodes::NoSuchKey, "no such key in LRU key-value store");
+            }
+            *entryOut = i->second.listIt->second;
             return Status::OK();
         }
 
@@ -158,11 +208,11 @@ namespace mongo {
          * Remove the kv-store entry keyed by 'key'.
          */
         Status remove(const K& key) {
-            KVMapConstIt i = _kvMap.find(key);
+            KVMapIt i = _kvMap.find(key);
             if (i == _kvMap.end()) {
                 return Status(ErrorCodes::NoSuchKey, "no such key in LRU key-value store");
             }
-            KVListIt found = i->second;
+            KVListIt found = i->second.listIt;
             delete found->second;
             _kvMap.erase(i);
             _kvList.erase(found);
@@ -210,13 +260,12 @@ namespace mongo {
         // The number of entries currently in the kv-store.
         size_t _currentSize;
 
-        // (K, V*) pairs are stored in this std::list. They are sorted in order
-        // of use, where the front is the most recently used and the back is the
-        // least recently used.
-        mutable KVList _kvList;
+        // (K, V*) pairs are stored in this std::list. New entries, and entries
+        // given a second chance, go to the front. Evictions are taken from the back.
+        KVList _kvList;
 
         // Maps from a key to the corresponding std::list entry.
-        mutable KVMap _kvMap;
+        KVMap _kvMap;
     };
 
 }  // namespace mongo
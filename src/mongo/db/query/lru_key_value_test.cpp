@@ -163,6 +163,58 @@ namespace {
         }
     }
 
+    /**
+     * Test that get() leaves the order of the entries alone, and
+     * that the entry it marked is moved to the front instead of
+     * being evicted when it reaches the back.
+     */
+    TEST(LRUKeyValueTest, GetGivesSecondChance) {
+        LRUKeyValue<int, int> cache(3);
+        cache.add(1, new int(1));
+        cache.add(2, new int(2));
+        cache.add(3, new int(3));
+        assertInKVStore(cache, 1, 1);
+        ASSERT_EQUALS(cache.begin()->first, 3);
+
+        std::unique_ptr<int> evicted = cache.add(4, new int(4));
+        ASSERT(NULL != evicted.get());
+        ASSERT_EQUALS(*evicted, 2);
+        ASSERT_EQUALS(cache.begin()->first, 1);
+
+        // Passing over 1 unmarked it.
+        evicted = cache.add(5, new int(5));
+        ASSERT(NULL != evicted.get());
+        ASSERT_EQUALS(*evicted, 3);
+        evicted = cache.add(6, new int(6));
+        ASSERT(NULL != evicted.get());
+        ASSERT_EQUALS(*evicted, 4);
+        evicted = cache.add(7, new int(7));
+        ASSERT(NULL != evicted.get());
+        ASSERT_EQUALS(*evicted, 1);
+    }
+
+    /**
+     * Test that peek() finds an entry without promoting it, so the entry
+     * is still the first to be evicted.
+     */
+    TEST(LRUKeyValueTest, PeekDoesNotPromote) {
+        LRUKeyValue<int, int> cache(2);
+        cache.add(1, new int(1));
+        cache.add(2, new int(2));
+
+        int* peeked = NULL;
+        ASSERT_OK(cache.peek(1, &peeked));
+        ASSERT_EQUALS(*peeked, 1);
+        ASSERT_NOT_OK(cache.peek(3, &peeked));
+
+        std::unique_ptr<int> evicted = cache.add(3, new int(3));
+        ASSERT(NULL != evicted.get());
+        ASSERT_EQUALS(*evicted, 1);
+        assertNotInKVStore(cache, 1);
+        assertInKVStore(cache, 2, 2);
+        assertInKVStore(cache, 3, 3);
+    }
+
     /**
      * Test that calling add() with a key that already exists
      * in the kv-store deletes the existing entry.
@@ -33,6 +33,7 @@
 #include "mongo/db/query/plan_cache.h"
 
 #include <algorithm>
+#include <functional>
 #include <math.h>
 #include <memory>
 #include "boost/thread/locks.hpp"
@@ -43,6 +44,7 @@
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/query_knobs.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
@@ -179,6 +181,30 @@ namespace {
         }
     }
 
+    /**
+     * Returns the number of index keys and documents examined by the plan with stats 'stats'.
+     */
+    size_t examinedByPlan(const PlanStageStats& stats) {
+        size_t examined = 0;
+        const SpecificStats* specific = stats.specific.get();
+        if (specific) {
+            if (STAGE_IXSCAN == stats.stageType) {
+                examined += static_cast<const IndexScanStats*>(specific)->keysExamined;
+            }
+            else if (STAGE_FETCH == stats.stageType) {
+                examined += static_cast<const FetchStats*>(specific)->docsExamined;
+            }
+            else if (STAGE_COLLSCAN == stats.stageType) {
+                examined += static_cast<const CollectionScanStats*>(specific)->docsTested;
+            }
+        }
+
+        for (size_t i = 0; i < stats.children.size(); ++i) {
+            examined += examinedByPlan(*stats.children[i]);
+        }
+        return examined;
+    }
+
 }  // namespace
 
     //
@@ -269,9 +295,18 @@ namespace {
     PlanCacheEntry::PlanCacheEntry(const std::vector<QuerySolution*>& solutions,
                                    PlanRankingDecision* why)
         : plannerData(solutions.size()),
-          decision(why) {
+          decision(why),
+          trialExamined(0),
+          trialReturned(0),
+          regressedRuns(0) {
         invariant(why);
 
+        // The winning plan's stats come first.
+        if (!why->stats.empty()) {
+            trialExamined = examinedByPlan(*why->stats[0]);
+            trialReturned = why->stats[0]->common.advanced;
+        }
+
         // The caller of this constructor is responsible for ensuring
         // that the QuerySolution 's' has valid cacheData. If there's no
         // data to cache you shouldn't be trying to construct a PlanCacheEntry.
@@ -313,6 +348,7 @@ namespace {
             fb->score = feedback[i]->score;
             entry->feedback.push_back(fb);
         }
+        entry->regressedRuns = regressedRuns;
         return entry;
     }
 
@@ -415,9 +451,30 @@ namespace {
     // PlanCache
     //
 
-    PlanCache::PlanCache() : _cache(internalQueryCacheSize) { }
+    PlanCache::PlanCache() {
+        initPartitions();
+    }
+
+    PlanCache::PlanCache(const std::string& ns) : _ns(ns) {
+        initPartitions();
+    }
 
-    PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize), _ns(ns) { }
+    void PlanCache::initPartitions() {
+        const size_t maxSize = std::max(internalQueryCacheSize, 1);
+        const size_t numPartitions = std::min(kMaxPartitions, maxSize);
+
+        // The first 'maxSize % numPartitions' partitions hold one more entry than the others, so
+        // that the partitions hold exactly 'maxSize' entries between them.
+        for (size_t i = 0; i < numPartitions; ++i) {
+            const size_t partitionSize =
+                maxSize / numPartitions + (i < maxSize % numPartitions ? 1 : 0);
+            _partitions.push_back(stdx::make_unique<Partition>(partitionSize));
+        }
+    }
+
+    PlanCache::Partition& PlanCache::getPartition(const PlanCacheKey& key) const {
+        return *_partitions[std::hash<PlanCacheKey>()(key) % _partitions.size()];
+    }
 
     PlanCache::~PlanCache() { }
 
@@ -581,10 +638,14 @@ namespace {
         entry->sort = pq.getSort().getOwned();
         entry->projection = pq.getProj().getOwned();
 
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-        std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(computeKey(query), entry);
+        const PlanCacheKey key = computeKey(query);
+        Partition& partition = getPartition(key);
+
+        SimpleRWLock::Exclusive cacheLock(partition.lock);
+        std::unique_ptr<PlanCacheEntry> evictedEntry = partition.cache.add(key, entry);
 
         if (NULL != evictedEntry.get()) {
+            _evictions.fetchAndAdd(1);
             LOG(1) << _ns << ": plan cache maximum size exceeded - "
                    << "removed least recently used entry "
                    << evictedEntry->toString();
@@ -597,13 +658,16 @@ namespace {
         PlanCacheKey key = computeKey(query);
         verify(crOut);
 
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+        Partition& partition = getPartition(key);
+        SimpleRWLock::Shared cacheLock(partition.lock);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = partition.cache.get(key, &entry);
         if (!cacheStatus.isOK()) {
+            partition.misses.fetchAndAdd(1);
             return cacheStatus;
         }
         invariant(entry);
+        partition.hits.fetchAndAdd(1);
 
         *crOut = new CachedSolution(key, *entry);
 
@@ -617,9 +681,10 @@ namespace {
         std::unique_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
         PlanCacheKey ck = computeKey(cq);
 
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+        Partition& partition = getPartition(ck);
+        SimpleRWLock::Exclusive cacheLock(partition.lock);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(ck, &entry);
+        Status cacheStatus = partition.cache.get(ck, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -633,14 +698,57 @@ namespace {
         return Status::OK();
     }
 
+    bool PlanCache::recordExecution(const CanonicalQuery& cq, const PlanStageStats& stats) {
+        const size_t examined = examinedByPlan(stats);
+        const size_t returned = stats.common.advanced;
+
+        const PlanCacheKey key = computeKey(cq);
+        Partition& partition = getPartition(key);
+        SimpleRWLock::Exclusive cacheLock(partition.lock);
+        // Reporting a run doesn't count as a use of the entry, so it can't keep the entry cached.
+        PlanCacheEntry* entry;
+        if (!partition.cache.peek(key, &entry).isOK()) {
+            return false;
+        }
+        invariant(entry);
+
+        // Compare work per result, counting one more result on each side so that runs which
+        // return nothing still compare sensibly.
+        const double perResult = double(examined) / (returned + 1);
+        const double trialPerResult = double(entry->trialExamined) / (entry->trialReturned + 1);
+        const bool regressed = examined > entry->trialExamined
+            && perResult > internalQueryCacheRegressionRatio * trialPerResult;
+
+        if (!regressed) {
+            entry->regressedRuns = 0;
+            return false;
+        }
+
+        if (++entry->regressedRuns < internalQueryCacheRegressedRunsBeforeEviction) {
+            return false;
+        }
+
+        LOG(1) << _ns << ": evicting plan cache entry after " << entry->regressedRuns
+               << " runs in a row examined " << perResult << " index keys and documents per"
+               << " result, where the trial period examined " << trialPerResult << ": "
+               << entry->toString();
+        partition.cache.remove(key);
+        _regressionEvictions.fetchAndAdd(1);
+        return true;
+    }
+
     Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-        return _cache.remove(computeKey(canonicalQuery));
+        const PlanCacheKey key = computeKey(canonicalQuery);
+        Partition& partition = getPartition(key);
+        SimpleRWLock::Exclusive cacheLock(partition.lock);
+        return partition.cache.remove(key);
     }
 
     void PlanCache::clear() {
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-        _cache.clear();
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            SimpleRWLock::Exclusive cacheLock(_partitions[i]->lock);
+            _partitions[i]->cache.clear();
+        }
         _writeOperations.store(0);
     }
 
@@ -656,9 +764,10 @@ namespace {
         PlanCacheKey key = computeKey(query);
         verify(entryOut);
 
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+        Partition& partition = getPartition(key);
+        SimpleRWLock::Shared cacheLock(partition.lock);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = partition.cache.get(key, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -670,25 +779,45 @@ namespace {
     }
 
     std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
         std::vector<PlanCacheEntry*> entries;
         typedef std::list< std::pair<PlanCacheKey, PlanCacheEntry*> >::const_iterator ConstIterator;
-        for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-            PlanCacheEntry* entry = i->second;
-            entries.push_back(entry->clone());
+        for (size_t p = 0; p < _partitions.size(); ++p) {
+            Partition& partition = *_partitions[p];
+            SimpleRWLock::Shared cacheLock(partition.lock);
+            for (ConstIterator i = partition.cache.begin(); i != partition.cache.end(); i++) {
+                PlanCacheEntry* entry = i->second;
+                entries.push_back(entry->clone());
+            }
         }
 
         return entries;
     }
 
     bool PlanCache::contains(const CanonicalQuery& cq) const {
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-        return _cache.hasKey(computeKey(cq));
+        const PlanCacheKey key = computeKey(cq);
+        Partition& partition = getPartition(key);
+        SimpleRWLock::Shared cacheLock(partition.lock);
+        return partition.cache.hasKey(key);
     }
 
     size_t PlanCache::size() const {
-        stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-        return _cache.size();
+        size_t size = 0;
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            SimpleRWLock::Shared cacheLock(_partitions[i]->lock);
+            size += _partitions[i]->cache.size();
+        }
+        return size;
+    }
+
+    PlanCacheStats PlanCache::getStats() const {
+        PlanCacheStats stats;
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            stats.hits += _partitions[i]->hits.load();
+            stats.misses += _partitions[i]->misses.load();
+        }
+        stats.evictions = _evictions.load();
+        stats.regressionEvictions = _regressionEvictions.load();
+        return stats;
     }
 
     void PlanCache::notifyOfWriteOp() {
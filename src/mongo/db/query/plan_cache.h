@@ -28,7 +28,9 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
+#include <vector>
 #include <boost/optional/optional.hpp>
 
 #include "mongo/db/exec/plan_stats.h"
@@ -38,7 +40,7 @@
 #include "mongo/db/query/plan_cache_indexability.h"
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/platform/atomic_word.h"
-#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/rwlock.h"
 
 namespace mongo {
 
@@ -256,6 +258,35 @@ namespace mongo {
         // Annotations from cached runs.  The CachedPlanStage provides these stats about its
         // runs when they complete.
         std::vector<PlanCacheEntryFeedback*> feedback;
+
+        // Index keys and documents examined, and results returned, by the winning plan during the
+        // trial period which ranked it.  Completed runs of the cached plan are measured against
+        // this.
+        size_t trialExamined;
+        size_t trialReturned;
+
+        // Number of completed runs in a row which examined far more per result than the trial
+        // period did.  See PlanCache::recordExecution().
+        int regressedRuns;
+    };
+
+    /**
+     * Counts of a PlanCache's lookups and evictions since it was created.
+     */
+    struct PlanCacheStats {
+        PlanCacheStats() : hits(0), misses(0), evictions(0), regressionEvictions(0) { }
+
+        // Calls to get() which found a cached plan.
+        long long hits;
+
+        // Calls to get() which did not.
+        long long misses;
+
+        // Entries removed to make room for new ones.
+        long long evictions;
+
+        // Entries removed because their plan kept doing much more work than when it was ranked.
+        long long regressionEvictions;
     };
 
     /**
@@ -325,6 +356,18 @@ namespace mongo {
          */
         Status feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback);
 
+        /**
+         * Records how a completed run of the cached plan for 'cq' went, given the stats tree of
+         * the plan.  A run is a regression if it examined more index keys and documents than
+         * the trial period that ranked the plan, and internalQueryCacheRegressionRatio times more
+         * per result returned.  After internalQueryCacheRegressedRunsBeforeEviction regressions
+         * in a row the entry is removed, so that the next run of the query is planned again
+         * against the current data.
+         *
+         * Returns true if the entry was removed.
+         */
+        bool recordExecution(const CanonicalQuery& cq, const PlanStageStats& stats);
+
         /**
          * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
          * was present and removed and an error status otherwise.
@@ -378,6 +421,12 @@ namespace mongo {
          */
         size_t size() const;
 
+        /**
+         * Returns the lookup and eviction counts of this cache.
+         * Used by planCacheListQueryShapes.
+         */
+        PlanCacheStats getStats() const;
+
         /**
          *  You must notify the cache if you are doing writes, as query plan utility will change.
          *  Cache is flushed after every 1000 notifications.
@@ -397,10 +446,41 @@ namespace mongo {
         void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
         void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
 
-        LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+        /**
+         * The cache is split by key into partitions, each with its own LRU store and lock, so
+         * that adding or evicting one query shape does not block lookups of others.  Lookups only
+         * take the lock in shared mode, as LRUKeyValue::get() just marks an entry as used, so
+         * concurrent hits on the same shape don't serialize either.  Entries are evicted in
+         * approximate LRU order within their partition.
+         */
+        struct Partition {
+            explicit Partition(size_t maxSize) : cache(maxSize), lock("PlanCache::Partition") { }
+
+            LRUKeyValue<PlanCacheKey, PlanCacheEntry> cache;
+
+            // Protects cache.  Shared for lookups; exclusive for anything which changes the
+            // store or an entry in it.
+            SimpleRWLock lock;
+
+            // Lookups of keys in this partition.  Kept here rather than in one counter for the
+            // whole cache so that lookups in different partitions don't share a cache line.
+            // Summed across partitions by getStats().
+            AtomicInt64 hits;
+            AtomicInt64 misses;
+        };
+
+        // Upper bound on the number of partitions.  Small caches get fewer of them.  The sizes of
+        // the partitions add up to internalQueryCacheSize.
+        static const size_t kMaxPartitions = 16;
+
+        void initPartitions();
+
+        Partition& getPartition(const PlanCacheKey& key) const;
+
+        std::vector<std::unique_ptr<Partition>> _partitions;
 
-        // Protects _cache.
-        mutable stdx::mutex _cacheMutex;
+        AtomicInt64 _evictions;
+        AtomicInt64 _regressionEvictions;
 
         // Counter for write notifications since initialization or last clear() invocation.  Starts
         // at 0.
@@ -423,6 +423,97 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    TEST(PlanCacheTest, LookupStatsAndEviction) {
+        // Restores the cache size knob when going out of scope.
+        class CacheSizeSetting {
+        public:
+            explicit CacheSizeSetting(int size) : _oldSize(internalQueryCacheSize) {
+                internalQueryCacheSize = size;
+            }
+            ~CacheSizeSetting() {
+                internalQueryCacheSize = _oldSize;
+            }
+        private:
+            const int _oldSize;
+        } cacheSizeSetting(20);
+
+        PlanCache planCache;
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        // Add more query shapes than fit in the cache.
+        const int numShapes = 100;
+        for (int i = 0; i < numShapes; ++i) {
+            const std::string field = str::stream() << "a" << i;
+            unique_ptr<CanonicalQuery> cq(canonicalize(BSON(field << 1)));
+            ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+        }
+
+        // The partitions hold 20 entries between them. Each evicts on its own, so one which saw
+        // few shapes may not be full.
+        const size_t size = planCache.size();
+        ASSERT_GREATER_THAN(size, 0U);
+        ASSERT_LESS_THAN_OR_EQUALS(size, 20U);
+        ASSERT_EQUALS(planCache.getStats().evictions, static_cast<long long>(numShapes - size));
+
+        long long hits = 0;
+        for (int i = 0; i < numShapes; ++i) {
+            const std::string field = str::stream() << "a" << i;
+            unique_ptr<CanonicalQuery> cq(canonicalize(BSON(field << 1)));
+            CachedSolution* rawCachedSolution;
+            if (planCache.get(*cq, &rawCachedSolution).isOK()) {
+                delete rawCachedSolution;
+                ++hits;
+            }
+        }
+        ASSERT_EQUALS(hits, static_cast<long long>(size));
+        ASSERT_EQUALS(planCache.getStats().hits, hits);
+        ASSERT_EQUALS(planCache.getStats().misses, numShapes - hits);
+    }
+
+    TEST(PlanCacheTest, RegressedRunsEvictEntry) {
+        PlanCache planCache;
+        unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        // The trial period of createDecision() examines nothing.
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+
+        CommonStats common("COLLSCAN");
+        PlanStageStats cheapRun(common, STAGE_COLLSCAN);
+        cheapRun.specific.reset(new CollectionScanStats());
+
+        PlanStageStats costlyRun(common, STAGE_COLLSCAN);
+        CollectionScanStats* costlyScan = new CollectionScanStats();
+        costlyScan->docsTested = 1000;
+        costlyRun.specific.reset(costlyScan);
+        costlyRun.common.advanced = 1;
+
+        // A run which does as well as the trial period resets the count of regressions.
+        for (int i = 1; i < internalQueryCacheRegressedRunsBeforeEviction; ++i) {
+            ASSERT_FALSE(planCache.recordExecution(*cq, costlyRun));
+        }
+        ASSERT_FALSE(planCache.recordExecution(*cq, cheapRun));
+        ASSERT_EQUALS(planCache.size(), 1U);
+
+        for (int i = 1; i < internalQueryCacheRegressedRunsBeforeEviction; ++i) {
+            ASSERT_FALSE(planCache.recordExecution(*cq, costlyRun));
+        }
+        ASSERT_TRUE(planCache.recordExecution(*cq, costlyRun));
+        ASSERT_EQUALS(planCache.size(), 0U);
+        ASSERT_EQUALS(planCache.getStats().regressionEvictions, 1LL);
+
+        // Nothing to record against once the entry is gone.
+        ASSERT_FALSE(planCache.recordExecution(*cq, costlyRun));
+    }
+
     /**
      * Each test in the CachePlanSelectionTest suite goes through
      * the following flow:
@@ -34,6 +34,7 @@
 #include "mongo/db/curop.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/multi_plan.h"
+#include "mongo/db/exec/parallel_batch.h"
 #include "mongo/db/exec/pipeline_proxy.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/plan_stats.h"
@@ -74,6 +75,35 @@ namespace mongo {
             return NULL;
         }
 
+        // The most results asked of the root stage at once, unless batches may be filtered in
+        // parallel and need to be larger to be worth splitting.
+        const size_t kResultsPerBatch = 128;
+
+        /**
+         * Asks 'root' for results a batch at a time and hands them out one by one, keeping those
+         * not handed out yet in 'batch'.  Same contract as PlanStage::work().
+         */
+        PlanStage::StageState workBatched(PlanStage* root,
+                                          std::deque<WorkingSetID>* batch,
+                                          WorkingSetID* out) {
+            if (batch->empty()) {
+                const size_t maxResults = (parallelBatchThreads() > 1) ? kParallelBatchResults
+                                                                       : kResultsPerBatch;
+                vector<WorkingSetID> results;
+                const PlanStage::StageState code = root->workBatch(maxResults, &results);
+                invariant(!results.empty());
+                *out = results[0];
+                if (PlanStage::ADVANCED == code) {
+                    batch->insert(batch->end(), results.begin() + 1, results.end());
+                }
+                return code;
+            }
+
+            *out = batch->front();
+            batch->pop_front();
+            return PlanStage::ADVANCED;
+        }
+
     }
 
     // static
@@ -204,7 +234,16 @@ namespace mongo {
         return Status::OK();
     }
 
-    PlanExecutor::~PlanExecutor() { }
+    PlanExecutor::~PlanExecutor() {
+        // A cached plan which stopped before EOF, because of a limit or because its cursor was
+        // closed, still reports how it did. Once killed, the plan cache may be gone.
+        if (!killed() && _collection) {
+            PlanStage* foundStage = getStageByType(_root.get(), STAGE_CACHED_PLAN);
+            if (foundStage) {
+                static_cast<CachedPlanStage*>(foundStage)->recordRun();
+            }
+        }
+    }
 
     // static
     std::string PlanExecutor::statestr(ExecState s) {
@@ -296,6 +335,15 @@ namespace mongo {
 
     void PlanExecutor::invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) {
         if (!killed()) { _root->invalidate(txn, dl, type); }
+
+        // Results waiting to be returned keep their own copy of a document that is about to be
+        // deleted or updated in place, like results buffered inside a stage do.
+        for (size_t i = 0; i < _batchedResults.size(); ++i) {
+            WorkingSetMember* member = _workingSet->get(_batchedResults[i]);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            }
+        }
     }
 
     PlanExecutor::ExecState PlanExecutor::getNext(BSONObj* objOut, RecordId* dlOut) {
@@ -334,7 +382,8 @@ namespace mongo {
         // just pass a NULL fetcher.
         std::unique_ptr<RecordFetcher> fetcher;
 
-        // Incremented on every writeConflict, reset to 0 on any successful call to _root->work.
+        // Incremented on every writeConflict, reset to 0 on any successful call to _root->work,
+        // or to its batched form.
         size_t writeConflictsInARow = 0;
 
         for (;;) {
@@ -364,7 +413,7 @@ namespace mongo {
             fetcher.reset();
 
             WorkingSetID id = WorkingSet::INVALID_ID;
-            PlanStage::StageState code = _root->work(&id);
+            PlanStage::StageState code = workBatched(_root.get(), &_batchedResults, &id);
 
             if (code != PlanStage::NEED_YIELD)
                 writeConflictsInARow = 0;
@@ -460,7 +509,7 @@ namespace mongo {
     }
 
     bool PlanExecutor::isEOF() {
-        return killed() || (_stash.empty() && _root->isEOF());
+        return killed() || (_stash.empty() && _batchedResults.empty() && _root->isEOF());
     }
 
     void PlanExecutor::registerExec() {
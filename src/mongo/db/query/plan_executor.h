@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 #include <queue>
 
 #include "mongo/base/status.h"
@@ -46,6 +47,7 @@ namespace mongo {
     struct PlanStageStats;
     class PlanYieldPolicy;
     class WorkingSet;
+    typedef size_t WorkingSetID;
 
     /**
      * A PlanExecutor is the abstraction that knows how to crank a tree of stages into execution.
@@ -445,6 +447,10 @@ namespace mongo {
         // to consume yet. We empty the queue before retrieving further results from the plan
         // stages.
         std::queue<BSONObj> _stash;
+
+        // Results produced by the root stage which have not been returned yet. Since they are no
+        // longer held by any stage, invalidations of their RecordIds are handled by the executor.
+        std::deque<WorkingSetID> _batchedResults;
     };
 
 }  // namespace mongo
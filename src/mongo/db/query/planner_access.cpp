@@ -31,6 +31,7 @@
 #include "mongo/db/query/planner_access.h"
 
 #include <algorithm>
+#include <set>
 #include <vector>
 
 #include "mongo/db/matcher/expression_array.h"
@@ -39,10 +40,12 @@
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/index_tag.h"
+#include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace {
 
@@ -1347,4 +1350,109 @@ namespace mongo {
         return solnRoot;
     }
 
+    // static
+    QuerySolutionNode* QueryPlannerAccess::makeSkipScan(const IndexEntry& index,
+                                                        const CanonicalQuery& query,
+                                                        const QueryPlannerParams& params) {
+        invariant(index.skipScanPrefixLen > 0);
+
+        // Sparse and partial indices don't hold every document, and only btrees are ordered by
+        // the plain values of their fields.
+        if (INDEX_BTREE != index.type || index.sparse || NULL != index.filterExpr) {
+            return NULL;
+        }
+
+        // Only predicates which every matching document satisfies may bound the scan.
+        vector<MatchExpression*> conjuncts;
+        MatchExpression* root = query.root();
+        if (MatchExpression::AND == root->matchType()) {
+            for (size_t i = 0; i < root->numChildren(); ++i) {
+                conjuncts.push_back(root->getChild(i));
+            }
+        }
+        else {
+            conjuncts.push_back(root);
+        }
+
+        unique_ptr<IndexScanNode> isn(new IndexScanNode());
+        isn->indexKeyPattern = index.keyPattern;
+        isn->indexIsMultiKey = index.multikey;
+        isn->maxScan = query.getParsed().getMaxScan();
+        isn->addKeyMetadata = query.getParsed().returnKey();
+        isn->bounds.fields.resize(index.keyPattern.nFields());
+
+        // The predicates which the bounds answer exactly.
+        size_t exactConjuncts = 0;
+        bool bounded = false;
+
+        // The path prefixes of the fields bounded so far.  As in
+        // PlanEnumerator::getMultikeyCompoundablePreds(), the bounds of two fields of a multikey
+        // index which share a path prefix can't be compounded: their keys may come from
+        // different elements of the same array.
+        std::set<std::string> usedPrefixes;
+
+        BSONObjIterator it(index.keyPattern);
+        for (size_t pos = 0; it.more(); ++pos) {
+            BSONElement keyElt = it.next();
+            if (pos < index.skipScanPrefixLen) {
+                continue;
+            }
+
+            const std::string pathPrefix = mongoutils::str::before(keyElt.fieldName(), '.');
+            if (index.multikey && usedPrefixes.count(pathPrefix)) {
+                continue;
+            }
+
+            OrderedIntervalList* oil = &isn->bounds.fields[pos];
+            for (size_t i = 0; i < conjuncts.size(); ++i) {
+                MatchExpression* child = conjuncts[i];
+                if (!child->isLeaf()
+                    || !Indexability::nodeCanUseIndexOnOwnField(child)
+                    || child->path() != keyElt.fieldNameStringData()
+                    || !QueryPlannerIXSelect::compatible(keyElt, index, child)) {
+                    continue;
+                }
+
+                // The bounds of two predicates over one field of a multikey index can't be
+                // intersected.  Any other predicate is left to the filter.
+                if (index.multikey && !oil->name.empty()) {
+                    continue;
+                }
+
+                IndexBoundsBuilder::BoundsTightness tightness;
+                if (oil->name.empty()) {
+                    IndexBoundsBuilder::translate(child, keyElt, index, oil, &tightness);
+                }
+                else {
+                    IndexBoundsBuilder::translateAndIntersect(child, keyElt, index, oil,
+                                                              &tightness);
+                }
+                bounded = true;
+                if (IndexBoundsBuilder::EXACT == tightness) {
+                    ++exactConjuncts;
+                }
+            }
+
+            if (!oil->name.empty()) {
+                usedPrefixes.insert(pathPrefix);
+            }
+        }
+
+        if (!bounded) {
+            return NULL;
+        }
+
+        // Fills in the prefix and every other field without a predicate with all values.
+        finishLeafNode(isn.get(), index);
+
+        if (exactConjuncts == conjuncts.size()) {
+            return isn.release();
+        }
+
+        FetchNode* fetch = new FetchNode();
+        fetch->filter.reset(root->shallowClone());
+        fetch->children.push_back(isn.release());
+        return fetch;
+    }
+
 }  // namespace mongo
@@ -208,6 +208,18 @@ namespace mongo {
                                                 const BSONObj& startKey,
                                                 const BSONObj& endKey);
 
+        /**
+         * Return a plan that skip scans 'index': every value of its first
+         * index.skipScanPrefixLen fields is scanned, and the fields after them are bounded by the
+         * predicates over them at the top level of 'query'.  The index scan seeks from one key
+         * prefix to the next whenever it runs out of bounds.
+         *
+         * Returns NULL if none of the fields after the prefix can be bounded.
+         */
+        static QuerySolutionNode* makeSkipScan(const IndexEntry& index,
+                                               const CanonicalQuery& query,
+                                               const QueryPlannerParams& params);
+
         //
         // Indexed Data Access methods.
         //
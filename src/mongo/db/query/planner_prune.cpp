@@ -0,0 +1,251 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/planner_prune.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
+
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+
+        /**
+         * Remembers the key counts of index scans, which candidates often share.
+         */
+        class CachingKeyCounter {
+        public:
+            explicit CachingKeyCounter(const QueryPlannerPrune::KeyCounter& countKeys)
+                : _countKeys(countKeys) { }
+
+            long long count(const IndexScanNode& node, long long limit) {
+                const std::string key = mongoutils::str::stream() << node.indexKeyPattern
+                                                                  << node.direction
+                                                                  << node.bounds.toString();
+                std::map<std::string, Count>::iterator it = _counts.find(key);
+                if (it != _counts.end()) {
+                    const Count& known = it->second;
+                    // An exact count, or a count which already went past a higher limit.
+                    if (known.keys <= known.limit || limit <= known.limit) {
+                        return known.keys;
+                    }
+                }
+
+                Count counted;
+                counted.limit = limit;
+                counted.keys = _countKeys(node, limit);
+                _counts[key] = counted;
+                return counted.keys;
+            }
+
+        private:
+            struct Count {
+                long long limit;
+                long long keys;
+            };
+
+            const QueryPlannerPrune::KeyCounter& _countKeys;
+            std::map<std::string, Count> _counts;
+        };
+
+        bool hasIntersection(const QuerySolutionNode* node) {
+            if (STAGE_AND_HASH == node->getType() || STAGE_AND_SORTED == node->getType()) {
+                return true;
+            }
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                if (hasIntersection(node->children[i])) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool hasFetch(const QuerySolutionNode* node) {
+            if (STAGE_FETCH == node->getType()) {
+                return true;
+            }
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                if (hasFetch(node->children[i])) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Adds the index scans below 'node' to 'scans'.  Returns false if anything other than an
+         * index scan provides data below 'node'.
+         */
+        bool getIndexScans(const QuerySolutionNode* node,
+                           std::vector<const IndexScanNode*>* scans) {
+            if (STAGE_IXSCAN == node->getType()) {
+                scans->push_back(static_cast<const IndexScanNode*>(node));
+                return true;
+            }
+            if (node->children.empty()) {
+                return false;
+            }
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                if (!getIndexScans(node->children[i], scans)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Returns the keys within the bounds of all of 'scans', or a number above 'limit' if
+         * there are more than 'limit' of them.
+         */
+        long long countScans(const std::vector<const IndexScanNode*>& scans,
+                             long long limit,
+                             CachingKeyCounter* counter) {
+            long long total = 0;
+            for (size_t i = 0; i < scans.size() && total <= limit; ++i) {
+                total += counter->count(*scans[i], limit - total);
+            }
+            return total;
+        }
+
+        /**
+         * Returns how many keys the AND node 'node' examines at least, or a number above 'limit'
+         * if that is more than 'limit'.  Children fed by something other than index scans count
+         * for nothing.
+         */
+        long long andLowerBound(const QuerySolutionNode* node,
+                                long long limit,
+                                CachingKeyCounter* counter) {
+            const std::vector<QuerySolutionNode*>& children = node->children;
+
+            if (STAGE_AND_HASH == node->getType()) {
+                // Every child but the last is hashed in full.
+                long long total = 0;
+                for (size_t i = 0; i + 1 < children.size() && total <= limit; ++i) {
+                    std::vector<const IndexScanNode*> scans;
+                    if (getIndexScans(children[i], &scans)) {
+                        total += countScans(scans, limit - total, counter);
+                    }
+                }
+                return total;
+            }
+
+            // AND_SORTED stops when any child is exhausted, so only the smallest is surely read.
+            long long smallest = limit + 1;
+            for (size_t i = 0; i < children.size(); ++i) {
+                std::vector<const IndexScanNode*> scans;
+                if (!getIndexScans(children[i], &scans)) {
+                    return 0;
+                }
+                smallest = std::min(smallest, countScans(scans, limit, counter));
+            }
+            return smallest;
+        }
+
+        long long intersectionLowerBound(const QuerySolutionNode* node,
+                                         long long limit,
+                                         CachingKeyCounter* counter) {
+            long long bound = 0;
+            if (STAGE_AND_HASH == node->getType() || STAGE_AND_SORTED == node->getType()) {
+                bound = andLowerBound(node, limit, counter);
+            }
+            for (size_t i = 0; i < node->children.size() && bound <= limit; ++i) {
+                bound = std::max(bound, intersectionLowerBound(node->children[i], limit, counter));
+            }
+            return bound;
+        }
+
+    }  // namespace
+
+    // static
+    size_t QueryPlannerPrune::pruneIntersections(std::vector<QuerySolution*>* solutions,
+                                                 long long probeLimit,
+                                                 const KeyCounter& countKeys) {
+        if (probeLimit <= 0) {
+            return 0;
+        }
+
+        std::vector<bool> intersects(solutions->size());
+        bool anyIntersection = false;
+        bool anySingle = false;
+        for (size_t i = 0; i < solutions->size(); ++i) {
+            intersects[i] = hasIntersection((*solutions)[i]->root.get());
+            anyIntersection = anyIntersection || intersects[i];
+            anySingle = anySingle || !intersects[i];
+        }
+        if (!anyIntersection || !anySingle) {
+            return 0;
+        }
+
+        CachingKeyCounter counter(countKeys);
+
+        // Find the cheapest candidate without an intersection whose cost we can count.  Each key
+        // it examines may cost a fetch as well.
+        const long long unknown = std::numeric_limits<long long>::max();
+        long long cheapest = unknown;
+        for (size_t i = 0; i < solutions->size(); ++i) {
+            const QuerySolutionNode* root = (*solutions)[i]->root.get();
+            std::vector<const IndexScanNode*> scans;
+            if (intersects[i] || !getIndexScans(root, &scans)) {
+                continue;
+            }
+            // A candidate examining 'cheapest' keys or more can't cost less than 'cheapest'.
+            const long long limit = std::min(probeLimit, cheapest);
+            const long long keys = countScans(scans, limit, &counter);
+            if (keys > limit) {
+                continue;
+            }
+            const long long cost = hasFetch(root) ? 2 * keys : keys;
+            cheapest = std::min(cheapest, cost);
+        }
+        if (cheapest == unknown) {
+            return 0;
+        }
+
+        size_t pruned = 0;
+        std::vector<QuerySolution*> kept;
+        for (size_t i = 0; i < solutions->size(); ++i) {
+            QuerySolution* soln = (*solutions)[i];
+            if (intersects[i]
+                && intersectionLowerBound(soln->root.get(), cheapest, &counter) > cheapest) {
+                delete soln;
+                ++pruned;
+                continue;
+            }
+            kept.push_back(soln);
+        }
+        solutions->swap(kept);
+        return pruned;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/query/query_solution.h"
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+    /**
+     * Drops index intersection candidates which are sure to do more work than a single-index
+     * candidate before they are handed to the MultiPlanStage, so that their trial runs are not
+     * paid for.
+     */
+    class QueryPlannerPrune {
+    public:
+        /**
+         * Counts the keys within the bounds of the index scan 'node', stopping once more than
+         * 'limit' keys were seen.  Returns a number greater than 'limit' in that case, or if the
+         * keys could not be counted.
+         */
+        typedef stdx::function<long long (const IndexScanNode& node, long long limit)> KeyCounter;
+
+        /**
+         * Deletes from 'solutions' the intersection plans (those with an AND_HASH or AND_SORTED
+         * stage) which must examine more index keys than some other candidate examines keys and
+         * fetches documents in total.
+         *
+         * The cost of a candidate without an intersection is the number of keys within the bounds
+         * of its index scans, plus as many document fetches again if it has a FETCH stage.  It is
+         * only known if there are at most 'probeLimit' keys and the candidate reads nothing but
+         * index scans.  An AND_HASH reads all of its children but the last before it returns
+         * anything, and an AND_SORTED reads at least one child to the end, which gives a lower
+         * bound on the keys an intersection plan examines.  The documents it fetches are not
+         * counted, so the bound holds however selective the intersection is.  Intersection plans
+         * whose lower bound is above the cheapest known cost are dropped; the others may still
+         * turn out to be cheaper, and are left to the trial runs.
+         *
+         * At least one candidate is always kept.  Returns the number of candidates deleted.
+         */
+        static size_t pruneIntersections(std::vector<QuerySolution*>* solutions,
+                                         long long probeLimit,
+                                         const KeyCounter& countKeys);
+    };
+
+}  // namespace mongo
@@ -0,0 +1,170 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/planner_prune.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/json.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    // Keys within the bounds of an index scan, by the first field of its index.
+    std::map<std::string, long long> keyCounts;
+
+    long long countKeys(const IndexScanNode& node, long long limit) {
+        const long long keys = keyCounts[node.indexKeyPattern.firstElementFieldName()];
+        return std::min(keys, limit + 1);
+    }
+
+    QuerySolutionNode* indexScan(const char* keyPattern) {
+        IndexScanNode* ixscan = new IndexScanNode();
+        ixscan->indexKeyPattern = fromjson(keyPattern);
+        return ixscan;
+    }
+
+    QuerySolutionNode* fetch(QuerySolutionNode* child) {
+        FetchNode* fetch = new FetchNode();
+        fetch->children.push_back(child);
+        return fetch;
+    }
+
+    QuerySolution* solution(QuerySolutionNode* root) {
+        QuerySolution* soln = new QuerySolution();
+        soln->root.reset(root);
+        return soln;
+    }
+
+    QuerySolution* andHash(const char* first, const char* second) {
+        AndHashNode* andHash = new AndHashNode();
+        andHash->children.push_back(indexScan(first));
+        andHash->children.push_back(indexScan(second));
+        return solution(fetch(andHash));
+    }
+
+    QuerySolution* andSorted(const char* first, const char* second) {
+        AndSortedNode* andSorted = new AndSortedNode();
+        andSorted->children.push_back(indexScan(first));
+        andSorted->children.push_back(indexScan(second));
+        return solution(fetch(andSorted));
+    }
+
+    void setKeyCounts() {
+        keyCounts.clear();
+        keyCounts["a"] = 50;
+        keyCounts["b"] = 150;
+        keyCounts["c"] = 500;
+        keyCounts["d"] = 80;
+    }
+
+    TEST(QueryPlannerPrune, DropsIntersectionsWhichExamineMoreThanASingleIndex) {
+        setKeyCounts();
+        OwnedPointerVector<QuerySolution> solutions;
+        solutions.mutableVector().push_back(solution(fetch(indexScan("{a: 1}"))));
+        solutions.mutableVector().push_back(andHash("{b: 1}", "{a: 1}"));
+        solutions.mutableVector().push_back(andHash("{a: 1}", "{b: 1}"));
+        solutions.mutableVector().push_back(andSorted("{b: 1}", "{c: 1}"));
+        solutions.mutableVector().push_back(andSorted("{a: 1}", "{c: 1}"));
+
+        ASSERT_EQUALS(2U, QueryPlannerPrune::pruneIntersections(&solutions.mutableVector(),
+                                                                1000,
+                                                                countKeys));
+        ASSERT_EQUALS(3U, solutions.size());
+
+        // The AND_HASH hashing {a: 1} and the AND_SORTED which may stop after {a: 1} are kept.
+        ASSERT_EQUALS(STAGE_FETCH, solutions[0]->root->getType());
+        ASSERT_EQUALS(STAGE_AND_HASH, solutions[1]->root->children[0]->getType());
+        ASSERT_EQUALS(STAGE_AND_SORTED, solutions[2]->root->children[0]->getType());
+    }
+
+    TEST(QueryPlannerPrune, CountsFetchesOfTheSingleIndexPlan) {
+        setKeyCounts();
+        OwnedPointerVector<QuerySolution> solutions;
+        solutions.mutableVector().push_back(solution(fetch(indexScan("{a: 1}"))));
+        solutions.mutableVector().push_back(andHash("{d: 1}", "{a: 1}"));
+
+        // Hashing {d: 1} examines more keys than {a: 1}, but fewer than the keys and fetches of
+        // the single-index plan.
+        ASSERT_EQUALS(0U, QueryPlannerPrune::pruneIntersections(&solutions.mutableVector(),
+                                                                1000,
+                                                                countKeys));
+        ASSERT_EQUALS(2U, solutions.size());
+
+        // A covered scan of {a: 1} fetches nothing.
+        solutions.mutableVector().push_back(solution(indexScan("{a: 1}")));
+        ASSERT_EQUALS(1U, QueryPlannerPrune::pruneIntersections(&solutions.mutableVector(),
+                                                                1000,
+                                                                countKeys));
+        ASSERT_EQUALS(2U, solutions.size());
+        ASSERT_EQUALS(STAGE_FETCH, solutions[0]->root->getType());
+        ASSERT_EQUALS(STAGE_IXSCAN, solutions[1]->root->getType());
+    }
+
+    TEST(QueryPlannerPrune, KeepsIntersectionsIfSingleIndexCostIsAboveLimit) {
+        setKeyCounts();
+        OwnedPointerVector<QuerySolution> solutions;
+        solutions.mutableVector().push_back(solution(fetch(indexScan("{a: 1}"))));
+        solutions.mutableVector().push_back(andHash("{c: 1}", "{a: 1}"));
+
+        ASSERT_EQUALS(0U, QueryPlannerPrune::pruneIntersections(&solutions.mutableVector(),
+                                                                10,
+                                                                countKeys));
+        ASSERT_EQUALS(2U, solutions.size());
+    }
+
+    TEST(QueryPlannerPrune, KeepsIntersectionsWithoutCountableAlternative) {
+        setKeyCounts();
+        OwnedPointerVector<QuerySolution> solutions;
+        solutions.mutableVector().push_back(solution(new CollectionScanNode()));
+        solutions.mutableVector().push_back(andHash("{c: 1}", "{a: 1}"));
+
+        ASSERT_EQUALS(0U, QueryPlannerPrune::pruneIntersections(&solutions.mutableVector(),
+                                                                1000,
+                                                                countKeys));
+        ASSERT_EQUALS(2U, solutions.size());
+    }
+
+    TEST(QueryPlannerPrune, ZeroLimitDisablesPruning) {
+        setKeyCounts();
+        OwnedPointerVector<QuerySolution> solutions;
+        solutions.mutableVector().push_back(solution(fetch(indexScan("{a: 1}"))));
+        solutions.mutableVector().push_back(andHash("{c: 1}", "{a: 1}"));
+
+        ASSERT_EQUALS(0U, QueryPlannerPrune::pruneIntersections(&solutions.mutableVector(),
+                                                                0,
+                                                                countKeys));
+        ASSERT_EQUALS(2U, solutions.size());
+    }
+
+}  // namespace
@@ -46,6 +46,10 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheWriteOpsBetweenFlush, int, 1000);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheRegressionRatio, double, 10.0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheRegressedRunsBeforeEviction, int, 3);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxOrSolutions, int, 10);
@@ -62,10 +66,19 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerIntersectionProbeKeys, int, 1000);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerSkipScanMaxPrefixes, int, 32);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1024 * 1024);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBlockingStageSpill, bool, true);
+
     // Yield every 128 cycles or 10ms.
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecParallelBatchThreads, int, 1);
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecParallelBatchMaxThreadsPerQuery, int, 4);
+
 }  // namespace mongo
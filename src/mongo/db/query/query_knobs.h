@@ -72,6 +72,13 @@ namespace mongo {
     // How many write ops should we allow in a collection before tossing all cache entries?
     extern int internalQueryCacheWriteOpsBetweenFlush;
 
+    // How many times more index keys and documents per result must a completed run of a cached
+    // plan examine than the plan did when it was ranked, for the run to count as a regression?
+    extern double internalQueryCacheRegressionRatio;
+
+    // How many regressed runs in a row evict a cache entry?
+    extern int internalQueryCacheRegressedRunsBeforeEviction;
+
     //
     // Planning and enumeration.
     //
@@ -92,16 +99,38 @@ namespace mongo {
     // during explodeForSort?
     extern int internalQueryMaxScansToExplode;
 
+    // How many index keys may we count, per candidate, to drop index intersection plans that
+    // must examine more keys than a single-index plan does in total?  0 disables the pruning.
+    extern int internalQueryPlannerIntersectionProbeKeys;
+
+    // How many distinct key prefixes may an index hold for the planner to skip scan it, jumping
+    // from one prefix to the next, to answer predicates over the fields after them?  0 disables
+    // skip scans.
+    extern int internalQueryPlannerSkipScanMaxPrefixes;
+
     //
     // Query execution.
     //
 
     extern int internalQueryExecMaxBlockingSortBytes;
 
+    // Do blocking SORT and AND_HASH stages spill to disk when over their memory limit, rather than
+    // fail?
+    extern bool internalQueryExecBlockingStageSpill;
+
     // Yield after this many "should yield?" checks.
     extern int internalQueryExecYieldIterations;
 
     // Yield if it's been at least this many milliseconds since we last yielded.
     extern int internalQueryExecYieldPeriodMS;
 
+    // How many threads, counting a query's own, the process-wide pool which filters batches of
+    // results is sized for. 0 means one per core, and 1, the default, disables parallel batches.
+    // The pool is sized on first use, but setting this to 1 later still turns them off.
+    extern int internalQueryExecParallelBatchThreads;
+
+    // The most threads, including the query's own, that one batch of results is split between.
+    // Only idle threads of the pool are used, so queries never wait behind each other's batches.
+    extern int internalQueryExecParallelBatchMaxThreadsPerQuery;
+
 }  // namespace mongo
@@ -815,6 +815,38 @@ namespace mongo {
             return Status::OK();
         }
 
+        // An index whose leading fields hold few distinct values can answer predicates over its
+        // later fields by skipping from one key prefix to the next.  These solutions aren't
+        // cached, as whether they pay off depends on the data.
+        size_t skipScanSolutions = 0;
+        if (!QueryPlannerCommon::hasNode(query.root(), MatchExpression::GEO_NEAR)
+            && !QueryPlannerCommon::hasNode(query.root(), MatchExpression::TEXT)) {
+            for (size_t i = 0; i < params.indices.size(); ++i) {
+                if (out->size() >= params.maxIndexedSolutions) {
+                    break;
+                }
+
+                const IndexEntry& index = params.indices[i];
+                if (0 == index.skipScanPrefixLen) {
+                    continue;
+                }
+
+                QuerySolutionNode* solnRoot = QueryPlannerAccess::makeSkipScan(index, query,
+                                                                               params);
+                if (NULL == solnRoot) {
+                    continue;
+                }
+
+                QuerySolution* soln = QueryPlannerAnalysis::analyzeDataAccess(query, params,
+                                                                              solnRoot);
+                if (NULL != soln) {
+                    LOG(5) << "Planner: adding skip scan solution:" << endl << soln->toString();
+                    out->push_back(soln);
+                    ++skipScanSolutions;
+                }
+            }
+        }
+
         // If a sort order is requested, there may be an index that provides it, even if that
         // index is not over any predicates in the query.
         //
@@ -908,7 +940,8 @@ namespace mongo {
         bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN);
 
         // No indexed plans?  We must provide a collscan if possible or else we can't run the query.
-        bool collscanNeeded = (0 == out->size() && canTableScan);
+        // A skip scan only wins if there are few enough key prefixes, so it has to race a collscan.
+        bool collscanNeeded = (skipScanSolutions == out->size() && canTableScan);
 
         if (possibleToCollscan && (collscanRequested || collscanNeeded)) {
             QuerySolution* collscan = buildCollscanSoln(query, false, params);
@@ -3410,6 +3410,79 @@ namespace {
                                 "{ixscan: {filter: null, pattern: {a: 1, b: 1}}}}}");
     }
 
+    //
+    // Skip scans over indices whose leading fields hold few distinct values.
+    //
+
+    TEST_F(QueryPlannerTest, SkipScanOverLowCardinalityPrefix) {
+        IndexEntry entry(BSON("a" << 1 << "b" << 1));
+        entry.skipScanPrefixLen = 1;
+        params.indices.push_back(entry);
+
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: {filter: null, "
+                                "pattern: {a: 1, b: 1}, bounds: "
+                                    "{a: [['MinKey','MaxKey',true,true]], "
+                                    "b: [[5,5,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanFiltersPredicatesItCannotAnswer) {
+        IndexEntry entry(BSON("a" << 1 << "b" << -1 << "c" << 1));
+        entry.skipScanPrefixLen = 1;
+        params.indices.push_back(entry);
+
+        runQuery(fromjson("{b: {$gte: 2, $lt: 4}, d: 1}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: {b: {$gte: 2, $lt: 4}, d: 1}, node: "
+                                "{ixscan: {pattern: {a: 1, b: -1, c: 1}, bounds: "
+                                    "{a: [['MinKey','MaxKey',true,true]], "
+                                    "b: [[4,2,false,true]], "
+                                    "c: [['MinKey','MaxKey',true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanDoesNotCompoundMultikeyFieldsSharingAPrefix) {
+        IndexEntry entry(BSON("a" << 1 << "x.b" << 1 << "x.c" << 1));
+        entry.multikey = true;
+        entry.skipScanPrefixLen = 1;
+        params.indices.push_back(entry);
+
+        runQuery(fromjson("{'x.b': 1, 'x.c': 2}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: {'x.b': 1, 'x.c': 2}, node: "
+                                "{ixscan: {pattern: {a: 1, 'x.b': 1, 'x.c': 1}, bounds: "
+                                    "{a: [['MinKey','MaxKey',true,true]], "
+                                    "'x.b': [[1,1,true,true]], "
+                                    "'x.c': [['MinKey','MaxKey',true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, NoSkipScanOfSparseIndex) {
+        IndexEntry entry(BSON("a" << 1 << "b" << 1));
+        entry.sparse = true;
+        entry.skipScanPrefixLen = 1;
+        params.indices.push_back(entry);
+
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+    }
+
+    TEST_F(QueryPlannerTest, NoSkipScanWithoutLowCardinalityPrefix) {
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+    }
+
     //
     // Test bad input to query planner helpers.
     //
@@ -48,6 +48,7 @@
 #include "mongo/db/repl/rollback_source_impl.h"
 #include "mongo/db/repl/rs_rollback.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
@@ -98,14 +99,14 @@ namespace {
                                                                 &bufferMaxSizeGauge );
 
 
-    BackgroundSyncInterface::~BackgroundSyncInterface() {}
+    // How many oplog getMores, and how many bytes of their replies, to keep in flight to the
+    // sync source.  More than one hides the round trip time on distant secondaries.
+    MONGO_EXPORT_SERVER_PARAMETER(replOplogFetcherMaxInFlightBatches, int, 4);
+    MONGO_EXPORT_SERVER_PARAMETER(replOplogFetcherMaxInFlightBytes, int, 32 * 1024 * 1024);
 
-    size_t getSize(const BSONObj& o) {
-        // SERVER-9808 Avoid Fortify complaint about implicit signed->unsigned conversion
-        return static_cast<size_t>(o.objsize());
-    }
+    BackgroundSyncInterface::~BackgroundSyncInterface() {}
 
-    BackgroundSync::BackgroundSync() : _buffer(bufferMaxSizeGauge, &getSize),
+    BackgroundSync::BackgroundSync() : _buffer(bufferMaxSizeGauge),
                                        _lastOpTimeFetched(
                                                Timestamp(std::numeric_limits<int>::max(), 0),
                                                std::numeric_limits<long long>::max()),
@@ -266,6 +267,13 @@ namespace {
             return;
         }
 
+        // The connection is only used by the cursor from here on, so it can keep several
+        // getMores in flight.
+        if (replOplogFetcherMaxInFlightBatches > 1) {
+            _syncSourceReader.pipelineGetMores(replOplogFetcherMaxInFlightBatches,
+                                               replOplogFetcherMaxInFlightBytes);
+        }
+
         while (!inShutdown()) {
             if (!_syncSourceReader.moreInCurrentBatch()) {
                 // Check some things periodically
@@ -336,9 +344,15 @@ namespace {
             }
 
             // At this point, we are guaranteed to have at least one thing to read out
-            // of the oplogreader cursor.
-            BSONObj o = _syncSourceReader.nextSafe().getOwned();
-            opsReadStats.increment();
+            // of the oplogreader cursor.  Take everything in the batch we received, so that it
+            // goes into the buffer in one go.
+            std::vector<BSONObj> ops;
+            do {
+                ops.push_back(_syncSourceReader.nextSafe().getOwned());
+            } while (_syncSourceReader.moreInCurrentBatch());
+            opsReadStats.increment(ops.size());
+
+            const BSONObj lastOp = ops.back();
 
             {
                 stdx::unique_lock<stdx::mutex> lock(_mutex);
@@ -349,14 +363,16 @@ namespace {
                 LOG(2) << "bgsync buffer has " << _buffer.size() << " bytes";
             }
 
-            bufferCountGauge.increment();
-            bufferSizeGauge.increment(getSize(o));
-            _buffer.push(o);
+            // The gauges go up before the ops are visible to the applier, which decrements
+            // them as it consumes the ops.
+            bufferCountGauge.increment(ops.size());
+            bufferSizeGauge.increment(OplogBuffer::sizeOfBatch(ops));
+            _buffer.pushBatch(&ops);
 
             {
                 stdx::unique_lock<stdx::mutex> lock(_mutex);
-                _lastFetchedHash = o["h"].numberLong();
-                _lastOpTimeFetched = extractOpTime(o);
+                _lastFetchedHash = lastOp["h"].numberLong();
+                _lastOpTimeFetched = extractOpTime(lastOp);
                 LOG(3) << "lastOpTimeFetched: " << _lastOpTimeFetched;
             }
         }
@@ -375,22 +391,26 @@ namespace {
 
 
     bool BackgroundSync::peek(BSONObj* op) {
-        return _buffer.peek(*op);
+        return _buffer.peek(op);
+    }
+
+    bool BackgroundSync::peekBatch(std::vector<BSONObj>* ops,
+                                   size_t maxCount,
+                                   size_t maxBytes) {
+        return _buffer.peekBatch(ops, maxCount, maxBytes) > 0;
     }
 
     void BackgroundSync::waitForMore() {
-        BSONObj op;
         // Block for one second before timing out.
-        // Ignore the value of the op we peeked at.
-        _buffer.blockingPeek(op, 1);
+        _buffer.waitForData(1);
     }
 
-    void BackgroundSync::consume() {
-        // this is just to get the op off the queue, it's been peeked at
+    void BackgroundSync::consume(size_t count) {
+        // this is just to get the ops off the queue, they've been peeked at
         // and queued for application already
-        BSONObj op = _buffer.blockingPop();
-        bufferCountGauge.decrement(1);
-        bufferSizeGauge.decrement(getSize(op));
+        const size_t bytes = _buffer.consume(count);
+        bufferCountGauge.decrement(count);
+        bufferSizeGauge.decrement(bytes);
     }
 
     bool BackgroundSync::_rollbackIfNeeded(OperationContext* txn, OplogReader& r) {
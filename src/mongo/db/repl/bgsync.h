@@ -29,11 +29,11 @@
 #pragma once
 
 #include "mongo/db/jsobj.h"
+#include "mongo/db/repl/oplog_buffer.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
-#include "mongo/util/queue.h"
 
 namespace mongo {
 
@@ -55,9 +55,14 @@ namespace repl {
         // false if the queue was empty.
         virtual bool peek(BSONObj* op) = 0;
 
-        // Deletes objects in the queue;
-        // called by sync thread after it has applied an op
-        virtual void consume() = 0;
+        // Appends the ops at the head of the buffer to "ops" without removing them, stopping
+        // after "maxCount" ops or before going over "maxBytes" (but always taking the first op).
+        // Returns false if the queue was empty.
+        virtual bool peekBatch(std::vector<BSONObj>* ops, size_t maxCount, size_t maxBytes) = 0;
+
+        // Deletes the first "count" objects in the queue;
+        // called by sync thread after it has taken them for application
+        virtual void consume(size_t count) = 0;
 
         // wait up to 1 second for more ops to appear
         virtual void waitForMore() = 0;
@@ -101,7 +106,8 @@ namespace repl {
         // Interface implementation
 
         virtual bool peek(BSONObj* op);
-        virtual void consume();
+        virtual bool peekBatch(std::vector<BSONObj>* ops, size_t maxCount, size_t maxBytes);
+        virtual void consume(size_t count);
         virtual void clearSyncTarget();
         virtual void waitForMore();
 
@@ -135,7 +141,7 @@ namespace repl {
         static stdx::mutex s_mutex;
 
         // Production thread
-        BlockingQueue<BSONObj> _buffer;
+        OplogBuffer _buffer;
         OplogReader _syncSourceReader;
 
         // _mutex protects all of the class variables except _syncSourceReader and _buffer
@@ -0,0 +1,162 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_buffer.h"
+
+#include "mongo/stdx/chrono.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace repl {
+
+namespace {
+
+    size_t sizeOf(const BSONObj& op) {
+        return static_cast<size_t>(op.objsize());
+    }
+
+} // namespace
+
+    OplogBuffer::OplogBuffer(size_t maxSizeBytes)
+        : _maxSize(maxSizeBytes),
+          _currentSize(0) {
+    }
+
+    size_t OplogBuffer::sizeOfBatch(const std::vector<BSONObj>& batch) {
+        size_t batchSize = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batchSize += sizeOf(batch[i]);
+        }
+        return batchSize;
+    }
+
+    size_t OplogBuffer::pushBatch(std::vector<BSONObj>* batch) {
+        const size_t batchSize = sizeOfBatch(*batch);
+
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        while (_currentSize + batchSize > _maxSize && !_ops.empty()) {
+            _notFull.wait(lk);
+        }
+
+        for (size_t i = 0; i < batch->size(); ++i) {
+            _ops.push_back(std::move((*batch)[i]));
+        }
+        _currentSize += batchSize;
+        batch->clear();
+
+        _notEmpty.notify_all();
+        return batchSize;
+    }
+
+    void OplogBuffer::push(const BSONObj& op) {
+        std::vector<BSONObj> batch(1, op);
+        pushBatch(&batch);
+    }
+
+    bool OplogBuffer::peek(BSONObj* op) const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_ops.empty()) {
+            return false;
+        }
+        *op = _ops.front();
+        return true;
+    }
+
+    size_t OplogBuffer::peekBatch(std::vector<BSONObj>* ops,
+                                  size_t maxCount,
+                                  size_t maxBytes) const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        size_t bytes = 0;
+        size_t copied = 0;
+        for (std::deque<BSONObj>::const_iterator it = _ops.begin();
+             it != _ops.end() && copied < maxCount;
+             ++it) {
+            bytes += sizeOf(*it);
+            if (copied > 0 && bytes > maxBytes) {
+                break;
+            }
+            ops->push_back(*it);
+            ++copied;
+        }
+        return copied;
+    }
+
+    bool OplogBuffer::waitForData(int maxSecondsToWait) const {
+        const auto deadline =
+            stdx::chrono::system_clock::now() + stdx::chrono::seconds(maxSecondsToWait);
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        while (_ops.empty()) {
+            if (stdx::cv_status::timeout == _notEmpty.wait_until(lk, deadline)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t OplogBuffer::consume(size_t count) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        invariant(count <= _ops.size());
+
+        size_t bytes = 0;
+        for (size_t i = 0; i < count; ++i) {
+            bytes += sizeOf(_ops.front());
+            _ops.pop_front();
+        }
+        _currentSize -= bytes;
+
+        _notFull.notify_all();
+        return bytes;
+    }
+
+    void OplogBuffer::clear() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _ops.clear();
+        _currentSize = 0;
+        _notFull.notify_all();
+    }
+
+    bool OplogBuffer::empty() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _ops.empty();
+    }
+
+    size_t OplogBuffer::size() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _currentSize;
+    }
+
+    size_t OplogBuffer::count() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _ops.size();
+    }
+
+} // namespace repl
+} // namespace mongo
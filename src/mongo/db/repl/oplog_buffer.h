@@ -0,0 +1,120 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+namespace repl {
+
+    /**
+     * The buffer of fetched oplog entries between BackgroundSync and the applier, bounded by the
+     * total size of the entries in bytes.
+     *
+     * Entries are pushed and removed a batch at a time, so the lock is taken once per fetched
+     * network batch and once per applied batch rather than once per entry.  Any number of
+     * threads may push.  Entries are removed by peeking and then consuming them, so there should
+     * be a single consumer.
+     */
+    class OplogBuffer {
+        MONGO_DISALLOW_COPYING(OplogBuffer);
+    public:
+        explicit OplogBuffer(size_t maxSizeBytes);
+
+        /**
+         * Returns the number of bytes the entries in 'batch' take up in the buffer.
+         */
+        static size_t sizeOfBatch(const std::vector<BSONObj>& batch);
+
+        /**
+         * Appends the entries in 'batch', in order, moving them out of it.  Blocks while the
+         * buffer doesn't have room for the whole batch; a batch bigger than the buffer is let in
+         * once the buffer is empty.  Returns the size of the batch in bytes.
+         */
+        size_t pushBatch(std::vector<BSONObj>* batch);
+
+        void push(const BSONObj& op);
+
+        /**
+         * Gets the entry at the head of the buffer without removing it.  Returns false if the
+         * buffer is empty.
+         */
+        bool peek(BSONObj* op) const;
+
+        /**
+         * Appends the entries at the head of the buffer to 'ops' without removing them, stopping
+         * after 'maxCount' entries or before going over 'maxBytes' bytes.  The first entry is
+         * always copied, whatever its size.  Returns the number of entries copied.
+         */
+        size_t peekBatch(std::vector<BSONObj>* ops, size_t maxCount, size_t maxBytes) const;
+
+        /**
+         * Waits up to 'maxSecondsToWait' for the buffer to be non-empty.  Returns false if it is
+         * still empty.
+         */
+        bool waitForData(int maxSecondsToWait) const;
+
+        /**
+         * Removes the first 'count' entries, which must be in the buffer.  Returns their total
+         * size in bytes.
+         */
+        size_t consume(size_t count);
+
+        void clear();
+
+        bool empty() const;
+
+        /**
+         * The total size of the buffered entries, in bytes.
+         */
+        size_t size() const;
+
+        size_t count() const;
+
+        size_t maxSize() const { return _maxSize; }
+
+    private:
+        mutable stdx::mutex _mutex;
+        mutable stdx::condition_variable _notEmpty;
+        stdx::condition_variable _notFull;
+
+        std::deque<BSONObj> _ops;
+        const size_t _maxSize;
+        size_t _currentSize;
+    };
+
+} // namespace repl
+} // namespace mongo
@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/repl/oplog_buffer.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using namespace mongo;
+    using namespace mongo::repl;
+
+    std::vector<BSONObj> makeBatch(int first, int count) {
+        std::vector<BSONObj> batch;
+        for (int i = first; i < first + count; ++i) {
+            batch.push_back(BSON("i" << i));
+        }
+        return batch;
+    }
+
+    TEST(OplogBufferTest, PushBatchThenPeekAndConsume) {
+        OplogBuffer buffer(1024 * 1024);
+        ASSERT_TRUE(buffer.empty());
+
+        std::vector<BSONObj> batch = makeBatch(0, 10);
+        const size_t opSize = batch[0].objsize();
+        ASSERT_EQUALS(10 * opSize, OplogBuffer::sizeOfBatch(batch));
+        ASSERT_EQUALS(10 * opSize, buffer.pushBatch(&batch));
+        ASSERT_TRUE(batch.empty());
+        ASSERT_EQUALS(10U, buffer.count());
+        ASSERT_EQUALS(10 * opSize, buffer.size());
+
+        BSONObj op;
+        ASSERT_TRUE(buffer.peek(&op));
+        ASSERT_EQUALS(0, op["i"].numberInt());
+
+        std::vector<BSONObj> peeked;
+        ASSERT_EQUALS(4U, buffer.peekBatch(&peeked, 4, 1024 * 1024));
+        ASSERT_EQUALS(3, peeked[3]["i"].numberInt());
+
+        ASSERT_EQUALS(4 * opSize, buffer.consume(4));
+        ASSERT_EQUALS(6U, buffer.count());
+        ASSERT_TRUE(buffer.peek(&op));
+        ASSERT_EQUALS(4, op["i"].numberInt());
+    }
+
+    TEST(OplogBufferTest, PeekBatchStopsAtByteLimit) {
+        OplogBuffer buffer(1024 * 1024);
+        std::vector<BSONObj> batch = makeBatch(0, 10);
+        const size_t opSize = batch[0].objsize();
+        buffer.pushBatch(&batch);
+
+        std::vector<BSONObj> peeked;
+        ASSERT_EQUALS(3U, buffer.peekBatch(&peeked, 100, 3 * opSize + 1));
+
+        // The first op is always taken.
+        peeked.clear();
+        ASSERT_EQUALS(1U, buffer.peekBatch(&peeked, 100, 0));
+    }
+
+    TEST(OplogBufferTest, PeekEmpty) {
+        OplogBuffer buffer(1024);
+        BSONObj op;
+        ASSERT_FALSE(buffer.peek(&op));
+        std::vector<BSONObj> peeked;
+        ASSERT_EQUALS(0U, buffer.peekBatch(&peeked, 10, 1024));
+        ASSERT_FALSE(buffer.waitForData(0));
+    }
+
+    TEST(OplogBufferTest, OversizedBatchGoesIntoEmptyBuffer) {
+        OplogBuffer buffer(1);
+        std::vector<BSONObj> batch = makeBatch(0, 5);
+        buffer.pushBatch(&batch);
+        ASSERT_EQUALS(5U, buffer.count());
+    }
+
+    void pushBatches(OplogBuffer* buffer, int batches, int batchSize) {
+        for (int i = 0; i < batches; ++i) {
+            std::vector<BSONObj> batch = makeBatch(i * batchSize, batchSize);
+            buffer->pushBatch(&batch);
+        }
+    }
+
+    TEST(OplogBufferTest, ProducerBlocksUntilConsumed) {
+        const int kBatches = 100;
+        const int kBatchSize = 10;
+
+        // Room for about two batches.
+        std::vector<BSONObj> sample = makeBatch(0, 1);
+        OplogBuffer buffer(2 * kBatchSize * sample[0].objsize() + 1);
+
+        stdx::thread producer(stdx::bind(pushBatches, &buffer, kBatches, kBatchSize));
+
+        int next = 0;
+        while (next < kBatches * kBatchSize) {
+            ASSERT_LESS_THAN_OR_EQUALS(buffer.size(), buffer.maxSize());
+            if (!buffer.waitForData(1)) {
+                continue;
+            }
+            std::vector<BSONObj> peeked;
+            const size_t count = buffer.peekBatch(&peeked, 7, buffer.maxSize());
+            for (size_t i = 0; i < count; ++i) {
+                ASSERT_EQUALS(next++, peeked[i]["i"].numberInt());
+            }
+            buffer.consume(count);
+        }
+        producer.join();
+        ASSERT_TRUE(buffer.empty());
+    }
+
+} // namespace
@@ -71,7 +71,15 @@ namespace repl {
     public:
         OplogReader();
         ~OplogReader() { }
-        void resetCursor() { cursor.reset(); }
+        void resetCursor() {
+            // The connection can't be used again until the replies to requests sent ahead by
+            // the cursor have been read, so drop it too.
+            if (cursor.get() && cursor->prefetchOutstanding() > 0) {
+                resetConnection();
+                return;
+            }
+            cursor.reset();
+        }
         void resetConnection() {
             cursor.reset();
             _conn.reset();
@@ -105,6 +113,17 @@ namespace repl {
 
         void tailingQueryGTE(const char *ns, Timestamp t);
 
+        /**
+         * Keeps up to 'maxBatches' getMores, and about 'maxInFlightBytes' of replies, in flight on
+         * the tailing cursor, so that fetching over a slow link isn't limited to one batch per
+         * round trip.  See DBClientCursor::enablePrefetch().  The connection mustn't be used for
+         * anything else afterwards; resetCursor() drops it.
+         */
+        void pipelineGetMores(int maxBatches, int maxInFlightBytes) {
+            uassert( 28704, "Doesn't have cursor for reading oplog", cursor.get() );
+            cursor->enablePrefetch(maxBatches, maxInFlightBytes);
+        }
+
         bool more() {
             uassert( 15910, "Doesn't have cursor for reading oplog", cursor.get() );
             return cursor->more();
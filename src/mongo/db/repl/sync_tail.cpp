@@ -46,6 +46,7 @@
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
@@ -63,6 +64,7 @@
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -85,6 +87,17 @@ namespace repl {
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
 
+    // Number of per-writer batches handed to the writer pool, and the number of ops given to
+    // the busiest writer of each replication batch, summed over all batches. Comparing the
+    // latter against repl.apply.ops shows how evenly the work is spread across the writers.
+    static Counter64 writerBatchesStats;
+    static ServerStatusMetricField<Counter64> displayWriterBatches( "repl.apply.writers.batches",
+                                                                   &writerBatchesStats );
+    static Counter64 busiestWriterOpsStats;
+    static ServerStatusMetricField<Counter64> displayBusiestWriterOps(
+                                                    "repl.apply.writers.busiestWriterOps",
+                                                    &busiestWriterOpsStats );
+
     MONGO_FP_DECLARE(rsSyncApplyStop);
 
     // Number and time of each ApplyOps worker pool round
@@ -291,18 +304,51 @@ namespace {
                             SyncTail::MultiSyncApplyFunc func,
                             SyncTail* sync) {
         TimerHolder timer(&applyBatchStats);
+        size_t busiestWriterOps = 0;
         for (std::vector< std::vector<BSONObj> >::const_iterator it = writerVectors.begin();
              it != writerVectors.end();
              ++it) {
             if (!it->empty()) {
                 writerPool->schedule(func, boost::cref(*it), sync);
+                writerBatchesStats.increment();
+                busiestWriterOps = std::max(busiestWriterOps, it->size());
             }
         }
+        busiestWriterOpsStats.increment(busiestWriterOps);
         writerPool->join();
     }
 
-    void fillWriterVectors(const std::deque<BSONObj>& ops,
-                           std::vector< std::vector<BSONObj> >* writerVectors) {
+    /**
+     * Returns true if 'ns' is a capped collection. Inserts into a capped collection must be
+     * applied in oplog order, since that order is the collection's natural order.
+     */
+    bool isCappedCollection(OperationContext* txn, StringData ns) {
+        ScopedTransaction transaction(txn, MODE_IS);
+        Lock::DBLock dbLock(txn->lockState(), nsToDatabaseSubstring(ns), MODE_IS);
+        Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IS);
+
+        Database* db = dbHolder().get(txn, ns);
+        if (!db) {
+            return false;
+        }
+        Collection* collection = db->getCollection(ns);
+        return collection && collection->isCapped();
+    }
+
+} // namespace
+
+    // static
+    void SyncTail::fillWriterVectors(OperationContext* txn,
+                                     const std::deque<BSONObj>& ops,
+                                     std::vector< std::vector<BSONObj> >* writerVectors) {
+
+        const bool supportsDocLocking =
+            getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking();
+
+        // Commands and index builds are always applied in batches of their own, and are the
+        // only ops which can make a collection capped, so the answer cannot change within a
+        // batch.
+        StringMap<bool> cappedCollections;
 
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
@@ -316,8 +362,20 @@ namespace {
 
             const char* opType = it->getField( "op" ).valuestrsafe();
 
-            if (getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking() &&
-                isCrudOpType(opType)) {
+            // With document level locking, CRUD ops are spread across the writers by _id, so
+            // that a single busy collection is still applied in parallel. Ops on a capped
+            // collection all go to the same writer, which applies them in oplog order.
+            bool hashOnId = supportsDocLocking && isCrudOpType(opType);
+            if (hashOnId) {
+                StringMap<bool>::const_iterator cappedIt = cappedCollections.find(ns);
+                if (cappedIt == cappedCollections.end()) {
+                    cappedCollections[ns] = isCappedCollection(txn, ns);
+                    cappedIt = cappedCollections.find(ns);
+                }
+                hashOnId = !cappedIt->second;
+            }
+
+            if (hashOnId) {
                 BSONElement id;
                 switch (opType[0]) {
                 case 'u':
@@ -337,8 +395,6 @@ namespace {
         }
     }
 
-} // namespace
-
     // Doles out all the work to the writer pool threads and waits for them to complete
     // static
     OpTime SyncTail::multiApply(OperationContext* txn,
@@ -360,7 +416,7 @@ namespace {
         
         std::vector< std::vector<BSONObj> > writerVectors(replWriterThreadCount);
 
-        fillWriterVectors(ops.getDeque(), &writerVectors);
+        fillWriterVectors(txn, ops.getDeque(), &writerVectors);
         LOG(2) << "replication batch size is " << ops.getDeque().size() << endl;
         // We must grab this because we're going to grab write locks later.
         // We hold this mutex the entire time we're writing; it doesn't matter
@@ -415,7 +471,10 @@ namespace {
         while (true) {
             OpQueue ops;
 
-            while (!tryPopAndWaitForMore(txn, &ops, getGlobalReplicationCoordinator())) {
+            while (!tryPopAndWaitForMore(txn,
+                                         &ops,
+                                         getGlobalReplicationCoordinator(),
+                                         endOpTime)) {
                 // nothing came back last time, so go again
                 if (ops.empty()) continue;
 
@@ -597,16 +656,33 @@ namespace {
     // to periodically check in the loop.
     bool SyncTail::tryPopAndWaitForMore(OperationContext* txn,
                                         SyncTail::OpQueue* ops,
-                                        ReplicationCoordinator* replCoord) {
-        BSONObj op;
+                                        ReplicationCoordinator* replCoord,
+                                        const OpTime& endOpTime) {
+        // Take as many ops as would still fit in the batch, so that the bgsync queue is only
+        // locked once or twice per batch.  With a slave delay we go one op at a time, since the
+        // caller checks each op's timestamp against the delay.
+        size_t maxCount = 1;
+        size_t maxBytes = 0;
+        if (replCoord->getSlaveDelaySecs().count() == 0) {
+            const size_t count = ops->getDeque().size();
+            if (count < replBatchLimitOperations) {
+                maxCount = replBatchLimitOperations - count;
+            }
+            if (ops->getSize() < replBatchLimitBytes) {
+                maxBytes = replBatchLimitBytes - ops->getSize();
+            }
+        }
+
+        std::vector<BSONObj> peeked;
         // Check to see if there are ops waiting in the bgsync queue
-        bool peek_success = peek(&op);
+        bool peek_success = _networkQueue->peekBatch(&peeked, maxCount, maxBytes);
 
         if (!peek_success) {
             // if we don't have anything in the queue, wait a bit for something to appear
             if (ops->empty()) {
                 if (replCoord->isWaitingForApplierToDrain()) {
                     BackgroundSync::get()->waitUntilPaused();
+                    BSONObj op;
                     if (peek(&op)) {
                         // The producer generated a last batch of ops before pausing so return
                         // false so that we'll come back and apply them before signaling the drain
@@ -624,45 +700,62 @@ namespace {
             return true;
         }
 
-        const char* ns = op["ns"].valuestrsafe();
+        size_t taken = 0;
+        bool endBatch = false;
+        for (; taken < peeked.size(); ++taken) {
+            const BSONObj& op = peeked[taken];
+            const char* ns = op["ns"].valuestrsafe();
+
+            // check for commands
+            if ((op["op"].valuestrsafe()[0] == 'c') ||
+                // Index builds are acheived through the use of an insert op, not a command op.
+                // The following line is the same as what the insert code uses to detect an index
+                // build.
+                ( *ns != '\0' && nsToCollectionSubstring(ns) == "system.indexes" )) {
+
+                if (ops->empty()) {
+                    // apply commands one-at-a-time
+                    ops->push_back(op);
+                    ++taken;
+                }
+
+                // otherwise, apply what we have so far and come back for the command
+                endBatch = true;
+                break;
+            }
+
+            // check for oplog version change
+            BSONElement elemVersion = op["v"];
+            int curVersion = 0;
+            if (elemVersion.eoo())
+                // missing version means version 1
+                curVersion = 1;
+            else
+                curVersion = elemVersion.Int();
+
+            if (curVersion != OPLOG_VERSION) {
+                severe() << "expected oplog version " << OPLOG_VERSION << " but found version "
+                         << curVersion << " in oplog entry: " << op;
+                fassertFailedNoTrace(18820);
+            }
 
-        // check for commands
-        if ((op["op"].valuestrsafe()[0] == 'c') ||
-            // Index builds are acheived through the use of an insert op, not a command op.
-            // The following line is the same as what the insert code uses to detect an index build.
-            ( *ns != '\0' && nsToCollectionSubstring(ns) == "system.indexes" )) {
+            // Copy the op to the deque.
+            ops->push_back(op);
 
-            if (ops->empty()) {
-                // apply commands one-at-a-time
-                ops->push_back(op);
-                _networkQueue->consume();
+            // Leave the ops after the one the caller is waiting for in the bgsync queue.
+            if (!endOpTime.isNull() && extractOpTime(op) >= endOpTime) {
+                ++taken;
+                break;
             }
+        }
 
-            // otherwise, apply what we have so far and come back for the command
-            return true;
+        // Remove the ops we took from the bgsync queue.
+        if (taken > 0) {
+            _networkQueue->consume(taken);
         }
 
-        // check for oplog version change
-        BSONElement elemVersion = op["v"];
-        int curVersion = 0;
-        if (elemVersion.eoo())
-            // missing version means version 1
-            curVersion = 1;
-        else
-            curVersion = elemVersion.Int();
-        
-        if (curVersion != OPLOG_VERSION) {
-            severe() << "expected oplog version " << OPLOG_VERSION << " but found version " 
-                     << curVersion << " in oplog entry: " << op;
-            fassertFailedNoTrace(18820);
-        }
-    
-        // Copy the op to the deque and remove it from the bgsync queue.
-        ops->push_back(op);
-        _networkQueue->consume();
-
-        // Go back for more ops
-        return false;
+        // Go back for more ops, unless we stopped at a command
+        return endBatch;
     }
 
     void SyncTail::handleSlaveDelay(const BSONObj& lastOp) {
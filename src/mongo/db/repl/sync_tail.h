@@ -32,6 +32,7 @@
 
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
+#include "mongo/db/repl/optime.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/util/concurrency/old_thread_pool.h"
@@ -44,7 +45,6 @@ namespace mongo {
 namespace repl {
     class BackgroundSyncInterface;
     class ReplicationCoordinator;
-    class OpTime;
 
     /**
      * "Normal" replica set syncing
@@ -95,6 +95,16 @@ namespace repl {
                                 const BSONObj &o,
                                 bool convertUpdateToUpsert);
 
+        /**
+         * Partitions 'ops' across 'writerVectors', one vector per writer thread, keeping the
+         * oplog order within each vector.  Ops are split by namespace, and with document level
+         * locking also by _id, except for ops on capped collections, which must be applied in
+         * oplog order by a single writer.
+         */
+        static void fillWriterVectors(OperationContext* txn,
+                                      const std::deque<BSONObj>& ops,
+                                      std::vector< std::vector<BSONObj> >* writerVectors);
+
         /**
          * Runs _applyOplogUntil(stopOpTime)
          */
@@ -108,7 +118,7 @@ namespace repl {
             OpQueue() : _size(0) {}
             size_t getSize() const { return _size; }
             const std::deque<BSONObj>& getDeque() const { return _deque; }
-            void push_back(BSONObj& op) {
+            void push_back(const BSONObj& op) {
                 _deque.push_back(op);
                 _size += op.objsize();
             }
@@ -128,9 +138,12 @@ namespace repl {
 
         // returns true if we should continue waiting for BSONObjs, false if we should
         // stop waiting and apply the queue we have.  Only returns false if !ops.empty().
+        // Takes several ops from the bgsync queue at a time; if endOpTime is given, stops
+        // taking ops once it has taken one at or past endOpTime.
         bool tryPopAndWaitForMore(OperationContext* txn,
                                   OpQueue* ops,
-                                  ReplicationCoordinator* replCoord);
+                                  ReplicationCoordinator* replCoord,
+                                  const OpTime& endOpTime = OpTime());
 
         /**
          * Fetch a single document referenced in the operation from the sync source.
@@ -30,6 +30,7 @@
 
 #include <memory>
 
+#include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/document_validation.h"
@@ -56,12 +57,18 @@ namespace {
     class BackgroundSyncMock : public BackgroundSyncInterface {
     public:
         bool peek(BSONObj* op) override;
-        void consume() override;
+        bool peekBatch(std::vector<BSONObj>* ops, size_t maxCount, size_t maxBytes) override;
+        void consume(size_t count) override;
         void waitForMore() override;
     };
 
     bool BackgroundSyncMock::peek(BSONObj* op) { return false; }
-    void BackgroundSyncMock::consume() { }
+    bool BackgroundSyncMock::peekBatch(std::vector<BSONObj>* ops,
+                                       size_t maxCount,
+                                       size_t maxBytes) {
+        return false;
+    }
+    void BackgroundSyncMock::consume(size_t count) { }
     void BackgroundSyncMock::waitForMore() { }
 
     class SyncTailTest : public unittest::Test {
@@ -335,4 +342,60 @@ namespace {
         ASSERT_EQUALS(1U, _opsApplied);
     }
 
+    TEST_F(SyncTailTest, FillWriterVectorsKeepsCappedCollectionsOnOneWriter) {
+        {
+            Lock::GlobalWrite globalLock(_txn->lockState());
+            bool justCreated = false;
+            Database* db = dbHolder().openDb(_txn.get(), "test", &justCreated);
+            ASSERT_TRUE(db);
+            ASSERT_TRUE(db->createCollection(_txn.get(), "test.t"));
+            CollectionOptions cappedOptions;
+            cappedOptions.capped = true;
+            cappedOptions.cappedSize = 4096;
+            ASSERT_TRUE(db->createCollection(_txn.get(), "test.capped", cappedOptions));
+        }
+
+        const int numOps = 20;
+        std::deque<BSONObj> ops;
+        for (int i = 0; i < numOps; ++i) {
+            ops.push_back(BSON("op" << "i" << "ns" << "test.t" << "o" << BSON("_id" << i)));
+            ops.push_back(BSON("op" << "i" << "ns" << "test.capped" << "o" << BSON("_id" << i)));
+        }
+
+        std::vector< std::vector<BSONObj> > writerVectors(4);
+        SyncTail::fillWriterVectors(_txn.get(), ops, &writerVectors);
+
+        size_t writersForCollection = 0;
+        size_t writersForCapped = 0;
+        for (size_t w = 0; w < writerVectors.size(); ++w) {
+            int lastId = -1;
+            int lastCappedId = -1;
+            for (size_t i = 0; i < writerVectors[w].size(); ++i) {
+                const BSONObj& op = writerVectors[w][i];
+                const int id = op["o"].Obj()["_id"].numberInt();
+                if (op["ns"].String() == "test.capped") {
+                    // Each writer keeps the oplog order of the ops it is given.
+                    ASSERT_EQUALS(lastCappedId + 1, id);
+                    lastCappedId = id;
+                }
+                else {
+                    ASSERT_LESS_THAN(lastId, id);
+                    lastId = id;
+                }
+            }
+            if (lastId >= 0) {
+                ++writersForCollection;
+            }
+            if (lastCappedId >= 0) {
+                // All of the capped collection's ops went to this writer.
+                ASSERT_EQUALS(numOps - 1, lastCappedId);
+                ++writersForCapped;
+            }
+        }
+
+        // Inserts into the uncapped collection are spread across the writers by _id.
+        ASSERT_GREATER_THAN(writersForCollection, 1U);
+        ASSERT_EQUALS(1U, writersForCapped);
+    }
+
 } // namespace
@@ -48,11 +48,11 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
-#include <snappy.h>
 
 #include "mongo/base/string_data.h"
 #include "mongo/config.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/sorter/sorter_spill.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/mongos_options.h"
@@ -203,54 +203,13 @@ namespace mongo {
             }
 
             void fill() {
-                int32_t rawSize;
-                read(&rawSize, sizeof(rawSize));
-                if (_done) return;
-
-                // negative size means compressed
-                const bool compressed = rawSize < 0;
-                const int32_t blockSize = std::abs(rawSize);
-
-                _buffer.reset(new char[blockSize]);
-                read(_buffer.get(), blockSize);
-                massert(16816, "file too short?", !_done);
-
-                if (!compressed) {
-                    _reader.reset(new BufReader(_buffer.get(), blockSize));
+                size_t blockSize;
+                if (!readSpillBlock(_file, _fileName, &_buffer, &blockSize)) {
+                    _done = true;
                     return;
                 }
 
-                dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
-
-                size_t uncompressedSize;
-                massert(17061, "couldn't get uncompressed length",
-                        snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
-
-                std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
-                massert(17062, "decompression failed",
-                        snappy::RawUncompress(_buffer.get(),
-                                              blockSize,
-                                              decompressionBuffer.get()));
-
-                // hold on to decompressed data and throw out compressed data at block exit
-                _buffer.swap(decompressionBuffer);
-                _reader.reset(new BufReader(_buffer.get(), uncompressedSize));
-            }
-
-            // sets _done to true on EOF - asserts on any other error
-            void read(void* out, size_t size) {
-                _file.read(reinterpret_cast<char*>(out), size);
-                if (!_file.good()) {
-                    if (_file.eof()) {
-                        _done = true;
-                        return;
-                    }
-
-                    msgasserted(16817, str::stream() << "error reading file \""
-                                                     << _fileName << "\": "
-                                                     << myErrnoWithDescription());
-                }
-                verify(_file.gcount() == static_cast<std::streamsize>(size));
+                _reader.reset(new BufReader(_buffer.get(), blockSize));
             }
 
             const Settings _settings;
@@ -402,6 +361,7 @@ namespace mongo {
                 , _settings(settings)
                 , _opts(opts)
                 , _memUsed(0)
+                , _numSpills(0)
             { verify(_opts.limit == 0); }
 
             void add(const Key& key, const Value& val) {
@@ -425,7 +385,8 @@ namespace mongo {
             }
 
             // TEMP these are here for compatibility. Will be replaced with a general stats API
-            int numFiles() const { return _iters.size(); }
+            // Counts every run spilled, including those since combined by a merge pass.
+            int numFiles() const { return _numSpills; }
             size_t memUsed() const { return _memUsed; }
 
         private:
@@ -473,6 +434,8 @@ namespace mongo {
                 }
 
                 _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
+                _numSpills++;
+                mergeSpilledRunsIfNeeded(&_iters, &_iterLevels, _opts, _comp, _settings);
 
                 _memUsed = 0;
             }
@@ -483,6 +446,8 @@ namespace mongo {
             size_t _memUsed;
             std::deque<Data> _data; // the "current" data
             std::vector<std::shared_ptr<Iterator> > _iters; // data that has already been spilled
+            std::vector<unsigned> _iterLevels; // merge level of each of _iters
+            int _numSpills;
         };
 
         template <typename Key, typename Value, typename Comparator>
@@ -547,6 +512,7 @@ namespace mongo {
                 , _settings(settings)
                 , _opts(opts)
                 , _memUsed(0)
+                , _numSpills(0)
                 , _haveCutoff(false)
                 , _worstCount(0)
                 , _medianCount(0)
@@ -616,7 +582,8 @@ namespace mongo {
             }
 
             // TEMP these are here for compatibility. Will be replaced with a general stats API
-            int numFiles() const { return _iters.size(); }
+            // Counts every run spilled, including those since combined by a merge pass.
+            int numFiles() const { return _numSpills; }
             size_t memUsed() const { return _memUsed; }
 
         private:
@@ -748,6 +715,8 @@ namespace mongo {
                 std::vector<Data>().swap(_data);
 
                 _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
+                _numSpills++;
+                mergeSpilledRunsIfNeeded(&_iters, &_iterLevels, _opts, _comp, _settings);
 
                 _memUsed = 0;
             }
@@ -758,6 +727,8 @@ namespace mongo {
             size_t _memUsed;
             std::vector<Data> _data; // the "current" data. Organized as max-heap if size == limit.
             std::vector<std::shared_ptr<Iterator> > _iters; // data that has already been spilled
+            std::vector<unsigned> _iterLevels; // merge level of each of _iters
+            int _numSpills;
 
             // See updateCutoff() for a full description of how these members are used.
             bool _haveCutoff;
@@ -784,6 +755,8 @@ namespace mongo {
     SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts,
                                                    const Settings& settings)
         : _settings(settings)
+        , _spillStats(opts.spillStats)
+        , _bytesWritten(0)
     {
         namespace str = mongoutils::str;
 
@@ -829,20 +802,8 @@ namespace mongo {
         if (_buffer.len() == 0)
             return;
 
-        std::string compressed;
-        snappy::Compress(_buffer.buf(), _buffer.len(), &compressed);
-        verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
-
         try {
-            if (compressed.size() < size_t(_buffer.len()/10*9)) {
-                const int32_t size = -int32_t(compressed.size()); // negative means compressed
-                _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-                _file.write(compressed.data(), compressed.size());
-            } else {
-                const int32_t size = _buffer.len();
-                _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-                _file.write(_buffer.buf(), _buffer.len());
-            }
+            _bytesWritten += sorter::writeSpillBlock(_file, _buffer.buf(), _buffer.len());
         } catch (const std::exception&) {
             msgasserted(16821, str::stream() << "error writing to file \"" << _fileName << "\": "
                                              << sorter::myErrnoWithDescription());
@@ -855,9 +816,73 @@ namespace mongo {
     SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
         spill();
         _file.close();
+
+        sorter::recordSpilledRun(_bytesWritten);
+        if (_spillStats) {
+            _spillStats->spilledRuns++;
+            _spillStats->spilledBytes += _bytesWritten;
+        }
+
         return new sorter::FileIterator<Key, Value>(_fileName, _settings, _fileDeleter);
     }
 
+    template <typename Key, typename Value, typename Comparator>
+    void mergeSpilledRunsIfNeeded(
+            std::vector<std::shared_ptr<SortIteratorInterface<Key, Value> > >* runs,
+            std::vector<unsigned>* runLevels,
+            const SortOptions& opts,
+            const Comparator& comp,
+            const typename SortedFileWriter<Key, Value>::Settings& settings) {
+        // Runs added since the last call were spilled from memory.
+        invariant(runLevels->size() <= runs->size());
+        runLevels->resize(runs->size(), 0);
+
+        const size_t maxRuns =
+            opts.maxOpenSpillFiles ? opts.maxOpenSpillFiles : sorter::maxOpenSpillFiles();
+        invariant(maxRuns >= 2);
+        if (runs->size() < maxRuns)
+            return;
+
+        // Runs are only merged with the runs spilled after them, so levels never increase along
+        // 'runs'. Merge the runs at the lowest level, along with those at the next level if that
+        // leaves only one. A run's bytes are only rewritten to raise their level.
+        const size_t numRuns = runs->size();
+        size_t begin = numRuns - 1;
+        while (begin > 0 && (*runLevels)[begin - 1] == (*runLevels)[numRuns - 1])
+            begin--;
+        if (numRuns - begin < 2) {
+            const unsigned nextLevel = (*runLevels)[begin - 1];
+            while (begin > 0 && (*runLevels)[begin - 1] == nextLevel)
+                begin--;
+        }
+        const unsigned mergedLevel = (*runLevels)[begin] + 1;
+
+        std::vector<std::shared_ptr<SortIteratorInterface<Key, Value> > > toMerge(
+            runs->begin() + begin, runs->end());
+        std::unique_ptr<SortIteratorInterface<Key, Value> > merged(
+            SortIteratorInterface<Key, Value>::merge(toMerge, opts, comp));
+
+        SortedFileWriter<Key, Value> writer(opts, settings);
+        while (merged->more()) {
+            // Serialize each pair before asking for the next one, as it may not be owned.
+            const std::pair<Key, Value> next = merged->next();
+            writer.addAlreadySorted(next.first, next.second);
+        }
+
+        // Closes the files of the merged runs.
+        merged.reset();
+        toMerge.clear();
+        runs->resize(begin);
+        runLevels->resize(begin);
+        runs->push_back(std::shared_ptr<SortIteratorInterface<Key, Value> >(writer.done()));
+        runLevels->push_back(mergedLevel);
+
+        sorter::recordMergePass();
+        if (opts.spillStats) {
+            opts.spillStats->mergePasses++;
+        }
+    }
+
     //
     // Factory Functions
     //
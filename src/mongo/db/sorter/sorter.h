@@ -30,6 +30,7 @@
 
 #include <deque>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -88,6 +89,17 @@ namespace mongo {
         class FileDeleter;
     }
 
+    /**
+     * Counts the disk usage of a sort. Runs and bytes written by merge passes are included.
+     */
+    struct SorterSpillStats {
+        long long spilledBytes = 0; /// Written to spill files, after compression.
+        long long spilledRuns = 0; /// Sorted runs written to disk.
+        long long mergePasses = 0; /// Times spilled runs were merged into a new run.
+
+        bool spilled() const { return spilledRuns > 0; }
+    };
+
     /**
      * Runtime options that control the Sorter's behavior
      */
@@ -97,11 +109,15 @@ namespace mongo {
         bool extSortAllowed; /// If false, uassert if more mem needed than allowed.
         std::string tempDir; /// Directory to directly place files in.
                              /// Must be explicitly set if extSortAllowed is true.
+        SorterSpillStats* spillStats; /// If set, updated on every spill. Not owned.
+        size_t maxOpenSpillFiles; /// Runs kept on disk before merging. 0 for the server default.
 
         SortOptions()
             : limit(0)
             , maxMemoryUsageBytes(64*1024*1024)
             , extSortAllowed(false)
+            , spillStats(NULL)
+            , maxOpenSpillFiles(0)
         {}
 
         /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -125,6 +141,16 @@ namespace mongo {
             tempDir = newTempDir;
             return *this;
         }
+
+        SortOptions& SpillStats(SorterSpillStats* newSpillStats) {
+            spillStats = newSpillStats;
+            return *this;
+        }
+
+        SortOptions& MaxOpenSpillFiles(size_t newMaxOpenSpillFiles) {
+            maxOpenSpillFiles = newMaxOpenSpillFiles;
+            return *this;
+        }
     };
 
     /// This is the output from the sorting framework
@@ -200,11 +226,30 @@ namespace mongo {
         void spill();
 
         const Settings _settings;
+        SorterSpillStats* const _spillStats;
         std::string _fileName;
         std::shared_ptr<sorter::FileDeleter> _fileDeleter; // Must outlive _file
         std::ofstream _file;
         BufBuilder _buffer;
+        size_t _bytesWritten;
     };
+
+    /**
+     * Keeps the number of files held open by a sort's spilled runs bounded: once 'runs' has
+     * reached opts.maxOpenSpillFiles, or the sorterMaxOpenSpillFiles server parameter if that is
+     * not set, the most recently spilled runs of the lowest merge level are merged into a single
+     * new run one level up. 'runLevels' holds the level of each run and is owned by the caller
+     * along with 'runs'; runs appended to 'runs' since the last call are level 0. 'runs' must all
+     * be sorted according to 'comp'.
+     */
+    template <typename Key, typename Value, typename Comparator>
+    void mergeSpilledRunsIfNeeded(
+            std::vector<std::shared_ptr<SortIteratorInterface<Key, Value> > >* runs,
+            std::vector<unsigned>* runLevels,
+            const SortOptions& opts,
+            const Comparator& comp,
+            const typename SortedFileWriter<Key, Value>::Settings& settings =
+                typename SortedFileWriter<Key, Value>::Settings());
 }
 
 /**
@@ -0,0 +1,272 @@
+/*
+*    Copyright (C) 2015 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/sorter/sorter_spill.h"
+
+#include <limits>
+#include <snappy.h>
+#include <zlib.h>
+
+#include "mongo/base/counter.h"
+#include "mongo/base/data_type_endian.h"
+#include "mongo/base/data_view.h"
+#include "mongo/base/status.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace sorter {
+
+namespace {
+
+    enum SpillCompressor : uint8_t {
+        kSpillCompressorNone = 0,
+        kSpillCompressorSnappy = 1,
+        kSpillCompressorZlib = 2,
+    };
+
+    // Blocks which compress to more than this fraction of their size are stored uncompressed.
+    const double kMaxCompressionRatio = 0.9;
+
+    std::string spillCompressorName = "snappy";
+    int spillFileLimit = 64;
+
+    class SpillCompressorParameter : public ExportedServerParameter<std::string> {
+    public:
+        SpillCompressorParameter()
+            : ExportedServerParameter<std::string>(ServerParameterSet::getGlobal(),
+                                                   "sorterSpillCompressor",
+                                                   &spillCompressorName,
+                                                   true,    // Change at startup
+                                                   false) {} // Change at runtime
+
+        virtual Status validate(const std::string& newValue) {
+            if (newValue != "none" && newValue != "snappy" && newValue != "zlib") {
+                return Status(ErrorCodes::BadValue,
+                              "sorterSpillCompressor must be one of: none, snappy, zlib");
+            }
+            return Status::OK();
+        }
+    } spillCompressorParam;
+
+    class SpillFileLimitParameter : public ExportedServerParameter<int> {
+    public:
+        SpillFileLimitParameter()
+            : ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                           "sorterMaxOpenSpillFiles",
+                                           &spillFileLimit,
+                                           true,    // Change at startup
+                                           false) {} // Change at runtime
+
+        virtual Status validate(const int& newValue) {
+            // Merging needs at least two runs to make progress.
+            if (newValue < 2) {
+                return Status(ErrorCodes::BadValue, "sorterMaxOpenSpillFiles must be at least 2");
+            }
+            return Status::OK();
+        }
+    } spillFileLimitParam;
+
+    Counter64 spilledBytesStats;
+    ServerStatusMetricField<Counter64> displaySpilledBytes("sorter.spilledBytes",
+                                                           &spilledBytesStats);
+    Counter64 spilledRunsStats;
+    ServerStatusMetricField<Counter64> displaySpilledRuns("sorter.spilledRuns",
+                                                          &spilledRunsStats);
+    Counter64 mergePassesStats;
+    ServerStatusMetricField<Counter64> displayMergePasses("sorter.mergePasses",
+                                                          &mergePassesStats);
+
+    SpillCompressor configuredCompressor() {
+        if (spillCompressorName == "zlib") {
+            return kSpillCompressorZlib;
+        }
+        if (spillCompressorName == "none") {
+            return kSpillCompressorNone;
+        }
+        return kSpillCompressorSnappy;
+    }
+
+    /**
+     * Compresses 'size' bytes at 'data' into 'out'. Returns false if 'compressor' did not make
+     * the data small enough to be worth storing compressed.
+     */
+    bool compress(SpillCompressor compressor, const char* data, size_t size, std::string* out) {
+        switch (compressor) {
+        case kSpillCompressorSnappy:
+            snappy::Compress(data, size, out);
+            break;
+        case kSpillCompressorZlib: {
+            uLongf compressedSize = compressBound(size);
+            out->resize(compressedSize);
+            if (compress2(reinterpret_cast<Bytef*>(&(*out)[0]),
+                          &compressedSize,
+                          reinterpret_cast<const Bytef*>(data),
+                          size,
+                          Z_DEFAULT_COMPRESSION) != Z_OK) {
+                return false;
+            }
+            out->resize(compressedSize);
+            break;
+        }
+        case kSpillCompressorNone:
+            return false;
+        }
+
+        return out->size() < size * kMaxCompressionRatio;
+    }
+
+    uint32_t checksum(const char* data, size_t size) {
+        return crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(data), size);
+    }
+
+    // Layout of the block header.
+    const size_t kStoredSizeOffset = 0;
+    const size_t kUncompressedSizeOffset = 4;
+    const size_t kChecksumOffset = 8;
+    const size_t kCompressorOffset = 12;
+
+} // namespace
+
+    size_t writeSpillBlock(std::ofstream& file, const char* data, size_t size) {
+        verify(size <= size_t(std::numeric_limits<int32_t>::max()));
+
+        SpillCompressor compressor = configuredCompressor();
+        std::string compressed;
+        if (!compress(compressor, data, size, &compressed)) {
+            compressor = kSpillCompressorNone;
+        }
+
+        const char* stored = compressor == kSpillCompressorNone ? data : compressed.data();
+        const size_t storedSize = compressor == kSpillCompressorNone ? size : compressed.size();
+
+        char header[kSpillBlockHeaderSize] = {};
+        DataView(header)
+            .write(LittleEndian<int32_t>(storedSize), kStoredSizeOffset)
+            .write(LittleEndian<int32_t>(size), kUncompressedSizeOffset)
+            .write(LittleEndian<uint32_t>(checksum(stored, storedSize)), kChecksumOffset)
+            .write(LittleEndian<uint8_t>(compressor), kCompressorOffset);
+
+        file.write(header, sizeof(header));
+        file.write(stored, storedSize);
+        return sizeof(header) + storedSize;
+    }
+
+    bool readSpillBlock(std::ifstream& file,
+                        const std::string& fileName,
+                        std::unique_ptr<char[]>* buffer,
+                        size_t* size) {
+        namespace str = mongoutils::str;
+
+        char header[kSpillBlockHeaderSize];
+        file.read(header, sizeof(header));
+        massert(16817, str::stream() << "error reading file \"" << fileName << "\"",
+                !file.bad());
+        if (file.gcount() == 0 && file.eof()) {
+            return false;
+        }
+        massert(16816, str::stream() << "file too short: " << fileName,
+                file.gcount() == static_cast<std::streamsize>(sizeof(header)));
+
+        ConstDataView headerView(header);
+        const int32_t storedSize =
+            headerView.read<LittleEndian<int32_t>>(kStoredSizeOffset);
+        const int32_t uncompressedSize =
+            headerView.read<LittleEndian<int32_t>>(kUncompressedSizeOffset);
+        const uint32_t expectedChecksum =
+            headerView.read<LittleEndian<uint32_t>>(kChecksumOffset);
+        const uint8_t compressor = headerView.read<LittleEndian<uint8_t>>(kCompressorOffset);
+
+        massert(28696, str::stream() << "invalid block sizes in file: " << fileName,
+                storedSize >= 0 && uncompressedSize >= 0);
+
+        std::unique_ptr<char[]> stored(new char[storedSize]);
+        file.read(stored.get(), storedSize);
+        massert(28705, str::stream() << "error reading file \"" << fileName << "\"",
+                !file.bad());
+        massert(28706, str::stream() << "file too short: " << fileName,
+                file.gcount() == static_cast<std::streamsize>(storedSize));
+
+        massert(28697, str::stream() << "checksum mismatch in file: " << fileName,
+                checksum(stored.get(), storedSize) == expectedChecksum);
+
+        switch (compressor) {
+        case kSpillCompressorNone:
+            massert(28698, str::stream() << "invalid block sizes in file: " << fileName,
+                    storedSize == uncompressedSize);
+            buffer->swap(stored);
+            break;
+        case kSpillCompressorSnappy: {
+            size_t snappySize;
+            massert(17061, "couldn't get uncompressed length",
+                    snappy::GetUncompressedLength(stored.get(), storedSize, &snappySize)
+                        && snappySize == size_t(uncompressedSize));
+            buffer->reset(new char[uncompressedSize]);
+            massert(17062, "decompression failed",
+                    snappy::RawUncompress(stored.get(), storedSize, buffer->get()));
+            break;
+        }
+        case kSpillCompressorZlib: {
+            uLongf zlibSize = uncompressedSize;
+            buffer->reset(new char[uncompressedSize]);
+            massert(28699, "decompression failed",
+                    uncompress(reinterpret_cast<Bytef*>(buffer->get()),
+                               &zlibSize,
+                               reinterpret_cast<const Bytef*>(stored.get()),
+                               storedSize) == Z_OK
+                        && zlibSize == uLongf(uncompressedSize));
+            break;
+        }
+        default:
+            msgasserted(28700, str::stream() << "unknown compressor " << int(compressor)
+                                             << " in file: " << fileName);
+        }
+
+        *size = uncompressedSize;
+        return true;
+    }
+
+    size_t maxOpenSpillFiles() {
+        return spillFileLimit;
+    }
+
+    void recordSpilledRun(size_t bytes) {
+        spilledRunsStats.increment();
+        spilledBytesStats.increment(bytes);
+    }
+
+    void recordMergePass() {
+        mergePassesStats.increment();
+    }
+
+} // namespace sorter
+} // namespace mongo
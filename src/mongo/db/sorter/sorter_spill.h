@@ -0,0 +1,79 @@
+/*
+*    Copyright (C) 2015 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace mongo {
+    namespace sorter {
+        // Everything in this file is internal to the sorter.
+
+        /**
+         * Spill files are a sequence of blocks, each holding serialized key-value pairs. A block
+         * starts with a fixed size header recording the compressor used, the stored and the
+         * uncompressed sizes, and a CRC-32 of the stored bytes, which is verified on read.
+         *
+         * The compressor is chosen with the sorterSpillCompressor server parameter: "snappy" (the
+         * default), "zlib" or "none". Blocks which do not compress well are stored uncompressed.
+         */
+        const size_t kSpillBlockHeaderSize = 16;
+
+        /**
+         * Writes 'size' bytes at 'data' to 'file' as a single block. Returns the number of bytes
+         * written, including the header. Stream errors are reported through the stream's
+         * exception mask.
+         */
+        size_t writeSpillBlock(std::ofstream& file, const char* data, size_t size);
+
+        /**
+         * Reads the next block from 'file' into 'buffer' and sets 'size' to its uncompressed size.
+         * Returns false if 'file' is at its end. Throws if the block is truncated or corrupt.
+         */
+        bool readSpillBlock(std::ifstream& file,
+                            const std::string& fileName,
+                            std::unique_ptr<char[]>* buffer,
+                            size_t* size);
+
+        /**
+         * Returns how many spilled runs a single sort may keep on disk, each with a file open,
+         * before they are merged into one. Set with the sorterMaxOpenSpillFiles server parameter.
+         */
+        size_t maxOpenSpillFiles();
+
+        /**
+         * Add to the process-wide sorter counters reported in serverStatus.
+         */
+        void recordSpilledRun(size_t bytes);
+        void recordMergePass();
+
+    } // namespace sorter
+} // namespace mongo
@@ -31,8 +31,10 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem.hpp>
+#include <fstream>
 
 #include "mongo/config.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
@@ -247,7 +249,67 @@ namespace mongo {
         }
     };
 
+    // Sets a server parameter, restoring its default value when going out of scope.
+    class ServerParameterSetting {
+    public:
+        ServerParameterSetting(const std::string& name,
+                               const std::string& value,
+                               const std::string& defaultValue)
+            : _parameter(ServerParameterSet::getGlobal()->getMap().find(name)->second)
+            , _defaultValue(defaultValue) {
+            ASSERT_OK(_parameter->setFromString(value));
+        }
+        ~ServerParameterSetting() {
+            _parameter->setFromString(_defaultValue);
+        }
+    private:
+        ServerParameter* const _parameter;
+        const std::string _defaultValue;
+    };
+
+    class SpillFileFormatTests {
+    public:
+        void run() {
+            unittest::TempDir tempDir("spillFileFormatTests");
+            const char* const compressors[] = {"none", "snappy", "zlib"};
+            for (size_t c = 0; c < sizeof(compressors) / sizeof(compressors[0]); c++) {
+                ServerParameterSetting setting("sorterSpillCompressor", compressors[c], "snappy");
+
+                SorterSpillStats stats;
+                const SortOptions opts = SortOptions().TempDir(tempDir.path()).SpillStats(&stats);
+                SortedFileWriter<IntWrapper, IntWrapper> sorter(opts);
+                for (int i=0; i< 1000*1000; i++)
+                    sorter.addAlreadySorted(i,-i);
+
+                ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter.done()),
+                                            make_shared<IntIterator>(0,1000*1000));
+                ASSERT_EQUALS(stats.spilledRuns, 1);
+                ASSERT_GREATER_THAN(stats.spilledBytes, 0);
+                ASSERT_EQUALS(stats.mergePasses, 0);
+            }
+            { // corrupt
+                ServerParameterSetting setting("sorterSpillCompressor", "none", "snappy");
+
+                const SortOptions opts = SortOptions().TempDir(tempDir.path());
+                SortedFileWriter<IntWrapper, IntWrapper> sorter(opts);
+                for (int i=0; i< 100; i++)
+                    sorter.addAlreadySorted(i,-i);
+                std::shared_ptr<IWIterator> iter(sorter.done());
 
+                const boost::filesystem::path file =
+                    *boost::filesystem::directory_iterator(tempDir.path());
+                std::fstream stream(file.string().c_str(),
+                                    std::ios::in | std::ios::out | std::ios::binary);
+                stream.seekp(sorter::kSpillBlockHeaderSize + 10);
+                stream.put('\xff');
+                stream.close();
+
+                ASSERT_THROWS(iter->more(), MsgAssertionException);
+            }
+
+            ASSERT(boost::filesystem::is_empty(tempDir.path()));
+        }
+    };
 
     class MergeIteratorTests {
     public:
@@ -522,6 +584,138 @@ namespace mongo {
             }
             enum { MEM_LIMIT = 32*1024 };
         };
+
+        // Spills more runs than sorterMaxOpenSpillFiles allows, forcing merge passes.
+        class ManySpilledRuns {
+        public:
+            void run() {
+                unittest::TempDir tempDir("sorterTests");
+                ServerParameterSetting setting("sorterMaxOpenSpillFiles", "8", "64");
+
+                SorterSpillStats stats;
+                const SortOptions opts = SortOptions().TempDir(tempDir.path())
+                                                      .MaxMemoryUsageBytes(MEM_LIMIT)
+                                                      .ExtSortAllowed()
+                                                      .SpillStats(&stats);
+
+                std::vector<int> data;
+                for (int i=0; i<NUM_ITEMS; i++)
+                    data.push_back(i);
+                std::random_shuffle(data.begin(), data.end());
+
+                std::shared_ptr<IWSorter> sorter(IWSorter::make(opts, IWComparator(ASC)));
+                for (int i=0; i<NUM_ITEMS; i++)
+                    sorter->add(data[i], -data[i]);
+
+                ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter->done()),
+                                            make_shared<IntIterator>(0, NUM_ITEMS));
+
+                // Each merge pass writes one run on top of those spilled by the sorter itself.
+                ASSERT_GREATER_THAN(stats.mergePasses, 0);
+                ASSERT_EQUALS(stats.spilledRuns, sorter->numFiles() + stats.mergePasses);
+
+                sorter.reset();
+                ASSERT(boost::filesystem::is_empty(tempDir.path()));
+            }
+
+            enum Constants {
+                NUM_ITEMS = 100*1000,
+                MEM_LIMIT = 16*1024,
+            };
+        };
+
+        // A limit set in the SortOptions bounds the runs left on disk in place of the server's.
+        class ManySpilledRunsWithSortOptionsLimit {
+        public:
+            void run() {
+                unittest::TempDir tempDir("sorterTests");
+
+                SorterSpillStats stats;
+                const SortOptions opts = SortOptions().TempDir(tempDir.path())
+                                                      .MaxMemoryUsageBytes(MEM_LIMIT)
+                                                      .ExtSortAllowed()
+                                                      .SpillStats(&stats)
+                                                      .MaxOpenSpillFiles(MAX_OPEN_SPILL_FILES);
+
+                std::vector<int> data;
+                for (int i=0; i<NUM_ITEMS; i++)
+                    data.push_back(i);
+                std::random_shuffle(data.begin(), data.end());
+
+                std::shared_ptr<IWSorter> sorter(IWSorter::make(opts, IWComparator(ASC)));
+                for (int i=0; i<NUM_ITEMS; i++)
+                    sorter->add(data[i], -data[i]);
+
+                std::shared_ptr<IWIterator> sorted(sorter->done());
+                ASSERT_GREATER_THAN(stats.mergePasses, 0);
+
+                // Each run left to the final merge is one file in the temp dir.
+                size_t numFiles = 0;
+                for (boost::filesystem::directory_iterator it(tempDir.path()), end; it != end;
+                        ++it) {
+                    numFiles++;
+                }
+                ASSERT_LESS_THAN_OR_EQUALS(numFiles, size_t(MAX_OPEN_SPILL_FILES));
+
+                ASSERT_ITERATORS_EQUIVALENT(sorted, make_shared<IntIterator>(0, NUM_ITEMS));
+            }
+
+            enum Constants {
+                NUM_ITEMS = 100*1000,
+                MEM_LIMIT = 16*1024,
+                MAX_OPEN_SPILL_FILES = 4,
+            };
+        };
+
+        // Merging many spilled runs under a low file limit only rewrites each byte a few times.
+        class ManySpilledRunsMergedByLevel {
+        public:
+            void run() {
+                std::vector<int> data;
+                for (int i=0; i<NUM_ITEMS; i++)
+                    data.push_back(i);
+                std::random_shuffle(data.begin(), data.end());
+
+                // About 100 runs, which never need merging.
+                const SorterSpillStats unmerged = sort(data, "1000");
+                ASSERT_EQUALS(unmerged.mergePasses, 0);
+                ASSERT_GREATER_THAN(unmerged.spilledRuns, 50);
+
+                // Merging everything whenever 8 runs are open would write the data about eight
+                // times over.
+                const SorterSpillStats merged = sort(data, "8");
+                ASSERT_GREATER_THAN(merged.mergePasses, 0);
+                ASSERT_LESS_THAN(merged.spilledBytes, 4 * unmerged.spilledBytes);
+            }
+
+        private:
+            static SorterSpillStats sort(const std::vector<int>& data,
+                                         const std::string& maxOpenSpillFiles) {
+                unittest::TempDir tempDir("sorterTests");
+                ServerParameterSetting setting("sorterMaxOpenSpillFiles",
+                                               maxOpenSpillFiles,
+                                               "64");
+
+                SorterSpillStats stats;
+                const SortOptions opts = SortOptions().TempDir(tempDir.path())
+                                                      .MaxMemoryUsageBytes(MEM_LIMIT)
+                                                      .ExtSortAllowed()
+                                                      .SpillStats(&stats);
+
+                std::shared_ptr<IWSorter> sorter(IWSorter::make(opts, IWComparator(ASC)));
+                for (size_t i=0; i<data.size(); i++)
+                    sorter->add(data[i], -data[i]);
+
+                ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter->done()),
+                                            make_shared<IntIterator>(0, NUM_ITEMS));
+                return stats;
+            }
+
+            enum Constants {
+                NUM_ITEMS = 100*1000,
+                MEM_LIMIT = 8*1024,
+            };
+        };
     }
 
     class SorterSuite : public mongo::unittest::Suite {
@@ -533,12 +727,16 @@ namespace mongo {
         void setupTests() {
             add<InMemIterTests>();
             add<SortedFileWriterAndFileIteratorTests>();
+            add<SpillFileFormatTests>();
             add<MergeIteratorTests>();
             add<SorterTests::Basic>();
             add<SorterTests::Limit>();
             add<SorterTests::Dupes>();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/false> >();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/true> >();
+            add<SorterTests::ManySpilledRuns>();
+            add<SorterTests::ManySpilledRunsWithSortOptionsLimit>();
+            add<SorterTests::ManySpilledRunsMergedByLevel>();
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/false> >(); // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/true> >();  // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/false> >(); // fits in mem
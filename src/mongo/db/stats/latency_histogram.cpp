@@ -0,0 +1,170 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/latency_histogram.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/bits.h"
+#include "mongo/util/concurrency/striped_counter.h"
+
+namespace mongo {
+
+    int LatencyHistogram::bucketFor(long long micros) {
+        if (micros < kSubBuckets) {
+            return micros < 0 ? 0 : static_cast<int>(micros);
+        }
+
+        const int bit = 63 - countLeadingZeros64(static_cast<unsigned long long>(micros));
+        if (bit > kMaxBit) {
+            return kNumBuckets - 1;
+        }
+
+        // The kSubBucketBits bits below the highest set bit pick the bucket within the power of
+        // two.
+        const int shift = bit - kSubBucketBits;
+        const int sub = static_cast<int>((micros >> shift) & (kSubBuckets - 1));
+        return kSubBuckets + shift * kSubBuckets + sub;
+    }
+
+    long long LatencyHistogram::bucketLowerBound(int bucket) {
+        if (bucket < kSubBuckets) {
+            return bucket;
+        }
+        const int shift = (bucket - kSubBuckets) / kSubBuckets;
+        const int sub = (bucket - kSubBuckets) % kSubBuckets;
+        return static_cast<long long>(kSubBuckets + sub) << shift;
+    }
+
+    long long LatencyHistogram::bucketUpperBound(int bucket) {
+        if (bucket < kSubBuckets) {
+            return bucket;
+        }
+        const int shift = (bucket - kSubBuckets) / kSubBuckets;
+        return bucketLowerBound(bucket) + (1LL << shift) - 1;
+    }
+
+    void LatencyHistogram::record(long long micros) {
+        Stripe& stripe = _stripes[threadStripe() % kStripes];
+        stripe.buckets[bucketFor(micros)].fetchAndAdd(1);
+        if (micros > 0) {
+            stripe.totalMicros.fetchAndAdd(micros);
+        }
+    }
+
+    long long LatencyHistogram::getCount() const {
+        long long count = 0;
+        for (unsigned s = 0; s < kStripes; ++s) {
+            for (int i = 0; i < kNumBuckets; ++i) {
+                count += _stripes[s].buckets[i].loadRelaxed();
+            }
+        }
+        return count;
+    }
+
+    long long LatencyHistogram::getTotalMicros() const {
+        long long totalMicros = 0;
+        for (unsigned s = 0; s < kStripes; ++s) {
+            totalMicros += _stripes[s].totalMicros.loadRelaxed();
+        }
+        return totalMicros;
+    }
+
+    long long LatencyHistogram::getPercentile(double percentile) const {
+        Snapshot snapshot;
+        _snapshot(&snapshot);
+        return _percentile(snapshot, percentile);
+    }
+
+    void LatencyHistogram::_snapshot(Snapshot* out) const {
+        out->total = 0;
+        for (int i = 0; i < kNumBuckets; ++i) {
+            out->counts[i] = 0;
+            for (unsigned s = 0; s < kStripes; ++s) {
+                out->counts[i] += _stripes[s].buckets[i].loadRelaxed();
+            }
+            out->total += out->counts[i];
+        }
+    }
+
+    long long LatencyHistogram::_percentile(const Snapshot& snapshot, double percentile) {
+        if (snapshot.total == 0) {
+            return 0;
+        }
+
+        // The rank of the value we want, counting from 1.
+        long long rank = static_cast<long long>(percentile / 100.0 * snapshot.total + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        }
+
+        long long seen = 0;
+        for (int i = 0; i < kNumBuckets; ++i) {
+            seen += snapshot.counts[i];
+            if (seen >= rank) {
+                return bucketUpperBound(i);
+            }
+        }
+        return bucketUpperBound(kNumBuckets - 1);
+    }
+
+    void LatencyHistogram::append(BSONObjBuilder& b) const {
+        Snapshot snapshot;
+        _snapshot(&snapshot);
+        const long long totalMicros = getTotalMicros();
+
+        b.appendNumber("count", snapshot.total);
+        b.appendNumber("totalMicros", totalMicros);
+        b.appendNumber("meanMicros", snapshot.total ? totalMicros / snapshot.total : 0);
+
+        {
+            BSONObjBuilder percentiles(b.subobjStart("percentiles"));
+            percentiles.appendNumber("50", _percentile(snapshot, 50));
+            percentiles.appendNumber("90", _percentile(snapshot, 90));
+            percentiles.appendNumber("99", _percentile(snapshot, 99));
+            percentiles.appendNumber("99.9", _percentile(snapshot, 99.9));
+            percentiles.appendNumber("100", _percentile(snapshot, 100));
+            percentiles.done();
+        }
+
+        BSONArrayBuilder buckets(b.subarrayStart("histogram"));
+        for (int i = 0; i < kNumBuckets; ++i) {
+            if (snapshot.counts[i] == 0) {
+                continue;
+            }
+            BSONObjBuilder bucket(buckets.subobjStart());
+            bucket.appendNumber("micros", bucketLowerBound(i));
+            bucket.appendNumber("count", snapshot.counts[i]);
+            bucket.done();
+        }
+        buckets.done();
+    }
+
+} // namespace mongo
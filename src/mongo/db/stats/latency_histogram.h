@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * A histogram of operation latencies in microseconds, in the style of an HDR histogram: each
+     * power of two is split into kSubBuckets linear buckets, so every recorded value lands in a
+     * bucket no wider than 1/kSubBuckets of the value, over the whole range from 0 up to about
+     * nineteen hours.  Longer latencies are counted in the last bucket.
+     *
+     * record() only does atomic adds, so any number of threads may record into one histogram
+     * without taking a lock.  Like StripedCounter, the histogram keeps several stripes of buckets
+     * and each thread records into its own, so that threads on different cores don't fight over
+     * the buckets of common latencies.  Reading sums the stripes into a snapshot which isn't
+     * atomic with respect to concurrent recording, which is fine for statistics.
+     */
+    class LatencyHistogram {
+        MONGO_DISALLOW_COPYING(LatencyHistogram);
+    public:
+        static const int kSubBucketBits = 3;
+        static const int kSubBuckets = 1 << kSubBucketBits;
+
+        // The highest bit a value may have before it is clamped into the last bucket.
+        static const int kMaxBit = 35;
+
+        static const int kNumBuckets = kSubBuckets + (kMaxBit - kSubBucketBits + 1) * kSubBuckets;
+
+        LatencyHistogram() { }
+
+        void record(long long micros);
+
+        long long getCount() const;
+        long long getTotalMicros() const;
+
+        /**
+         * Returns the highest latency which falls in the same bucket as the value at the given
+         * percentile (between 0 and 100) of the recorded latencies, or 0 if nothing was recorded.
+         */
+        long long getPercentile(double percentile) const;
+
+        /**
+         * Appends the count, total and mean latency, a few percentiles, and the non-empty buckets
+         * as an array of { micros: <lowest latency in the bucket>, count: <n> }.
+         */
+        void append(BSONObjBuilder& b) const;
+
+        static int bucketFor(long long micros);
+        static long long bucketLowerBound(int bucket);
+        static long long bucketUpperBound(int bucket);
+
+    private:
+        // Fewer stripes than a StripedCounter, since each one holds every bucket.
+        static const unsigned kStripes = 8;
+
+        // Padded so that no two stripes share a cache line, wherever the array starts.
+        struct Stripe {
+            AtomicInt64 buckets[kNumBuckets];
+            AtomicInt64 totalMicros;
+            char pad[64 - sizeof(AtomicInt64)];
+        };
+
+        struct Snapshot {
+            long long counts[kNumBuckets];
+            long long total;
+        };
+
+        void _snapshot(Snapshot* out) const;
+        static long long _percentile(const Snapshot& snapshot, double percentile);
+
+        Stripe _stripes[kStripes];
+    };
+
+} // namespace mongo
@@ -0,0 +1,166 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/latency_stats.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/service_context.h"
+#include "mongo/util/concurrency/striped_counter.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+namespace {
+
+    const auto getLatencyStats = ServiceContext::declareDecoration<LatencyStats>();
+
+} // namespace
+
+    LatencyStats& LatencyStats::get(ServiceContext* service) {
+        return getLatencyStats(service);
+    }
+
+    LatencyStats::LatencyStats() : _namespacesLock("LatencyStats") { }
+
+    bool LatencyStats::opTypeFor(int op, bool isCommand, OpType* out) {
+        if (isCommand) {
+            *out = kCommand;
+            return true;
+        }
+
+        switch (op) {
+        case dbQuery: *out = kQuery; return true;
+        case dbGetMore: *out = kGetMore; return true;
+        case dbInsert: *out = kInsert; return true;
+        case dbUpdate: *out = kUpdate; return true;
+        case dbDelete: *out = kDelete; return true;
+        case dbCommand: *out = kCommand; return true;
+        default: return false;
+        }
+    }
+
+    const char* LatencyStats::opTypeName(OpType type) {
+        switch (type) {
+        case kQuery: return "queries";
+        case kGetMore: return "getmore";
+        case kInsert: return "insert";
+        case kUpdate: return "update";
+        case kDelete: return "remove";
+        case kCommand: return "commands";
+        default: return "unknown";
+        }
+    }
+
+    void LatencyStats::record(OpType type, long long micros) {
+        _byOpType[type].record(micros);
+    }
+
+    void LatencyStats::recordForNamespace(StringData ns, OpType type, long long micros) {
+        if (ns.empty()) {
+            return;
+        }
+        _getForNamespace(ns)->byOpType[type].record(micros);
+    }
+
+    std::shared_ptr<LatencyStats::NamespaceHistograms>
+    LatencyStats::_getForNamespace(StringData ns) {
+        Stripe& stripe = _stripes[threadStripe() % kStripes];
+        {
+            SimpleMutex::scoped_lock lk(stripe.lock);
+            NamespaceMap::const_iterator it = stripe.histograms.find(ns);
+            if (it != stripe.histograms.end()) {
+                return it->second;
+            }
+        }
+
+        // First time this thread's stripe sees the namespace.
+        SimpleMutex::scoped_lock lk(_namespacesLock);
+        std::shared_ptr<NamespaceHistograms>& histograms = _namespaces[ns];
+        if (!histograms) {
+            histograms = std::make_shared<NamespaceHistograms>();
+        }
+
+        SimpleMutex::scoped_lock stripeLock(stripe.lock);
+        stripe.histograms[ns] = histograms;
+        return histograms;
+    }
+
+    void LatencyStats::collectionDropped(StringData ns) {
+        SimpleMutex::scoped_lock lk(_namespacesLock);
+        _namespaces.erase(ns);
+        for (size_t i = 0; i < kStripes; ++i) {
+            SimpleMutex::scoped_lock stripeLock(_stripes[i].lock);
+            _stripes[i].histograms.erase(ns);
+        }
+    }
+
+    void LatencyStats::appendByOpType(BSONObjBuilder& b) const {
+        for (int i = 0; i < kNumOpTypes; ++i) {
+            BSONObjBuilder bb(b.subobjStart(opTypeName(static_cast<OpType>(i))));
+            _byOpType[i].append(bb);
+            bb.done();
+        }
+    }
+
+    void LatencyStats::appendByNamespace(BSONObjBuilder& b) const {
+        // Hold on to the histograms so that we can append them without the lock.
+        std::vector<std::pair<std::string, std::shared_ptr<NamespaceHistograms>>> namespaces;
+        {
+            SimpleMutex::scoped_lock lk(_namespacesLock);
+            for (NamespaceMap::const_iterator it = _namespaces.begin();
+                 it != _namespaces.end();
+                 ++it) {
+                namespaces.push_back(std::make_pair(it->first, it->second));
+            }
+        }
+
+        std::sort(namespaces.begin(), namespaces.end());
+
+        for (size_t i = 0; i < namespaces.size(); ++i) {
+            BSONObjBuilder nsBuilder(b.subobjStart(namespaces[i].first));
+            for (int type = 0; type < kNumOpTypes; ++type) {
+                const LatencyHistogram& histogram = namespaces[i].second->byOpType[type];
+                if (histogram.getCount() == 0) {
+                    continue;
+                }
+                BSONObjBuilder bb(nsBuilder.subobjStart(opTypeName(static_cast<OpType>(type))));
+                histogram.append(bb);
+                bb.done();
+            }
+            nsBuilder.done();
+        }
+    }
+
+} // namespace mongo
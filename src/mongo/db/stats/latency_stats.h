@@ -0,0 +1,123 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+    class ServiceContext;
+
+    /**
+     * Latency histograms of completed operations, kept per operation type and, when asked to,
+     * per namespace and operation type.
+     *
+     * Recording into the per operation type histograms never takes a lock.  The per namespace
+     * histograms are found through a map which is striped across threads like Top's, so the only
+     * lock taken is the recording thread's own stripe, and the histogram itself is updated after
+     * the lock is released.
+     */
+    class LatencyStats {
+        MONGO_DISALLOW_COPYING(LatencyStats);
+    public:
+        enum OpType {
+            kQuery = 0,
+            kGetMore,
+            kInsert,
+            kUpdate,
+            kDelete,
+            kCommand,
+            kNumOpTypes
+        };
+
+        static LatencyStats& get(ServiceContext* service);
+
+        LatencyStats();
+
+        /**
+         * Maps a wire protocol operation to the histogram it is recorded in.  Returns false for
+         * operations which aren't tracked.
+         */
+        static bool opTypeFor(int op, bool isCommand, OpType* out);
+
+        static const char* opTypeName(OpType type);
+
+        void record(OpType type, long long micros);
+        void recordForNamespace(StringData ns, OpType type, long long micros);
+
+        void collectionDropped(StringData ns);
+
+        /**
+         * Appends a subobject per operation type.
+         */
+        void appendByOpType(BSONObjBuilder& b) const;
+
+        /**
+         * Appends a subobject per namespace, sorted by name, each holding a subobject per
+         * operation type which has been recorded for it.
+         */
+        void appendByNamespace(BSONObjBuilder& b) const;
+
+    private:
+        struct NamespaceHistograms {
+            LatencyHistogram byOpType[kNumOpTypes];
+        };
+
+        typedef StringMap<std::shared_ptr<NamespaceHistograms>> NamespaceMap;
+
+        struct Stripe {
+            Stripe() : lock("LatencyStats") { }
+
+            SimpleMutex lock;
+            NamespaceMap histograms;
+        };
+
+        static const size_t kStripes = 16;
+
+        std::shared_ptr<NamespaceHistograms> _getForNamespace(StringData ns);
+
+        LatencyHistogram _byOpType[kNumOpTypes];
+
+        // Owns the set of namespaces; the stripes cache pointers into it.  Always taken before a
+        // stripe's lock.
+        mutable SimpleMutex _namespacesLock;
+        NamespaceMap _namespaces;
+
+        mutable Stripe _stripes[kStripes];
+    };
+
+} // namespace mongo
@@ -0,0 +1,166 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <limits>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/db/stats/latency_stats.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+
+namespace {
+
+    using namespace mongo;
+
+    TEST(LatencyHistogramTest, BucketsCoverTheirValues) {
+        for (long long micros = 0; micros < 100000; ++micros) {
+            const int bucket = LatencyHistogram::bucketFor(micros);
+            ASSERT_LESS_THAN_OR_EQUALS(LatencyHistogram::bucketLowerBound(bucket), micros);
+            ASSERT_GREATER_THAN_OR_EQUALS(LatencyHistogram::bucketUpperBound(bucket), micros);
+        }
+    }
+
+    TEST(LatencyHistogramTest, BucketsAreNarrow) {
+        for (int bucket = 0; bucket < LatencyHistogram::kNumBuckets; ++bucket) {
+            const long long low = LatencyHistogram::bucketLowerBound(bucket);
+            const long long high = LatencyHistogram::bucketUpperBound(bucket);
+            ASSERT_LESS_THAN_OR_EQUALS(high - low, low / LatencyHistogram::kSubBuckets);
+        }
+    }
+
+    TEST(LatencyHistogramTest, ClampsLongAndNegativeLatencies) {
+        ASSERT_EQUALS(LatencyHistogram::kNumBuckets - 1,
+                      LatencyHistogram::bucketFor(std::numeric_limits<long long>::max()));
+        ASSERT_EQUALS(0, LatencyHistogram::bucketFor(-5));
+    }
+
+    TEST(LatencyHistogramTest, Percentiles) {
+        LatencyHistogram histogram;
+        ASSERT_EQUALS(0, histogram.getPercentile(50));
+
+        for (int i = 0; i < 99; ++i) {
+            histogram.record(5);
+        }
+        histogram.record(1000);
+
+        ASSERT_EQUALS(100, histogram.getCount());
+        ASSERT_EQUALS(99 * 5 + 1000, histogram.getTotalMicros());
+        ASSERT_EQUALS(5, histogram.getPercentile(50));
+        ASSERT_EQUALS(5, histogram.getPercentile(99));
+
+        // 1000 is reported as the highest value in its bucket.
+        const long long max = histogram.getPercentile(100);
+        ASSERT_EQUALS(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketFor(1000)), max);
+        ASSERT_LESS_THAN_OR_EQUALS(1000, max);
+        ASSERT_LESS_THAN_OR_EQUALS(max, 1000 + 1000 / LatencyHistogram::kSubBuckets);
+    }
+
+    TEST(LatencyHistogramTest, AppendsOnlyNonEmptyBuckets) {
+        LatencyHistogram histogram;
+        histogram.record(3);
+        histogram.record(3);
+        histogram.record(700);
+
+        BSONObjBuilder b;
+        histogram.append(b);
+        BSONObj obj = b.obj();
+
+        ASSERT_EQUALS(3, obj["count"].numberLong());
+        std::vector<BSONElement> buckets = obj["histogram"].Array();
+        ASSERT_EQUALS(2U, buckets.size());
+        ASSERT_EQUALS(3, buckets[0].Obj()["micros"].numberLong());
+        ASSERT_EQUALS(2, buckets[0].Obj()["count"].numberLong());
+        ASSERT_EQUALS(LatencyHistogram::bucketLowerBound(LatencyHistogram::bucketFor(700)),
+                      buckets[1].Obj()["micros"].numberLong());
+    }
+
+    void recordQueries(LatencyStats* stats, int times) {
+        for (int i = 0; i < times; ++i) {
+            stats->record(LatencyStats::kQuery, 10);
+            stats->recordForNamespace("db.coll", LatencyStats::kQuery, 10);
+        }
+    }
+
+    TEST(LatencyStatsTest, MergesLatenciesRecordedOnManyThreads) {
+        const int kThreads = 4;
+        const int kQueries = 1000;
+
+        LatencyStats stats;
+        std::vector<stdx::thread*> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.push_back(new stdx::thread(stdx::bind(recordQueries, &stats, kQueries)));
+        }
+        for (int i = 0; i < kThreads; ++i) {
+            threads[i]->join();
+            delete threads[i];
+        }
+
+        BSONObjBuilder byOpType;
+        stats.appendByOpType(byOpType);
+        ASSERT_EQUALS(kThreads * kQueries,
+                      byOpType.obj()["queries"].Obj()["count"].numberLong());
+
+        BSONObjBuilder byNamespace;
+        stats.appendByNamespace(byNamespace);
+        BSONObj coll = byNamespace.obj()["db.coll"].Obj();
+        ASSERT_EQUALS(kThreads * kQueries, coll["queries"].Obj()["count"].numberLong());
+        ASSERT_FALSE(coll.hasField("insert"));
+    }
+
+    TEST(LatencyStatsTest, CollectionDropped) {
+        LatencyStats stats;
+        stats.recordForNamespace("db.coll", LatencyStats::kInsert, 10);
+        stats.collectionDropped("db.coll");
+
+        BSONObjBuilder byNamespace;
+        stats.appendByNamespace(byNamespace);
+        ASSERT_FALSE(byNamespace.obj().hasField("db.coll"));
+
+        // The namespace comes back if it is used again.
+        stats.recordForNamespace("db.coll", LatencyStats::kInsert, 10);
+        BSONObjBuilder again;
+        stats.appendByNamespace(again);
+        ASSERT_EQUALS(1, again.obj()["db.coll"].Obj()["insert"].Obj()["count"].numberLong());
+    }
+
+    TEST(LatencyStatsTest, OpTypes) {
+        LatencyStats::OpType type;
+        ASSERT_TRUE(LatencyStats::opTypeFor(dbQuery, true, &type));
+        ASSERT_EQUALS(LatencyStats::kCommand, type);
+        ASSERT_TRUE(LatencyStats::opTypeFor(dbGetMore, false, &type));
+        ASSERT_EQUALS(LatencyStats::kGetMore, type);
+        ASSERT_FALSE(LatencyStats::opTypeFor(dbKillCursors, false, &type));
+    }
+
+} // namespace
@@ -35,6 +35,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/service_context.h"
+#include "mongo/util/concurrency/striped_counter.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/message.h"
 
@@ -70,6 +71,18 @@ namespace {
 
     }
 
+    void Top::CollectionData::add( const CollectionData& other ) {
+        total.add( other.total );
+        readLock.add( other.readLock );
+        writeLock.add( other.writeLock );
+        queries.add( other.queries );
+        getmore.add( other.getmore );
+        insert.add( other.insert );
+        update.add( other.update );
+        remove.add( other.remove );
+        commands.add( other.commands );
+    }
+
     // static
     Top& Top::get(ServiceContext* service) {
         return getTop(service);
@@ -80,14 +93,15 @@ namespace {
             return;
 
         //cout << "record: " << ns << "\t" << op << "\t" << command << endl;
-        SimpleMutex::scoped_lock lk(_lock);
+        Stripe& stripe = _stripes[threadStripe() % kStripes];
+        SimpleMutex::scoped_lock lk(stripe.lock);
 
-        if ( ( command || op == dbQuery ) && ns == _lastDropped ) {
-            _lastDropped = "";
+        if ( ( command || op == dbQuery ) && ns == stripe.lastDropped ) {
+            stripe.lastDropped = "";
             return;
         }
 
-        CollectionData& coll = _usage[ns];
+        CollectionData& coll = stripe.usage[ns];
         _record( coll, op, lockType, micros, command );
     }
 
@@ -138,19 +152,31 @@ namespace {
     }
 
     void Top::collectionDropped( StringData ns ) {
-        SimpleMutex::scoped_lock lk(_lock);
-        _usage.erase(ns);
-        _lastDropped = ns.toString();
+        const size_t mine = threadStripe() % kStripes;
+        for ( size_t i = 0; i < kStripes; ++i ) {
+            SimpleMutex::scoped_lock lk( _stripes[i].lock );
+            _stripes[i].usage.erase( ns );
+            if ( i == mine ) {
+                _stripes[i].lastDropped = ns.toString();
+            }
+        }
     }
 
     void Top::cloneMap(Top::UsageMap& out) const {
-        SimpleMutex::scoped_lock lk(_lock);
-        out = _usage;
+        out = UsageMap();
+        for ( size_t i = 0; i < kStripes; ++i ) {
+            SimpleMutex::scoped_lock lk( _stripes[i].lock );
+            const UsageMap& usage = _stripes[i].usage;
+            for ( UsageMap::const_iterator it = usage.begin(); it != usage.end(); ++it ) {
+                out[it->first].add( it->second );
+            }
+        }
     }
 
     void Top::append( BSONObjBuilder& b ) {
-        SimpleMutex::scoped_lock lk( _lock );
-        _appendToUsageMap( b, _usage );
+        UsageMap usage;
+        cloneMap( usage );
+        _appendToUsageMap( b, usage );
     }
 
     void Top::_appendToUsageMap( BSONObjBuilder& b, const UsageMap& map ) const {
@@ -40,13 +40,16 @@ namespace mongo {
 
     /**
      * tracks usage by collection
+     *
+     * Each thread records into its own stripe of the usage map, so that operations on different
+     * cores don't serialize on one mutex.  Reading the usage merges the stripes.
      */
     class Top {
 
     public:
         static Top& get(ServiceContext* service);
 
-        Top() : _lock("Top") { }
+        Top() { }
 
         struct UsageData {
             UsageData() : time(0), count(0) {}
@@ -58,6 +61,11 @@ namespace mongo {
                 count++;
                 time += micros;
             }
+
+            void add( const UsageData& other ) {
+                count += other.count;
+                time += other.time;
+            }
         };
 
         struct CollectionData {
@@ -78,6 +86,8 @@ namespace mongo {
             UsageData update;
             UsageData remove;
             UsageData commands;
+
+            void add( const CollectionData& other );
         };
 
         typedef StringMap<CollectionData> UsageMap;
@@ -93,9 +103,20 @@ namespace mongo {
         void _appendStatsEntry( BSONObjBuilder& b, const char * statsName, const UsageData& map ) const;
         void _record( CollectionData& c, int op, int lockType, long long micros, bool command );
 
-        mutable SimpleMutex _lock;
-        UsageMap _usage;
-        std::string _lastDropped;
+        struct Stripe {
+            Stripe() : lock("Top") { }
+
+            SimpleMutex lock;
+            UsageMap usage;
+
+            // Set on the stripe of the thread which dropped the collection, so that the drop
+            // command doesn't put it back when it records itself.
+            std::string lastDropped;
+        };
+
+        static const size_t kStripes = 16;
+
+        mutable Stripe _stripes[kStripes];
     };
 
 } // namespace mongo
@@ -29,7 +29,10 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/db/stats/top.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
 
 namespace {
 
@@ -39,4 +42,44 @@ namespace {
         Top().collectionDropped("coll");
     }
 
+    void recordQueries(Top* top, int times) {
+        for (int i = 0; i < times; ++i) {
+            top->record("db.coll", dbQuery, -1, 10, false);
+        }
+    }
+
+    TEST(TopTest, MergesUsageRecordedOnManyThreads) {
+        const int kThreads = 4;
+        const int kQueries = 1000;
+
+        Top top;
+        std::vector<stdx::thread*> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.push_back(new stdx::thread(stdx::bind(recordQueries, &top, kQueries)));
+        }
+        for (int i = 0; i < kThreads; ++i) {
+            threads[i]->join();
+            delete threads[i];
+        }
+
+        Top::UsageMap usage;
+        top.cloneMap(usage);
+        ASSERT_EQUALS(kThreads * kQueries, usage["db.coll"].queries.count);
+        ASSERT_EQUALS(kThreads * kQueries, usage["db.coll"].readLock.count);
+        ASSERT_EQUALS(10LL * kThreads * kQueries, usage["db.coll"].total.time);
+    }
+
+    TEST(TopTest, DroppedCollectionIsForgotten) {
+        Top top;
+        recordQueries(&top, 3);
+        top.collectionDropped("db.coll");
+
+        // The drop command recording itself doesn't bring the collection back.
+        top.record("db.coll", dbQuery, 1, 10, true);
+
+        Top::UsageMap usage;
+        top.cloneMap(usage);
+        ASSERT(usage.find("db.coll") == usage.end());
+    }
+
 } // namespace
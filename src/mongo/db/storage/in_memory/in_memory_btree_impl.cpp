@@ -32,11 +32,12 @@
 
 #include "mongo/db/storage/in_memory/in_memory_btree_impl.h"
 
-#include <set>
+#include <map>
 
 #include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/storage/index_entry_comparison.h"
 #include "mongo/db/storage/in_memory/in_memory_recovery_unit.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -69,7 +70,34 @@ namespace {
         return bb.obj();
     }
 
-    typedef std::set<IndexKeyEntry, IndexEntryComparison> IndexSet;
+    /**
+     * Maps the KeyString encoding of each (key, RecordId) pair to the TypeBits needed to decode
+     * the key back to BSON. The encoding already accounts for the index Ordering, so the byte-wise
+     * comparison done by std::string (memcmp, then length) is the index order. The TypeBits are
+     * left empty in the common case where they are all zeros.
+     */
+    typedef std::map<string, string> IndexSet;
+
+    string toIndexSetKey(const KeyString& ks) {
+        return string(ks.getBuffer(), ks.getSize());
+    }
+
+    string toIndexSetValue(const KeyString::TypeBits& typeBits) {
+        if (typeBits.isAllZeros())
+            return string();
+        return string(reinterpret_cast<const char*>(typeBits.getBuffer()), typeBits.getSize());
+    }
+
+    KeyString::TypeBits typeBitsFromIndexSetValue(const string& value) {
+        if (value.empty())
+            return KeyString::TypeBits();
+        BufReader reader(value.data(), value.size());
+        return KeyString::TypeBits::fromBuffer(&reader);
+    }
+
+    size_t entrySize(const IndexSet::value_type& entry) {
+        return entry.first.size() + entry.second.size();
+    }
 
     // taken from btree_logic.cpp
     Status dupKeyError(const BSONObj& key) {
@@ -80,22 +108,30 @@ namespace {
         return Status(ErrorCodes::DuplicateKey, sb.str());
     }
 
-    bool isDup(const IndexSet& data, const BSONObj& key, RecordId loc) {
-        const IndexSet::const_iterator it = data.find(IndexKeyEntry(key, RecordId()));
-        if (it == data.end())
+    /**
+     * 'keyPrefix' must be the KeyString of the key alone, with no RecordId or discriminator. All
+     * entries for that key start with exactly those bytes.
+     */
+    bool isDup(const IndexSet& data, const KeyString& keyPrefix, RecordId loc) {
+        const string prefix = toIndexSetKey(keyPrefix);
+        const IndexSet::const_iterator it = data.lower_bound(prefix);
+        if (it == data.end() || it->first.compare(0, prefix.size(), prefix) != 0)
             return false;
 
         // Not a dup if the entry is for the same loc.
-        return it->loc != loc;
+        return KeyString::decodeRecordIdAtEnd(it->first.data(), it->first.size()) != loc;
     }
 
     class InMemoryBtreeBuilderImpl : public SortedDataBuilderInterface {
     public:
-        InMemoryBtreeBuilderImpl(IndexSet* data, long long* currentKeySize, bool dupsAllowed)
+        InMemoryBtreeBuilderImpl(IndexSet* data,
+                                 const Ordering& ordering,
+                                 long long* currentKeySize,
+                                 bool dupsAllowed)
                 : _data(data),
+                  _ordering(ordering),
                   _currentKeySize( currentKeySize ),
-                  _dupsAllowed(dupsAllowed),
-                  _comparator(_data->key_comp()) {
+                  _dupsAllowed(dupsAllowed) {
             invariant(_data->empty());
         }
 
@@ -109,44 +145,53 @@ namespace {
             invariant(loc.isNormal());
             invariant(!hasFieldNames(key));
 
+            const KeyString keyPrefix(key, _ordering);
             if (!_data->empty()) {
                 // Compare specified key with last inserted key, ignoring its RecordId
-                int cmp = _comparator.compare(IndexKeyEntry(key, RecordId()), *_last);
-                if (cmp < 0 || (_dupsAllowed && cmp == 0 && loc < _last->loc)) {
+                int cmp = keyPrefix.compare(_lastKey);
+                if (cmp < 0 || (_dupsAllowed && cmp == 0 && loc < _lastLoc)) {
                     return Status(ErrorCodes::InternalError,
                                   "expected ascending (key, RecordId) order in bulk builder");
                 }
-                else if (!_dupsAllowed && cmp == 0 && loc != _last->loc) {
+                else if (!_dupsAllowed && cmp == 0 && loc != _lastLoc) {
                     return dupKeyError(key);
                 }
             }
 
-            BSONObj owned = key.getOwned();
-            _last = _data->insert(_data->end(), IndexKeyEntry(owned, loc));
-            *_currentKeySize += key.objsize();
+            const KeyString data(key, _ordering, loc);
+            IndexSet::iterator it = _data->insert(_data->end(),
+                                                  IndexSet::value_type(
+                                                      toIndexSetKey(data),
+                                                      toIndexSetValue(data.getTypeBits())));
+            *_currentKeySize += entrySize(*it);
+
+            _lastKey.resetFromBuffer(keyPrefix.getBuffer(), keyPrefix.getSize());
+            _lastLoc = loc;
 
             return Status::OK();
         }
 
     private:
         IndexSet* const _data;
+        const Ordering _ordering;
         long long* _currentKeySize;
         const bool _dupsAllowed;
 
-        IndexEntryComparison _comparator;  // used by the bulk builder to detect duplicate keys
-        IndexSet::const_iterator _last;    // or (key, RecordId) ordering violations
+        KeyString _lastKey; // used by the bulk builder to detect duplicate keys
+        RecordId _lastLoc;  // or (key, RecordId) ordering violations
     };
 
     class InMemoryBtreeImpl : public SortedDataInterface {
     public:
-        InMemoryBtreeImpl(IndexSet* data)
-            : _data(data) {
+        InMemoryBtreeImpl(IndexSet* data, const Ordering& ordering)
+            : _data(data),
+              _ordering(ordering) {
             _currentKeySize = 0;
         }
 
         virtual SortedDataBuilderInterface* getBulkBuilder(OperationContext* txn,
                                                            bool dupsAllowed) {
-            return new InMemoryBtreeBuilderImpl(_data, &_currentKeySize, dupsAllowed);
+            return new InMemoryBtreeBuilderImpl(_data, _ordering, &_currentKeySize, dupsAllowed);
         }
 
         virtual Status insert(OperationContext* txn,
@@ -165,12 +210,14 @@ namespace {
             }
 
             // TODO optimization: save the iterator from the dup-check to speed up insert
-            if (!dupsAllowed && isDup(*_data, key, loc))
+            if (!dupsAllowed && isDup(*_data, KeyString(key, _ordering), loc))
                 return dupKeyError(key);
 
-            IndexKeyEntry entry(key.getOwned(), loc);
+            const KeyString data(key, _ordering, loc);
+            const IndexSet::value_type entry(toIndexSetKey(data),
+                                             toIndexSetValue(data.getTypeBits()));
             if ( _data->insert(entry).second ) {
-                _currentKeySize += key.objsize();
+                _currentKeySize += entrySize(entry);
                 txn->recoveryUnit()->registerChange(new IndexChange(_data, entry, true));
             }
             return Status::OK();
@@ -183,11 +230,11 @@ namespace {
             invariant(loc.isNormal());
             invariant(!hasFieldNames(key));
 
-            IndexKeyEntry entry(key.getOwned(), loc);
-            const size_t numDeleted = _data->erase(entry);
-            invariant(numDeleted <= 1);
-            if ( numDeleted == 1 ) {
-                _currentKeySize -= key.objsize();
+            const IndexSet::iterator it = _data->find(toIndexSetKey(KeyString(key, _ordering, loc)));
+            if ( it != _data->end() ) {
+                const IndexSet::value_type entry = *it;
+                _data->erase(it);
+                _currentKeySize -= entrySize(entry);
                 txn->recoveryUnit()->registerChange(new IndexChange(_data, entry, false));
             }
         }
@@ -204,12 +251,12 @@ namespace {
         }
 
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const {
-            return _currentKeySize + ( sizeof(IndexKeyEntry) * _data->size() );
+            return _currentKeySize + ( sizeof(IndexSet::value_type) * _data->size() );
         }
 
         virtual Status dupKeyCheck(OperationContext* txn, const BSONObj& key, const RecordId& loc) {
             invariant(!hasFieldNames(key));
-            if (isDup(*_data, key, loc))
+            if (isDup(*_data, KeyString(key, _ordering), loc))
                 return dupKeyError(key);
             return Status::OK();
         }
@@ -225,9 +272,11 @@ namespace {
 
         class Cursor final : public SortedDataInterface::Cursor {
         public:
-            Cursor(OperationContext* txn, const IndexSet& data, bool isForward)
+            Cursor(OperationContext* txn, const IndexSet& data, const Ordering& ordering,
+                   bool isForward)
                 : _txn(txn),
                   _data(data),
+                  _ordering(ordering),
                   _forward(isForward),
                   _it(data.end())
             {}
@@ -242,8 +291,7 @@ namespace {
                     if (atEndPoint()) _isEOF = true;
                 }
 
-                if (_isEOF) return {};
-                return *_it;
+                return curr(parts);
             }
         
             void setEndPosition(const BSONObj& key, bool inclusive) override {
@@ -253,33 +301,44 @@ namespace {
                     return;
                 }
                 
-                // NOTE: this uses the opposite min/max rules as a normal seek because a forward
-                // scan should land after the key if inclusive and before if exclusive.
-                _endState = EndState(stripFieldNames(key),
-                                     _forward == inclusive ? RecordId::max() : RecordId::min());
+                // NOTE: this uses the opposite rules as a normal seek because a forward scan
+                // should land after the key if inclusive and before if exclusive.
+                const auto discriminator = _forward == inclusive ? KeyString::kExclusiveAfter
+                                                                 : KeyString::kExclusiveBefore;
+                _endState = EndState(toIndexSetKey(KeyString(stripFieldNames(key),
+                                                             _ordering,
+                                                             discriminator)));
                 seekEndCursor();
             }
 
             boost::optional<IndexKeyEntry> seek(const BSONObj& key, bool inclusive,
                                                 RequestedInfo parts) override {
-                const BSONObj query = stripFieldNames(key);
-                locate(query, _forward == inclusive ? RecordId::min() : RecordId::max());
+                const auto discriminator = _forward == inclusive ? KeyString::kExclusiveBefore
+                                                                 : KeyString::kExclusiveAfter;
+                const string query = toIndexSetKey(KeyString(stripFieldNames(key),
+                                                             _ordering,
+                                                             discriminator));
+                locate(query);
                 _lastMoveWasRestore = false;
                 if (_isEOF) return {};
-                dassert(inclusive ? compareKeys(_it->key, query) >= 0
-                                  : compareKeys(_it->key, query) > 0);
-                return *_it;
+                dassert(compareKeys(_it->first, query) > 0);
+                return curr(parts);
             }
 
             boost::optional<IndexKeyEntry> seek(const IndexSeekPoint& seekPoint,
                                                 RequestedInfo parts) override {
                 // Query encodes exclusive case so it can be treated as an inclusive query.
-                const BSONObj query = IndexEntryComparison::makeQueryObject(seekPoint, _forward);
-                locate(query, _forward ? RecordId::min() : RecordId::max());
+                const BSONObj key = IndexEntryComparison::makeQueryObject(seekPoint, _forward);
+
+                // makeQueryObject handles the discriminator in the real exclusive cases.
+                const auto discriminator = _forward ? KeyString::kExclusiveBefore
+                                                    : KeyString::kExclusiveAfter;
+                const string query = toIndexSetKey(KeyString(key, _ordering, discriminator));
+                locate(query);
                 _lastMoveWasRestore = false;
                 if (_isEOF) return {};
-                dassert(compareKeys(_it->key, query) >= 0);
-                return *_it;
+                dassert(compareKeys(_it->first, query) > 0);
+                return curr(parts);
             }
 
             void savePositioned() override {
@@ -293,8 +352,7 @@ namespace {
                 }
 
                 _savedAtEnd = false;
-                _savedKey = _it->key.getOwned();
-                _savedLoc = _it->loc;
+                _savedKey = _it->first;
                 // Doing nothing with end cursor since it will do full reseek on restore.
             }
 
@@ -318,13 +376,28 @@ namespace {
                 }
                 
                 // Need to find our position from the root.
-                locate(_savedKey, _savedLoc);
+                locate(_savedKey);
 
                 _lastMoveWasRestore = _isEOF // We weren't EOF but now are.
-                                   || _data.value_comp().compare(*_it, {_savedKey, _savedLoc}) != 0;
+                                   || _it->first != _savedKey;
             }
 
         private:
+            boost::optional<IndexKeyEntry> curr(RequestedInfo parts) const {
+                if (_isEOF) return {};
+
+                // Only decode the key if it was asked for. The RecordId is cheap to read from the
+                // end of the encoded entry.
+                BSONObj key;
+                if (parts & kWantKey) {
+                    key = KeyString::toBson(_it->first.data(), _it->first.size(), _ordering,
+                                            typeBitsFromIndexSetValue(_it->second));
+                }
+
+                return {{std::move(key),
+                         KeyString::decodeRecordIdAtEnd(_it->first.data(), _it->first.size())}};
+            }
+
             bool atEndPoint() const {
                 return _endState && _it == _endState->it;
             }
@@ -352,7 +425,7 @@ namespace {
                 if (_isEOF) return true;
                 if (!_endState) return false;
                
-                const int cmp = _data.value_comp().compare(*_it, _endState->query);
+                const int cmp = _it->first.compare(_endState->query);
 
                 // We set up _endState->query to be in between the last in-range value and the first
                 // out-of-range value. In particular, it is constructed to never equal any legal
@@ -369,16 +442,15 @@ namespace {
                 }
             }
 
-            void locate(const BSONObj& key, const RecordId& loc) {
+            void locate(const string& query) {
                 _isEOF = false;
-                const auto query = IndexKeyEntry(key, loc);
                 _it = _data.lower_bound(query);
                 if (_forward) {
                     if (_it == _data.end()) _isEOF = true;
                 }
                 else {
                     // lower_bound lands us on or after query. Reverse cursors must be on or before.
-                    if (_it == _data.end() || _data.value_comp().compare(*_it, query) > 0)
+                    if (_it == _data.end() || _it->first > query)
                         advance(); // sets _isEOF if there is nothing more to return.
                 }
 
@@ -387,8 +459,8 @@ namespace {
 
             // Returns comparison relative to direction of scan. If rhs would be seen later, returns
             // a positive value.
-            int compareKeys(const BSONObj& lhs, const BSONObj& rhs) const {
-                int cmp = _data.value_comp().compare({lhs, RecordId()}, {rhs, RecordId()});
+            int compareKeys(const string& lhs, const string& rhs) const {
+                int cmp = lhs.compare(rhs);
                 return _forward ? cmp : -cmp;
             }
 
@@ -398,8 +470,7 @@ namespace {
                 auto it = _data.lower_bound(_endState->query);
                 if (!_forward) {
                     // lower_bound lands us on or after query. Reverse cursors must be on or before.
-                    if (it == _data.end() || _data.value_comp().compare(*it,
-                                                                        _endState->query) > 0) {
+                    if (it == _data.end() || it->first > _endState->query) {
                         if (it == _data.begin()) {
                             it = _data.end(); // all existing data in range.
                         }
@@ -409,20 +480,21 @@ namespace {
                     }
                 }
 
-                if (it != _data.end()) dassert(compareKeys(it->key, _endState->query.key) >= 0);
+                if (it != _data.end()) dassert(compareKeys(it->first, _endState->query) > 0);
                 _endState->it = it;
             }
 
             OperationContext* _txn; // not owned
             const IndexSet& _data;
+            const Ordering _ordering;
             const bool _forward;
             bool _isEOF = true;
             IndexSet::const_iterator _it;
             
             struct EndState {
-                EndState(BSONObj key, RecordId loc) : query(std::move(key), loc) {}
+                explicit EndState(string query) : query(std::move(query)) {}
 
-                IndexKeyEntry query;
+                string query;
                 IndexSet::const_iterator it;
             };
             boost::optional<EndState> _endState;
@@ -432,16 +504,16 @@ namespace {
             // pairs.
             bool _lastMoveWasRestore = false;
 
-            // For save/restore since _it may be invalidated during a yield.
+            // For save/restore since _it may be invalidated during a yield. This is the encoded
+            // (key, RecordId) pair so it identifies a unique position.
             bool _savedAtEnd = false;
-            BSONObj _savedKey;
-            RecordId _savedLoc;
+            string _savedKey;
         };
 
         virtual std::unique_ptr<SortedDataInterface::Cursor> newCursor(
                 OperationContext* txn,
                 bool isForward) const {
-            return stdx::make_unique<Cursor>(txn, *_data, isForward);
+            return stdx::make_unique<Cursor>(txn, *_data, _ordering, isForward);
         }
 
         virtual Status initAsEmpty(OperationContext* txn) {
@@ -452,25 +524,26 @@ namespace {
     private:
         class IndexChange : public RecoveryUnit::Change {
         public:
-            IndexChange(IndexSet* data, const IndexKeyEntry& entry, bool insert)
+            IndexChange(IndexSet* data, const IndexSet::value_type& entry, bool insert)
                 : _data(data), _entry(entry), _insert(insert)
             {}
 
             virtual void commit() {}
             virtual void rollback() {
                 if (_insert)
-                    _data->erase(_entry);
+                    _data->erase(_entry.first);
                 else
                     _data->insert(_entry);
             }
 
         private:
             IndexSet* _data;
-            const IndexKeyEntry _entry;
+            const IndexSet::value_type _entry;
             const bool _insert;
         };
 
         IndexSet* _data;
+        const Ordering _ordering;
         long long _currentKeySize;
     };
 } // namespace
@@ -481,9 +554,9 @@ namespace {
                                               std::shared_ptr<void>* dataInOut) {
         invariant(dataInOut);
         if (!*dataInOut) {
-            *dataInOut = std::make_shared<IndexSet>(IndexEntryComparison(ordering));
+            *dataInOut = std::make_shared<IndexSet>();
         }
-        return new InMemoryBtreeImpl(static_cast<IndexSet*>(dataInOut->get()));
+        return new InMemoryBtreeImpl(static_cast<IndexSet*>(dataInOut->get()), ordering);
     }
 
 }  // namespace mongo
@@ -31,6 +31,7 @@
 #include "mongo/db/storage/in_memory/in_memory_btree_impl.h"
 
 
+#include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/in_memory/in_memory_recovery_unit.h"
 #include "mongo/db/storage/sorted_data_interface_test_harness.h"
 #include "mongo/stdx/memory.h"
@@ -61,4 +62,47 @@ namespace mongo {
         return stdx::make_unique<InMemoryHarnessHelper>();
     }
 
+    // Keys are stored as KeyStrings, so numeric types must survive the round trip through the
+    // TypeBits and descending fields must still iterate in index order.
+    TEST(InMemoryBtreeImpl, PreservesKeyTypesWithDescendingOrdering) {
+        std::shared_ptr<void> data;
+        const std::unique_ptr<SortedDataInterface> sorted(
+            getInMemoryBtreeImpl(Ordering::make(BSON("a" << 1 << "b" << -1)), &data));
+
+        const BSONObj keys[] = {
+            BSON("" << 1 << "" << 2.5),
+            BSON("" << 1.0 << "" << 2LL),
+            BSON("" << 2LL << "" << "x"),
+        };
+
+        {
+            OperationContextNoop txn(new InMemoryRecoveryUnit());
+            WriteUnitOfWork uow(&txn);
+            ASSERT_OK(sorted->insert(&txn, keys[2], loc1, true));
+            ASSERT_OK(sorted->insert(&txn, keys[1], loc2, true));
+            ASSERT_OK(sorted->insert(&txn, keys[0], loc3, true));
+            uow.commit();
+        }
+
+        OperationContextNoop txn(new InMemoryRecoveryUnit());
+        const std::unique_ptr<SortedDataInterface::Cursor> cursor(sorted->newCursor(&txn));
+
+        auto entry = cursor->seek(BSONObj(), true);
+        ASSERT(entry);
+        ASSERT(entry->key.binaryEqual(keys[0]));
+        ASSERT_EQUALS(entry->loc, loc3);
+
+        entry = cursor->next();
+        ASSERT(entry);
+        ASSERT(entry->key.binaryEqual(keys[1]));
+        ASSERT_EQUALS(entry->loc, loc2);
+
+        entry = cursor->next();
+        ASSERT(entry);
+        ASSERT(entry->key.binaryEqual(keys[2]));
+        ASSERT_EQUALS(entry->loc, loc1);
+
+        ASSERT(!cursor->next());
+    }
+
 }
@@ -382,6 +382,40 @@ namespace mongo {
                                        "object to insert exceeds cappedMaxSize");
         }
 
+        StatusWith<RecordId> loc = insertRecordNoCappedDelete(txn, data, len);
+        if (!loc.isOK())
+            return loc;
+
+        cappedDeleteAsNeeded(txn);
+
+        return loc;
+    }
+
+    Status InMemoryRecordStore::insertRecords(OperationContext* txn,
+                                              std::vector<Record>* records,
+                                              bool enforceQuota) {
+        if (_isCapped) {
+            // Each insert may have to delete the oldest records to make room, so they are done
+            // one at a time.
+            return RecordStore::insertRecords(txn, records, enforceQuota);
+        }
+
+        for (auto& record : *records) {
+            StatusWith<RecordId> loc = insertRecordNoCappedDelete(txn,
+                                                                  record.data.data(),
+                                                                  record.data.size());
+            if (!loc.isOK())
+                return loc.getStatus();
+
+            record.id = loc.getValue();
+        }
+
+        return Status::OK();
+    }
+
+    StatusWith<RecordId> InMemoryRecordStore::insertRecordNoCappedDelete(OperationContext* txn,
+                                                                        const char* data,
+                                                                        int len) {
         InMemoryRecord rec(len);
         memcpy(rec.data.get(), data, len);
 
@@ -400,8 +434,6 @@ namespace mongo {
         _data->dataSize += len;
         _data->records[loc] = rec;
 
-        cappedDeleteAsNeeded(txn);
-
         return StatusWith<RecordId>(loc);
     }
 
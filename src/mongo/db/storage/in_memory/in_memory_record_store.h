@@ -69,6 +69,10 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota );
 
+        virtual Status insertRecords( OperationContext* txn,
+                                      std::vector<Record>* records,
+                                      bool enforceQuota );
+
         virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
                                                   const RecordId& oldLocation,
                                                   const char* data,
@@ -163,6 +167,14 @@ namespace mongo {
         StatusWith<RecordId> extractAndCheckLocForOplog(const char* data, int len) const;
 
         RecordId allocateLoc();
+
+        /**
+         * Inserts without checking the capped size limits or performing capped deletes.
+         */
+        StatusWith<RecordId> insertRecordNoCappedDelete(OperationContext* txn,
+                                                       const char* data,
+                                                       int len);
+
         bool cappedAndNeedDelete(OperationContext* txn) const;
         void cappedDeleteAsNeeded(OperationContext* txn);
 
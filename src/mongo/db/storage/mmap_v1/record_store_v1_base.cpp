@@ -312,6 +312,10 @@ namespace mongo {
 
         _details->incrementStats( txn, r->netLength(), 1 );
 
+        if ( _rangeSummary ) {
+            _rangeSummary->recordInserted( txn, loc.getValue().toRecordId(), BSONObj( r->data() ) );
+        }
+
         return StatusWith<RecordId>(loc.getValue().toRecordId());
     }
 
@@ -331,10 +335,74 @@ namespace mongo {
         return _insertRecord( txn, data, len, enforceQuota );
     }
 
+    Status RecordStoreV1Base::insertRecords( OperationContext* txn,
+                                             std::vector<Record>* records,
+                                             bool enforceQuota ) {
+        if ( isCapped() ) {
+            // Capped allocation consults the collection stats to decide what to delete, so they
+            // have to be kept current after every record.
+            return RecordStore::insertRecords( txn, records, enforceQuota );
+        }
+
+        for ( const auto& record : *records ) {
+            if ( record.data.size() < 4 ) {
+                return Status( ErrorCodes::InvalidLength, "record has to be >= 4 bytes" );
+            }
+
+            if ( record.data.size() + MmapV1RecordHeader::HeaderSize > MaxAllowedAllocation ) {
+                return Status( ErrorCodes::InvalidLength, "record has to be <= 16.5MB" );
+            }
+        }
+
+        // The collection stats are journaled on every change, so accumulate them over the
+        // whole batch and declare the write intent once.
+        long long dataSizeIncrement = 0;
+        long long numRecordsIncrement = 0;
+
+        Status status = Status::OK();
+        for ( auto& record : *records ) {
+            int netLength;
+            StatusWith<RecordId> loc = _writeRecord( txn,
+                                                     record.data.data(),
+                                                     record.data.size(),
+                                                     enforceQuota,
+                                                     &netLength );
+            if ( !loc.isOK() ) {
+                status = loc.getStatus();
+                break;
+            }
+
+            record.id = loc.getValue();
+            dataSizeIncrement += netLength;
+            numRecordsIncrement++;
+        }
+
+        if ( numRecordsIncrement ) {
+            _details->incrementStats( txn, dataSizeIncrement, numRecordsIncrement );
+        }
+
+        return status;
+    }
+
     StatusWith<RecordId> RecordStoreV1Base::_insertRecord( OperationContext* txn,
                                                           const char* data,
                                                           int len,
                                                           bool enforceQuota ) {
+        int netLength;
+        StatusWith<RecordId> loc = _writeRecord( txn, data, len, enforceQuota, &netLength );
+        if ( !loc.isOK() )
+            return loc;
+
+        _details->incrementStats( txn, netLength, 1 );
+
+        return loc;
+    }
+
+    StatusWith<RecordId> RecordStoreV1Base::_writeRecord( OperationContext* txn,
+                                                         const char* data,
+                                                         int len,
+                                                         bool enforceQuota,
+                                                         int* netLength ) {
 
         const int lenWHdr = len + MmapV1RecordHeader::HeaderSize;
         const int lenToAlloc = shouldPadInserts() ? quantizeAllocationSpace(lenWHdr)
@@ -354,7 +422,11 @@ namespace mongo {
 
         _addRecordToRecListInExtent(txn, r, loc.getValue());
 
-        _details->incrementStats( txn, r->netLength(), 1 );
+        *netLength = r->netLength();
+
+        if ( _rangeSummary ) {
+            _rangeSummary->recordInserted( txn, loc.getValue().toRecordId(), BSONObj( data ) );
+        }
 
         return StatusWith<RecordId>(loc.getValue().toRecordId());
     }
@@ -377,6 +449,10 @@ namespace mongo {
 
             // we fit
             memcpy( txn->recoveryUnit()->writingPtr( oldRecord->data(), dataSize ), data, dataSize );
+
+            if ( _rangeSummary ) {
+                _rangeSummary->recordUpdated( oldLocation, BSONObj( data ) );
+            }
             return StatusWith<RecordId>( oldLocation );
         }
 
@@ -430,6 +506,10 @@ namespace mongo {
             std::memcpy(targetPtr, sourcePtr, where->size);
         }
 
+        if ( _rangeSummary ) {
+            _rangeSummary->recordUpdated( loc, BSONObj( root ) );
+        }
+
         return Status::OK();
     }
 
@@ -439,6 +519,10 @@ namespace mongo {
         MmapV1RecordHeader* todelete = recordFor( dl );
         invariant( todelete->netLength() >= 4 ); // this is required for defensive code
 
+        if ( _rangeSummary ) {
+            _rangeSummary->recordDeleted( rid );
+        }
+
         /* remove ourself from the record next/prev chain */
         {
             if ( todelete->prevOfs() != DiskLoc::NullOfs ) {
@@ -30,10 +30,13 @@
 
 #pragma once
 
+#include <memory>
+
 #include "mongo/util/concurrency/spin_lock.h"
 #include "mongo/platform/unordered_set.h"
 
 #include "mongo/db/storage/mmap_v1/diskloc.h"
+#include "mongo/db/storage/record_range_summary.h"
 #include "mongo/db/storage/record_store.h"
 
 namespace mongo {
@@ -197,6 +200,10 @@ namespace mongo {
                                            const DocWriter* doc,
                                            bool enforceQuota );
 
+        Status insertRecords( OperationContext* txn,
+                              std::vector<Record>* records,
+                              bool enforceQuota );
+
         virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
                                                    const RecordId& oldLocation,
                                                    const char* data,
@@ -227,6 +234,8 @@ namespace mongo {
 
         virtual Status touch( OperationContext* txn, BSONObjBuilder* output ) const;
 
+        virtual const RecordRangeSummary* rangeSummary() const { return _rangeSummary.get(); }
+
         const RecordStoreV1MetaData* details() const { return _details.get(); }
 
         // This keeps track of cursors saved during yielding, for invalidation purposes.
@@ -306,10 +315,23 @@ namespace mongo {
                                             int len,
                                             bool enforceQuota );
 
+        /**
+         * Same as _insertRecord, but leaves updating the collection stats to the caller.
+         * 'netLength' is set to the amount the data size stat should be incremented by.
+         */
+        StatusWith<RecordId> _writeRecord( OperationContext* txn,
+                                           const char* data,
+                                           int len,
+                                           bool enforceQuota,
+                                           int* netLength );
+
         std::unique_ptr<RecordStoreV1MetaData> _details;
         ExtentManager* _extentManager;
         bool _isSystemIndexes;
 
+        // Set by record stores which scan records in insertion order.
+        std::unique_ptr<RecordRangeSummary> _rangeSummary;
+
         friend class RecordStoreV1RepairCursor;
     };
 
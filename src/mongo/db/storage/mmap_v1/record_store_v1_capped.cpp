@@ -254,6 +254,10 @@ namespace mongo {
             addDeletedRec( txn, _findFirstSpot( txn, extLoc, ext ) );
         }
 
+        if ( _rangeSummary ) {
+            _rangeSummary->clear();
+        }
+
         return Status::OK();
     }
 
@@ -659,6 +663,13 @@ namespace mongo {
         return cursors;
     }
 
+    void CappedRecordStoreV1::enableRangeSummary(StringData fieldName) {
+        if ( !_rangeSummary ) {
+            // DiskLocs are reused, but a capped collection is scanned in insertion order.
+            _rangeSummary.reset( new RecordRangeSummary( fieldName, /*idsIncrease=*/false ) );
+        }
+    }
+
     void CappedRecordStoreV1::_maybeComplain( OperationContext* txn, int len ) const {
         RARELY {
             std::stringstream buf;
@@ -67,6 +67,8 @@ namespace mongo {
         std::vector<std::unique_ptr<RecordCursor>> getManyCursors(
             OperationContext* txn) const final;
 
+        void enableRangeSummary(StringData fieldName) final;
+
         // Start from firstExtent by default.
         DiskLoc firstRecord( OperationContext* txn,
                              const DiskLoc &startExtent = DiskLoc() ) const;
@@ -0,0 +1,239 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/record_range_summary.h"
+
+#include <algorithm>
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/recovery_unit.h"
+
+namespace mongo {
+
+    namespace {
+
+        bool firstAfter(const RecordId& id, const RecordRangeSummary::Range& range) {
+            return id < range.first;
+        }
+
+    }  // namespace
+
+    /**
+     * A rolled back insert leaves a RecordId which scans can't seek to.
+     */
+    class RecordRangeSummary::InsertChange : public RecoveryUnit::Change {
+    public:
+        InsertChange(RecordRangeSummary* summary, const RecordId& id)
+            : _summary(summary),
+              _id(id) {
+        }
+
+        virtual void commit() { }
+        virtual void rollback() { _summary->recordDeleted(_id); }
+
+    private:
+        RecordRangeSummary* const _summary;
+        const RecordId _id;
+    };
+
+    RecordRangeSummary::RecordRangeSummary(StringData fieldName,
+                                           bool idsIncrease,
+                                           long long recordsPerRange)
+        : _fieldName(fieldName.toString()),
+          _idsIncrease(idsIncrease),
+          _recordsPerRange(recordsPerRange),
+          _frontSeq(0) {
+        invariant(_recordsPerRange > 0);
+    }
+
+    void RecordRangeSummary::recordInserted(OperationContext* txn,
+                                            const RecordId& id,
+                                            const BSONObj& doc) {
+        const BSONObj value = summarize(doc);
+
+        // The summary is widened before the insert commits, so that no scan which can see the
+        // record finds a range which leaves it out.
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            insert_inlock(id, value);
+        }
+        txn->recoveryUnit()->registerChange(new InsertChange(this, id));
+    }
+
+    void RecordRangeSummary::recordUpdated(const RecordId& id, const BSONObj& doc) {
+        const BSONObj value = summarize(doc);
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_idsIncrease) {
+            _ranges.clear();
+            _byFirst.clear();
+            _byLast.clear();
+            return;
+        }
+
+        if (Range* range = rangeFor_inlock(id)) {
+            widen(range, value);
+        }
+    }
+
+    void RecordRangeSummary::recordDeleted(const RecordId& id) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        forget_inlock(id);
+    }
+
+    void RecordRangeSummary::clear() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _ranges.clear();
+        _byFirst.clear();
+        _byLast.clear();
+    }
+
+    bool RecordRangeSummary::findRange(const RecordId& id, bool forward, Range* out) const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        const RangeIndex& index = forward ? _byFirst : _byLast;
+        RangeIndex::const_iterator it = index.find(id);
+        if (index.end() == it) {
+            return false;
+        }
+
+        const Range& range = _ranges[it->second - _frontSeq];
+        if (!range.closed || range.dead) {
+            return false;
+        }
+
+        *out = range;
+        return true;
+    }
+
+    BSONObj RecordRangeSummary::summarize(const BSONObj& doc) const {
+        BSONElement elt = doc[_fieldName];
+        BSONObjBuilder bob;
+        if (elt.eoo() || Undefined == elt.type()) {
+            // Equality to null matches both.
+            bob.appendNull("");
+        }
+        else {
+            bob.appendAs(elt, "");
+        }
+        return bob.obj();
+    }
+
+    void RecordRangeSummary::insert_inlock(const RecordId& id, const BSONObj& value) {
+        if (!_idsIncrease) {
+            // The RecordId may be reused from a record which started or ended a range.
+            forget_inlock(id);
+            append_inlock(id, value);
+            return;
+        }
+
+        if (_ranges.empty() || _ranges.back().last < id) {
+            append_inlock(id, value);
+            return;
+        }
+
+        // An insert which got its RecordId before the last one summarized.  If it doesn't fall
+        // inside a range, scans read it anyway.
+        if (Range* range = rangeFor_inlock(id)) {
+            ++range->records;
+            widen(range, value);
+        }
+    }
+
+    void RecordRangeSummary::append_inlock(const RecordId& id, const BSONObj& value) {
+        if (_ranges.empty() || _ranges.back().closed) {
+            _ranges.push_back(Range());
+            _ranges.back().first = id;
+            _byFirst[id] = _frontSeq + _ranges.size() - 1;
+        }
+
+        Range& range = _ranges.back();
+        range.last = id;
+        ++range.records;
+        widen(&range, value);
+
+        if (range.records >= _recordsPerRange) {
+            range.closed = true;
+            _byLast[id] = _frontSeq + _ranges.size() - 1;
+        }
+    }
+
+    // static
+    void RecordRangeSummary::widen(Range* range, const BSONObj& value) {
+        BSONElement elt = value.firstElement();
+        if (Array == elt.type()) {
+            // An array matches a bound if any of its elements does.
+            range->hasArray = true;
+            return;
+        }
+
+        if (range->min.isEmpty() || elt.woCompare(range->min.firstElement(), false) < 0) {
+            range->min = value;
+        }
+        if (range->max.isEmpty() || elt.woCompare(range->max.firstElement(), false) > 0) {
+            range->max = value;
+        }
+    }
+
+    RecordRangeSummary::Range* RecordRangeSummary::rangeFor_inlock(const RecordId& id) {
+        std::deque<Range>::iterator it = std::upper_bound(_ranges.begin(), _ranges.end(), id,
+                                                          firstAfter);
+        if (_ranges.begin() == it) {
+            return NULL;
+        }
+
+        --it;
+        return id <= it->last ? &*it : NULL;
+    }
+
+    void RecordRangeSummary::forget_inlock(const RecordId& id) {
+        const RangeIndex* indexes[] = {&_byFirst, &_byLast};
+        for (size_t i = 0; i < 2; ++i) {
+            RangeIndex::const_iterator it = indexes[i]->find(id);
+            if (indexes[i]->end() == it) {
+                continue;
+            }
+
+            Range& range = _ranges[it->second - _frontSeq];
+            range.closed = true;
+            range.dead = true;
+            _byFirst.erase(range.first);
+            _byLast.erase(range.last);
+        }
+
+        // Capped collections delete their oldest records, so this keeps the summary from growing
+        // past the collection.
+        while (!_ranges.empty() && _ranges.front().dead) {
+            _ranges.pop_front();
+            ++_frontSeq;
+        }
+    }
+
+}  // namespace mongo
@@ -0,0 +1,155 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+
+    class OperationContext;
+
+    /**
+     * Keeps the smallest and largest value of one top-level field over each run of consecutive
+     * records in a record store which is scanned in insertion order, such as a capped collection.
+     * A collection scan whose filter bounds that field can step from the first record of a range
+     * to its last without reading the ones in between when no value in the range can match.
+     *
+     * The summary is in memory only and covers the records inserted since it was created. Every
+     * value a range holds is between its min and max, though min and max may be wider than the
+     * values which remain.  A range which holds an array is never skipped.
+     *
+     * Thread safe.
+     */
+    class RecordRangeSummary {
+        MONGO_DISALLOW_COPYING(RecordRangeSummary);
+    public:
+        static const long long kDefaultRecordsPerRange = 1024;
+
+        struct Range {
+            Range() : records(0), hasArray(false), closed(false), dead(false) { }
+
+            // The first and last record of the range in insertion order.
+            RecordId first;
+            RecordId last;
+            long long records;
+
+            // Single element objects holding the smallest and largest value.  A missing field
+            // counts as null.
+            BSONObj min;
+            BSONObj max;
+            bool hasArray;
+
+            // A closed range gets no more inserts at its end.
+            bool closed;
+
+            // A range whose first or last record is gone can't be skipped.
+            bool dead;
+        };
+
+        /**
+         * When 'idsIncrease' is true, RecordIds are handed out in increasing order but inserts may
+         * commit in any order.  Otherwise inserts must commit in the order they are scanned in.
+         */
+        RecordRangeSummary(StringData fieldName,
+                           bool idsIncrease,
+                           long long recordsPerRange = kDefaultRecordsPerRange);
+
+        const std::string& fieldName() const { return _fieldName; }
+
+        /**
+         * Adds 'doc' to the summary once the insert it belongs to commits.
+         */
+        void recordInserted(OperationContext* txn, const RecordId& id, const BSONObj& doc);
+
+        /**
+         * Widens the range holding 'id' to the new contents of the record.  Without increasing
+         * RecordIds the range can't be found, so the summary starts over.
+         */
+        void recordUpdated(const RecordId& id, const BSONObj& doc);
+
+        void recordDeleted(const RecordId& id);
+
+        void clear();
+
+        /**
+         * Finds the closed range which a scan enters at 'id': the range whose first record is 'id'
+         * when 'forward' is true, or whose last record is 'id' otherwise.  Returns false if there
+         * is none.
+         */
+        bool findRange(const RecordId& id, bool forward, Range* out) const;
+
+    private:
+        typedef unordered_map<RecordId, long long, RecordId::Hasher> RangeIndex;
+
+        /**
+         * Returns the value which the summary keeps for 'doc'.
+         */
+        BSONObj summarize(const BSONObj& doc) const;
+
+        void insert_inlock(const RecordId& id, const BSONObj& value);
+        void append_inlock(const RecordId& id, const BSONObj& value);
+        static void widen(Range* range, const BSONObj& value);
+
+        /**
+         * Returns the range holding 'id', or NULL.  Only meaningful with increasing RecordIds.
+         */
+        Range* rangeFor_inlock(const RecordId& id);
+
+        /**
+         * Marks the range which starts or ends at 'id' as dead.
+         */
+        void forget_inlock(const RecordId& id);
+
+        class InsertChange;
+
+        const std::string _fieldName;
+        const bool _idsIncrease;
+        const long long _recordsPerRange;
+
+        mutable stdx::mutex _mutex;
+
+        // Ranges in insertion order.  The range at _ranges[i] has sequence number _frontSeq + i.
+        std::deque<Range> _ranges;
+        long long _frontSeq;
+
+        // Sequence numbers of the live ranges by their first and, once closed, last RecordId.
+        RangeIndex _byFirst;
+        RangeIndex _byLast;
+    };
+
+}  // namespace mongo
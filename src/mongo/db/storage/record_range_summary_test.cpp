@@ -0,0 +1,195 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/record_range_summary.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using namespace mongo;
+
+    void insert(OperationContext* txn, RecordRangeSummary* summary, int id, const BSONObj& doc) {
+        WriteUnitOfWork wuow(txn);
+        summary->recordInserted(txn, RecordId(id), doc);
+        wuow.commit();
+    }
+
+    void insertRange(OperationContext* txn, RecordRangeSummary* summary, int firstId, int lastId) {
+        for (int id = firstId; id <= lastId; ++id) {
+            insert(txn, summary, id, BSON("ts" << id * 10));
+        }
+    }
+
+    TEST(RecordRangeSummaryTest, ClosedRangesAreFound) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", true, 3);
+        insertRange(&txn, &summary, 1, 7);
+
+        RecordRangeSummary::Range range;
+        ASSERT_TRUE(summary.findRange(RecordId(1), true, &range));
+        ASSERT_EQUALS(RecordId(1), range.first);
+        ASSERT_EQUALS(RecordId(3), range.last);
+        ASSERT_EQUALS(3, range.records);
+        ASSERT_EQUALS(BSON("" << 10), range.min);
+        ASSERT_EQUALS(BSON("" << 30), range.max);
+        ASSERT_FALSE(range.hasArray);
+
+        ASSERT_TRUE(summary.findRange(RecordId(6), false, &range));
+        ASSERT_EQUALS(RecordId(4), range.first);
+        ASSERT_EQUALS(BSON("" << 40), range.min);
+        ASSERT_EQUALS(BSON("" << 60), range.max);
+
+        // Only the first record of a range leads into it.
+        ASSERT_FALSE(summary.findRange(RecordId(2), true, &range));
+        ASSERT_FALSE(summary.findRange(RecordId(4), false, &range));
+
+        // The last range is still open.
+        ASSERT_FALSE(summary.findRange(RecordId(7), true, &range));
+    }
+
+    TEST(RecordRangeSummaryTest, LateInsertWidensItsRange) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", true, 3);
+        insert(&txn, &summary, 1, BSON("ts" << 10));
+        insert(&txn, &summary, 2, BSON("ts" << 20));
+        insert(&txn, &summary, 4, BSON("ts" << 40));
+        insert(&txn, &summary, 3, BSON("ts" << 100));
+
+        RecordRangeSummary::Range range;
+        ASSERT_TRUE(summary.findRange(RecordId(1), true, &range));
+        ASSERT_EQUALS(RecordId(4), range.last);
+        ASSERT_EQUALS(4, range.records);
+        ASSERT_EQUALS(BSON("" << 100), range.max);
+    }
+
+    TEST(RecordRangeSummaryTest, MissingFieldCountsAsNullAndArraysAreFlagged) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", true, 2);
+        insert(&txn, &summary, 1, BSON("other" << 1));
+        insert(&txn, &summary, 2, BSON("ts" << 5));
+        insert(&txn, &summary, 3, BSON("ts" << BSON_ARRAY(1 << 2)));
+        insert(&txn, &summary, 4, BSON("ts" << 5));
+
+        RecordRangeSummary::Range range;
+        ASSERT_TRUE(summary.findRange(RecordId(1), true, &range));
+        ASSERT_EQUALS(jstNULL, range.min.firstElement().type());
+        ASSERT_EQUALS(BSON("" << 5), range.max);
+        ASSERT_FALSE(range.hasArray);
+
+        ASSERT_TRUE(summary.findRange(RecordId(3), true, &range));
+        ASSERT_TRUE(range.hasArray);
+    }
+
+    TEST(RecordRangeSummaryTest, UpdateWidensRange) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", true, 3);
+        insertRange(&txn, &summary, 1, 3);
+        summary.recordUpdated(RecordId(2), BSON("ts" << -1));
+
+        RecordRangeSummary::Range range;
+        ASSERT_TRUE(summary.findRange(RecordId(1), true, &range));
+        ASSERT_EQUALS(BSON("" << -1), range.min);
+        ASSERT_EQUALS(BSON("" << 30), range.max);
+    }
+
+    TEST(RecordRangeSummaryTest, UpdateWithoutIncreasingIdsStartsOver) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", false, 3);
+        insertRange(&txn, &summary, 1, 3);
+        summary.recordUpdated(RecordId(2), BSON("ts" << -1));
+
+        RecordRangeSummary::Range range;
+        ASSERT_FALSE(summary.findRange(RecordId(1), true, &range));
+    }
+
+    TEST(RecordRangeSummaryTest, DeletingAnEndDropsRange) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", true, 3);
+        insertRange(&txn, &summary, 1, 6);
+        summary.recordDeleted(RecordId(1));
+
+        RecordRangeSummary::Range range;
+        ASSERT_FALSE(summary.findRange(RecordId(1), true, &range));
+        ASSERT_FALSE(summary.findRange(RecordId(3), false, &range));
+        ASSERT_TRUE(summary.findRange(RecordId(4), true, &range));
+
+        // A record deleted from the middle of a range leaves it alone.
+        summary.recordDeleted(RecordId(5));
+        ASSERT_TRUE(summary.findRange(RecordId(4), true, &range));
+    }
+
+    TEST(RecordRangeSummaryTest, RolledBackInsertDropsRange) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", true, 3);
+        insertRange(&txn, &summary, 1, 2);
+        {
+            WriteUnitOfWork wuow(&txn);
+            summary.recordInserted(&txn, RecordId(3), BSON("ts" << 30));
+        }
+
+        insertRange(&txn, &summary, 4, 6);
+
+        RecordRangeSummary::Range range;
+        ASSERT_FALSE(summary.findRange(RecordId(1), true, &range));
+        ASSERT_TRUE(summary.findRange(RecordId(4), true, &range));
+    }
+
+    TEST(RecordRangeSummaryTest, ReusedIdDropsRange) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", false, 3);
+        insertRange(&txn, &summary, 7, 9);
+        insertRange(&txn, &summary, 1, 3);
+
+        // Reusing the space of the first record of a range, without deleting it first.
+        insert(&txn, &summary, 7, BSON("ts" << 1000));
+
+        RecordRangeSummary::Range range;
+        ASSERT_FALSE(summary.findRange(RecordId(7), true, &range));
+        ASSERT_FALSE(summary.findRange(RecordId(9), false, &range));
+        ASSERT_TRUE(summary.findRange(RecordId(1), true, &range));
+    }
+
+    TEST(RecordRangeSummaryTest, Clear) {
+        OperationContextNoop txn;
+        RecordRangeSummary summary("ts", true, 3);
+        insertRange(&txn, &summary, 1, 3);
+        summary.clear();
+
+        RecordRangeSummary::Range range;
+        ASSERT_FALSE(summary.findRange(RecordId(1), true, &range));
+        insertRange(&txn, &summary, 4, 6);
+        ASSERT_TRUE(summary.findRange(RecordId(4), true, &range));
+    }
+
+}  // namespace
@@ -50,6 +50,7 @@ namespace mongo {
     class NamespaceDetails;
     class OperationContext;
     class RecordFetcher;
+    class RecordRangeSummary;
 
     class RecordStoreCompactAdaptor;
     class RecordStore;
@@ -316,6 +317,32 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota ) = 0;
 
+        /**
+         * Inserts every Record in 'records', filling in each Record's id with the location it
+         * was stored at. Only the 'data' member of each Record is read.
+         *
+         * Equivalent to calling insertRecord() for each Record in order, stopping at the first
+         * failure. On failure some of the records may already have been inserted, so callers
+         * must abandon the enclosing WriteUnitOfWork. Implementations should override this to
+         * amortize per-call work (cursor positioning, size accounting, capped deletes) across
+         * the whole batch.
+         */
+        virtual Status insertRecords( OperationContext* txn,
+                                      std::vector<Record>* records,
+                                      bool enforceQuota ) {
+            for ( auto& record : *records ) {
+                StatusWith<RecordId> res = insertRecord( txn,
+                                                         record.data.data(),
+                                                         record.data.size(),
+                                                         enforceQuota );
+                if ( !res.isOK() )
+                    return res.getStatus();
+
+                record.id = res.getValue();
+            }
+            return Status::OK();
+        }
+
         /**
          * @param notifier - Only used by record stores which do not support doc-locking.
          *                   In the case of a document move, this is called after the document
@@ -480,6 +507,18 @@ namespace mongo {
             return boost::none;
         }
 
+        /**
+         * Starts keeping a RecordRangeSummary of the top-level field 'fieldName', which collection
+         * scans use to step over ranges of records that can't match.  Only record stores which
+         * scan records in insertion order keep one; the default implementation does nothing.
+         */
+        virtual void enableRangeSummary(StringData fieldName) { }
+
+        /**
+         * Returns the summary started by enableRangeSummary(), or NULL if there is none.
+         */
+        virtual const RecordRangeSummary* rangeSummary() const { return NULL; }
+
         /**
          * When we write to an oplog, we call this so that if the storage engine
          * supports doc locking, it can manage the visibility of oplog entries to ensure
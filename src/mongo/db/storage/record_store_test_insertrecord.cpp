@@ -113,6 +113,47 @@ namespace mongo {
         }
     }
 
+    // Insert multiple records with a single call to insertRecords and verify that each
+    // record can be found at the location it was assigned.
+    TEST( RecordStoreTestHarness, InsertRecordsBatch ) {
+        unique_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        unique_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
+
+        const int nToInsert = 10;
+        std::vector<string> datas;
+        for ( int i = 0; i < nToInsert; i++ ) {
+            stringstream ss;
+            ss << "record " << i;
+            datas.push_back( ss.str() );
+        }
+
+        std::vector<Record> records;
+        for ( int i = 0; i < nToInsert; i++ ) {
+            records.push_back( Record{ RecordId(),
+                                       RecordData( datas[i].c_str(), datas[i].size() + 1 ) } );
+        }
+
+        {
+            unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                ASSERT_OK( rs->insertRecords( opCtx.get(), &records, false ) );
+                uow.commit();
+            }
+        }
+
+        {
+            unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            ASSERT_EQUALS( nToInsert, rs->numRecords( opCtx.get() ) );
+
+            for ( int i = 0; i < nToInsert; i++ ) {
+                ASSERT( !records[i].id.isNull() );
+                RecordData record = rs->dataFor( opCtx.get(), records[i].id );
+                ASSERT_EQUALS( datas[i], string( record.data() ) );
+            }
+        }
+    }
+
     // Insert a record using a DocWriter and verify the number of entries
     // in the collection is 1.
     TEST( RecordStoreTestHarness, InsertRecordUsingDocWriter ) {
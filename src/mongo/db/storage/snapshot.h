@@ -49,6 +49,8 @@ namespace mongo {
 
         bool isNull() const { return _id == kNullId; }
 
+        uint64_t toNumber() const { return _id; }
+
         bool operator==(const SnapshotId& other) const {
             return _id == other._id;
         }
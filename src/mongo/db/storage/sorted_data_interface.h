@@ -29,6 +29,7 @@
 #include <boost/optional/optional.hpp>
 #include <boost/optional/optional_io.hpp>
 #include <memory>
+#include <vector>
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
@@ -100,6 +101,35 @@ namespace mongo {
                               const RecordId& loc,
                               bool dupsAllowed) = 0;
 
+        /**
+         * Insert each of the entries in the range [begin, end) into the index.
+         *
+         * Equivalent to calling insert() for each entry in order, stopping at the first failure.
+         * Implementations may override this to reuse a single cursor across the whole range.
+         *
+         * @param numInserted set to the number of leading entries of the range which were
+         *        inserted. On failure, the entry at 'begin + *numInserted' is the one which
+         *        could not be inserted.
+         *
+         * @return Status::OK() if every entry was inserted, otherwise the status returned by
+         *         insert() for the first entry which failed
+         */
+        virtual Status insertKeys(OperationContext* txn,
+                                  std::vector<IndexKeyEntry>::const_iterator begin,
+                                  std::vector<IndexKeyEntry>::const_iterator end,
+                                  bool dupsAllowed,
+                                  size_t* numInserted) {
+            *numInserted = 0;
+            for (auto it = begin; it != end; ++it) {
+                Status status = insert(txn, it->key, it->loc, dupsAllowed);
+                if (!status.isOK())
+                    return status;
+
+                ++*numInserted;
+            }
+            return Status::OK();
+        }
+
         /**
          * Remove the entry from the index with the specified key and RecordId.
          *
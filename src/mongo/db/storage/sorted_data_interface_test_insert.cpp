@@ -315,6 +315,78 @@ namespace {
         }
     }
 
+    // Insert multiple keys with a single call to insertKeys and verify that the number of
+    // entries in the index equals the number that were inserted.
+    TEST( SortedDataInterface, InsertKeysBatch ) {
+        const std::unique_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        const std::unique_ptr<SortedDataInterface> sorted( harnessHelper->newSortedDataInterface( true ) );
+
+        std::vector<IndexKeyEntry> entries;
+        entries.push_back( IndexKeyEntry( key1, loc1 ) );
+        entries.push_back( IndexKeyEntry( key2, loc2 ) );
+        entries.push_back( IndexKeyEntry( key3, loc3 ) );
+
+        {
+            const std::unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                size_t numInserted = 0;
+                ASSERT_OK( sorted->insertKeys( opCtx.get(),
+                                               entries.begin(),
+                                               entries.end(),
+                                               false,
+                                               &numInserted ) );
+                ASSERT_EQUALS( 3U, numInserted );
+                uow.commit();
+            }
+        }
+
+        {
+            const std::unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            ASSERT_EQUALS( 3, sorted->numEntries( opCtx.get() ) );
+        }
+    }
+
+    // Insert a batch containing a duplicate of an existing key into a unique index and verify
+    // that insertKeys reports the position of the failing entry.
+    TEST( SortedDataInterface, InsertKeysBatchStopsAtDuplicate ) {
+        const std::unique_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        const std::unique_ptr<SortedDataInterface> sorted( harnessHelper->newSortedDataInterface( true ) );
+
+        {
+            const std::unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                ASSERT_OK( sorted->insert( opCtx.get(), key2, loc2, false ) );
+                uow.commit();
+            }
+        }
+
+        std::vector<IndexKeyEntry> entries;
+        entries.push_back( IndexKeyEntry( key1, loc1 ) );
+        entries.push_back( IndexKeyEntry( key2, loc3 ) );
+        entries.push_back( IndexKeyEntry( key3, loc4 ) );
+
+        {
+            const std::unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                size_t numInserted = 0;
+                ASSERT_NOT_OK( sorted->insertKeys( opCtx.get(),
+                                                   entries.begin(),
+                                                   entries.end(),
+                                                   false,
+                                                   &numInserted ) );
+                ASSERT_EQUALS( 1U, numInserted );
+            }
+        }
+
+        {
+            const std::unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            ASSERT_EQUALS( 1, sorted->numEntries( opCtx.get() ) );
+        }
+    }
+
     // Insert multiple compound keys and verify that the number of entries
     // in the index equals the number that were inserted.
     TEST( SortedDataInterface, InsertMultipleCompoundKeys ) {
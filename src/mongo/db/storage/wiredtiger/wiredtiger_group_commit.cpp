@@ -0,0 +1,183 @@
+// wiredtiger_group_commit.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_group_commit.h"
+
+#include <algorithm>
+#include <string>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    namespace {
+        // How long a group commit leader waits for more callers to join before flushing. Zero
+        // only batches callers that arrive while the previous flush is running.
+        MONGO_EXPORT_SERVER_PARAMETER(wiredTigerGroupCommitWindowMicros, int, 0);
+    }
+
+    const char WiredTigerGroupCommit::kFlushTableIdent[] = "groupCommitFlush";
+
+    WiredTigerGroupCommit::WiredTigerGroupCommit(WT_CONNECTION* conn, bool journaled)
+        : _conn(conn),
+          _journaled(journaled) {
+    }
+
+    void WiredTigerGroupCommit::waitUntilDurable(WT_SESSION* session) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+
+        const uint64_t ticket = ++_lastTicket;
+        if (session) {
+            _pendingSessions.push_back(session);
+        }
+        else {
+            _pendingNeedsLogFlush = true;
+        }
+
+        while (_flushedThrough < ticket) {
+            if (_flushInProgress) {
+                _flushDone.wait(lk);
+                continue;
+            }
+
+            // Nobody is flushing, so lead the next batch.
+            _flushInProgress = true;
+
+            const int windowMicros = wiredTigerGroupCommitWindowMicros;
+            if (windowMicros > 0) {
+                lk.unlock();
+                sleepmicros(windowMicros);
+                lk.lock();
+            }
+
+            // Everything committed by the waiters holding these tickets happened before the flush
+            // starts, so the flush covers all of them.
+            const uint64_t batchEnd = _lastTicket;
+            const uint64_t batchSize = batchEnd - _flushedThrough;
+            std::vector<WT_SESSION*> sessions;
+            sessions.swap(_pendingSessions);
+            const bool needLogFlush = _pendingNeedsLogFlush;
+            _pendingNeedsLogFlush = false;
+
+            lk.unlock();
+            Timer timer;
+            _flush(sessions, needLogFlush);
+            const uint64_t micros = timer.micros();
+            lk.lock();
+
+            _flushedThrough = batchEnd;
+            _flushInProgress = false;
+
+            _flushes++;
+            if (!_journaled)
+                _checkpointFlushes++;
+            else if (needLogFlush)
+                _logFlushes++;
+            _waitersFlushed += batchSize;
+            _maxBatchSize = std::max(_maxBatchSize, batchSize);
+            _totalFlushMicros += micros;
+            _maxFlushMicros = std::max(_maxFlushMicros, micros);
+
+            _flushDone.notify_all();
+        }
+    }
+
+    void WiredTigerGroupCommit::_flush(const std::vector<WT_SESSION*>& sessions,
+                                       bool needLogFlush) {
+        if (!_journaled) {
+            WiredTigerSession session(_conn);
+            WT_SESSION* s = session.getSession();
+            invariantWTOK(s->checkpoint(s, NULL));
+            return;
+        }
+
+        if (needLogFlush) {
+            // Syncing the whole journal also covers the sessions.
+            _flushLog();
+            return;
+        }
+
+        // Each of these sessions asked for a background sync when it committed. The log server
+        // syncs up to the newest write it has seen, so the first wait usually covers the rest
+        // and they return immediately.
+        for (size_t i = 0; i < sessions.size(); i++) {
+            WT_SESSION* s = sessions[i];
+            invariantWTOK(s->transaction_sync(s, NULL));
+        }
+    }
+
+    void WiredTigerGroupCommit::_flushLog() {
+        const std::string uri = std::string("table:") + kFlushTableIdent;
+
+        WiredTigerSession session(_conn);
+        WT_SESSION* s = session.getSession();
+        WT_CURSOR* c;
+        int ret = s->open_cursor(s, uri.c_str(), NULL, "overwrite=true", &c);
+        if (ret == ENOENT) {
+            invariantWTOK(s->create(s, uri.c_str(), "key_format=q,value_format=q"));
+            ret = s->open_cursor(s, uri.c_str(), NULL, "overwrite=true", &c);
+        }
+        invariantWTOK(ret);
+
+        // Log records are synced in order, so syncing this one syncs everything before it.
+        invariantWTOK(s->begin_transaction(s, NULL));
+        c->set_key(c, 1LL);
+        c->set_value(c, ++_logFlushRecord);
+        invariantWTOK(c->insert(c));
+        invariantWTOK(c->close(c));
+        invariantWTOK(s->commit_transaction(s, "sync=on"));
+    }
+
+    void WiredTigerGroupCommit::appendStats(BSONObjBuilder* builder) const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+        BSONObjBuilder bb(builder->subobjStart("groupCommit"));
+        bb.appendNumber("flushes", static_cast<long long>(_flushes));
+        bb.appendNumber("logFlushes", static_cast<long long>(_logFlushes));
+        bb.appendNumber("checkpointFlushes", static_cast<long long>(_checkpointFlushes));
+        bb.appendNumber("waiters", static_cast<long long>(_waitersFlushed));
+        bb.append("averageBatchSize",
+                  _flushes ? static_cast<double>(_waitersFlushed) / _flushes : 0.0);
+        bb.appendNumber("maxBatchSize", static_cast<long long>(_maxBatchSize));
+        bb.appendNumber("totalFlushMicros", static_cast<long long>(_totalFlushMicros));
+        bb.appendNumber("maxFlushMicros", static_cast<long long>(_maxFlushMicros));
+        bb.append("windowMicros", wiredTigerGroupCommitWindowMicros);
+        bb.done();
+    }
+
+}  // namespace mongo
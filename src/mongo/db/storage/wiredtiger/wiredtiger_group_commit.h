@@ -0,0 +1,127 @@
+// wiredtiger_group_commit.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <wiredtiger.h>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Makes committed writes durable in batches, so one flush of the journal covers every caller
+     * that is waiting at that moment.
+     *
+     * The first caller to arrive while no flush is running becomes the leader. The leader waits
+     * out the commit window (wiredTigerGroupCommitWindowMicros), takes everyone who has arrived so
+     * far as its batch, does a single flush for the batch and wakes them all. Callers that arrive
+     * during a flush form the next batch, and one of them leads it.
+     */
+    class WiredTigerGroupCommit {
+        MONGO_DISALLOW_COPYING(WiredTigerGroupCommit);
+    public:
+        /**
+         * 'journaled' tells whether the connection was opened with logging enabled. Without a
+         * journal every flush is a checkpoint.
+         */
+        WiredTigerGroupCommit(WT_CONNECTION* conn, bool journaled);
+
+        /**
+         * The table, owned by this class, which log flushes commit a record to.
+         */
+        static const char kFlushTableIdent[];
+
+        /**
+         * Returns once everything the caller committed before this call is durable.
+         *
+         * If 'session' is non-NULL, the caller's commits since it last waited were made with
+         * "sync=background". In that case it is enough to wait until the journal is synced past
+         * them. 'session' must have no running transaction, and the caller must not use it until
+         * this returns. If 'session' is NULL, the batch syncs the whole journal. Without a
+         * journal, every batch is made durable with a checkpoint.
+         */
+        void waitUntilDurable(WT_SESSION* session);
+
+        bool isJournaled() const { return _journaled; }
+
+        void appendStats(BSONObjBuilder* builder) const;
+
+    private:
+        /**
+         * Performs one flush for a batch. Called by the leader without holding _mutex.
+         */
+        void _flush(const std::vector<WT_SESSION*>& sessions, bool needLogFlush);
+
+        /**
+         * Syncs the journal past every record written so far. This WiredTiger has no call to
+         * just flush the log, and an empty transaction writes no log record, so this commits a
+         * record to kFlushTableIdent with "sync=on". Only called by the leader.
+         */
+        void _flushLog();
+
+        WT_CONNECTION* const _conn; // not owned
+        const bool _journaled;
+
+        // Protects everything below.
+        mutable stdx::mutex _mutex;
+        stdx::condition_variable _flushDone;
+
+        // Each waiter takes a ticket. Every ticket up to _flushedThrough is durable.
+        uint64_t _lastTicket = 0;
+        uint64_t _flushedThrough = 0;
+        bool _flushInProgress = false;
+
+        // What the next batch must do. Owned by whoever leads it.
+        std::vector<WT_SESSION*> _pendingSessions;
+        bool _pendingNeedsLogFlush = false;
+
+        // Written to kFlushTableIdent by _flushLog(). Only used by the leader.
+        long long _logFlushRecord = 0;
+
+        // Statistics.
+        uint64_t _flushes = 0;
+        uint64_t _logFlushes = 0;
+        uint64_t _checkpointFlushes = 0;
+        uint64_t _waitersFlushed = 0;
+        uint64_t _maxBatchSize = 0;
+        uint64_t _totalFlushMicros = 0;
+        uint64_t _maxFlushMicros = 0;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,184 @@
+// wiredtiger_group_commit_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_group_commit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    const char* const kUri = "table:groupCommit";
+
+    class GroupCommitHarness {
+    public:
+        explicit GroupCommitHarness(bool journaled) : _dbpath("wt_group_commit_test") {
+            const std::string config = journaled ? "create,log=(enabled=true)" : "create";
+            invariantWTOK(wiredtiger_open(_dbpath.path().c_str(), NULL, config.c_str(), &_conn));
+
+            WiredTigerSession session(_conn);
+            WT_SESSION* s = session.getSession();
+            invariantWTOK(s->create(s, kUri, "key_format=q,value_format=S"));
+        }
+
+        ~GroupCommitHarness() {
+            _conn->close(_conn, NULL);
+        }
+
+        WT_CONNECTION* conn() const { return _conn; }
+
+        // Commits one record with a background sync, as a j:true write does.
+        static void insert(WT_SESSION* s, long long key) {
+            WT_CURSOR* c;
+            invariantWTOK(s->begin_transaction(s, NULL));
+            invariantWTOK(s->open_cursor(s, kUri, NULL, NULL, &c));
+            c->set_key(c, key);
+            c->set_value(c, "value");
+            invariantWTOK(c->insert(c));
+            invariantWTOK(c->close(c));
+            invariantWTOK(s->commit_transaction(s, "sync=background"));
+        }
+
+    private:
+        unittest::TempDir _dbpath;
+        WT_CONNECTION* _conn;
+    };
+
+    BSONObj getStats(const WiredTigerGroupCommit& groupCommit) {
+        BSONObjBuilder bob;
+        groupCommit.appendStats(&bob);
+        return bob.obj()["groupCommit"].Obj().getOwned();
+    }
+
+    TEST(WiredTigerGroupCommit, ConcurrentWaitersShareFlushes) {
+        GroupCommitHarness harness(true);
+        WiredTigerGroupCommit groupCommit(harness.conn(), true);
+
+        const int kThreads = 8;
+        const int kWritesPerThread = 20;
+        std::vector<stdx::thread> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([&harness, &groupCommit, t] {
+                WiredTigerSession session(harness.conn());
+                WT_SESSION* s = session.getSession();
+                for (int i = 0; i < kWritesPerThread; i++) {
+                    GroupCommitHarness::insert(s, t * kWritesPerThread + i);
+                    groupCommit.waitUntilDurable(s);
+                }
+            });
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+
+        const BSONObj stats = getStats(groupCommit);
+        ASSERT_EQUALS(kThreads * kWritesPerThread, stats["waiters"].numberLong());
+        ASSERT_GREATER_THAN_OR_EQUALS(stats["flushes"].numberLong(), 1);
+        ASSERT_LESS_THAN_OR_EQUALS(stats["flushes"].numberLong(),
+                                   stats["waiters"].numberLong());
+        ASSERT_GREATER_THAN_OR_EQUALS(stats["maxBatchSize"].numberLong(), 1);
+        ASSERT_EQUALS(0, stats["logFlushes"].numberLong());
+        ASSERT_EQUALS(0, stats["checkpointFlushes"].numberLong());
+    }
+
+    TEST(WiredTigerGroupCommit, JournaledWaitersWithoutSessionFlushLog) {
+        GroupCommitHarness harness(true);
+        WiredTigerGroupCommit groupCommit(harness.conn(), true);
+
+        {
+            // Commits without a sync, like a write whose caller only later asks for j:true.
+            WiredTigerSession session(harness.conn());
+            WT_SESSION* s = session.getSession();
+            WT_CURSOR* c;
+            invariantWTOK(s->begin_transaction(s, NULL));
+            invariantWTOK(s->open_cursor(s, kUri, NULL, NULL, &c));
+            c->set_key(c, 1LL);
+            c->set_value(c, "value");
+            invariantWTOK(c->insert(c));
+            invariantWTOK(c->close(c));
+            invariantWTOK(s->commit_transaction(s, NULL));
+        }
+        groupCommit.waitUntilDurable(NULL);
+        groupCommit.waitUntilDurable(NULL);
+
+        const BSONObj stats = getStats(groupCommit);
+        ASSERT_EQUALS(2, stats["waiters"].numberLong());
+        ASSERT_EQUALS(2, stats["flushes"].numberLong());
+        ASSERT_EQUALS(2, stats["logFlushes"].numberLong());
+        ASSERT_EQUALS(0, stats["checkpointFlushes"].numberLong());
+
+        // The log flushes wrote to their own table rather than taking checkpoints.
+        WiredTigerSession session(harness.conn());
+        WT_SESSION* s = session.getSession();
+        WT_CURSOR* c;
+        const std::string flushUri =
+            std::string("table:") + WiredTigerGroupCommit::kFlushTableIdent;
+        invariantWTOK(s->open_cursor(s, flushUri.c_str(), NULL, NULL, &c));
+        c->set_key(c, 1LL);
+        invariantWTOK(c->search(c));
+        long long value;
+        invariantWTOK(c->get_value(c, &value));
+        ASSERT_EQUALS(2, value);
+        invariantWTOK(c->close(c));
+    }
+
+    TEST(WiredTigerGroupCommit, WaitersWithoutSessionCheckpoint) {
+        GroupCommitHarness harness(false);
+        WiredTigerGroupCommit groupCommit(harness.conn(), false);
+        ASSERT_FALSE(groupCommit.isJournaled());
+
+        {
+            WiredTigerSession session(harness.conn());
+            GroupCommitHarness::insert(session.getSession(), 1);
+            // Without a journal the session is ignored and a checkpoint is taken.
+            groupCommit.waitUntilDurable(session.getSession());
+        }
+        groupCommit.waitUntilDurable(NULL);
+
+        const BSONObj stats = getStats(groupCommit);
+        ASSERT_EQUALS(2, stats["waiters"].numberLong());
+        ASSERT_EQUALS(2, stats["flushes"].numberLong());
+        ASSERT_EQUALS(0, stats["logFlushes"].numberLong());
+        ASSERT_EQUALS(2, stats["checkpointFlushes"].numberLong());
+        ASSERT_EQUALS(1, stats["maxBatchSize"].numberLong());
+    }
+
+}  // namespace
+}  // namespace mongo
@@ -241,6 +241,37 @@ namespace {
         return _insert( c, key, loc, dupsAllowed );
     }
 
+    Status WiredTigerIndex::insertKeys(OperationContext* txn,
+                                       std::vector<IndexKeyEntry>::const_iterator begin,
+                                       std::vector<IndexKeyEntry>::const_iterator end,
+                                       bool dupsAllowed,
+                                       size_t* numInserted) {
+        *numInserted = 0;
+        if (begin == end)
+            return Status::OK();
+
+        // Share one cursor across the whole batch rather than fetching it per key.
+        WiredTigerCursor curwrap(_uri, _instanceId, false, txn);
+        curwrap.assertInActiveTxn();
+        WT_CURSOR *c = curwrap.get();
+
+        for (auto it = begin; it != end; ++it) {
+            invariant(it->loc.isNormal());
+            dassert(!hasFieldNames(it->key));
+
+            Status s = checkKeySize(it->key);
+            if (!s.isOK())
+                return s;
+
+            s = _insert(c, it->key, it->loc, dupsAllowed);
+            if (!s.isOK())
+                return s;
+
+            ++*numInserted;
+        }
+        return Status::OK();
+    }
+
     void WiredTigerIndex::unindex(OperationContext* txn,
                                   const BSONObj& key,
                                   const RecordId& loc,
@@ -86,6 +86,12 @@ namespace mongo {
                               const RecordId& loc,
                               bool dupsAllowed);
 
+        virtual Status insertKeys(OperationContext* txn,
+                                  std::vector<IndexKeyEntry>::const_iterator begin,
+                                  std::vector<IndexKeyEntry>::const_iterator end,
+                                  bool dupsAllowed,
+                                  size_t* numInserted);
+
         virtual void unindex(OperationContext* txn,
                              const BSONObj& key,
                              const RecordId& loc,
@@ -41,6 +41,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_group_commit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_index.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
@@ -444,7 +445,7 @@ namespace mongo {
                 continue;
 
             StringData ident = key.substr(idx+1);
-            if ( ident == "sizeStorer" )
+            if ( ident == "sizeStorer" || ident == WiredTigerGroupCommit::kFlushTableIdent )
                 continue;
 
             all.push_back( ident.toString() );
@@ -162,6 +162,7 @@ namespace {
             data.makeOwned(); // TODO delete this line once safe.
 
             _lastReturnedId = id;
+            _eof = false;
             return {{id, std::move(data)}};
         }
 
@@ -565,6 +566,10 @@ namespace {
 
         _changeNumRecords(txn, -1);
         _increaseDataSize(txn, -old_length);
+
+        if (_rangeSummary) {
+            _rangeSummary->recordDeleted(loc);
+        }
     }
 
     bool WiredTigerRecordStore::cappedAndNeedDelete() const {
@@ -695,6 +700,10 @@ namespace {
                 ++docsRemoved;
                 sizeSaved += old_value.size;
 
+                if (_rangeSummary) {
+                    _rangeSummary->recordDeleted(newestOld);
+                }
+
                 if ( _cappedDeleteCallback ) {
                     uassertStatusOK(
                         _cappedDeleteCallback->aboutToDeleteCapped(
@@ -800,6 +809,10 @@ namespace {
             return StatusWith<RecordId>(wtRCToStatus(ret, "WiredTigerRecordStore::insertRecord"));
         }
 
+        if (_rangeSummary) {
+            _rangeSummary->recordInserted(txn, loc, BSONObj(data));
+        }
+
         _changeNumRecords( txn, 1 );
         _increaseDataSize( txn, len );
 
@@ -808,6 +821,47 @@ namespace {
         return StatusWith<RecordId>( loc );
     }
 
+    Status WiredTigerRecordStore::insertRecords( OperationContext* txn,
+                                                 std::vector<Record>* records,
+                                                 bool enforceQuota ) {
+        if ( _isCapped ) {
+            // Each insert into a capped collection, the oplog included, may have to delete the
+            // oldest documents to make room, so they are done one at a time.
+            return RecordStore::insertRecords( txn, records, enforceQuota );
+        }
+
+        if ( records->empty() )
+            return Status::OK();
+
+        WiredTigerCursor curwrap( _uri, _instanceId, true, txn);
+        curwrap.assertInActiveTxn();
+        WT_CURSOR *c = curwrap.get();
+        invariant( c );
+
+        int64_t totalLength = 0;
+        for ( auto& record : *records ) {
+            record.id = _nextId();
+
+            c->set_key(c, _makeKey(record.id));
+            WiredTigerItem value(record.data.data(), record.data.size());
+            c->set_value(c, value.Get());
+            int ret = WT_OP_CHECK(c->insert(c));
+            if (ret) {
+                return wtRCToStatus(ret, "WiredTigerRecordStore::insertRecords");
+            }
+
+            if (_rangeSummary) {
+                _rangeSummary->recordInserted(txn, record.id, BSONObj(record.data.data()));
+            }
+            totalLength += record.data.size();
+        }
+
+        _changeNumRecords( txn, records->size() );
+        _increaseDataSize( txn, totalLength );
+
+        return Status::OK();
+    }
+
     void WiredTigerRecordStore::dealtWithCappedLoc( const RecordId& loc ) {
         stdx::lock_guard<stdx::mutex> lk( _uncommittedDiskLocsMutex );
         SortedDiskLocs::iterator it = std::find(_uncommittedDiskLocs.begin(),
@@ -864,6 +918,10 @@ namespace {
 
         _increaseDataSize(txn, len - old_length);
 
+        if (_rangeSummary) {
+            _rangeSummary->recordUpdated(loc, BSONObj(data));
+        }
+
         cappedDeleteAsNeeded(txn, loc);
 
         return StatusWith<RecordId>( loc );
@@ -928,6 +986,10 @@ namespace {
         _changeNumRecords(txn, -numRecords(txn));
         _increaseDataSize(txn, -dataSize(txn));
 
+        if (_rangeSummary) {
+            _rangeSummary->clear();
+        }
+
         return Status::OK();
     }
 
@@ -1134,6 +1196,12 @@ namespace {
         return _fromKey(key);
     }
 
+    void WiredTigerRecordStore::enableRangeSummary(StringData fieldName) {
+        if (!_rangeSummary) {
+            _rangeSummary.reset(new RecordRangeSummary(fieldName, /*idsIncrease=*/true));
+        }
+    }
+
     void WiredTigerRecordStore::updateStatsAfterRepair(OperationContext* txn,
                                                        long long numRecords,
                                                        long long dataSize) {
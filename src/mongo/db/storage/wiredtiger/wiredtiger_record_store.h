@@ -31,11 +31,13 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
 #include <string>
 
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/storage/capped_callback.h"
+#include "mongo/db/storage/record_range_summary.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/mutex.h"
@@ -129,6 +131,10 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota );
 
+        virtual Status insertRecords( OperationContext* txn,
+                                      std::vector<Record>* records,
+                                      bool enforceQuota );
+
         virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
                                                   const RecordId& oldLocation,
                                                   const char* data,
@@ -179,6 +185,10 @@ namespace mongo {
         virtual Status oplogDiskLocRegister( OperationContext* txn,
                                              const Timestamp& opTime );
 
+        virtual void enableRangeSummary(StringData fieldName);
+
+        virtual const RecordRangeSummary* rangeSummary() const { return _rangeSummary.get(); }
+
         virtual void updateStatsAfterRepair(OperationContext* txn,
                                             long long numRecords,
                                             long long dataSize);
@@ -264,6 +274,9 @@ namespace mongo {
 
         bool _shuttingDown;
         bool _hasBackgroundThread;
+
+        // RecordIds only increase, so records are scanned in the order they were inserted in.
+        std::unique_ptr<RecordRangeSummary> _rangeSummary;
     };
 
     // WT failpoint to throw write conflict exceptions randomly
@@ -737,6 +737,37 @@ namespace {
         ASSERT(!cursor->next());
     }
 
+    TEST(WiredTigerRecordStoreTest, CappedInsertRecordsRespectsMaxDocs) {
+        unique_ptr<WiredTigerHarnessHelper> harnessHelper( new WiredTigerHarnessHelper() );
+        unique_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("a.b", 10000, 5));
+
+        std::vector<BSONObj> objs;
+        std::vector<Record> records;
+        for ( int i = 0; i < 20; i++ ) {
+            objs.push_back( BSON( "i" << i ) );
+            records.push_back( Record{ RecordId(), RecordData( objs.back().objdata(),
+                                                               objs.back().objsize() ) } );
+        }
+
+        {
+            unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            WriteUnitOfWork uow( opCtx.get() );
+            ASSERT_OK( rs->insertRecords( opCtx.get(), &records, false ) );
+            uow.commit();
+        }
+
+        // The batch is inserted one record at a time, so only its last five records are kept.
+        unique_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+        ASSERT_EQUALS( 5, rs->numRecords( opCtx.get() ) );
+        auto cursor = rs->getCursor( opCtx.get() );
+        for ( int i = 15; i < 20; i++ ) {
+            auto record = cursor->next();
+            ASSERT( record );
+            ASSERT_EQUALS( i, record->data.toBson()["i"].numberInt() );
+        }
+        ASSERT( !cursor->next() );
+    }
+
     RecordId _oplogOrderInsertOplog( OperationContext* txn,
                                     unique_ptr<RecordStore>& rs,
                                     int inc ) {
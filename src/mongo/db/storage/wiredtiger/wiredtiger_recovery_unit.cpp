@@ -38,8 +38,6 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
-#include "mongo/stdx/condition_variable.h"
-#include "mongo/stdx/mutex.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
@@ -47,37 +45,6 @@
 
 namespace mongo {
 
-    namespace {
-        struct WaitUntilDurableData {
-            WaitUntilDurableData() :
-                numWaitingForSync(0),
-                lastSyncTime(0) {
-            }
-
-            void syncHappend() {
-                stdx::lock_guard<stdx::mutex> lk( mutex );
-                lastSyncTime++;
-                condvar.notify_all();
-            }
-
-            // return true if happened
-            bool waitUntilDurable() {
-                stdx::unique_lock<stdx::mutex> lk( mutex );
-                long long start = lastSyncTime;
-                numWaitingForSync.fetchAndAdd(1);
-                condvar.timed_wait(lk,boost::posix_time::milliseconds(50));
-                numWaitingForSync.fetchAndAdd(-1);
-                return lastSyncTime > start;
-            }
-
-            AtomicUInt32 numWaitingForSync;
-
-            stdx::mutex mutex; // this just protects lastSyncTime
-            stdx::condition_variable condvar;
-            long long lastSyncTime;
-        } waitUntilDurableData;
-    }
-
     WiredTigerRecoveryUnit::WiredTigerRecoveryUnit(WiredTigerSessionCache* sc) :
         _sessionCache( sc ),
         _session( NULL ),
@@ -87,6 +54,7 @@ namespace mongo {
         _everStartedWrite( false ),
         _currentlySquirreled( false ),
         _syncing( false ),
+        _lastCommitBackgroundSynced( false ),
         _noTicketNeeded( false ) {
     }
 
@@ -170,20 +138,25 @@ namespace mongo {
     }
 
     void WiredTigerRecoveryUnit::goingToWaitUntilDurable() {
-        if ( _active ) {
-            // too late, can't change config
-            return;
-        }
-        // yay, we've configured ourselves for sync
+        // The sync config is chosen when a transaction commits, so a running one picks this up.
         _syncing = true;
     }
 
     bool WiredTigerRecoveryUnit::waitUntilDurable() {
-        if ( _syncing && _everStartedWrite ) {
-            // we did a sync, so we're good
+        WiredTigerGroupCommit* groupCommit = _sessionCache->getGroupCommit();
+
+        if ( _lastCommitBackgroundSynced && _session ) {
+            // Our last commit asked for a background sync, so we only need the journal to catch
+            // up with it. WT won't wait on a session with a running transaction.
+            if ( _active )
+                abandonSnapshot();
+            groupCommit->waitUntilDurable( _session->getSession() );
             return true;
         }
-        waitUntilDurableData.waitUntilDurable();
+
+        // Nothing is known about our commits, so the batch syncs the whole journal, or takes a
+        // checkpoint if there is none.
+        groupCommit->waitUntilDurable( NULL );
         return true;
     }
 
@@ -303,10 +276,13 @@ namespace mongo {
         invariant( _active );
         WT_SESSION *s = _session->getSession();
         if ( commit ) {
-            invariantWTOK( s->commit_transaction(s, NULL) );
+            // Syncing commits don't wait for the journal here. waitUntilDurable() does that, so
+            // concurrent callers can share one flush.
+            const bool backgroundSync =
+                _syncing && _sessionCache->getGroupCommit()->isJournaled();
+            invariantWTOK( s->commit_transaction(s, backgroundSync ? "sync=background" : NULL) );
+            _lastCommitBackgroundSynced = backgroundSync;
             LOG(2) << "WT commit_transaction";
-            if ( _syncing )
-                waitUntilDurableData.syncHappend();
         }
         else {
             invariantWTOK( s->rollback_transaction(s, NULL) );
@@ -359,8 +335,7 @@ namespace mongo {
         _getTicket(opCtx);
 
         WT_SESSION *s = _session->getSession();
-        _syncing = _syncing || waitUntilDurableData.numWaitingForSync.load() > 0;
-        invariantWTOK( s->begin_transaction(s, _syncing ? "sync=true" : NULL) );
+        invariantWTOK( s->begin_transaction(s, NULL) );
         LOG(2) << "WT begin_transaction";
         _timer.reset();
         _active = true;
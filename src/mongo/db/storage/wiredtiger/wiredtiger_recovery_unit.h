@@ -112,6 +112,9 @@ namespace mongo {
         Timer _timer;
         bool _currentlySquirreled;
         bool _syncing;
+        // Whether the last transaction committed was synced in the background, which makes the
+        // journal cover it and everything committed before it once synced.
+        bool _lastCommitBackgroundSynced;
         RecordId _oplogReadTill;
 
         typedef OwnedPointerVector<Change> Changes;
@@ -77,6 +77,7 @@ namespace mongo {
         }
 
         WiredTigerRecoveryUnit::appendGlobalStats(bob);
+        WiredTigerRecoveryUnit::get(txn)->getSessionCache()->getGroupCommit()->appendStats(&bob);
 
         return bob.obj();
     }
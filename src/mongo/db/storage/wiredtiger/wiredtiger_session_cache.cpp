@@ -158,12 +158,14 @@ namespace mongo {
 
     WiredTigerSessionCache::WiredTigerSessionCache(WiredTigerKVEngine* engine)
         : _engine(engine), _conn(engine->getConnection()),
-          _sessionsOut(0), _shuttingDown(0), _highWaterMark(1), _head(Tagger(0,0)) {
+          _sessionsOut(0), _shuttingDown(0), _highWaterMark(1), _head(Tagger(0,0)),
+          _groupCommit(_conn, engine->isDurable()) {
     }
 
     WiredTigerSessionCache::WiredTigerSessionCache(WT_CONNECTION* conn)
         : _engine(NULL), _conn(conn),
-          _sessionsOut(0), _shuttingDown(0), _highWaterMark(1), _head(Tagger(0,0)) {
+          _sessionsOut(0), _shuttingDown(0), _highWaterMark(1), _head(Tagger(0,0)),
+          _groupCommit(_conn, false) {
     }
 
     WiredTigerSessionCache::~WiredTigerSessionCache() {
@@ -39,6 +39,7 @@
 
 #include <wiredtiger.h>
 
+#include "mongo/db/storage/wiredtiger/wiredtiger_group_commit.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/spin_lock.h"
 
@@ -164,6 +165,11 @@ namespace mongo {
 
         WT_CONNECTION* conn() const { return _conn; }
 
+        /**
+         * Batches callers waiting for their writes to become durable on this connection.
+         */
+        WiredTigerGroupCommit* getGroupCommit() { return &_groupCommit; }
+
     private:
 
         // Vodou for ABA problem
@@ -188,6 +194,8 @@ namespace mongo {
 
         // The sessions are stored as a linked list stack. So we need to track the head
         std::atomic<Tagger> _head;
+
+        WiredTigerGroupCommit _groupCommit;
     };
 
 }
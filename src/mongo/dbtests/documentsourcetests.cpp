@@ -782,6 +782,35 @@ namespace DocumentSourceTests {
             }
         };
 
+        /** Numeric accumulators over more documents than $group processes in one batch. */
+        class ManyValuesTwoKeys : public CheckResultsBase {
+            void populateData() {
+                for ( int i = 0; i < 3000; ++i ) {
+                    if ( i % 2 == 0 ) {
+                        // Only ints.
+                        client.insert( ns, BSON( "id" << 0 << "a" << i ) );
+                    }
+                    else if ( i % 4 == 1 ) {
+                        // Mixed with the doubles below.
+                        client.insert( ns, BSON( "id" << 1 << "a" << i ) );
+                    }
+                    else {
+                        client.insert( ns, BSON( "id" << 1 << "a" << static_cast<double>( i ) ) );
+                    }
+                }
+                // Non numeric values are ignored.
+                client.insert( ns, BSON( "id" << 1 << "a" << "x" ) );
+            }
+            virtual BSONObj groupSpec() {
+                return BSON( "_id" << "$id"
+                             << "sum" << BSON( "$sum" << "$a" )
+                             << "avg" << BSON( "$avg" << "$a" ) );
+            }
+            virtual string expectedResultSetString() {
+                return "[{_id:0,sum:2248500,avg:1499},{_id:1,sum:2250000,avg:1500}]";
+            }
+        };
+
         /** Null and undefined _id values are grouped together. */
         class GroupNullUndefinedIds : public CheckResultsBase {
             void populateData() {
@@ -1901,6 +1930,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceGroup::TwoValuesTwoKeys>();
             add<DocumentSourceGroup::FourValuesTwoKeys>();
             add<DocumentSourceGroup::FourValuesTwoKeysTwoAccumulators>();
+            add<DocumentSourceGroup::ManyValuesTwoKeys>();
             add<DocumentSourceGroup::GroupNullUndefinedIds>();
             add<DocumentSourceGroup::ComplexId>();
             add<DocumentSourceGroup::UndefinedAccumulatorValue>();
@@ -461,6 +461,81 @@ namespace IndexUpdateTests {
         }
     };
 
+    /**
+     * A foreground build over a collection large enough to generate keys on several threads
+     * finds the duplicates and multikey documents wherever they fall in the collection.
+     */
+    class InsertBuildParallelKeyGeneration : public IndexBuildBase {
+    public:
+        void run() {
+            const int numDocs = 25 * 1000;
+
+            // Create a new collection.
+            Database* db = _ctx.db();
+            Collection* coll;
+            RecordId loc1;
+            RecordId loc2;
+            {
+                WriteUnitOfWork wunit(&_txn);
+                db->dropCollection( &_txn, _ns );
+                coll = db->createCollection( &_txn, _ns );
+
+                for (int i = 0; i < numDocs; ++i) {
+                    BSONObj doc;
+                    if (i == 3) {
+                        doc = BSON("_id" << i << "a" << "dup" << "b" << BSON_ARRAY(1 << 2));
+                    }
+                    else if (i == numDocs - 3) {
+                        doc = BSON("_id" << i << "a" << "dup" << "b" << i);
+                    }
+                    else {
+                        doc = BSON("_id" << i << "a" << i << "b" << i);
+                    }
+
+                    StatusWith<RecordId> swLoc = coll->insertDocument(&_txn, doc, true);
+                    ASSERT_OK(swLoc.getStatus());
+                    if (i == 3) {
+                        loc1 = swLoc.getValue();
+                    }
+                    else if (i == numDocs - 3) {
+                        loc2 = swLoc.getValue();
+                    }
+                }
+                wunit.commit();
+            }
+
+            MultiIndexBlock indexer(&_txn, coll);
+            indexer.allowInterruption();
+
+            const BSONObj uniqueSpec = BSON("name" << "a"
+                                         << "ns" << coll->ns().ns()
+                                         << "key" << BSON("a" << 1)
+                                         << "unique" << true);
+            const BSONObj multikeySpec = BSON("name" << "b"
+                                           << "ns" << coll->ns().ns()
+                                           << "key" << BSON("b" << 1));
+
+            ASSERT_OK(indexer.init(std::vector<BSONObj>{uniqueSpec, multikeySpec}));
+
+            std::set<RecordId> dups;
+            ASSERT_OK(indexer.insertAllDocumentsInCollection(&dups));
+
+            // either loc1 or loc2 should be in dups but not both.
+            ASSERT_EQUALS(dups.size(), 1U);
+            ASSERT(dups.count(loc1) || dups.count(loc2));
+
+            {
+                WriteUnitOfWork wunit(&_txn);
+                indexer.commit();
+                wunit.commit();
+            }
+
+            IndexCatalog* catalog = coll->getIndexCatalog();
+            ASSERT_FALSE(catalog->isMultikey(&_txn, catalog->findIndexByName(&_txn, "a")));
+            ASSERT_TRUE(catalog->isMultikey(&_txn, catalog->findIndexByName(&_txn, "b")));
+        }
+    };
+
     /** Index creation is killed if mayInterrupt is true. */
     class InsertBuildIndexInterrupt : public IndexBuildBase {
     public:
@@ -918,6 +993,7 @@ namespace IndexUpdateTests {
             add<InsertBuildEnforceUnique<false> >();
             add<InsertBuildFillDups<true> >();
             add<InsertBuildFillDups<false> >();
+            add<InsertBuildParallelKeyGeneration>();
             add<InsertBuildIndexInterrupt>();
             add<InsertBuildIndexInterruptDisallowed>();
             add<InsertBuildIdIndexInterrupt>();
@@ -46,6 +46,8 @@
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/mongoutils/str.h"
@@ -60,10 +62,11 @@ namespace QueryStageAnd {
     class QueryStageAndBase {
     public:
         QueryStageAndBase() : _client(&_txn) { 
-
+            _blockingStageSpill = internalQueryExecBlockingStageSpill;
         }
 
         virtual ~QueryStageAndBase() {
+            internalQueryExecBlockingStageSpill = _blockingStageSpill;
             _client.dropCollection(ns());
         }
 
@@ -147,6 +150,8 @@ namespace QueryStageAnd {
 
     private:
         DBDirectClient _client;
+
+        bool _blockingStageSpill;
     };
 
     //
@@ -422,6 +427,7 @@ namespace QueryStageAnd {
             // Lower buffer limit to 20 * sizeof(big) to force memory error
             // before hashed AND is done reading the first child (stage has to
             // hold 21 keys in buffer for Foo <= 20).
+            internalQueryExecBlockingStageSpill = false;
             WorkingSet ws;
             unique_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, coll, 20 * big.size()));
 
@@ -590,6 +596,7 @@ namespace QueryStageAnd {
             // Lower buffer limit to 10 * sizeof(big) to force memory error
             // before hashed AND is done reading the second child (stage has to
             // hold 11 keys in buffer for Foo <= 20 and Bar >= 10).
+            internalQueryExecBlockingStageSpill = false;
             WorkingSet ws;
             unique_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, coll, 10 * big.size()));
 
@@ -624,6 +631,90 @@ namespace QueryStageAnd {
         }
     };
 
+    // As above, but the hashed AND spills to disk rather than fail.  Only storage engines with
+    // document-level locking can spill, since no invalidations reach spilled data.
+    class QueryStageAndHashThreeLeafMiddleChildSpill : public QueryStageAndBase {
+    public:
+        void run() {
+            if (!supportsDocLocking()) {
+                return;
+            }
+
+            OldClientWriteContext ctx(&_txn, ns());
+            Database* db = ctx.db();
+            Collection* coll = ctx.getCollection();
+            if (!coll) {
+                WriteUnitOfWork wuow(&_txn);
+                coll = db->createCollection(&_txn, ns());
+                wuow.commit();
+            }
+
+            std::string big(512, 'a');
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("foo" << i << "bar" << i << "baz" << i << "big" << big));
+            }
+
+            addIndex(BSON("foo" << 1 << "big" << 1));
+            addIndex(BSON("bar" << 1 << "big" << 1));
+            addIndex(BSON("baz" << 1));
+
+            // The first child alone overflows the buffer, so all but the last child is spilled.
+            internalQueryExecBlockingStageSpill = true;
+            WorkingSet ws;
+            unique_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, coll, 10 * big.size()));
+
+            // Foo <= 20
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1 << "big" << 1), coll);
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << 20 << "" << big);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = -1;
+            ah->addChild(new IndexScan(&_txn, params, &ws, NULL));
+
+            // Bar >= 10
+            params.descriptor = getIndex(BSON("bar" << 1 << "big" << 1), coll);
+            params.bounds.startKey = BSON("" << 10 << "" << big);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            ah->addChild(new IndexScan(&_txn, params, &ws, NULL));
+
+            // 5 <= baz <= 15
+            params.descriptor = getIndex(BSON("baz" << 1), coll);
+            params.bounds.startKey = BSON("" << 5);
+            params.bounds.endKey = BSON("" << 15);
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            ah->addChild(new IndexScan(&_txn, params, &ws, NULL));
+
+            // Results come back in the order of the last child, with the keys of all children.
+            int expected = 10;
+            while (!ah->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState status = ah->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, status);
+                if (PlanStage::ADVANCED != status) { continue; }
+
+                WorkingSetMember* member = ws.get(id);
+                BSONElement elt;
+                ASSERT_TRUE(member->getFieldDotted("foo", &elt));
+                ASSERT_EQUALS(expected, elt.numberInt());
+                ASSERT_TRUE(member->getFieldDotted("bar", &elt));
+                ASSERT_EQUALS(expected, elt.numberInt());
+                ASSERT_TRUE(member->getFieldDotted("baz", &elt));
+                ASSERT_EQUALS(expected, elt.numberInt());
+                ++expected;
+            }
+            ASSERT_EQUALS(16, expected);
+
+            unique_ptr<PlanStageStats> stats(ah->getStats());
+            const AndHashStats* specific = static_cast<const AndHashStats*>(stats->specific.get());
+            ASSERT_GREATER_THAN(specific->spilledRuns, 0);
+        }
+    };
+
     // An AND with an index scan that returns nothing.
     class QueryStageAndHashWithNothing : public QueryStageAndBase {
     public:
@@ -1538,6 +1629,7 @@ namespace QueryStageAnd {
             add<QueryStageAndHashTwoLeafLastChildLargeKeys>();
             add<QueryStageAndHashThreeLeaf>();
             add<QueryStageAndHashThreeLeafMiddleChildLargeKeys>();
+            add<QueryStageAndHashThreeLeafMiddleChildSpill>();
             add<QueryStageAndHashWithNothing>();
             add<QueryStageAndHashProducesNothing>();
             add<QueryStageAndHashWithMatcher>();
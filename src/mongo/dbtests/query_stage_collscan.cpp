@@ -37,11 +37,13 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_batch.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/fail_point_service.h"
@@ -73,6 +75,10 @@ namespace QueryStageCollectionScan {
             _client.dropCollection(ns());
         }
 
+        void insert(const BSONObj& obj) {
+            _client.insert(ns(), obj);
+        }
+
         void remove(const BSONObj& obj) {
             _client.remove(ns(), obj);
         }
@@ -186,6 +192,231 @@ namespace QueryStageCollectionScan {
         }
     };
 
+    //
+    // Produce matches a batch at a time. The results and the stats must be the same as when
+    // producing them one at a time.
+    //
+
+    class QueryStageCollscanWorkBatch : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            AutoGetCollectionForRead ctx(&_txn, ns());
+
+            CollectionScanParams params;
+            params.collection = ctx.getCollection();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            StatusWithMatchExpression swme =
+                MatchExpressionParser::parse(BSON("foo" << BSON("$lt" << 25)));
+            ASSERT_OK(swme.getStatus());
+            unique_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            // One at a time.
+            WorkingSet ws;
+            CollectionScan scan(&_txn, params, &ws, filterExpr.get());
+            vector<int> expected;
+            while (!scan.isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                if (PlanStage::ADVANCED == scan.work(&id)) {
+                    expected.push_back(ws.get(id)->obj.value()["foo"].numberInt());
+                    ws.free(id);
+                }
+            }
+
+            // In batches of at most 7.
+            WorkingSet batchWs;
+            CollectionScan batchScan(&_txn, params, &batchWs, filterExpr.get());
+            vector<int> results;
+            for (PlanStage::StageState state = PlanStage::NEED_TIME;
+                 PlanStage::IS_EOF != state; ) {
+                vector<WorkingSetID> ids;
+                state = batchScan.workBatch(7, &ids);
+                ASSERT_GREATER_THAN_OR_EQUALS(ids.size(), 1U);
+                ASSERT_LESS_THAN_OR_EQUALS(ids.size(), 7U);
+                if (PlanStage::ADVANCED == state) {
+                    for (size_t i = 0; i < ids.size(); ++i) {
+                        results.push_back(batchWs.get(ids[i])->obj.value()["foo"].numberInt());
+                        batchWs.free(ids[i]);
+                    }
+                }
+                else {
+                    ASSERT_EQUALS(1U, ids.size());
+                }
+            }
+
+            ASSERT_EQUALS(25U, results.size());
+            ASSERT(expected == results);
+
+            const CommonStats* stats = scan.getCommonStats();
+            const CommonStats* batchStats = batchScan.getCommonStats();
+            ASSERT_EQUALS(stats->works, batchStats->works);
+            ASSERT_EQUALS(stats->advanced, batchStats->advanced);
+            ASSERT_EQUALS(stats->needTime, batchStats->needTime);
+        }
+    };
+
+    //
+    // Filter batches on several threads. The results must come back in the order they were read.
+    //
+
+    class QueryStageCollscanWorkBatchInParallel : public QueryStageCollectionScanBase {
+    public:
+        QueryStageCollscanWorkBatchInParallel()
+            : _oldThreads(internalQueryExecParallelBatchThreads) {
+            internalQueryExecParallelBatchThreads = 4;
+        }
+
+        ~QueryStageCollscanWorkBatchInParallel() {
+            internalQueryExecParallelBatchThreads = _oldThreads;
+        }
+
+        void run() {
+            {
+                OldClientWriteContext ctx(&_txn, ns());
+                for (int i = numObj(); i < 2000; ++i) {
+                    insert(BSON("foo" << i));
+                }
+            }
+
+            AutoGetCollectionForRead ctx(&_txn, ns());
+
+            CollectionScanParams params;
+            params.collection = ctx.getCollection();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            StatusWithMatchExpression swme =
+                MatchExpressionParser::parse(fromjson("{foo: {$mod: [3, 0]}}"));
+            ASSERT_OK(swme.getStatus());
+            unique_ptr<MatchExpression> filterExpr(swme.getValue());
+            ASSERT_TRUE(canMatchInParallel(filterExpr.get()));
+
+            // One at a time.
+            WorkingSet ws;
+            CollectionScan scan(&_txn, params, &ws, filterExpr.get());
+            vector<int> expected;
+            while (!scan.isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                if (PlanStage::ADVANCED == scan.work(&id)) {
+                    expected.push_back(ws.get(id)->obj.value()["foo"].numberInt());
+                    ws.free(id);
+                }
+            }
+
+            // In batches large enough to be split between threads.
+            WorkingSet batchWs;
+            CollectionScan batchScan(&_txn, params, &batchWs, filterExpr.get());
+            vector<int> results;
+            for (PlanStage::StageState state = PlanStage::NEED_TIME;
+                 PlanStage::IS_EOF != state; ) {
+                vector<WorkingSetID> ids;
+                state = batchScan.workBatch(512, &ids);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+                ASSERT_LESS_THAN_OR_EQUALS(ids.size(), 512U);
+                if (PlanStage::ADVANCED == state) {
+                    for (size_t i = 0; i < ids.size(); ++i) {
+                        results.push_back(batchWs.get(ids[i])->obj.value()["foo"].numberInt());
+                        batchWs.free(ids[i]);
+                    }
+                }
+            }
+
+            ASSERT_EQUALS(667U, results.size());
+            ASSERT(expected == results);
+
+            const CommonStats* stats = scan.getCommonStats();
+            const CommonStats* batchStats = batchScan.getCommonStats();
+            ASSERT_EQUALS(stats->advanced, batchStats->advanced);
+            ASSERT_EQUALS(stats->needTime, batchStats->needTime);
+        }
+
+    private:
+        const int _oldThreads;
+    };
+
+    //
+    // A big polygon $geoWithin builds S2 state lazily while matching, so the filter must be
+    // evaluated serially even when batches are large enough to split.
+    //
+
+    class QueryStageCollscanWorkBatchGeoFilter : public QueryStageCollectionScanBase {
+    public:
+        QueryStageCollscanWorkBatchGeoFilter()
+            : _oldThreads(internalQueryExecParallelBatchThreads) {
+            internalQueryExecParallelBatchThreads = 4;
+        }
+
+        ~QueryStageCollscanWorkBatchGeoFilter() {
+            internalQueryExecParallelBatchThreads = _oldThreads;
+        }
+
+        void run() {
+            {
+                OldClientWriteContext ctx(&_txn, ns());
+                for (int i = 0; i < 2000; ++i) {
+                    BSONObj point = BSON("type" << "Point"
+                                         << "coordinates" << BSON_ARRAY((i % 100) - 49.5
+                                                                        << (i / 100) - 9.5));
+                    insert(BSON("loc" << point));
+                }
+            }
+
+            AutoGetCollectionForRead ctx(&_txn, ns());
+
+            CollectionScanParams params;
+            params.collection = ctx.getCollection();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            // Everything outside of the box from (-10, -10) to (10, 10).
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(fromjson(
+                "{loc: {$geoWithin: {$geometry: {type: 'Polygon', "
+                "coordinates: [[[10, 10], [10, -10], [-10, -10], [-10, 10], [10, 10]]], "
+                "crs: {type: 'name', "
+                "properties: {name: 'urn:x-mongodb:crs:strictwinding:EPSG:4326'}}}}}}"));
+            ASSERT_OK(swme.getStatus());
+            unique_ptr<MatchExpression> filterExpr(swme.getValue());
+            ASSERT_FALSE(canMatchInParallel(filterExpr.get()));
+
+            WorkingSet ws;
+            CollectionScan scan(&_txn, params, &ws, filterExpr.get());
+            vector<BSONObj> expected;
+            while (!scan.isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                if (PlanStage::ADVANCED == scan.work(&id)) {
+                    expected.push_back(ws.get(id)->obj.value().getOwned());
+                    ws.free(id);
+                }
+            }
+
+            WorkingSet batchWs;
+            CollectionScan batchScan(&_txn, params, &batchWs, filterExpr.get());
+            vector<BSONObj> results;
+            for (PlanStage::StageState state = PlanStage::NEED_TIME;
+                 PlanStage::IS_EOF != state; ) {
+                vector<WorkingSetID> ids;
+                state = batchScan.workBatch(512, &ids);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+                if (PlanStage::ADVANCED == state) {
+                    for (size_t i = 0; i < ids.size(); ++i) {
+                        results.push_back(batchWs.get(ids[i])->obj.value().getOwned());
+                        batchWs.free(ids[i]);
+                    }
+                }
+            }
+
+            ASSERT_FALSE(results.empty());
+            ASSERT_EQUALS(expected.size(), results.size());
+            for (size_t i = 0; i < results.size(); ++i) {
+                ASSERT_EQUALS(expected[i], results[i]);
+            }
+        }
+
+    private:
+        const int _oldThreads;
+    };
+
     //
     // Get objects in the order we inserted them.
     //
@@ -378,6 +609,77 @@ namespace QueryStageCollectionScan {
         }
     };
 
+    //
+    // A capped collection summarizing 'ts' steps over the ranges of records that can't match,
+    // going either way.
+    //
+
+    class QueryStageCollscanSkipsSummarizedRanges : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            const char* cappedNs = "unittests.QueryStageCollectionScanSummarized";
+            OldClientWriteContext ctx(&_txn, cappedNs);
+            DBDirectClient client(&_txn);
+            client.dropCollection(cappedNs);
+
+            BSONObj info;
+            ASSERT(client.runCommand("unittests",
+                                      BSON("create" << nsToCollectionSubstring(cappedNs)
+                                                    << "capped" << true
+                                                    << "size" << 1024 * 1024
+                                                    << "rangeSummaryField" << "ts"),
+                                      info));
+
+            // Three closed ranges and a partly filled one.
+            const int numDocs = 4000;
+            for (int i = 0; i < numDocs; ++i) {
+                client.insert(cappedNs, BSON("ts" << i));
+            }
+
+            Collection* coll = ctx.getCollection();
+            ASSERT(coll);
+            ASSERT(coll->getRecordStore()->rangeSummary());
+
+            BSONObj filterObj = fromjson("{ts: {$gte: 2500, $lt: 3500}}");
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            ASSERT_OK(swme.getStatus());
+            unique_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            CollectionScanParams::Direction directions[] = {CollectionScanParams::FORWARD,
+                                                            CollectionScanParams::BACKWARD};
+            for (size_t d = 0; d < 2; ++d) {
+                CollectionScanParams params;
+                params.collection = coll;
+                params.direction = directions[d];
+                params.tailable = false;
+
+                WorkingSet ws;
+                unique_ptr<CollectionScan> scan(
+                    new CollectionScan(&_txn, params, &ws, filterExpr.get()));
+
+                int count = 0;
+                while (!scan->isEOF()) {
+                    WorkingSetID id = WorkingSet::INVALID_ID;
+                    PlanStage::StageState state = scan->work(&id);
+                    if (PlanStage::ADVANCED == state) {
+                        int ts = ws.get(id)->obj.value()["ts"].numberInt();
+                        ASSERT_GREATER_THAN_OR_EQUALS(ts, 2500);
+                        ASSERT_LESS_THAN(ts, 3500);
+                        ++count;
+                    }
+                }
+                ASSERT_EQUALS(1000, count);
+
+                const CollectionScanStats* stats =
+                    static_cast<const CollectionScanStats*>(scan->getSpecificStats());
+                ASSERT_EQUALS(2U, stats->rangesSkipped);
+                ASSERT_LESS_THAN(stats->docsTested, static_cast<size_t>(numDocs));
+            }
+
+            client.dropCollection(cappedNs);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "QueryStageCollectionScan" ) {}
@@ -388,10 +690,14 @@ namespace QueryStageCollectionScan {
             add<QueryStageCollscanBasicBackward>();
             add<QueryStageCollscanBasicForwardWithMatch>();
             add<QueryStageCollscanBasicBackwardWithMatch>();
+            add<QueryStageCollscanWorkBatch>();
+            add<QueryStageCollscanWorkBatchInParallel>();
+            add<QueryStageCollscanWorkBatchGeoFilter>();
             add<QueryStageCollscanObjectsInOrderForward>();
             add<QueryStageCollscanObjectsInOrderBackward>();
             add<QueryStageCollscanInvalidateUpcomingObject>();
             add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+            add<QueryStageCollscanSkipsSummarizedRanges>();
         }
     };
 
@@ -38,6 +38,7 @@
 #include "mongo/db/json.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/dbtests/dbtests.h"
 
 /**
@@ -282,6 +283,42 @@ namespace QueryStageSortTests {
         }
     };
 
+    // Sort more objects than fit in memory, so the sort spills to disk rather than fail.
+    class QueryStageSortSpill : public QueryStageSortTestBase {
+    public:
+        QueryStageSortSpill()
+            : _maxBlockingSortBytes(internalQueryExecMaxBlockingSortBytes),
+              _blockingStageSpill(internalQueryExecBlockingStageSpill) {
+            internalQueryExecMaxBlockingSortBytes = 64 * 1024;
+            internalQueryExecBlockingStageSpill = true;
+        }
+
+        virtual ~QueryStageSortSpill() {
+            internalQueryExecMaxBlockingSortBytes = _maxBlockingSortBytes;
+            internalQueryExecBlockingStageSpill = _blockingStageSpill;
+        }
+
+        virtual int numObj() { return 10000; }
+
+        void run() {
+            OldClientWriteContext ctx(&_txn, ns());
+            Database* db = ctx.db();
+            Collection* coll = db->getCollection(ns());
+            if (!coll) {
+                WriteUnitOfWork wuow(&_txn);
+                coll = db->createCollection(&_txn, ns());
+                wuow.commit();
+            }
+
+            fillData();
+            sortAndCheck(1, coll);
+        }
+
+    private:
+        int _maxBlockingSortBytes;
+        bool _blockingStageSpill;
+    };
+
     // Mutation invalidation of docs fed to sort.
     class QueryStageSortMutationInvalidation : public QueryStageSortTestBase {
     public:
@@ -552,6 +589,7 @@ namespace QueryStageSortTests {
             // and a special case for limit == 1
             add<QueryStageSortDecWithLimit<1> >();
             add<QueryStageSortExt>();
+            add<QueryStageSortSpill>();
             add<QueryStageSortMutationInvalidation>();
             add<QueryStageSortDeletionInvalidation>();
             add<QueryStageSortDeletionInvalidationWithLimit<10> >();
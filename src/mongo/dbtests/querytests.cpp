@@ -1564,6 +1564,49 @@ namespace QueryTests {
         }
     };
 
+    /**
+     * Open enough cursors that every partition of the collection's cursor manager holds some, and
+     * check that they can all be found, listed and killed.
+     */
+    class ManyOpenCursors : public CollectionBase {
+    public:
+        ManyOpenCursors() : CollectionBase( "manyopencursors" ) {
+        }
+        void run() {
+            _client.insert( ns(), vector<BSONObj>( 3, BSONObj() ) );
+            const size_t startNumCursors = numCursorsOpen();
+
+            std::vector<long long> cursorIds;
+            for ( int i = 0; i < 100; ++i ) {
+                unique_ptr<DBClientCursor> cursor =
+                        _client.query( ns(), BSONObj(), 0, 0, 0, 0, 2 );
+                ASSERT_NOT_EQUALS( 0, cursor->getCursorId() );
+                cursorIds.push_back( cursor->getCursorId() );
+                cursor->decouple();
+            }
+            ASSERT_EQUALS( startNumCursors + cursorIds.size(), numCursorsOpen() );
+
+            {
+                AutoGetCollectionForRead ctx(&_txn, ns());
+                CursorManager* cursorManager = ctx.getCollection()->getCursorManager();
+
+                std::set<CursorId> openCursors;
+                cursorManager->getCursorIds( &openCursors );
+                for ( size_t i = 0; i < cursorIds.size(); ++i ) {
+                    ASSERT_EQUALS( 1U, openCursors.count( cursorIds[i] ) );
+                    ClientCursorPin pin( cursorManager, cursorIds[i] );
+                    ASSERT( pin.c() );
+                    ASSERT_EQUALS( cursorIds[i], pin.c()->cursorid() );
+                }
+            }
+
+            for ( size_t i = 0; i < cursorIds.size(); ++i ) {
+                ASSERT( CursorManager::eraseCursorGlobal( &_txn, cursorIds[i] ) );
+            }
+            ASSERT_EQUALS( startNumCursors, numCursorsOpen() );
+        }
+    };
+
     namespace queryobjecttests {
         class names1 {
         public:
@@ -1662,6 +1705,7 @@ namespace QueryTests {
             add< QueryCursorTimeout >();
             add< QueryReadsAll >();
             add< KillPinnedCursor >();
+            add< ManyOpenCursors >();
 
             add< queryobjecttests::names1 >();
 
@@ -0,0 +1,72 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/striped_counter.h"
+
+#include "mongo/config.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+namespace {
+
+    // Threads take stripes in turn, the first time they ask for one.
+    AtomicUInt32 nextStripe;
+
+    // The calling thread's stripe plus one, or zero if it has none yet.
+#if defined(MONGO_CONFIG_HAVE___THREAD)
+    __thread unsigned myStripe;
+#elif defined(MONGO_CONFIG_HAVE___DECLSPEC_THREAD)
+    __declspec( thread ) unsigned myStripe;
+#else
+    ThreadLocalValue<unsigned> myStripeValue;
+#endif
+
+} // namespace
+
+    unsigned threadStripe() {
+#if defined(MONGO_CONFIG_HAVE___THREAD) || defined(MONGO_CONFIG_HAVE___DECLSPEC_THREAD)
+        if (!myStripe) {
+            myStripe = nextStripe.fetchAndAdd(1) + 1;
+        }
+        return myStripe - 1;
+#else
+        unsigned stripe = myStripeValue.get();
+        if (!stripe) {
+            stripe = nextStripe.fetchAndAdd(1) + 1;
+            myStripeValue.set(stripe);
+        }
+        return stripe - 1;
+#endif
+    }
+
+}  // namespace mongo
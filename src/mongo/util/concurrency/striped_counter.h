@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * Returns a small number which is the same for every call on a thread, and differs between
+     * threads as far as possible.  Structures which many threads update keep several stripes and
+     * let each thread work on stripe 'threadStripe() % stripes', so that threads on different
+     * cores don't fight over one cache line.
+     */
+    unsigned threadStripe();
+
+    /**
+     * A statistics counter which many threads may add to without contending for a cache line.
+     * Each thread adds to its own stripe; reading the counter sums the stripes.
+     *
+     * get() isn't atomic with respect to concurrent calls to add(), which is fine for statistics.
+     */
+    class StripedCounter {
+        MONGO_DISALLOW_COPYING(StripedCounter);
+    public:
+        static const unsigned kStripes = 32;
+
+        StripedCounter() { }
+
+        void add(long long n) {
+            _stripes[threadStripe() % kStripes].value.fetchAndAdd(n);
+        }
+
+        long long get() const {
+            long long sum = 0;
+            for (unsigned i = 0; i < kStripes; ++i) {
+                sum += _stripes[i].value.loadRelaxed();
+            }
+            return sum;
+        }
+
+    private:
+        // Padded so that no two stripes' values share a cache line, wherever the array starts.
+        struct Stripe {
+            AtomicInt64 value;
+            char pad[64 - sizeof(AtomicInt64)];
+        };
+
+        Stripe _stripes[kStripes];
+    };
+
+}  // namespace mongo
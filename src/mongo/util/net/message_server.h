@@ -34,12 +34,22 @@
 
 #pragma once
 
+#include <memory>
+
 #include "mongo/platform/basic.h"
 
 namespace mongo {
 
     class MessageHandler {
     public:
+        /**
+         * Per-connection state which a handler keeps in thread-local storage.
+         */
+        class ThreadState {
+        public:
+            virtual ~ThreadState() {}
+        };
+
         virtual ~MessageHandler() {}
         
         /**
@@ -52,6 +62,28 @@ namespace mongo {
          * handler is responsible for responding to client
          */
         virtual void process(Message& m, AbstractMessagingPort* p) = 0;
+
+        /**
+         * Returns true if connections of this handler may move between threads, in which case
+         * idle connections are parked and their messages processed by a pool of worker threads
+         * (see the connectionWorkerThreads server parameter) rather than by a dedicated thread.
+         */
+        virtual bool canShareThreads() const { return false; }
+
+        /**
+         * Detaches the thread-local state of the connection 'p' from the current thread. Called
+         * when the connection goes idle, and once more before the connection is destroyed.
+         */
+        virtual std::unique_ptr<ThreadState> releaseThreadState( AbstractMessagingPort* p ) {
+            return {};
+        }
+
+        /**
+         * Attaches state previously returned by releaseThreadState to the current thread, before
+         * the next message of 'p' is processed on it.
+         */
+        virtual void restoreThreadState( AbstractMessagingPort* p,
+                                         std::unique_ptr<ThreadState> state ) { }
     };
 
     class MessageServer {
@@ -31,14 +31,25 @@
 
 #include "mongo/platform/basic.h"
 
+#include <deque>
 #include <memory>
+#include <vector>
+
+#ifdef __linux__
+# include <sys/epoll.h>
+# include <sys/ioctl.h>
+# include <sys/socket.h>
+#endif
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/config.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/concurrency/thread_name.h"
@@ -52,7 +63,9 @@
 #include "mongo/util/net/message_port.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/net/ssl_options.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
 # include <sys/resource.h>
@@ -67,6 +80,12 @@ namespace mongo {
     using std::unique_ptr;
     using std::endl;
 
+    // When non-zero, connections are not given a thread each. Instead idle connections are
+    // watched by 'connectionIOThreads' poller threads, and their requests are processed by a pool
+    // of worker threads which never shrinks below this size.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(connectionWorkerThreads, int, 0);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(connectionIOThreads, int, 2);
+
 namespace {
 
     class MessagingPortWithHandler : public MessagingPort {
@@ -82,11 +101,457 @@ namespace {
 
         MessageHandler* getHandler() const { return _handler; }
 
+        // Used by the worker pool only: the handler's per-connection state while the connection
+        // is not attached to any thread, whether MessageHandler::connected has been called,
+        // whether the socket has been added to its poller, and the socket's current receive
+        // low-water mark.
+        std::unique_ptr<MessageHandler::ThreadState> threadState;
+        bool handlerConnected = false;
+        bool registeredWithPoller = false;
+        int receiveLowWaterMark = 1;
+
     private:
         // Not owned.
         MessageHandler* const _handler;
     };
 
+    /**
+     * Starts a detached thread running fn(arg). Throws boost::thread_resource_error if the
+     * thread cannot be created.
+     */
+    void launchDetachedThread(void* (*fn)(void*), void* arg) {
+#ifndef __linux__  // TODO: consider making this ifdef _WIN32
+        {
+            stdx::thread thr(stdx::bind(fn, arg));
+        }
+#else
+        pthread_attr_t attrs;
+        pthread_attr_init(&attrs);
+        pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+
+        static const size_t STACK_SIZE = 1024*1024; // if we change this we need to update the warning
+
+        struct rlimit limits;
+        verify(getrlimit(RLIMIT_STACK, &limits) == 0);
+        if (limits.rlim_cur > STACK_SIZE) {
+            size_t stackSizeToSet = STACK_SIZE;
+#if !__has_feature(address_sanitizer)
+            if (kDebugBuild)
+                stackSizeToSet /= 2;
+#endif
+            pthread_attr_setstacksize(&attrs, stackSizeToSet);
+        } else if (limits.rlim_cur < 1024*1024) {
+            warning() << "Stack size set to " << (limits.rlim_cur/1024) << "KB. We suggest 1MB" << endl;
+        }
+
+
+        pthread_t thread;
+        int failed = pthread_create(&thread, &attrs, fn, arg);
+
+        pthread_attr_destroy(&attrs);
+
+        if (failed) {
+            log() << "pthread_create failed: " << errnoWithDescription(failed) << endl;
+            throw boost::thread_resource_error(); // for consistency with boost::thread
+        }
+#endif  // __linux__
+    }
+
+    void logEndConnection(MessagingPortWithHandler* portWithHandler) {
+        if (!serverGlobalParams.quiet) {
+            int conns = Listener::globalTicketHolder.used()-1;
+            const char* word = (conns == 1 ? " connection" : " connections");
+            log() << "end connection " << portWithHandler->psock->remoteString()
+                  << " (" << conns << word << " now open)" << endl;
+        }
+    }
+
+    /**
+     * Logs the exception being handled while processing a request from 'portWithHandler' and
+     * closes the connection. Must only be called from within a catch block.
+     */
+    void handleRequestException(MessagingPortWithHandler* portWithHandler) {
+        try {
+            throw;
+        }
+        catch ( AssertionException& e ) {
+            log() << "AssertionException handling request, closing client connection: " << e << endl;
+            portWithHandler->shutdown();
+        }
+        catch ( SocketException& e ) {
+            log() << "SocketException handling request, closing client connection: " << e << endl;
+            portWithHandler->shutdown();
+        }
+        catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+            log() << "DBException handling request, closing client connection: " << e << endl;
+            portWithHandler->shutdown();
+        }
+        catch ( std::exception &e ) {
+            error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+            dbexit( EXIT_UNCAUGHT );
+        }
+    }
+
+    /**
+     * Receives one message from 'portWithHandler' and has its handler process it. Returns false
+     * if the client closed the connection. Exceptions are left to the caller.
+     */
+    bool receiveAndProcess(MessagingPortWithHandler* portWithHandler, Message& m) {
+        m.reset();
+        portWithHandler->psock->clearCounters();
+
+        if (!portWithHandler->recv(m)) {
+            logEndConnection(portWithHandler);
+            portWithHandler->shutdown();
+            return false;
+        }
+
+        portWithHandler->getHandler()->process(m, portWithHandler);
+        networkCounter.hit(portWithHandler->psock->getBytesIn(),
+                           portWithHandler->psock->getBytesOut());
+        return true;
+    }
+
+#ifdef __linux__
+
+    const int kMinIOThreads = 1;
+    const Seconds kMaxIdleWorkerAge(30);
+    const Milliseconds kPollTimeout(1000);
+    const int kMaxEventsPerPoll = 256;
+
+    // How many messages a worker processes from one connection, while the connection has
+    // messages ready, before returning it to the poller so that other connections get a turn.
+    const int kMaxMessagesPerDispatch = 16;
+
+    // A connection is only handed to a worker once this much of its next message has arrived,
+    // or all of it if it is smaller. The kernel has to be able to buffer that many bytes before
+    // it reports the socket readable, so it is kept well below the default receive buffer size.
+    // Only the rest of a message bigger than this is read while the worker waits on the client.
+    const int kMaxReadAheadBytes = 16 * 1024;
+
+    // The name of idle worker threads. While servicing a connection a worker takes the name the
+    // handler gives it, usually that of the connection.
+    const char kWorkerThreadName[] = "connworker";
+
+    void setReceiveLowWaterMark(MessagingPortWithHandler* portWithHandler, int bytes) {
+        if (portWithHandler->receiveLowWaterMark == bytes) {
+            return;
+        }
+        if (::setsockopt(portWithHandler->psock->rawFD(), SOL_SOCKET, SO_RCVLOWAT,
+                       &bytes, sizeof(bytes)) == 0) {
+            portWithHandler->receiveLowWaterMark = bytes;
+        }
+    }
+
+    /**
+     * Returns true if the next message of 'portWithHandler' can be read without waiting on the
+     * client: all of it, or kMaxReadAheadBytes of a bigger one, has arrived. Also returns true
+     * on EOF, on errors, and for headers which MessagingPort::recv() handles specially, so that
+     * recv() reports them. Otherwise sets the socket's receive low-water mark such that the
+     * socket only polls readable once enough has arrived, and returns false.
+     */
+    bool hasMessageReady(MessagingPortWithHandler* portWithHandler) {
+        const int fd = portWithHandler->psock->rawFD();
+
+        MSGHEADER::Value header;
+        const ssize_t peeked = ::recv(fd, &header, sizeof(header), MSG_PEEK | MSG_DONTWAIT);
+        if (peeked == 0 || (peeked < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            setReceiveLowWaterMark(portWithHandler, 1);
+            return true;
+        }
+
+        int needed = sizeof(header);
+        if (peeked == static_cast<ssize_t>(sizeof(header))) {
+            const int len = header.constView().getMessageLength();
+            if (len < static_cast<int>(sizeof(header))
+                    || static_cast<size_t>(len) > MaxMessageSizeBytes) {
+                // The endian check, an HTTP request or an invalid length.
+                setReceiveLowWaterMark(portWithHandler, 1);
+                return true;
+            }
+            needed = std::min(len, kMaxReadAheadBytes);
+        }
+
+        setReceiveLowWaterMark(portWithHandler, needed);
+
+        int buffered = 0;
+        return peeked > 0 && ::ioctl(fd, FIONREAD, &buffered) == 0 && buffered >= needed;
+    }
+
+    class ConnectionWorkerPool;
+
+    /**
+     * Watches idle connections and hands them to the worker pool once their next message has
+     * arrived. Each socket is added to the poller's epoll set once, and re-armed with
+     * EPOLLONESHOT whenever a worker parks its connection, so parking a connection costs the
+     * same however many others are parked, and a connection is only ever reported to one
+     * worker at a time.
+     */
+    class ConnectionPoller {
+        MONGO_DISALLOW_COPYING(ConnectionPoller);
+    public:
+        explicit ConnectionPoller(ConnectionWorkerPool* workers);
+
+        void start();
+
+        /**
+         * Hands an idle connection over to this poller. Returns false if the poller can't watch
+         * it, in which case the caller keeps ownership.
+         */
+        bool park(MessagingPortWithHandler* portWithHandler);
+
+    private:
+        static void* threadMain(void* arg);
+
+        void _run();
+
+        ConnectionWorkerPool* const _workers;
+        int _epollFd;
+    };
+
+    /**
+     * Processes the messages of connections which have a message ready. The pool keeps at least
+     * 'minThreads' threads, and starts more whenever work is queued and no thread is idle: a
+     * request may block for an arbitrary time (e.g. waiting for a lock which another client
+     * releases), so a hard cap on the number of threads could deadlock the server. Threads
+     * above the minimum retire after kMaxIdleWorkerAge without work. Either way the number of
+     * threads follows the number of operations in progress, not the number of connections.
+     */
+    class ConnectionWorkerPool {
+        MONGO_DISALLOW_COPYING(ConnectionWorkerPool);
+    public:
+        ConnectionWorkerPool(MessageHandler* handler, int minThreads, int numPollers);
+
+        void start();
+
+        /**
+         * Queues a new connection, or one which has a message ready, to be processed by a worker.
+         * The pool takes ownership of 'portWithHandler' and of its connection ticket.
+         */
+        void schedule(MessagingPortWithHandler* portWithHandler);
+
+    private:
+        static void* threadMain(void* arg);
+
+        void _startWorker_inlock();
+        void _consumeConnections();
+
+        /**
+         * Processes messages from 'portWithHandler' while it has messages ready. Returns false if
+         * the connection has been closed.
+         */
+        bool _serviceConnection(MessagingPortWithHandler* portWithHandler);
+
+        void _closeConnection(MessagingPortWithHandler* portWithHandler);
+
+        MessageHandler* const _handler;
+        const size_t _minThreads;
+        std::vector<std::unique_ptr<ConnectionPoller>> _pollers;
+
+        stdx::mutex _mutex;
+        stdx::condition_variable _workAvailable;
+        std::deque<MessagingPortWithHandler*> _ready;
+        size_t _numThreads = 0;
+        size_t _numIdleThreads = 0;
+    };
+
+    ConnectionPoller::ConnectionPoller(ConnectionWorkerPool* workers) : _workers(workers) {
+        _epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (_epollFd < 0) {
+            severe() << "failed to create connection poller epoll set: " << errnoWithDescription();
+            fassertFailed(28695);
+        }
+    }
+
+    void ConnectionPoller::start() {
+        launchDetachedThread(&ConnectionPoller::threadMain, this);
+    }
+
+    void* ConnectionPoller::threadMain(void* arg) {
+        static_cast<ConnectionPoller*>(arg)->_run();
+        return NULL;
+    }
+
+    bool ConnectionPoller::park(MessagingPortWithHandler* portWithHandler) {
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = portWithHandler;
+
+        // Once the socket is armed another worker may own the connection, so it mustn't be
+        // touched afterwards. Closing the socket takes it out of the epoll set.
+        const int op = portWithHandler->registeredWithPoller ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        portWithHandler->registeredWithPoller = true;
+        if (epoll_ctl(_epollFd, op, portWithHandler->psock->rawFD(), &event) != 0) {
+            warning() << "failed to watch connection " << portWithHandler->connectionId()
+                      << " for requests: " << errnoWithDescription();
+            return false;
+        }
+        return true;
+    }
+
+    void ConnectionPoller::_run() {
+        setThreadName("connpoller");
+
+        std::vector<epoll_event> events(kMaxEventsPerPoll);
+        while (!inShutdown()) {
+            const int nEvents = epoll_wait(_epollFd, events.data(), events.size(),
+                                           kPollTimeout.count());
+            if (nEvents < 0) {
+                if (errno != EINTR) {
+                    warning() << "epoll_wait() failed in connection poller: "
+                              << errnoWithDescription();
+                }
+                continue;
+            }
+
+            // EPOLLONESHOT disarmed each of these sockets, so until a worker parks it again
+            // the connection belongs to that worker alone.
+            for (int i = 0; i < nEvents; ++i) {
+                _workers->schedule(static_cast<MessagingPortWithHandler*>(events[i].data.ptr));
+            }
+        }
+    }
+
+    ConnectionWorkerPool::ConnectionWorkerPool(MessageHandler* handler,
+                                               int minThreads,
+                                               int numPollers)
+        : _handler(handler),
+          _minThreads(minThreads) {
+        for (int i = 0; i < numPollers; ++i) {
+            _pollers.emplace_back(new ConnectionPoller(this));
+        }
+    }
+
+    void ConnectionWorkerPool::start() {
+        for (size_t i = 0; i < _pollers.size(); ++i) {
+            _pollers[i]->start();
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        while (_numThreads < _minThreads) {
+            _startWorker_inlock();
+        }
+    }
+
+    void ConnectionWorkerPool::schedule(MessagingPortWithHandler* portWithHandler) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _ready.push_back(portWithHandler);
+        if (_ready.size() > _numIdleThreads) {
+            try {
+                _startWorker_inlock();
+            }
+            catch (boost::thread_resource_error&) {
+                // The connection stays queued until one of the existing workers gets to it.
+                log() << "can't create new connection worker thread" << endl;
+            }
+        }
+        _workAvailable.notify_one();
+    }
+
+    void ConnectionWorkerPool::_startWorker_inlock() {
+        launchDetachedThread(&ConnectionWorkerPool::threadMain, this);
+        ++_numThreads;
+        ++_numIdleThreads;
+    }
+
+    void* ConnectionWorkerPool::threadMain(void* arg) {
+        static_cast<ConnectionWorkerPool*>(arg)->_consumeConnections();
+        return NULL;
+    }
+
+    void ConnectionWorkerPool::_consumeConnections() {
+        setThreadName(kWorkerThreadName);
+
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        while (!inShutdown()) {
+            if (_ready.empty()) {
+                // Occasionally we want to see if we're using too much memory.
+                markThreadIdle();
+
+                if (_workAvailable.wait_for(lk, kMaxIdleWorkerAge) == stdx::cv_status::timeout
+                        && _ready.empty()
+                        && _numThreads > _minThreads) {
+                    break;
+                }
+                continue;
+            }
+
+            MessagingPortWithHandler* portWithHandler = _ready.front();
+            _ready.pop_front();
+            --_numIdleThreads;
+            lk.unlock();
+
+            const bool stillOpen = _serviceConnection(portWithHandler);
+
+            // Don't let the connection's name stick to the thread, which will service other
+            // connections next.
+            setThreadName(kWorkerThreadName);
+
+            if (!stillOpen
+                    || !_pollers[portWithHandler->connectionId() % _pollers.size()]->park(
+                            portWithHandler)) {
+                _closeConnection(portWithHandler);
+            }
+
+            lk.lock();
+            ++_numIdleThreads;
+        }
+
+        --_numIdleThreads;
+        --_numThreads;
+    }
+
+    bool ConnectionWorkerPool::_serviceConnection(MessagingPortWithHandler* portWithHandler) {
+        bool hasData;
+        if (!portWithHandler->handlerConnected) {
+            portWithHandler->psock->setLogLevel(logger::LogSeverity::Debug(1));
+            portWithHandler->handlerConnected = true;
+            try {
+                _handler->connected(portWithHandler);
+            }
+            catch (...) {
+                handleRequestException(portWithHandler);
+                portWithHandler->threadState = _handler->releaseThreadState(portWithHandler);
+                return false;
+            }
+            hasData = hasMessageReady(portWithHandler);
+        }
+        else {
+            // Connections are only scheduled again once their next message has arrived, or the
+            // client has hung up.
+            _handler->restoreThreadState(portWithHandler, std::move(portWithHandler->threadState));
+            hasData = true;
+        }
+
+        ON_BLOCK_EXIT([this, portWithHandler] {
+            portWithHandler->threadState = _handler->releaseThreadState(portWithHandler);
+        });
+
+        Message m;
+        try {
+            for (int i = 0; hasData && i < kMaxMessagesPerDispatch && !inShutdown(); ++i) {
+                if (!receiveAndProcess(portWithHandler, m)) {
+                    return false;
+                }
+                hasData = hasMessageReady(portWithHandler);
+            }
+        }
+        catch (...) {
+            handleRequestException(portWithHandler);
+            return false;
+        }
+
+        return !inShutdown();
+    }
+
+    void ConnectionWorkerPool::_closeConnection(MessagingPortWithHandler* portWithHandler) {
+        // Destroying the port also destroys the handler's state for the connection.
+        delete portWithHandler;
+        Listener::globalTicketHolder.release();
+    }
+
+#endif  // __linux__
+
 }  // namespace
 
     class PortMessageServer : public MessageServer , public Listener {
@@ -112,43 +577,16 @@ namespace {
                 return;
             }
 
-            try {
-#ifndef __linux__  // TODO: consider making this ifdef _WIN32
-                {
-                    stdx::thread thr(stdx::bind(&handleIncomingMsg, portWithHandler.get()));
-                }
-#else
-                pthread_attr_t attrs;
-                pthread_attr_init(&attrs);
-                pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
-
-                static const size_t STACK_SIZE = 1024*1024; // if we change this we need to update the warning
-
-                struct rlimit limits;
-                verify(getrlimit(RLIMIT_STACK, &limits) == 0);
-                if (limits.rlim_cur > STACK_SIZE) {
-                    size_t stackSizeToSet = STACK_SIZE;
-#if !__has_feature(address_sanitizer)
-                    if (kDebugBuild)
-                        stackSizeToSet /= 2;
+#ifdef __linux__
+            if (_workerPool) {
+                _workerPool->schedule(portWithHandler.release());
+                sleepAfterClosingPort.Dismiss();
+                return;
+            }
 #endif
-                    pthread_attr_setstacksize(&attrs, stackSizeToSet);
-                } else if (limits.rlim_cur < 1024*1024) {
-                    warning() << "Stack size set to " << (limits.rlim_cur/1024) << "KB. We suggest 1MB" << endl;
-                }
-
-
-                pthread_t thread;
-                int failed =
-                    pthread_create(&thread, &attrs, &handleIncomingMsg, portWithHandler.get());
 
-                pthread_attr_destroy(&attrs);
-
-                if (failed) {
-                    log() << "pthread_create failed: " << errnoWithDescription(failed) << endl;
-                    throw boost::thread_resource_error(); // for consistency with boost::thread
-                }
-#endif  // __linux__
+            try {
+                launchDetachedThread(&handleIncomingMsg, portWithHandler.get());
 
                 portWithHandler.release();
                 sleepAfterClosingPort.Dismiss();
@@ -172,6 +610,7 @@ namespace {
         }
 
         void run() {
+            _startWorkerPoolIfEnabled();
             initAndListen();
         }
 
@@ -180,6 +619,43 @@ namespace {
     private:
         MessageHandler* _handler;
 
+#ifdef __linux__
+        std::unique_ptr<ConnectionWorkerPool> _workerPool;
+#endif
+
+        void _startWorkerPoolIfEnabled() {
+            if (connectionWorkerThreads <= 0) {
+                return;
+            }
+
+            if (!_handler->canShareThreads()) {
+                warning() << "connectionWorkerThreads is not supported by this process, "
+                          << "using one thread per connection";
+                return;
+            }
+
+#ifndef __linux__
+            warning() << "connectionWorkerThreads is only supported on Linux, "
+                      << "using one thread per connection";
+#else
+            if (sslGlobalParams.sslMode.load() != SSLParams::SSLMode_disabled) {
+                // Decrypted data buffered inside the SSL connection is invisible to epoll.
+                warning() << "connectionWorkerThreads is not supported together with SSL, "
+                          << "using one thread per connection";
+                return;
+            }
+
+            const int numPollers = std::max(kMinIOThreads, static_cast<int>(connectionIOThreads));
+            log() << "processing connections with a pool of at least " << connectionWorkerThreads
+                  << " worker threads and " << numPollers << " I/O threads";
+
+            _workerPool.reset(new ConnectionWorkerPool(_handler,
+                                                       connectionWorkerThreads,
+                                                       numPollers));
+            _workerPool->start();
+#endif
+        }
+
         /**
          * Handles incoming messages from a given socket.
          *
@@ -209,45 +685,18 @@ namespace {
                 handler->connected(portWithHandler.get());
 
                 while ( ! inShutdown() ) {
-                    m.reset();
-                    portWithHandler->psock->clearCounters();
-
-                    if (!portWithHandler->recv(m)) {
-                        if (!serverGlobalParams.quiet) {
-                            int conns = Listener::globalTicketHolder.used()-1;
-                            const char* word = (conns == 1 ? " connection" : " connections");
-                            log() << "end connection " << portWithHandler->psock->remoteString()
-                                  << " (" << conns << word << " now open)" << endl;
-                        }
-                        portWithHandler->shutdown();
+                    if (!receiveAndProcess(portWithHandler.get(), m)) {
                         break;
                     }
 
-                    handler->process(m, portWithHandler.get());
-                    networkCounter.hit(portWithHandler->psock->getBytesIn(),
-                                       portWithHandler->psock->getBytesOut());
-
                     // Occasionally we want to see if we're using too much memory.
                     if ((counter++ & 0xf) == 0) {
                         markThreadIdle();
                     }
                 }
             }
-            catch ( AssertionException& e ) {
-                log() << "AssertionException handling request, closing client connection: " << e << endl;
-                portWithHandler->shutdown();
-            }
-            catch ( SocketException& e ) {
-                log() << "SocketException handling request, closing client connection: " << e << endl;
-                portWithHandler->shutdown();
-            }
-            catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
-                log() << "DBException handling request, closing client connection: " << e << endl;
-                portWithHandler->shutdown();
-            }
-            catch ( std::exception &e ) {
-                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
-                dbexit( EXIT_UNCAUGHT );
+            catch ( ... ) {
+                handleRequestException(portWithHandler.get());
             }
 
             // Normal disconnect path.